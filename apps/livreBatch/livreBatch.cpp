@@ -0,0 +1,219 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <livre/lib/animation/CameraPath.h>
+#include <livre/lib/configuration/ApplicationParameters.h>
+#include <livre/lib/configuration/VolumeRendererParameters.h>
+#include <livre/lib/render/BatchRenderer.h>
+
+#include <livre/core/render/TransferFunction1D.h>
+#include <livre/core/version.h>
+#include <livre/data/DataSource.h>
+#include <livre/data/VolumeInformation.h>
+
+#include <lunchbox/term.h>
+
+#include <boost/program_options/parsers.hpp>
+#include <boost/program_options/variables_map.hpp>
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+
+namespace
+{
+const char CAMERAPATH_PARAM[] = "camera-path";
+const char WIDTH_PARAM[] = "width";
+const char HEIGHT_PARAM[] = "height";
+const char OUTPUT_PARAM[] = "output";
+const char PARALLELFRAMES_PARAM[] = "parallel-frames";
+
+const float fieldOfView = 45.f;
+const float nearPlane = 0.1f;
+const float farPlane = 15.f;
+
+struct BatchParameters
+{
+    std::string cameraPath;
+    uint32_t width = 1920;
+    uint32_t height = 1080;
+    std::string output = "frame_";
+    uint32_t parallelFrames = 0;
+
+    livre::options_description getOptions() const
+    {
+        livre::options_description options("Batch Parameters",
+                                           lunchbox::term::getSize().first);
+        livre::addOption(options, CAMERAPATH_PARAM,
+                         "Camera path file (eqPly format) of the frames, "
+                         "instead of the camera position and orientation",
+                         cameraPath);
+        livre::addOption(options, WIDTH_PARAM, "Width of the images", width);
+        livre::addOption(options, HEIGHT_PARAM, "Height of the images",
+                         height);
+        livre::addOption(options, OUTPUT_PARAM,
+                         "Prefix of the image files, followed by the frame "
+                         "number and .ppm",
+                         output);
+        livre::addOption(options, PARALLELFRAMES_PARAM,
+                         "Number of frames rendered in parallel, 0 for one "
+                         "per core",
+                         parallelFrames);
+        return options;
+    }
+
+    void parse(const int argc, const char* const argv[])
+    {
+        livre::variables_map vm;
+        boost::program_options::store(
+            boost::program_options::command_line_parser(argc, argv)
+                .options(getOptions())
+                .allow_unregistered()
+                .run(),
+            vm);
+        cameraPath = vm[CAMERAPATH_PARAM].as<std::string>();
+        width = vm[WIDTH_PARAM].as<uint32_t>();
+        height = vm[HEIGHT_PARAM].as<uint32_t>();
+        output = vm[OUTPUT_PARAM].as<std::string>();
+        parallelFrames = vm[PARALLELFRAMES_PARAM].as<uint32_t>();
+    }
+};
+
+/** Writes the image as binary PPM, which stores the rows from the top */
+void writePPM(const std::string& fileName, const livre::Vector2ui& size,
+              const std::vector<uint8_t>& rgba)
+{
+    std::ofstream file(fileName, std::ios::binary);
+    file << "P6\n" << size[0] << " " << size[1] << "\n255\n";
+
+    std::vector<char> row(size[0] * 3);
+    for (uint32_t y = size[1]; y > 0; --y)
+    {
+        const uint8_t* pixel = &rgba[(y - 1) * size[0] * 4];
+        for (uint32_t x = 0; x < size[0]; ++x, pixel += 4)
+            std::copy(pixel, pixel + 3, &row[x * 3]);
+        file.write(row.data(), row.size());
+    }
+    if (!file)
+        LBTHROW(std::runtime_error("Cannot write " + fileName));
+}
+
+livre::BatchFrames makeFrames(const livre::ApplicationParameters& appParams,
+                              const BatchParameters& batchParams,
+                              const livre::Vector2ui& timeSteps)
+{
+    livre::CameraPath cameraPath;
+    if (!batchParams.cameraPath.empty() &&
+        !cameraPath.loadAnimation(batchParams.cameraPath))
+    {
+        LBTHROW(std::runtime_error("Cannot load camera path " +
+                                   batchParams.cameraPath));
+    }
+
+    // a frame per camera path step, or per time step without a camera path;
+    // the last time step is held by the rest of the frames
+    const uint32_t nFrames = std::min(cameraPath.isValid()
+                                          ? cameraPath.getNumberOfFrames()
+                                          : timeSteps[1] - timeSteps[0],
+                                      appParams.maxFrames);
+    const livre::Matrix4f modelView(appParams.cameraPosition,
+                                    appParams.cameraLookAt,
+                                    livre::Vector3f::up());
+
+    livre::BatchFrames frames(nFrames);
+    for (uint32_t i = 0; i < nFrames; ++i)
+    {
+        frames[i].modelView =
+            cameraPath.isValid()
+                ? cameraPath.getModelViewMatrix(cameraPath.getNextStep())
+                : modelView;
+        frames[i].timeStep = std::min(timeSteps[0] + i, timeSteps[1] - 1);
+    }
+    return frames;
+}
+}
+
+int main(const int argc, char** argv)
+{
+    BatchParameters batchParams;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string("--help") == argv[i])
+        {
+            livre::DataSource::loadPlugins(); // needed to complete --volume
+            std::cout << livre::ApplicationParameters::getHelp()
+                      << livre::VolumeRendererParameters::getHelp()
+                      << batchParams.getOptions() << std::endl;
+            return EXIT_SUCCESS;
+        }
+        if (std::string("--version") == argv[i])
+        {
+            std::cout << "Livre version "
+                      << livrecore::Version::getString() << std::endl;
+            return EXIT_SUCCESS;
+        }
+    }
+
+    try
+    {
+        const livre::ApplicationParameters appParams(argc, argv);
+        const livre::VolumeRendererParameters vrParams(argc, argv);
+        batchParams.parse(argc, argv);
+
+        livre::DataSource::loadPlugins();
+        livre::BatchRenderer renderer(servus::URI(appParams.dataFileName),
+                                      vrParams, batchParams.parallelFrames);
+        if (!appParams.transferFunction.empty())
+            renderer.setTransferFunction(
+                livre::TransferFunction1D(appParams.transferFunction));
+
+        const livre::Vector2ui& volumeTimeSteps =
+            renderer.getDataSource().getVolumeInfo().frameRange;
+        const livre::Vector2ui timeSteps(
+            std::max(appParams.frames[0], volumeTimeSteps[0]),
+            std::min(appParams.frames[1], volumeTimeSteps[1]));
+        if (timeSteps[0] >= timeSteps[1])
+            LBTHROW(std::runtime_error("No frames to render"));
+
+        const livre::Vector2ui size(batchParams.width, batchParams.height);
+        const livre::Frustumf projection(fieldOfView, float(size[0]) / size[1],
+                                         nearPlane, farPlane);
+        const livre::BatchStatistics statistics = renderer.render(
+            makeFrames(appParams, batchParams, timeSteps), projection, size,
+            [&](const size_t index, const std::vector<uint8_t>& rgba) {
+                std::ostringstream fileName;
+                fileName << batchParams.output << std::setw(5)
+                         << std::setfill('0') << index << ".ppm";
+                writePPM(fileName.str(), size, rgba);
+            });
+
+        std::cout << "Rendered " << statistics.frames << " frames in "
+                  << statistics.seconds << " s, "
+                  << statistics.getFramesPerHour() << " frames/hour, "
+                  << statistics.brickReads << " brick reads for "
+                  << statistics.bricks << " bricks" << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "livreBatch: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
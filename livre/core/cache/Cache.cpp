@@ -122,6 +122,12 @@ struct Cache::Impl
         }
     }
 
+    void makeRoom()
+    {
+        WriteLock writeLock(_mutex);
+        applyPolicy();
+    }
+
     ConstCacheObjectPtr load(ConstCacheObjectPtr obj)
     {
         WriteLock writeLock(_mutex);
@@ -226,6 +232,11 @@ ConstCacheObjectPtr Cache::_load(ConstCacheObjectPtr obj)
     return _impl->load(obj);
 }
 
+void Cache::_makeRoom()
+{
+    _impl->makeRoom();
+}
+
 bool Cache::unload(const CacheId& cacheId)
 {
     if (cacheId == INVALID_CACHE_ID)
@@ -105,6 +105,10 @@ public:
      * @return the loaded or previously loaded cache object. Return empty
      * pointer
      * if cache id is invalid or object cannot be loaded.
+     *
+     * A full cache evicts its unreferenced objects before the new object is
+     * constructed, so that objects holding a limited resource, e.g. the slots
+     * of a texture atlas, find the ones released by the evicted objects.
      */
     template <class CacheObjectT, class... Args>
     LIVRECORE_API std::shared_ptr<const CacheObjectT> load(
@@ -119,6 +123,7 @@ public:
 
         try
         {
+            _makeRoom();
             ConstCacheObjectPtr cacheObject =
                 _load(ConstCacheObjectPtr(new CacheObjectT(cacheId, args...)));
 
@@ -168,6 +173,7 @@ protected:
 
 private:
     ConstCacheObjectPtr _load(ConstCacheObjectPtr cacheObject);
+    void _makeRoom();
     const std::type_index& _getCacheObjectType() const;
 
     struct Impl;
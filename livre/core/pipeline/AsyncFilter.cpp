@@ -0,0 +1,66 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <livre/core/pipeline/AsyncFilter.h>
+
+namespace livre
+{
+void AsyncFilter::execute(const FutureMap& input, PromiseMap& output) const
+{
+    execute(input, output, CancelToken());
+}
+
+void AsyncFilter::execute(const FutureMap& input, PromiseMap& output,
+                          const CancelToken& token) const
+{
+    Suspension suspension(token);
+    execute(input, output, suspension);
+    while (suspension.isSuspended() && !token.isCanceled())
+    {
+        FutureMap(suspension.getFutures()).wait();
+        suspension.resume()(input, output, suspension);
+    }
+}
+
+Suspension::Suspension(const CancelToken& token)
+    : _token(token)
+{
+}
+
+Suspension::~Suspension()
+{
+}
+
+void Suspension::await(const Futures& futures, const AsyncFilter::Step& step)
+{
+    if (_step)
+        LBTHROW(std::logic_error("The step already awaits other futures"));
+
+    Futures awaited(futures); // futures are not assignable
+    _futures.swap(awaited);
+    _step = step;
+}
+
+AsyncFilter::Step Suspension::resume()
+{
+    _futures.clear();
+    AsyncFilter::Step step;
+    step.swap(_step);
+    return step;
+}
+}
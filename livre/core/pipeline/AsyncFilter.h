@@ -0,0 +1,115 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _AsyncFilter_h_
+#define _AsyncFilter_h_
+
+#include <livre/core/api.h>
+#include <livre/core/pipeline/Filter.h>
+
+namespace livre
+{
+class Suspension;
+
+/**
+ * A filter which waits for futures, e.g. for the completion of an I/O request,
+ * without blocking a thread. Its execution is split into steps: each step
+ * either finishes the execution, or awaits futures and gives the step which
+ * continues the execution once they are ready.
+ *
+ * When the @PipeFilter is scheduled on an executor, a suspended filter does
+ * not hold a worker thread: the next step is scheduled on the same executor
+ * and only runs once the awaited futures are ready. The executor has to
+ * outlive the execution. Otherwise, e.g. in Pipeline::execute(), the steps
+ * are run on the calling thread, which waits for the awaited futures.
+ */
+class AsyncFilter : public Filter
+{
+public:
+    /**
+     * A step of the execution.
+     * @param input The Future that can be read for input parameters
+     * @param output The Promise that can be written to for output parameters.
+     * The unset promises are flushed after the last step.
+     * @param suspension suspends the execution after the step
+     */
+    typedef std::function<void(const FutureMap& input, PromiseMap& output,
+                               Suspension& suspension)>
+        Step;
+
+    /**
+     * Runs the first step of the execution, with the parameters of a Step.
+     */
+    virtual void execute(const FutureMap& input, PromiseMap& output,
+                         Suspension& suspension) const = 0;
+
+    /**
+     * Runs all the steps on the calling thread.
+     * @copydoc Filter::execute(const FutureMap&,PromiseMap&)
+     */
+    LIVRECORE_API void execute(const FutureMap& input,
+                               PromiseMap& output) const final;
+
+    /**
+     * Runs the steps on the calling thread until the token is canceled.
+     * @copydoc Filter::execute(const FutureMap&,PromiseMap&,const CancelToken&)
+     */
+    LIVRECORE_API void execute(const FutureMap& input, PromiseMap& output,
+                               const CancelToken& token) const final;
+};
+
+/**
+ * Suspends the execution of an @AsyncFilter after the current step.
+ */
+class Suspension
+{
+public:
+    /** @param token of the execution */
+    LIVRECORE_API explicit Suspension(const CancelToken& token);
+    LIVRECORE_API ~Suspension();
+
+    /**
+     * Suspends the execution after the current step until the futures are
+     * ready. The execution is not resumed if it is canceled meanwhile.
+     * @param futures to wait for, e.g. the ones of an I/O request
+     * @param step continues the execution with the same input and output
+     * @throw std::logic_error if the step already awaits other futures
+     */
+    LIVRECORE_API void await(const Futures& futures,
+                             const AsyncFilter::Step& step);
+
+    /** @return the token of the execution, for long running steps */
+    const CancelToken& getCancelToken() const { return _token; }
+    /** @return true if the current step awaits futures */
+    bool isSuspended() const { return bool(_step); }
+    /** @return the futures awaited by the current step */
+    const Futures& getFutures() const { return _futures; }
+    /**
+     * Resumes the execution, so the returned step can suspend it again.
+     * @return the step to run once the awaited futures are ready
+     */
+    LIVRECORE_API AsyncFilter::Step resume();
+
+private:
+    CancelToken _token;
+    Futures _futures;
+    AsyncFilter::Step _step;
+};
+}
+
+#endif // _AsyncFilter_h_
@@ -0,0 +1,54 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _CancelToken_h_
+#define _CancelToken_h_
+
+#include <livre/core/types.h>
+
+#include <atomic>
+
+namespace livre
+{
+/**
+ * Tells executables that their results are not needed anymore, e.g. because
+ * a newer frame has been started. The copies of a token share its state.
+ */
+class CancelToken
+{
+public:
+    CancelToken()
+        : _canceled(std::make_shared<std::atomic<bool>>(false))
+    {
+    }
+
+    /** Cancels the token and all its copies. */
+    void cancel() { *_canceled = true; }
+
+    /** @return true if the token has been canceled */
+    bool isCanceled() const
+    {
+        return _canceled->load(std::memory_order_relaxed);
+    }
+
+private:
+    std::shared_ptr<std::atomic<bool>> _canceled;
+};
+}
+
+#endif // _CancelToken_h_
@@ -0,0 +1,224 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <livre/core/pipeline/DependencyExecutor.h>
+
+#include <livre/core/pipeline/Executable.h>
+#include <livre/core/pipeline/FuturePromise.h>
+#include <livre/core/pipeline/Tracer.h>
+#include <livre/core/pipeline/Workers.h>
+
+#include <boost/thread/condition_variable.hpp>
+
+#include <memory>
+#include <unordered_map>
+
+namespace livre
+{
+namespace
+{
+/**
+ * Owns the executables waiting for their preconditions. The callbacks on the
+ * preconditions only hold a weak reference: the futures of an executable do
+ * not keep it alive, so the executables which are never ready are freed by
+ * clear() or with the executor. The executables handed to the Workers are
+ * counted until they are executed or dropped, so the executor can wait for
+ * them.
+ */
+struct State : public std::enable_shared_from_this<State>
+{
+    struct Pending
+    {
+        ExecutablePtr executable;
+        size_t count; // unfulfilled preconditions, plus one while scheduling
+    };
+
+    State(Workers& workers_, const WorkPriority priority_)
+        : workers(&workers_)
+        , priority(priority_)
+        , nextId(0)
+        , nScheduled(0)
+    {
+    }
+
+    uint64_t add(const ExecutablePtr& executable, const size_t count)
+    {
+        ScopedLock lock(mutex);
+        pending.emplace(nextId, Pending{executable, count});
+        return nextId++;
+    }
+
+    void release(const uint64_t id);
+
+    void clear()
+    {
+        std::unordered_map<uint64_t, Pending> cleared;
+        ScopedLock lock(mutex);
+        cleared.swap(pending);
+    }
+
+    void finished()
+    {
+        ScopedLock lock(mutex);
+        if (--nScheduled == 0)
+            done.notify_all();
+    }
+
+    void waitScheduled()
+    {
+        ScopedLock lock(mutex);
+        while (nScheduled > 0)
+            done.wait(lock);
+    }
+
+    boost::mutex mutex;
+    boost::condition_variable done;
+    Workers* workers; // 0 after destruction of the executor
+    const WorkPriority priority;
+    std::unordered_map<uint64_t, Pending> pending;
+    uint64_t nextId;
+    size_t nScheduled; // in the Workers, queued or running
+};
+typedef std::shared_ptr<State> StatePtr;
+typedef std::weak_ptr<State> StateWeakPtr;
+
+/** An executable in the Workers, counted by the State until destroyed */
+class ScheduledExecutable : public Executable
+{
+public:
+    ScheduledExecutable(ExecutablePtr executable, StatePtr state)
+        : _executable(std::move(executable))
+        , _state(std::move(state))
+    {
+    }
+
+    ~ScheduledExecutable() { _state->finished(); }
+    void execute() final { _executable->execute(); }
+    Futures getPostconditions() const final
+    {
+        return _executable->getPostconditions();
+    }
+
+    Futures getPreconditions() const final
+    {
+        return _executable->getPreconditions();
+    }
+
+    ExecutablePtr clone() const final { return _executable->clone(); }
+private:
+    const ExecutablePtr _executable;
+    const StatePtr _state;
+};
+
+void State::release(const uint64_t id)
+{
+    // Destroyed outside of the lock: the executable if cleared, and the
+    // scheduled one if the Workers are already done with it
+    ExecutablePtr executable, scheduled;
+    ScopedLock lock(mutex);
+    const auto i = pending.find(id);
+    if (i == pending.end() || --i->second.count > 0)
+        return;
+
+    executable = std::move(i->second.executable);
+    pending.erase(i);
+    if (!workers)
+        return;
+
+    ++nScheduled;
+    Tracer::setQueued(*executable);
+    scheduled.reset(
+        new ScheduledExecutable(std::move(executable), shared_from_this()));
+    workers->schedule(scheduled, priority);
+}
+}
+
+struct DependencyExecutor::Impl
+{
+    Impl(const std::string& name, const size_t threadCount,
+         const GLContext& glContext)
+        : _ownWorkers(new Workers(name, threadCount, glContext))
+        , _state(std::make_shared<State>(*_ownWorkers, PRIORITY_RENDER))
+    {
+    }
+
+    Impl(Workers& workers, const WorkPriority priority)
+        : _state(std::make_shared<State>(workers, priority))
+    {
+    }
+
+    ~Impl()
+    {
+        {
+            ScopedLock lock(_state->mutex);
+            _state->workers = nullptr;
+        }
+        _state->clear();
+        _state->waitScheduled();
+    }
+
+    void clear() { _state->clear(); }
+    void schedule(const ExecutablePtr& executable)
+    {
+        const Futures& preConds = executable->getPreconditions();
+
+        // One extra count is held until all the callbacks are registered, so
+        // the executable is not submitted before.
+        const uint64_t id = _state->add(executable, preConds.size() + 1);
+        const StateWeakPtr weakState = _state;
+        const std::function<void()> release = [weakState, id]() {
+            if (const StatePtr state = weakState.lock())
+                state->release(id);
+        };
+
+        for (const Future& future : preConds)
+            future.onReady(release);
+        release();
+    }
+
+    const std::unique_ptr<Workers> _ownWorkers; // 0 if shared
+    const StatePtr _state;
+};
+
+DependencyExecutor::DependencyExecutor(const std::string& name,
+                                       const size_t threadCount,
+                                       const GLContext& glContext)
+    : _impl(new Impl(name, threadCount, glContext))
+{
+}
+
+DependencyExecutor::DependencyExecutor(Workers& workers,
+                                       const WorkPriority priority)
+    : _impl(new Impl(workers, priority))
+{
+}
+
+DependencyExecutor::~DependencyExecutor()
+{
+}
+
+void DependencyExecutor::clear()
+{
+    _impl->clear();
+}
+
+void DependencyExecutor::schedule(ExecutablePtr executable)
+{
+    _impl->schedule(Tracer::trace(executable));
+}
+}
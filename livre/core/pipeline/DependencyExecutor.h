@@ -0,0 +1,81 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _DependencyExecutor_h_
+#define _DependencyExecutor_h_
+
+#include <livre/core/api.h>
+#include <livre/core/pipeline/Executor.h>
+#include <livre/core/types.h>
+
+namespace livre
+{
+/**
+ * Event driven implementation of the Executor class. It has a thread pool for
+ * executing multiple executables asynchronously.
+ *
+ * Each submitted executable counts its unsatisfied preconditions. Fulfilling
+ * a precondition decrements the counter, and the executable is pushed to the
+ * worker threads by the thread which fulfils the last one. There is no
+ * scheduling thread, so an executable is started as soon as its inputs are
+ * available.
+ */
+class DependencyExecutor : public Executor
+{
+public:
+    /**
+     * @param name name for the threads
+     * @param threadCount is number of worker threads
+     * @param glContext the worker threads will share their contexts with the
+     * given context
+     */
+    LIVRECORE_API DependencyExecutor(const std::string& name,
+                                     size_t threadCount,
+                                     const GLContext& glContext);
+
+    /**
+     * @param workers the thread pool, which can be shared with other
+     * executors and has to outlive the executor
+     * @param priority of the executables scheduled by this executor
+     */
+    LIVRECORE_API DependencyExecutor(Workers& workers, WorkPriority priority);
+
+    /**
+     * Waits for the executables it gave to the Workers, also shared ones,
+     * until they are executed or dropped by the Workers. The executables whose
+     * preconditions are not satisfied yet are never executed.
+     */
+    LIVRECORE_API virtual ~DependencyExecutor();
+
+    /**
+     * @copydoc Executor::schedule
+     */
+    LIVRECORE_API void schedule(ExecutablePtr executable) final;
+
+    /**
+     * Drops the executables whose preconditions are not satisfied yet.
+     */
+    LIVRECORE_API void clear() final;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> _impl;
+};
+}
+
+#endif // _DependencyExecutor_h_
@@ -68,6 +68,17 @@ public:
      * ( The futures are not ready )
      */
     LIVRECORE_API virtual void reset() {}
+    /**
+     * Sets the token which cancels the execution. A canceled executable still
+     * fulfills its postconditions, possibly with empty data, so the executables
+     * waiting for it are not blocked.
+     * @param token is canceled when the results are not needed anymore
+     */
+    LIVRECORE_API virtual void setCancelToken(
+        const CancelToken& token LB_UNUSED)
+    {
+    }
+
     /**
      * @return returns a copy
      */
@@ -21,6 +21,7 @@
 #define _Filter_h_
 
 #include <livre/core/api.h>
+#include <livre/core/pipeline/CancelToken.h>
 #include <livre/core/pipeline/FutureMap.h>
 #include <livre/core/pipeline/FuturePromise.h>
 #include <livre/core/pipeline/PromiseMap.h>
@@ -45,6 +46,21 @@ public:
      */
     virtual void execute(const FutureMap& input, PromiseMap& output) const = 0;
 
+    /**
+     * Called instead of the above function by the @PipeFilter, so long
+     * running filters can return early once their results are not needed
+     * anymore. The unset promises are flushed afterwards.
+     * @param input The Future that can be read for input parameters
+     * @param output The Promise that can be written to for output parameters
+     * @param token is canceled when the results are not needed anymore
+     */
+    LIVRECORE_API virtual void execute(const FutureMap& input,
+                                       PromiseMap& output,
+                                       const CancelToken& token LB_UNUSED) const
+    {
+        execute(input, output);
+    }
+
     /**
      * @return map for the name and data types for the filter
      * communication. In execution time using these names and types,
@@ -69,6 +69,29 @@ public:
         return results;
     }
 
+    /**
+     * Gets references to the value(s) with the given type T, without copying
+     * them. Until all futures with a given name are ready, this function will
+     * block.
+     * @param name of the future.
+     * @return the references to the values, valid as long as the map exists
+     * and the promises are not reset.
+     * @throw std::logic_error when there is no future associated with the
+     * given name
+     * @throw std::runtime_error when the data is not exact
+     * type T
+     */
+    template <class T>
+    std::vector<std::reference_wrapper<const T>> getRefs(
+        const std::string& name) const
+    {
+        std::vector<std::reference_wrapper<const T>> results;
+        for (const auto& future : getFutures(name))
+            results.push_back(std::cref(future.get<T>()));
+
+        return results;
+    }
+
     /**
      * Gets the copy of ready value(s) with the given type T.
      * @param name of the future.
@@ -19,28 +19,77 @@
 
 #include <livre/core/pipeline/FuturePromise.h>
 
-#include <servus/uint128_t.h>
-
 #include <boost/thread/future.hpp>
 
+#include <atomic>
+
 namespace livre
 {
 typedef boost::shared_future<PortDataPtr> PortDataFuture;
 typedef boost::promise<PortDataPtr> PortDataPromise;
 typedef std::vector<PortDataFuture> PortDataFutures;
 
+namespace
+{
+/** @return a new identifier, unique within the process */
+uint64_t newId()
+{
+    static std::atomic<uint64_t> lastId(0);
+    return lastId.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+}
+
+/** The callbacks which are called once a promise is fulfilled */
+class Continuations
+{
+public:
+    void add(const std::function<void()>& callback)
+    {
+        {
+            ScopedLock lock(_mutex);
+            if (!_ready)
+            {
+                _callbacks.push_back(callback);
+                return;
+            }
+        }
+        callback();
+    }
+
+    void notify()
+    {
+        std::vector<std::function<void()>> callbacks;
+        {
+            ScopedLock lock(_mutex);
+            _ready = true;
+            callbacks.swap(_callbacks);
+        }
+        for (const auto& callback : callbacks)
+            callback();
+    }
+
+private:
+    boost::mutex _mutex;
+    bool _ready = false;
+    std::vector<std::function<void()>> _callbacks;
+};
+typedef std::shared_ptr<Continuations> ContinuationsPtr;
+
 struct Future::Impl
 {
     Impl(const PortDataFuture& future, const std::string& name,
-         const servus::uint128_t& uuid)
+         const uint64_t id, const ContinuationsPtr& continuations,
+         const bool linked = false)
         : _name(name)
         , _future(future)
-        , _uuid(uuid)
+        , _id(id)
+        , _continuations(continuations)
+        , _linked(linked)
     {
     }
 
     const std::string& getName() const { return _name; }
-    PortDataPtr get(const std::type_index& dataType) const
+    const PortData& get(const std::type_index& dataType) const
     {
         const PortDataPtr& data = _future.get();
 
@@ -50,26 +99,36 @@ struct Future::Impl
         if (data->dataType != dataType)
             LBTHROW(std::runtime_error("Types does not match on get value"));
 
-        return data;
+        return *data;
     }
 
     bool isReady() const { return _future.is_ready(); }
     void wait() const { return _future.wait(); }
     std::string _name;
     mutable PortDataFuture _future;
-    servus::uint128_t _uuid;
+    uint64_t _id;
+    ContinuationsPtr _continuations;
+
+    // Updated by Promise::reset(), otherwise immutable and shared by copies
+    const bool _linked;
 };
 
 struct Promise::Impl
 {
     Impl(const DataInfo& dataInfo)
         : _dataInfo(dataInfo)
-        , _uuid(servus::make_UUID())
+        , _id(newId())
+        , _continuations(new Continuations)
         , _futureImpl(new Future::Impl(PortDataFuture(_promise.get_future()),
-                                       dataInfo.first, _uuid))
+                                       dataInfo.first, _id, _continuations,
+                                       true))
     {
     }
 
+    // The futures become ready with a broken promise, which also releases
+    // the pending callbacks.
+    ~Impl() { _continuations->notify(); }
+
     const std::string& getName() const { return _dataInfo.first; }
     std::type_index getDataType() const { return _dataInfo.second; }
     void set(const PortDataPtr& data)
@@ -81,6 +140,8 @@ struct Promise::Impl
                     std::runtime_error("Types does not match on set value"));
         }
 
+        // A waiting thread may release the promise once the value is set
+        const ContinuationsPtr continuations = _continuations;
         try
         {
             _promise.set_value(data);
@@ -89,27 +150,25 @@ struct Promise::Impl
         {
             LBTHROW(std::runtime_error("Data only can be set once"));
         }
+        continuations->notify();
     }
 
     void reset()
     {
-        try
-        {
-            _promise.set_value(PortDataPtr());
-        }
-        catch (const boost::promise_already_satisfied&)
-        {
-        }
+        flush();
 
         PortDataPromise promise;
         _promise.swap(promise);
-        _uuid = servus::make_UUID();
+        _id = newId();
+        _continuations.reset(new Continuations);
         _futureImpl->_future = _promise.get_future();
-        _futureImpl->_uuid = _uuid;
+        _futureImpl->_id = _id;
+        _futureImpl->_continuations = _continuations;
     }
 
     void flush()
     {
+        const ContinuationsPtr continuations = _continuations;
         try
         {
             _promise.set_value(PortDataPtr());
@@ -117,11 +176,13 @@ struct Promise::Impl
         catch (const boost::promise_already_satisfied&)
         {
         }
+        continuations->notify();
     }
 
     PortDataPromise _promise;
     const DataInfo _dataInfo;
-    servus::uint128_t _uuid;
+    uint64_t _id;
+    ContinuationsPtr _continuations;
     std::shared_ptr<Future::Impl> _futureImpl;
 };
 
@@ -171,12 +232,16 @@ Future::Future(const Promise& promise)
 }
 
 Future::Future(const Future& future)
-    : _impl(new Future::Impl(future._impl->_future, future.getName(),
-                             future._impl->_uuid))
+    : _impl(future._impl->_linked
+                ? std::make_shared<Future::Impl>(future._impl->_future,
+                                                 future.getName(),
+                                                 future._impl->_id,
+                                                 future._impl->_continuations)
+                : future._impl)
 {
 }
 
-Future::Future(Future&& future)
+Future::Future(Future&& future) noexcept
     : _impl(std::move(future._impl))
 {
 }
@@ -191,7 +256,11 @@ const std::string& Future::getName() const
 }
 
 Future::Future(const Future& future, const std::string& name)
-    : _impl(new Future::Impl(future._impl->_future, name, future._impl->_uuid))
+    : _impl(!future._impl->_linked && name == future.getName()
+                ? future._impl
+                : std::make_shared<Future::Impl>(future._impl->_future, name,
+                                                 future._impl->_id,
+                                                 future._impl->_continuations))
 {
 }
 
@@ -205,17 +274,22 @@ bool Future::isReady() const
     return _impl->isReady();
 }
 
+void Future::onReady(const std::function<void()>& callback) const
+{
+    _impl->_continuations->add(callback);
+}
+
 bool Future::operator==(const Future& future) const
 {
-    return _impl->_uuid == future._impl->_uuid;
+    return _impl->_id == future._impl->_id;
 }
 
-const servus::uint128_t& Future::getId() const
+uint64_t Future::getId() const
 {
-    return _impl->_uuid;
+    return _impl->_id;
 }
 
-PortDataPtr Future::_getPtr(const std::type_index& dataType) const
+const PortData& Future::_getData(const std::type_index& dataType) const
 {
     return _impl->get(dataType);
 }
@@ -51,14 +51,15 @@ public:
 
     /**
      * Sets the port with the value.
-     * @param value to be set
+     * @param value to be set, moved into the promise if it is an rvalue
      * @throw std::runtime_error when the port data is not exact
      * type T or there is no such port name.
      */
     template <class T>
-    void set(const T& value)
+    void set(T&& value)
     {
-        _set(std::make_shared<PortDataT<T>>(value));
+        typedef typename std::decay<T>::type ValueT;
+        _set(std::make_shared<PortDataT<ValueT>>(std::forward<T>(value)));
     }
 
     /**
@@ -104,7 +105,7 @@ class Future
 public:
     ~Future();
     Future(const Future& future);
-    Future(Future&& future);
+    Future(Future&& future) noexcept;
 
     /**
      * @return name of the future
@@ -119,7 +120,9 @@ public:
     /**
      * Gets the value with the given type T. Blocks until data is
      * available.
-     * @return the value.
+     * @return the value. The reference is valid as long as the future exists
+     * and, for a future constructed from a promise, until the promise is
+     * reset.
      * @throw std::runtime_error when the data is not exact
      * type T
      */
@@ -139,6 +142,14 @@ public:
      */
     bool isReady() const;
 
+    /**
+     * Calls the callback once the future is ready. If it is already ready,
+     * the callback is called immediately, otherwise from the thread which
+     * sets, flushes or resets the promise. The callback should not block.
+     * @param callback is called exactly once
+     */
+    void onReady(const std::function<void()>& callback) const;
+
     /**
      * @param future is the future to be checked with
      * @return true if both futures are belonging to same promise
@@ -151,9 +162,10 @@ public:
      */
     bool operator!=(const Future& future) const { return !(*this == future); }
     /**
-     * @return the unique identifier for the future
+     * @return the identifier of the future, unique within the process. The
+     * identifiers are not meant to be shared with other processes.
      */
-    const servus::uint128_t& getId() const;
+    uint64_t getId() const;
 
     /**
      * Promise construction is needed when reset() on the promise
@@ -173,13 +185,10 @@ private:
     template <class T>
     const T& _get() const
     {
-        const auto dataPtr =
-            std::static_pointer_cast<const PortDataT<T>>(_getPtr(getType<T>()));
-
-        return dataPtr->data;
+        return static_cast<const PortDataT<T>&>(_getData(getType<T>())).data;
     }
 
-    PortDataPtr _getPtr(const std::type_index& dataType) const;
+    const PortData& _getData(const std::type_index& dataType) const;
 
     struct Impl;
     std::shared_ptr<Impl> _impl;
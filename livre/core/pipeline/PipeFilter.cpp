@@ -18,25 +18,73 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
-#include <livre/core/pipeline/Filter.h>
+#include <livre/core/pipeline/AsyncFilter.h>
 #include <livre/core/pipeline/FutureMap.h>
 #include <livre/core/pipeline/FuturePromise.h>
 #include <livre/core/pipeline/InputPort.h>
 #include <livre/core/pipeline/OutputPort.h>
 #include <livre/core/pipeline/PipeFilter.h>
 #include <livre/core/pipeline/PromiseMap.h>
+#include <livre/core/pipeline/Tracer.h>
 
 namespace livre
 {
-struct PipeFilter::Impl
+struct PipeFilter::Impl : public std::enable_shared_from_this<Impl>
 {
     typedef std::map<std::string, OutputPort> OutputPortMap;
     typedef std::map<std::string, InputPort> InputPortMap;
+    typedef std::shared_ptr<const FutureMap> FutureMapPtr;
+
+    /**
+     * Resumes a suspended execution of an asynchronous filter. It is
+     * scheduled with the awaited futures as preconditions, so no thread
+     * waits for them.
+     */
+    class Continuation : public Executable
+    {
+    public:
+        Continuation(std::shared_ptr<Impl> impl, Executor& executor,
+                     FutureMapPtr input, Suspension&& suspension)
+            : _impl(std::move(impl))
+            , _executor(executor)
+            , _input(std::move(input))
+            , _suspension(std::move(suspension))
+        {
+        }
+
+        void execute() final
+        {
+            _impl->resume(_executor, _input, _suspension.resume());
+        }
+
+        Futures getPostconditions() const final
+        {
+            return _impl->getPostconditions();
+        }
+
+        Futures getPreconditions() const final
+        {
+            return _suspension.getFutures();
+        }
+
+        ExecutablePtr clone() const final
+        {
+            return ExecutablePtr(new Continuation(*this));
+        }
+
+    private:
+        const std::shared_ptr<Impl> _impl;
+        Executor& _executor;
+        const FutureMapPtr _input;
+        Suspension _suspension;
+    };
 
     Impl(PipeFilter& pipeFilter, const std::string& name, FilterPtr filter)
         : _pipeFilter(pipeFilter)
         , _name(name)
+        , _traceId(Tracer::getNameId(name))
         , _filter(std::move(filter))
+        , _asyncFilter(dynamic_cast<const AsyncFilter*>(_filter.get()))
     {
         for (const DataInfo& dataInfo : _filter->getInputDataInfos())
         {
@@ -51,6 +99,10 @@ struct PipeFilter::Impl
                                std::forward_as_tuple(dataInfo.first),
                                std::forward_as_tuple(dataInfo));
         }
+
+        // The promises are reset in place, so the map is valid for all
+        // executions
+        _outputPromises.reset(new PromiseMap(getOutputPromises()));
     }
 
     bool hasInputPort(const std::string& portName) const
@@ -69,8 +121,15 @@ struct PipeFilter::Impl
                                    portName));
     }
 
-    void execute()
+    void execute(Executor* executor)
     {
+        const Tracer::Scope trace(_traceId);
+        if (_cancelToken.isCanceled())
+        {
+            _outputPromises->flush();
+            return;
+        }
+
         Futures inputFutures;
         for (const auto& namePort : _inputMap)
         {
@@ -79,13 +138,60 @@ struct PipeFilter::Impl
                 inputFutures.emplace_back(future, namePort.second.getName());
         }
 
+        if (_asyncFilter && executor)
+        {
+            const AsyncFilter& filter = *_asyncFilter;
+            executeStep(*executor,
+                        std::make_shared<const FutureMap>(inputFutures),
+                        [&filter](const FutureMap& input, PromiseMap& output,
+                                  Suspension& suspension) {
+                            filter.execute(input, output, suspension);
+                        });
+            return;
+        }
+
         const FutureMap futures(inputFutures);
-        PromiseMap promises(getOutputPromises());
+        PromiseMap& promises = *_outputPromises;
 
         try
         {
-            _filter->execute(futures, promises);
+            _filter->execute(futures, promises, _cancelToken);
+            promises.flush();
+        }
+        catch (const std::runtime_error& err)
+        {
+            promises.flush();
+            throw err;
+        }
+        catch (const std::logic_error& err)
+        {
             promises.flush();
+            throw err;
+        }
+    }
+
+    void resume(Executor& executor, const FutureMapPtr& input,
+                const AsyncFilter::Step& step)
+    {
+        const Tracer::Scope trace(_traceId);
+        if (_cancelToken.isCanceled())
+        {
+            _outputPromises->flush();
+            return;
+        }
+        executeStep(executor, input, step);
+    }
+
+    // Runs one step of an asynchronous filter, and schedules the next one if
+    // the step suspended the execution
+    void executeStep(Executor& executor, const FutureMapPtr& input,
+                     const AsyncFilter::Step& step)
+    {
+        PromiseMap& promises = *_outputPromises;
+        Suspension suspension(_cancelToken);
+        try
+        {
+            step(*input, promises, suspension);
         }
         catch (const std::runtime_error& err)
         {
@@ -97,6 +203,16 @@ struct PipeFilter::Impl
             promises.flush();
             throw err;
         }
+
+        if (!suspension.isSuspended())
+        {
+            promises.flush();
+            return;
+        }
+
+        executor.schedule(
+            ExecutablePtr(new Continuation(shared_from_this(), executor, input,
+                                           std::move(suspension))));
     }
 
     Promise getInputPromise(const std::string& portName)
@@ -172,24 +288,30 @@ struct PipeFilter::Impl
 
     void reset()
     {
+        // The manually set ports are kept, so a reused filter only allocates
+        // its new values
         for (auto& namePort : _manuallySetPortsMap)
-            _inputMap.find(namePort.first)->second.disconnect(namePort.second);
+            namePort.second.reset();
 
-        _manuallySetPortsMap.clear();
         for (auto& namePort : _outputMap)
             namePort.second.reset();
     }
 
     PipeFilter& _pipeFilter;
     const std::string _name;
+    const uint32_t _traceId;
     const FilterPtr _filter;
+    const AsyncFilter* const _asyncFilter; // 0 for synchronous filters
     InputPortMap _inputMap;
     OutputPortMap _outputMap;
     OutputPortMap _manuallySetPortsMap;
+    std::unique_ptr<PromiseMap> _outputPromises;
+    CancelToken _cancelToken;
 };
 
 PipeFilter::PipeFilter(const std::string& name, FilterPtr&& filter)
-    : _impl(new Impl(*this, name, std::move(filter)))
+    : _impl(std::make_shared<Impl>(*this, name, std::move(filter)))
+    , _executor(nullptr)
 {
 }
 
@@ -214,7 +336,7 @@ Promise PipeFilter::getPromise(const std::string& portName)
 
 void PipeFilter::execute()
 {
-    _impl->execute();
+    _impl->execute(_executor);
 }
 
 Futures PipeFilter::getPostconditions() const
@@ -232,6 +354,18 @@ void PipeFilter::reset()
     _impl->reset();
 }
 
+void PipeFilter::setCancelToken(const CancelToken& token)
+{
+    _impl->_cancelToken = token;
+}
+
+void PipeFilter::_schedule(Executor& executor)
+{
+    PipeFilter* filter = new PipeFilter(*this);
+    filter->_executor = &executor;
+    executor.schedule(ExecutablePtr(filter));
+}
+
 void PipeFilter::connect(const std::string& srcPortName, PipeFilter& dst,
                          const std::string& dstPortName)
 {
@@ -80,10 +80,19 @@ public:
     LIVRECORE_API Futures getPreconditions() const final;
 
     /**
-     * @copydoc Executable::reset
+     * Resets the promises of the output ports and of the manually set input
+     * ports. The connections are kept, so the filter can be executed again
+     * once its inputs are set.
      */
     LIVRECORE_API void reset() final;
 
+    /**
+     * @copydoc Executable::setCancelToken
+     * A filter canceled before its execution only flushes its outputs. The
+     * token is kept by reset().
+     */
+    LIVRECORE_API void setCancelToken(const CancelToken& token) final;
+
 protected:
     /**
      * Constructs a PipeFilter with a given filter
@@ -95,8 +104,15 @@ protected:
 private:
     ExecutablePtr clone() const;
 
+    /**
+     * Schedules a copy which resumes the suspended executions of an
+     * @AsyncFilter on the executor.
+     */
+    void _schedule(Executor& executor) final;
+
     struct Impl;
     std::shared_ptr<Impl> _impl;
+    Executor* _executor; // of the scheduled copy, 0 for direct executions
 };
 
 /**
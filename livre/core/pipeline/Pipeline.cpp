@@ -21,6 +21,9 @@
 #include <livre/core/pipeline/FutureMap.h>
 #include <livre/core/pipeline/Pipeline.h>
 
+#include <unordered_map>
+#include <unordered_set>
+
 namespace livre
 {
 struct Pipeline::Impl
@@ -41,48 +44,110 @@ struct Pipeline::Impl
             LBTHROW(std::runtime_error(name + " already exists"));
 
         if (wait)
-        {
-            const Futures& futures = executable->getPostconditions();
-            _outFutures.insert(_outFutures.end(), futures.begin(),
-                               futures.end());
-        }
+            _waitExecutables.push_back(executable.get());
 
         _executableMap.emplace(std::piecewise_construct,
                                std::forward_as_tuple(name),
                                std::forward_as_tuple(std::move(executable)));
+        _order.clear();
     }
 
+    // Executes in topological order, so only the inputs set outside of the
+    // pipeline are waited for
     void execute()
     {
-        Executables executables = getExecutables();
-        Executables::iterator it = executables.begin();
-        while (!executables.empty())
+        for (Executable* executable : getOrder())
         {
-            Executable* executable = *it;
-            const FutureMap futureMap(executable->getPreconditions());
-            if (futureMap.isReady())
-            {
-                executable->execute();
-                executables.erase(it);
-                it = executables.begin();
-            }
-            else
-            {
-                if (it == executables.end())
-                    break;
-                ++it;
-            }
+            FutureMap(executable->getPreconditions()).wait();
+            executable->execute();
         }
     }
 
-    Executables getExecutables() const
+    void execute(Executor& executor)
     {
-        Executables executables;
+        // Scheduled in topological order, so the producers are queued before
+        // their consumers
+        Futures futures;
+        for (Executable* executable : getOrder())
+        {
+            const Futures& postconditions = executable->schedule(executor);
+            futures.insert(futures.end(), postconditions.begin(),
+                           postconditions.end());
+        }
+        FutureMap(futures).wait();
+    }
 
-        for (auto& nameExec : _executableMap)
+    size_t countConnections() const
+    {
+        // Connections are only added, so their number changes with the graph
+        size_t nConnections = 0;
+        for (const auto& nameExec : _executableMap)
+            nConnections += nameExec.second->getPreconditions().size();
+        return nConnections;
+    }
+
+    // The order is computed again once executables or connections are added
+    const std::vector<Executable*>& getOrder()
+    {
+        const size_t nConnections = countConnections();
+        if (_order.size() == _executableMap.size() &&
+            _orderConnections == nConnections)
+        {
+            return _order;
+        }
+
+        std::vector<Executable*> executables;
+        std::unordered_map<uint64_t, size_t> producers; // future id -> index
+        for (const auto& nameExec : _executableMap)
+        {
+            for (const Future& future : nameExec.second->getPostconditions())
+                producers[future.getId()] = executables.size();
             executables.push_back(nameExec.second.get());
+        }
+
+        const size_t nExecutables = executables.size();
+        std::vector<std::vector<size_t>> consumers(nExecutables);
+        std::vector<size_t> nProducers(nExecutables, 0);
+        for (size_t i = 0; i < nExecutables; ++i)
+        {
+            for (const Future& future : executables[i]->getPreconditions())
+            {
+                const auto producer = producers.find(future.getId());
+                if (producer == producers.end() || producer->second == i)
+                    continue;
+
+                consumers[producer->second].push_back(i);
+                ++nProducers[i];
+            }
+        }
+
+        std::vector<size_t> ready;
+        for (size_t i = nExecutables; i > 0; --i)
+        {
+            if (nProducers[i - 1] == 0)
+                ready.push_back(i - 1);
+        }
 
-        return executables;
+        _order.clear();
+        while (!ready.empty())
+        {
+            const size_t index = ready.back();
+            ready.pop_back();
+            _order.push_back(executables[index]);
+            for (const size_t consumer : consumers[index])
+            {
+                if (--nProducers[consumer] == 0)
+                    ready.push_back(consumer);
+            }
+        }
+
+        if (_order.size() != nExecutables)
+        {
+            _order.clear();
+            LBTHROW(std::runtime_error("The pipeline has a cycle"));
+        }
+        _orderConnections = nConnections;
+        return _order;
     }
 
     Executable& getExecutable(const std::string& name)
@@ -95,20 +160,43 @@ struct Pipeline::Impl
 
     Futures getPreconditions() const
     {
+        // The futures produced within the pipeline are not preconditions
+        std::unordered_set<uint64_t> produced;
+        for (const auto& nameExec : _executableMap)
+        {
+            for (const Future& future : nameExec.second->getPostconditions())
+                produced.insert(future.getId());
+        }
+
         Futures inFutures;
-        for (auto& nameExec : _executableMap)
+        for (const auto& nameExec : _executableMap)
         {
-            const Futures& futures = nameExec.second->getPreconditions();
-            inFutures.insert(inFutures.end(), futures.begin(), futures.end());
+            for (const Future& future : nameExec.second->getPreconditions())
+            {
+                if (!produced.count(future.getId()))
+                    inFutures.push_back(future);
+            }
         }
         return inFutures;
     }
 
-    Futures getPostconditions() const { return _outFutures; }
+    Futures getPostconditions() const
+    {
+        // Queried on each call, as reset() renews the futures
+        Futures outFutures;
+        for (const Executable* executable : _waitExecutables)
+        {
+            const Futures& futures = executable->getPostconditions();
+            outFutures.insert(outFutures.end(), futures.begin(),
+                              futures.end());
+        }
+        return outFutures;
+    }
+
     void schedule(Executor& executor)
     {
         for (auto& nameExec : _executableMap)
-            executor.schedule(nameExec.second->clone());
+            nameExec.second->schedule(executor);
     }
 
     void reset()
@@ -117,9 +205,17 @@ struct Pipeline::Impl
             nameExec.second->reset();
     }
 
+    void setCancelToken(const CancelToken& token)
+    {
+        for (auto& nameExec : _executableMap)
+            nameExec.second->setCancelToken(token);
+    }
+
     Pipeline& _pipeline;
     ExecutableMap _executableMap;
-    Futures _outFutures;
+    Executables _waitExecutables;
+    std::vector<Executable*> _order; // topological, empty if outdated
+    size_t _orderConnections = 0;    // connections when _order was computed
 };
 
 Pipeline::Pipeline()
@@ -147,6 +243,11 @@ void Pipeline::execute()
     _impl->execute();
 }
 
+void Pipeline::execute(Executor& executor)
+{
+    _impl->execute(executor);
+}
+
 Futures Pipeline::getPostconditions() const
 {
     return _impl->getPostconditions();
@@ -162,6 +263,11 @@ void Pipeline::reset()
     _impl->reset();
 }
 
+void Pipeline::setCancelToken(const CancelToken& token)
+{
+    _impl->setCancelToken(token);
+}
+
 void Pipeline::_schedule(Executor& executor)
 {
     _impl->schedule(executor);
@@ -77,17 +77,31 @@ public:
     LIVRECORE_API Executable& getExecutable(const std::string& name);
 
     /**
-     * @copydoc Executable::execute
+     * Executes the executables on the calling thread in topological order.
+     * The order is computed at the first execution, and again once
+     * executables or connections are added. The inputs which are set outside
+     * of the pipeline are waited for.
+     * @throw std::runtime_error if the connections have a cycle
      */
     LIVRECORE_API void execute() final;
 
+    /**
+     * Schedules the executables in topological order, so independent
+     * branches run in parallel, and waits for the postconditions of all of
+     * them.
+     * @param executor runs the executables, e.g. a DependencyExecutor
+     * @throw std::runtime_error if the connections have a cycle
+     */
+    LIVRECORE_API void execute(Executor& executor);
+
     /**
      * @copydoc Executable::getPostconditions
      */
     LIVRECORE_API Futures getPostconditions() const final;
 
     /**
-     * @copydoc Executable::getPreconditions
+     * @return the input conditions which are not fulfilled by the executables
+     * of the pipeline, i.e. the inputs set from outside.
      */
     LIVRECORE_API Futures getPreconditions() const final;
 
@@ -96,6 +110,12 @@ public:
      */
     LIVRECORE_API void reset() final;
 
+    /**
+     * Sets the token of all the executables of the pipeline.
+     * @copydoc Executable::setCancelToken
+     */
+    LIVRECORE_API void setCancelToken(const CancelToken& token) final;
+
 private:
     void _add(const std::string& name, UniqueExecutablePtr exec, bool wait);
 
@@ -57,6 +57,16 @@ struct PortDataT final : public PortData
     {
     }
 
+    /**
+     * Constructor
+     * @param data_ is moved
+     */
+    explicit PortDataT(T&& data_)
+        : PortData(getType<T>())
+        , data(std::move(data_))
+    {
+    }
+
     ~PortDataT() {}
     const T data;
 
@@ -46,16 +46,16 @@ public:
     /**
      * Sets the port with the value.
      * @param name of the promise
-     * @param value to be set
+     * @param value to be set, moved into the promise if it is an rvalue
      * @throw std::logic_error when there is no promise associated with the
      * given name
      * @throw std::runtime_error when the port data is not exact
      * type T
      */
     template <class T>
-    void set(const std::string& name, const T& value) const
+    void set(const std::string& name, T&& value) const
     {
-        getPromise(name).set(value);
+        getPromise(name).set(std::forward<T>(value));
     }
 
     /**
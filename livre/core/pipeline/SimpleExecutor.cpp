@@ -25,6 +25,7 @@
 #include <livre/core/pipeline/FutureMap.h>
 #include <livre/core/pipeline/FuturePromise.h>
 #include <livre/core/pipeline/PipeFilter.h>
+#include <livre/core/pipeline/Tracer.h>
 #include <livre/core/pipeline/Workers.h>
 
 #include <livre/core/render/GLContext.h>
@@ -49,7 +50,18 @@ struct SimpleExecutor::Impl
 {
     Impl(const std::string& name, const size_t threadCount,
          const GLContext& glContext)
-        : _workers(name, threadCount, glContext)
+        : _ownWorkers(new Workers(name, threadCount, glContext))
+        , _workers(*_ownWorkers)
+        , _priority(PRIORITY_RENDER)
+        , _unlockPromise(DataInfo("LoopUnlock", getType<bool>()))
+        , _workThread(boost::thread(boost::bind(&Impl::schedule, this)))
+        , _name(name + "Exec")
+    {
+    }
+
+    Impl(const std::string& name, Workers& workers, const WorkPriority priority)
+        : _workers(workers)
+        , _priority(priority)
         , _unlockPromise(DataInfo("LoopUnlock", getType<bool>()))
         , _workThread(boost::thread(boost::bind(&Impl::schedule, this)))
         , _name(name + "Exec")
@@ -109,7 +121,7 @@ struct SimpleExecutor::Impl
                 const FutureMap futureMap(preConds);
                 if (futureMap.isReady())
                 {
-                    _workers.schedule(executable);
+                    _workers.schedule(executable, _priority);
                     it = executables.erase(it);
                     for (const auto& future : futureMap.getFutures())
                         inputConditions.erase(future);
@@ -131,7 +143,9 @@ struct SimpleExecutor::Impl
     }
 
     lunchbox::MTQueue<ExecutablePtr> _mtWorkQueue;
-    Workers _workers;
+    const std::unique_ptr<Workers> _ownWorkers; // 0 if shared
+    Workers& _workers;
+    const WorkPriority _priority;
     Promise _unlockPromise;
     boost::mutex _promiseReset;
     boost::thread _workThread;
@@ -145,6 +159,12 @@ SimpleExecutor::SimpleExecutor(const std::string& name,
 {
 }
 
+SimpleExecutor::SimpleExecutor(const std::string& name, Workers& workers,
+                               const WorkPriority priority)
+    : _impl(new Impl(name, workers, priority))
+{
+}
+
 SimpleExecutor::~SimpleExecutor()
 {
 }
@@ -156,6 +176,6 @@ void SimpleExecutor::clear()
 
 void SimpleExecutor::schedule(ExecutablePtr executable)
 {
-    _impl->schedule(executable);
+    _impl->schedule(Tracer::trace(executable));
 }
 }
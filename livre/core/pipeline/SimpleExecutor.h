@@ -47,6 +47,15 @@ public:
     LIVRECORE_API SimpleExecutor(const std::string& name, size_t threadCount,
                                  const GLContext& glContext);
 
+    /**
+     * @param name name for the thread
+     * @param workers the thread pool, which can be shared with other
+     * executors and has to outlive the executor
+     * @param priority of the executables scheduled by this executor
+     */
+    LIVRECORE_API SimpleExecutor(const std::string& name, Workers& workers,
+                                 WorkPriority priority);
+
     LIVRECORE_API virtual ~SimpleExecutor();
 
     /**
@@ -0,0 +1,367 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <livre/core/pipeline/Executable.h>
+#include <livre/core/pipeline/Tracer.h>
+
+#include <boost/thread/tss.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace livre
+{
+namespace
+{
+const uint64_t capacity = 1 << 16; // events in the ring buffer
+
+enum Field
+{
+    FIELD_NAME_FRAME, // name id in the upper, frame id in the lower 32 bits
+    FIELD_THREAD,
+    FIELD_QUEUED,
+    FIELD_START,
+    FIELD_END,
+    FIELD_CPU, // core the execution ended on, plus one; 0 if unknown
+    FIELD_ALL
+};
+
+/**
+ * An event of the ring buffer. The fields are written and read like a
+ * sequence lock: the sequence is odd while the event is written.
+ */
+struct Slot
+{
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint64_t> fields[FIELD_ALL];
+};
+
+/** The schedule time and frame of the executable run by a thread */
+struct Queued
+{
+    uint64_t time;
+    uint32_t frame;
+};
+
+void keepQueued(Queued*)
+{
+}
+
+std::atomic<bool> enabled(false);
+std::atomic<uint32_t> currentFrame(0);
+std::atomic<uint64_t> firstEvent(0); // moved by clear()
+std::atomic<uint64_t> nextEvent(0);
+std::atomic<uint32_t> nThreads(0);
+std::atomic<Slot*> slots(nullptr); // allocated once enabled, never freed
+
+boost::mutex namesMutex;
+std::vector<std::string> names;
+std::map<std::string, uint32_t> nameIds;
+
+boost::thread_specific_ptr<Queued> queuedExecution(keepQueued);
+boost::thread_specific_ptr<uint32_t> threadId;
+
+uint64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+uint64_t getCPU()
+{
+#ifdef __linux__
+    return uint64_t(sched_getcpu() + 1); // -1 on error
+#else
+    return 0;
+#endif
+}
+
+uint32_t getThreadId()
+{
+    if (!threadId.get())
+        threadId.reset(new uint32_t(nThreads++));
+    return *threadId;
+}
+
+void record(const uint32_t nameId, const uint32_t frame,
+            const uint64_t queued, const uint64_t start, const uint64_t end)
+{
+    const uint64_t fields[FIELD_ALL] = {uint64_t(nameId) << 32 | frame,
+                                        getThreadId(), queued, start, end,
+                                        getCPU()};
+
+    Slot* const ring = slots.load(std::memory_order_acquire);
+    if (!ring)
+        return;
+
+    const uint64_t index = nextEvent++;
+    Slot& slot = ring[index % capacity];
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < FIELD_ALL; ++i)
+        slot.fields[i].store(fields[i], std::memory_order_relaxed);
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+/** @return false if the event is overwritten or still written */
+bool read(const Slot* ring, const uint64_t index, uint64_t fields[FIELD_ALL])
+{
+    const Slot& slot = ring[index % capacity];
+    const uint64_t sequence = 2 * index + 2;
+    if (slot.sequence.load(std::memory_order_acquire) != sequence)
+        return false;
+
+    for (size_t i = 0; i < FIELD_ALL; ++i)
+        fields[i] = slot.fields[i].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+std::string escape(const std::string& name)
+{
+    std::string escaped;
+    for (const char c : name)
+    {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+/**
+ * Records the frame an executable is scheduled for, and the time it waits in
+ * the Workers once its preconditions are met.
+ */
+class TracedExecutable : public Executable
+{
+public:
+    explicit TracedExecutable(ExecutablePtr executable)
+        : _executable(std::move(executable))
+    {
+        _queued.time = now(); // until setQueued()
+        _queued.frame = currentFrame.load(std::memory_order_relaxed);
+    }
+
+    void setQueued() { _queued.time = now(); }
+
+    void execute() final
+    {
+        struct Reset
+        {
+            ~Reset() { queuedExecution.reset(); }
+        } reset;
+
+        queuedExecution.reset(&_queued);
+        _executable->execute();
+    }
+
+    Futures getPostconditions() const final
+    {
+        return _executable->getPostconditions();
+    }
+
+    Futures getPreconditions() const final
+    {
+        return _executable->getPreconditions();
+    }
+
+    void reset() final { _executable->reset(); }
+    void setCancelToken(const CancelToken& token) final
+    {
+        _executable->setCancelToken(token);
+    }
+
+    ExecutablePtr clone() const final
+    {
+        return ExecutablePtr(new TracedExecutable(*this));
+    }
+
+private:
+    const ExecutablePtr _executable;
+    Queued _queued;
+};
+}
+
+void Tracer::setEnabled(const bool enabled_)
+{
+    // The recording threads may hold the ring buffer, so it is kept once it
+    // is allocated
+    if (enabled_ && !slots.load(std::memory_order_acquire))
+    {
+        Slot* ring = new Slot[capacity]();
+        Slot* expected = nullptr;
+        if (!slots.compare_exchange_strong(expected, ring))
+            delete[] ring;
+    }
+    enabled = enabled_;
+}
+
+bool Tracer::isEnabled()
+{
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void Tracer::setFrame(const uint32_t frameId)
+{
+    currentFrame.store(frameId, std::memory_order_relaxed);
+}
+
+ExecutablePtr Tracer::trace(ExecutablePtr executable)
+{
+    if (!isEnabled())
+        return executable;
+    return ExecutablePtr(new TracedExecutable(std::move(executable)));
+}
+
+void Tracer::setQueued(Executable& executable)
+{
+    if (!isEnabled())
+        return;
+
+    if (TracedExecutable* traced = dynamic_cast<TracedExecutable*>(&executable))
+        traced->setQueued();
+}
+
+uint32_t Tracer::getNameId(const std::string& name)
+{
+    ScopedLock lock(namesMutex);
+    const auto i = nameIds.find(name);
+    if (i != nameIds.end())
+        return i->second;
+
+    names.push_back(name);
+    return nameIds[name] = uint32_t(names.size() - 1);
+}
+
+uint32_t Tracer::getProcessId()
+{
+#ifdef _WIN32
+    return uint32_t(_getpid());
+#else
+    return uint32_t(getpid());
+#endif
+}
+
+void Tracer::write(std::ostream& os)
+{
+    const uint32_t pid = getProcessId();
+    const Slot* ring = slots.load(std::memory_order_acquire);
+    const uint64_t end = ring ? nextEvent.load() : firstEvent.load();
+    uint64_t begin = firstEvent;
+    if (end - begin > capacity)
+        begin = end - capacity;
+
+    std::vector<std::string> eventNames;
+    {
+        ScopedLock lock(namesMutex);
+        for (const std::string& name : names)
+            eventNames.push_back(escape(name));
+    }
+
+    os << "{\"traceEvents\":[";
+    const char* separator = "\n";
+    for (uint64_t i = begin; i < end; ++i)
+    {
+        uint64_t fields[FIELD_ALL];
+        if (!read(ring, i, fields))
+            continue;
+
+        const std::string& name = eventNames[fields[FIELD_NAME_FRAME] >> 32];
+        const uint32_t frame = uint32_t(fields[FIELD_NAME_FRAME]);
+        const uint64_t queued = fields[FIELD_QUEUED];
+        const uint64_t start = fields[FIELD_START];
+
+        os << separator << "{\"name\":\"" << name
+           << "\",\"cat\":\"filter\",\"ph\":\"X\",\"pid\":" << pid
+           << ",\"tid\":" << fields[FIELD_THREAD] << ",\"ts\":" << start
+           << ",\"dur\":" << fields[FIELD_END] - start
+           << ",\"args\":{\"frame\":" << frame
+           << ",\"wait\":" << start - queued;
+        if (fields[FIELD_CPU] > 0)
+            os << ",\"cpu\":" << fields[FIELD_CPU] - 1;
+        os << "}}";
+        separator = ",\n";
+
+        // the wait in the Workers is shown on its own track
+        if (start == queued)
+            continue;
+        os << separator << "{\"name\":\"" << name
+           << "\",\"cat\":\"wait\",\"ph\":\"b\",\"pid\":" << pid
+           << ",\"id\":" << i << ",\"ts\":" << queued
+           << ",\"args\":{\"frame\":" << frame << "}}" << separator
+           << "{\"name\":\"" << name
+           << "\",\"cat\":\"wait\",\"ph\":\"e\",\"pid\":" << pid
+           << ",\"id\":" << i << ",\"ts\":" << start << "}";
+    }
+    os << "\n],\"displayTimeUnit\":\"ms\"}" << std::endl;
+}
+
+bool Tracer::write(const std::string& filename)
+{
+    std::ofstream file(filename.c_str());
+    if (!file)
+        return false;
+
+    write(file);
+    return file.good();
+}
+
+void Tracer::clear()
+{
+    firstEvent = nextEvent.load();
+}
+
+Tracer::Scope::Scope(const uint32_t nameId)
+    : _nameId(nameId)
+    , _start(isEnabled() ? now() : 0)
+    , _queued(_start)
+    , _frame(0)
+{
+    if (_start == 0)
+        return;
+
+    // Only the first scope of a traced executable waited in the Workers, the
+    // scopes it runs inline, e.g. from Pipeline::execute(), did not
+    if (const Queued* queued = queuedExecution.get())
+    {
+        _queued = queued->time;
+        _frame = queued->frame;
+        queuedExecution.reset();
+    }
+    else
+        _frame = currentFrame.load(std::memory_order_relaxed);
+}
+
+Tracer::Scope::~Scope()
+{
+    if (_start != 0)
+        record(_nameId, _frame, _queued, _start, now());
+}
+}
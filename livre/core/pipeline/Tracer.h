@@ -0,0 +1,120 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _Tracer_h_
+#define _Tracer_h_
+
+#include <livre/core/api.h>
+#include <livre/core/types.h>
+
+namespace livre
+{
+/**
+ * Records the executions of the pipeline filters into a lock-free ring buffer
+ * and writes them in the Chrome trace event format, which can be loaded in
+ * chrome://tracing or Perfetto.
+ *
+ * Each event has the name of the filter, its thread, its run time, the frame
+ * it was scheduled for, the time it waited in the Workers and, on Linux, the
+ * core it ran on, e.g. to check the affinity of the Workers. The tracer is
+ * shared by all the pipelines of the process, the events carry its process
+ * id. It is disabled by default, and then costs one atomic load per scheduled
+ * or executed filter; the ring buffer is allocated when it is first enabled.
+ */
+class Tracer
+{
+public:
+    /**
+     * Enables or disables the recording. The recorded events are kept.
+     * @param enabled true to record the executions
+     */
+    LIVRECORE_API static void setEnabled(bool enabled);
+
+    /** @return true if the executions are recorded */
+    LIVRECORE_API static bool isEnabled();
+
+    /**
+     * @param frameId is recorded with the executables scheduled from now on
+     */
+    LIVRECORE_API static void setFrame(uint32_t frameId);
+
+    /**
+     * @param executable to be scheduled
+     * @return an executable which records the frame it is scheduled for and
+     * the time it waits in the Workers, or the given one if the tracer is
+     * disabled
+     */
+    LIVRECORE_API static ExecutablePtr trace(ExecutablePtr executable);
+
+    /**
+     * Starts the wait of an executable returned by trace(), once its
+     * preconditions are met and it is submitted to the Workers. Does nothing
+     * for the other executables.
+     */
+    LIVRECORE_API static void setQueued(Executable& executable);
+
+    /**
+     * @param name of an execution, e.g. the filter name
+     * @return the id of the name for Scope, to be looked up once per filter
+     */
+    LIVRECORE_API static uint32_t getNameId(const std::string& name);
+
+    /** @return the id of the process, written with the events */
+    LIVRECORE_API static uint32_t getProcessId();
+
+    /**
+     * Writes the recorded events, the oldest ones are overwritten once the
+     * ring buffer is full.
+     * @param os the stream to write the Chrome trace JSON to
+     */
+    LIVRECORE_API static void write(std::ostream& os);
+
+    /**
+     * @param filename of the Chrome trace JSON file
+     * @return false if the file can not be written
+     */
+    LIVRECORE_API static bool write(const std::string& filename);
+
+    /** Discards the recorded events. */
+    LIVRECORE_API static void clear();
+
+    /**
+     * Records the execution of the enclosing scope, if the tracer is enabled.
+     * The wait in the Workers is recorded with the outermost scope of a traced
+     * executable, the scopes nested in it are recorded without a wait.
+     */
+    class Scope
+    {
+    public:
+        /** @param nameId of the execution, see getNameId() */
+        LIVRECORE_API explicit Scope(uint32_t nameId);
+        LIVRECORE_API ~Scope();
+
+    private:
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        const uint32_t _nameId;
+        uint64_t _start; // 0 if the tracer is disabled
+        uint64_t _queued;
+        uint32_t _frame;
+    };
+};
+}
+
+#endif // _Tracer_h_
@@ -18,69 +18,173 @@
  */
 
 #include <livre/core/pipeline/Executable.h>
+#include <livre/core/pipeline/Tracer.h>
 #include <livre/core/pipeline/Workers.h>
 #include <livre/core/render/GLContext.h>
 
-#include <lunchbox/mtQueue.h>
+#include <lunchbox/thread.h>
 
+#include <boost/algorithm/string.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <boost/thread/thread.hpp>
+#include <boost/thread/tss.hpp>
+
+#include <atomic>
 
 namespace livre
 {
+namespace
+{
+const size_t nPriorities = PRIORITY_BACKGROUND + 1;
+
+/** The queues of one worker thread, one per priority */
+struct Queues
+{
+    bool pop(const WorkPriority priority, ExecutablePtr& executable,
+             const bool stealing)
+    {
+        ScopedLock lock(mutex);
+        std::deque<ExecutablePtr>& queue = queues[priority];
+        if (queue.empty())
+            return false;
+
+        if (stealing)
+        {
+            executable = std::move(queue.front());
+            queue.pop_front();
+        }
+        else
+        {
+            executable = std::move(queue.back());
+            queue.pop_back();
+        }
+        return true;
+    }
+
+    void push(const WorkPriority priority, ExecutablePtr executable)
+    {
+        ScopedLock lock(mutex);
+        queues[priority].push_back(std::move(executable));
+    }
+
+    boost::mutex mutex;
+    std::deque<ExecutablePtr> queues[nPriorities];
+};
+}
+
 struct Workers::Impl
 {
-    Impl(const std::string& name, Workers& workers, const size_t nThreads,
-         const GLContext& glContext)
-        : _workers(workers)
-        , _glContext(glContext.clone())
+    Impl(const std::string& name, const size_t nThreads,
+         const GLContext& glContext, const Int32s& affinities)
+        : _glContext(glContext.clone())
         , _name(name + "Worker")
+        , _affinities(affinities)
+        , _pending(0)
+        , _next(0)
+        , _stopped(false)
     {
+        if (nThreads == 0)
+            LBTHROW(std::runtime_error("Workers need at least one thread"));
+
         for (size_t i = 0; i < nThreads; ++i)
-            _threadGroup.create_thread(boost::bind(&Impl::execute, this));
+            _queues.emplace_back(new Queues);
+
+        for (size_t i = 0; i < nThreads; ++i)
+            _threadGroup.create_thread(boost::bind(&Impl::execute, this, i));
     }
 
-    void execute()
+    void execute(const size_t index)
     {
         lunchbox::Thread::setName(_name);
+        if (!_affinities.empty())
+            lunchbox::Thread::setAffinity(
+                _affinities[index % _affinities.size()]);
+
+        // The context and the data allocated by the thread are on the memory
+        // of its NUMA node, if its affinity is set
         GLContextPtr context(_glContext->clone());
+        _index.reset(new size_t(index));
 
-        while (true)
+        ExecutablePtr exec;
+        while (pop(index, exec))
         {
-            ExecutablePtr exec = _workQueue.pop();
-            if (!exec)
-                break;
-
             exec->execute();
+            exec.reset();
         }
 
         context->doneCurrent();
     }
 
+    bool pop(const size_t index, ExecutablePtr& exec)
+    {
+        const size_t nThreads = _queues.size();
+        while (true)
+        {
+            for (size_t i = 0; i < nPriorities; ++i)
+            {
+                const WorkPriority priority = WorkPriority(i);
+                for (size_t j = 0; j < nThreads; ++j)
+                {
+                    if (_queues[(index + j) % nThreads]->pop(priority, exec,
+                                                             j > 0))
+                    {
+                        --_pending;
+                        return true;
+                    }
+                }
+            }
+
+            ScopedLock lock(_mutex);
+            if (_stopped)
+                return false;
+
+            // An executable may be pushed after the queues were checked
+            if (_pending == 0)
+                _condition.wait(lock);
+        }
+    }
+
     ~Impl()
     {
-        _workQueue.clear();
-        for (size_t i = 0; i < getSize(); ++i)
-            _workQueue.push(ExecutablePtr());
+        {
+            ScopedLock lock(_mutex);
+            _stopped = true;
+        }
+        _condition.notify_all();
         _threadGroup.join_all();
         _glContext.reset();
     }
 
-    void submitWork(ExecutablePtr executable)
+    void submitWork(ExecutablePtr executable, const WorkPriority priority)
     {
-        _workQueue.pushFront(executable);
+        const size_t* current = _index.get();
+        const size_t index = current ? *current : _next++ % _queues.size();
+
+        ++_pending;
+        _queues[index]->push(priority, std::move(executable));
+
+        ScopedLock lock(_mutex);
+        _condition.notify_one();
     }
 
     size_t getSize() const { return _threadGroup.size(); }
-    Workers& _workers;
-    lunchbox::MTQueue<ExecutablePtr> _workQueue;
+    std::vector<std::unique_ptr<Queues>> _queues;
+    boost::thread_specific_ptr<size_t> _index; // of the calling worker
     boost::thread_group _threadGroup;
     GLContextPtr _glContext;
     const std::string _name;
+    const Int32s _affinities;
+
+    std::atomic<size_t> _pending;
+    std::atomic<size_t> _next;
+    boost::mutex _mutex;
+    boost::condition_variable _condition;
+    bool _stopped;
 };
 
 Workers::Workers(const std::string& name, const size_t nThreads,
-                 const GLContext& glContext)
-    : _impl(new Workers::Impl(name, *this, nThreads, glContext))
+                 const GLContext& glContext, const Int32s& affinities)
+    : _impl(new Workers::Impl(name, nThreads, glContext, affinities))
 {
 }
 
@@ -88,13 +192,62 @@ Workers::~Workers()
 {
 }
 
-void Workers::schedule(ExecutablePtr executable)
+void Workers::schedule(ExecutablePtr executable, const WorkPriority priority)
 {
-    _impl->submitWork(executable);
+    Tracer::setQueued(*executable);
+    _impl->submitWork(executable, priority);
 }
 
 size_t Workers::getSize() const
 {
     return _impl->getSize();
 }
+
+Int32s Workers::parseAffinities(const std::string& description)
+{
+    Int32s affinities;
+    if (description.empty())
+        return affinities;
+
+    const std::string socketPrefix = "socket:";
+    const std::string coresPrefix = "cores:";
+    try
+    {
+        if (description.compare(0, socketPrefix.size(), socketPrefix) == 0)
+        {
+            const int32_t socket =
+                std::stoi(description.substr(socketPrefix.size()));
+            const int32_t affinity = lunchbox::Thread::SOCKET + socket;
+            if (socket < 0 || affinity > lunchbox::Thread::SOCKET_MAX)
+                throw std::out_of_range(description);
+            affinities.push_back(affinity);
+            return affinities;
+        }
+
+        if (description.compare(0, coresPrefix.size(), coresPrefix) == 0)
+        {
+            Strings ranges;
+            const std::string cores = description.substr(coresPrefix.size());
+            boost::algorithm::split(ranges, cores, boost::is_any_of(","));
+            for (const std::string& range : ranges)
+            {
+                const size_t dash = range.find('-');
+                const int32_t first = std::stoi(range.substr(0, dash));
+                const int32_t last = dash == std::string::npos
+                                         ? first
+                                         : std::stoi(range.substr(dash + 1));
+                if (first < 0 || last < first)
+                    throw std::out_of_range(range);
+
+                for (int32_t core = first; core <= last; ++core)
+                    affinities.push_back(lunchbox::Thread::CORE + core);
+            }
+            return affinities;
+        }
+    }
+    catch (const std::logic_error&) // from std::stoi or out of range
+    {
+    }
+    LBTHROW(std::runtime_error("Invalid thread affinity: " + description));
+}
 }
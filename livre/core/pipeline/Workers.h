@@ -26,7 +26,14 @@
 namespace livre
 {
 /**
- * A simple thread pool
+ * A work stealing thread pool with priorities, which can be shared by several
+ * executors.
+ *
+ * Each thread has one queue per priority. An executable scheduled from a
+ * worker thread goes to the queue of this thread, others are distributed
+ * round robin. A thread runs the newest executable of its own queue, or steals
+ * the oldest one from the other threads, always choosing the highest priority
+ * available in the pool.
  */
 class Workers
 {
@@ -36,23 +43,47 @@ public:
      * @param name name of the thread
      * @param nThreads is the number of threads.
      * @param glContext OpenGL context to use.
+     * @param affinities of the threads, the thread i is bound with
+     * lunchbox::Thread::setAffinity( affinities[ i % affinities.size( )]).
+     * If empty, the threads keep the affinity of the calling thread, e.g. the
+     * one of an Equalizer pipe.
+     * @throw std::runtime_error if nThreads is 0
      */
     LIVRECORE_API Workers(const std::string& name, size_t nThreads,
-                          const GLContext& glContext);
+                          const GLContext& glContext,
+                          const Int32s& affinities = Int32s());
+
+    /**
+     * Waits for the running executables. The queued ones are not executed.
+     */
     LIVRECORE_API ~Workers();
 
     /**
      * Submitted executable is scheduled to the execution
      * queue.
      * @param executable is executed by thread pool.
+     * @param priority of the executable
      */
-    LIVRECORE_API void schedule(ExecutablePtr executable);
+    LIVRECORE_API void schedule(ExecutablePtr executable,
+                                WorkPriority priority = PRIORITY_RENDER);
 
     /**
      * @return the size of thread pool.
      */
     LIVRECORE_API size_t getSize() const;
 
+    /**
+     * Parses the affinities of the threads. The description is either empty,
+     * "socket:N" to bind all threads to the cores of the processor socket N,
+     * i.e. to its NUMA node, or "cores:" followed by a comma separated list of
+     * cores and core ranges, e.g. "cores:2-5,7", to bind each thread to one
+     * of the cores.
+     * @param description of the affinities
+     * @return the affinities for the constructor
+     * @throw std::runtime_error if the description is invalid
+     */
+    LIVRECORE_API static Int32s parseAffinities(const std::string& description);
+
 private:
     struct Impl;
     std::unique_ptr<Impl> _impl;
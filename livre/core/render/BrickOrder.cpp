@@ -0,0 +1,105 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "BrickOrder.h"
+
+#include <livre/data/DataSource.h>
+#include <livre/data/Frustum.h>
+#include <livre/data/LODNode.h>
+
+#include <cstring>
+
+namespace livre
+{
+namespace
+{
+const uint32_t radixBits = 11;
+const uint32_t radixSize = 1u << radixBits;
+const uint32_t radixMask = radixSize - 1;
+const uint32_t radixPasses = (32 + radixBits - 1) / radixBits;
+
+struct BrickKey
+{
+    uint32_t key;
+    uint32_t index;
+};
+typedef std::vector<BrickKey> BrickKeys;
+
+// The bit pattern of non-negative floats has the same order as their values
+uint32_t toKey(const float distance)
+{
+    uint32_t key;
+    std::memcpy(&key, &distance, sizeof(key));
+    return key;
+}
+
+// Stable LSD radix sort, ping-ponging between keys and buffer
+void radixSort(BrickKeys& keys)
+{
+    BrickKeys buffer(keys.size());
+    for (uint32_t pass = 0; pass < radixPasses; ++pass)
+    {
+        const uint32_t shift = pass * radixBits;
+        uint32_t offsets[radixSize] = {0};
+        for (const BrickKey& key : keys)
+            ++offsets[(key.key >> shift) & radixMask];
+
+        if (offsets[(keys.front().key >> shift) & radixMask] == keys.size())
+            continue; // all keys have the same digit
+
+        uint32_t sum = 0;
+        for (uint32_t& offset : offsets)
+        {
+            const uint32_t count = offset;
+            offset = sum;
+            sum += count;
+        }
+
+        for (const BrickKey& key : keys)
+            buffer[offsets[(key.key >> shift) & radixMask]++] = key;
+        keys.swap(buffer);
+    }
+}
+}
+
+NodeIds orderFrontToBack(const DataSource& dataSource, const NodeIds& bricks,
+                         const Frustum& frustum)
+{
+    if (bricks.size() < 2)
+        return bricks;
+
+    const Matrix4f& mvMatrix = frustum.getMVMatrix();
+    BrickKeys keys;
+    keys.reserve(bricks.size());
+    for (size_t i = 0; i < bricks.size(); ++i)
+    {
+        const LODNode& lodNode = dataSource.getNode(bricks[i]);
+        const float distance =
+            (mvMatrix * lodNode.getWorldBox().getCenter()).length();
+        keys.push_back({toKey(distance), uint32_t(i)});
+    }
+
+    radixSort(keys);
+
+    NodeIds ordered;
+    ordered.reserve(bricks.size());
+    for (const BrickKey& key : keys)
+        ordered.push_back(bricks[key.index]);
+    return ordered;
+}
+}
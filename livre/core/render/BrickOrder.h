@@ -0,0 +1,41 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _BrickOrder_h_
+#define _BrickOrder_h_
+
+#include <livre/core/api.h>
+#include <livre/core/types.h>
+
+namespace livre
+{
+/**
+ * Orders the bricks front to back, i.e. by the distance of their center to
+ * the eye. The distance is computed once per brick and the bricks are sorted
+ * with a radix sort on the distances.
+ * @param dataSource the data source of the bricks
+ * @param bricks the bricks to order
+ * @param frustum the frustum giving the eye position
+ * @return the ordered bricks
+ */
+LIVRECORE_API NodeIds orderFrontToBack(const DataSource& dataSource,
+                                       const NodeIds& bricks,
+                                       const Frustum& frustum);
+}
+
+#endif // _BrickOrder_h_
@@ -0,0 +1,186 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <livre/core/render/GLContext.h>
+#include <livre/core/render/PixelBufferRing.h>
+
+#include <eq/gl.h>
+
+#include <cstring>
+#include <mutex>
+
+namespace livre
+{
+namespace
+{
+const GLbitfield mapFlags =
+    GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+// The GPU is far behind if the last upload from a buffer is not done by then,
+// the caller then uploads without the buffer instead of blocking
+const GLuint64 fenceTimeout = 1000000; // ns
+}
+
+#define glewGetContext() GLContext::getCurrent()->glewGetContext()
+
+struct PixelBufferRing::Impl
+{
+    struct Buffer
+    {
+        GLuint name;
+        void* memory;
+        GLsync fence; // of the last upload from the buffer
+        bool isFilling;
+    };
+
+    Impl(const size_t bufferSize, const size_t nBuffers)
+        : _bufferSize(bufferSize)
+        , _next(0)
+    {
+        _buffers.resize(nBuffers);
+        for (Buffer& buffer : _buffers)
+        {
+            glGenBuffers(1, &buffer.name);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.name);
+            glBufferStorage(GL_PIXEL_UNPACK_BUFFER, bufferSize, nullptr,
+                            mapFlags);
+            buffer.memory = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0,
+                                             bufferSize, mapFlags);
+            buffer.fence = nullptr;
+            buffer.isFilling = false;
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        for (const Buffer& buffer : _buffers)
+        {
+            if (buffer.memory)
+                continue;
+
+            for (const Buffer& allocated : _buffers)
+                glDeleteBuffers(1, &allocated.name);
+            LBTHROW(std::runtime_error("Cannot map the pixel buffers"));
+        }
+    }
+
+    ~Impl()
+    {
+        if (!GLContext::getCurrent())
+            return; // deleted with the context
+
+        for (const Buffer& buffer : _buffers)
+        {
+            if (buffer.fence)
+                glDeleteSync(buffer.fence);
+            // unmapped by the deletion
+            glDeleteBuffers(1, &buffer.name);
+        }
+    }
+
+    Buffer* acquire()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (size_t i = 0; i < _buffers.size(); ++i)
+        {
+            Buffer& buffer = _buffers[(_next + i) % _buffers.size()];
+            if (buffer.isFilling)
+                continue;
+
+            buffer.isFilling = true;
+            _next = (_next + i + 1) % _buffers.size();
+            return &buffer;
+        }
+        return nullptr;
+    }
+
+    void release(Buffer& buffer, const GLsync fence)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        buffer.fence = fence;
+        buffer.isFilling = false;
+    }
+
+    bool upload(const Vector3ui& offset, const Vector3ui& size,
+                const GLenum format, const GLenum type, const void* data,
+                const size_t dataSize)
+    {
+        if (dataSize > _bufferSize)
+            return false;
+
+        Buffer* buffer = acquire();
+        if (!buffer)
+            return false;
+
+        // The fences are flushed by the threads which created them, so they
+        // get signaled even if they are from another context
+        if (buffer->fence)
+        {
+            const GLenum status =
+                glClientWaitSync(buffer->fence, 0, fenceTimeout);
+            if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED)
+            {
+                // The GPU may still read the buffer, it keeps its fence. A
+                // failed wait leaves an error the caller must not see.
+                if (status == GL_WAIT_FAILED)
+                    glGetError();
+                release(*buffer, buffer->fence);
+                return false;
+            }
+            glDeleteSync(buffer->fence);
+            buffer->fence = nullptr;
+        }
+
+        std::memcpy(buffer->memory, data, dataSize);
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer->name);
+        glTexSubImage3D(GL_TEXTURE_3D, 0, offset[0], offset[1], offset[2],
+                        size[0], size[1], size[2], format, type, nullptr);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        const GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+        release(*buffer, fence);
+        return true;
+    }
+
+    const size_t _bufferSize;
+    std::vector<Buffer> _buffers;
+    size_t _next;
+    std::mutex _mutex;
+};
+
+PixelBufferRing::PixelBufferRing(const size_t bufferSize, const size_t nBuffers)
+    : _impl(new PixelBufferRing::Impl(bufferSize, nBuffers))
+{
+}
+
+PixelBufferRing::~PixelBufferRing()
+{
+}
+
+bool PixelBufferRing::isSupported()
+{
+    return GLContext::getCurrent() && GLEW_ARB_buffer_storage && GLEW_ARB_sync;
+}
+
+bool PixelBufferRing::upload(const Vector3ui& offset, const Vector3ui& size,
+                             const uint32_t format, const uint32_t type,
+                             const void* data, const size_t dataSize)
+{
+    return _impl->upload(offset, size, format, type, data, dataSize);
+}
+}
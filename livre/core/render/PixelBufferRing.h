@@ -0,0 +1,78 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _PixelBufferRing_h_
+#define _PixelBufferRing_h_
+
+#include <livre/core/api.h>
+#include <livre/core/types.h>
+
+namespace livre
+{
+/**
+ * A ring of persistently mapped pixel buffer objects to upload textures
+ * asynchronously. The data is copied into the next free buffer, from which
+ * the GPU copies it into the texture while the caller goes on. A buffer is
+ * reused once the fence of its last upload is signaled, which is only waited
+ * for when the ring wrapped around, and then only briefly.
+ *
+ * Thread safe, the uploading threads need shared GL contexts.
+ */
+class PixelBufferRing
+{
+public:
+    /**
+     * Allocates and maps the buffers, needs a current GLContext.
+     * @param bufferSize the size of a buffer in bytes
+     * @param nBuffers the number of buffers
+     */
+    LIVRECORE_API PixelBufferRing(size_t bufferSize, size_t nBuffers);
+
+    /** Deletes the buffers if a GLContext is current. */
+    LIVRECORE_API ~PixelBufferRing();
+
+    /** @return true if the current GLContext supports the ring. */
+    LIVRECORE_API static bool isSupported();
+
+    /**
+     * Uploads data into a region of the bound 3D texture.
+     * @param offset the position of the region in the texture, in voxels
+     * @param size the size of the region in voxels
+     * @param format the OpenGL format of the data
+     * @param type the OpenGL data type of the data
+     * @param data the data of the region
+     * @param dataSize the size of the data in bytes
+     * @return false if the data is larger than a buffer, if all the buffers
+     *         are being filled by other threads, or if the GPU did not finish
+     *         the last upload from the next buffer in time; nothing is
+     *         uploaded then and the caller uploads the data directly.
+     */
+    LIVRECORE_API bool upload(const Vector3ui& offset, const Vector3ui& size,
+                              uint32_t format, uint32_t type, const void* data,
+                              size_t dataSize);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> _impl;
+
+    PixelBufferRing(const PixelBufferRing&) = delete;
+    PixelBufferRing& operator=(const PixelBufferRing&) = delete;
+};
+}
+
+#endif // _PixelBufferRing_h_
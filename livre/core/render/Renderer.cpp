@@ -34,7 +34,8 @@ void Renderer::render(const Frustum& frustum, const ClipPlanes& planes,
                       const PixelViewport& view, const NodeIds& bricks,
                       const uint32_t renderStages)
 {
-    const NodeIds& ordered = order(bricks, frustum);
+    const NodeIds& ordered =
+        renderStages & RENDER_ORDERED ? bricks : order(bricks, frustum);
 
     if (renderStages & RENDER_BEGIN)
         _onFrameStart(frustum, planes, view, ordered);
@@ -32,6 +32,9 @@ static const uint32_t RENDER_FRAME = 1u << 1;
 static const uint32_t RENDER_END = 1u << 2;
 static const uint32_t RENDER_ALL = RENDER_BEGIN | RENDER_FRAME | RENDER_END;
 
+/** Flag for render(): the bricks are already ordered, skips order() */
+static const uint32_t RENDER_ORDERED = 1u << 3;
+
 /**
  * The Renderer class is the base class for renderers.
  */
@@ -47,7 +50,9 @@ public:
      * stages of
      * rendering. i.e. With different settings, multipass rendering can be
      * performed in
-     * the same frame.
+     * the same frame. With RENDER_ORDERED, the bricks are rendered in the
+     * given order, e.g. when the ordering of the frame is reused for all of
+     * its passes.
      */
     LIVRECORE_API void render(const Frustum& frustum, const ClipPlanes& planes,
                               const PixelViewport& view, const NodeIds& bricks,
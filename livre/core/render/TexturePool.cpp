@@ -21,17 +21,41 @@
 
 #include <livre/core/defines.h>
 #include <livre/core/render/GLContext.h>
+#include <livre/core/render/PixelBufferRing.h>
 
 #include <livre/data/DataSource.h>
+#include <livre/data/VolumeInformation.h>
 
 #include <eq/gl.h>
 
+#include <algorithm>
+
 namespace livre
 {
+namespace
+{
+// The minimum GL_MAX_3D_TEXTURE_SIZE of OpenGL 4.2, needed by the ray caster
+const uint32_t maxAtlasPageSize = 2048;
+
+// Some drivers fail to allocate larger single textures
+const size_t maxAtlasPageMemory = size_t(1) << 30;
+
+// The upload ring has a buffer per brick being uploaded, enough for the
+// pipeline threads to upload in parallel while the GPU copies the others
+const size_t maxPixelBuffers = 16;
+const size_t pixelBuffersMemory = size_t(64) << 20;
+}
+
 #define glewGetContext() GLContext::getCurrent()->glewGetContext()
 
-TexturePool::TexturePool(const DataSource& dataSource)
+TexturePool::TexturePool(const DataSource& dataSource, const size_t atlasMemory)
     : _maxBlockSize(dataSource.getVolumeInfo().maximumBlockSize)
+    , _slotMemory(_maxBlockSize.product() *
+                  dataSource.getVolumeInfo().getBytesPerVoxel())
+    , _slotGrid(1u)
+    , _textureSize(_maxBlockSize)
+    , _maxPages(0)
+    , _hasPixelBuffers(false)
     , _internalTextureFormat(0)
     , _format(0)
     , _textureType(0)
@@ -81,47 +105,179 @@ TexturePool::TexturePool(const DataSource& dataSource)
         LBTHROW(std::runtime_error("Undefined data type"));
         break;
     }
+
+    if (atlasMemory == 0)
+        return;
+
+    // The slots of a page fill x, then y, then z; the atlas memory is rounded
+    // down to whole pages
+    const size_t maxSlots = atlasMemory / _slotMemory;
+    if (maxSlots == 0)
+        LBTHROW(std::runtime_error("Texture atlas smaller than a brick"));
+
+    const size_t maxPageSlots =
+        std::max(maxAtlasPageMemory / _slotMemory, size_t(1));
+    const size_t pageSlots = std::min(maxSlots, maxPageSlots);
+    for (size_t i = 0, slots = pageSlots; i < 3; ++i)
+    {
+        const uint32_t maxSlotsInDim =
+            std::max(maxAtlasPageSize / _maxBlockSize[i], 1u);
+        _slotGrid[i] = std::min(slots, size_t(maxSlotsInDim));
+        slots /= _slotGrid[i];
+    }
+    _textureSize = _slotGrid * _maxBlockSize;
+    _maxPages = maxSlots / _slotGrid.product();
 }
 
 TexturePool::~TexturePool()
 {
+    if (!GLContext::getCurrent())
+        return; // deleted with the context
+
+    glDeleteTextures(_textureStack.size(), _textureStack.data());
+    glDeleteTextures(_pages.size(), _pages.data());
+}
+
+bool TexturePool::upload(TextureState& textureState, const Vector3ui& size,
+                         const void* data)
+{
+    PixelBufferRing* pixelBuffers = _getPixelBuffers();
+    const Vector3ui& offset = textureState.textureOffset;
+    const size_t dataSize =
+        size.product() * (_slotMemory / _maxBlockSize.product());
+
+    textureState.bind();
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (!pixelBuffers || !pixelBuffers->upload(offset, size, _format,
+                                               _textureType, data, dataSize))
+    {
+        glTexSubImage3D(GL_TEXTURE_3D, 0, offset[0], offset[1], offset[2],
+                        size[0], size[1], size[2], _format, _textureType,
+                        data);
+    }
+
+    const GLenum glErr = glGetError();
+    if (glErr != GL_NO_ERROR)
+    {
+        LBERROR << "Error loading the texture into GPU, error number : "
+                << glErr << std::endl;
+        return false;
+    }
+
+    if (!GLEW_ARB_sync)
+    {
+        glFinish(); // no fence to wait for in the rendering context
+        return true;
+    }
+
+    LBASSERT(!textureState._uploadFence.load());
+    textureState._uploadFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush(); // the fence needs to be flushed to be waited for elsewhere
+    return true;
+}
+
+size_t TexturePool::getMaxSlots() const
+{
+    return _maxPages * _slotGrid.product();
+}
+
+size_t TexturePool::getAtlasMemory() const
+{
+    return getMaxSlots() * _slotMemory;
 }
 
 void TexturePool::generate(TextureState& textureState)
 {
     std::lock_guard<std::mutex> lock(_mutex);
     LBASSERT(textureState.textureId == INVALID_TEXTURE_ID);
-    if (!_textureStack.empty())
+    if (_maxPages > 0)
+    {
+        if (_freeSlots.empty() && _pages.size() < _maxPages)
+            _allocatePage();
+        if (_freeSlots.empty())
+            return;
+
+        textureState.textureId = _freeSlots.back().textureId;
+        textureState.textureOffset = _freeSlots.back().offset;
+        _freeSlots.pop_back();
+    }
+    else if (!_textureStack.empty())
     {
         textureState.textureId = _textureStack.back();
         _textureStack.pop_back();
     }
     else
-    {
-        glGenTextures(1, &textureState.textureId);
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-        textureState.bind();
-
-        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-        // Allocate a texture
-        glTexImage3D(GL_TEXTURE_3D, 0, _internalTextureFormat, _maxBlockSize[0],
-                     _maxBlockSize[1], _maxBlockSize[2], 0, _format,
-                     _textureType, (GLvoid*)NULL);
-
-        const GLenum glErr = glGetError();
-        if (glErr != GL_NO_ERROR)
-            LBERROR << "Error loading the texture into GPU, error number: "
-                    << glErr << std::endl;
-    }
+        textureState.textureId = _allocateTexture(_maxBlockSize);
 }
 
 void TexturePool::release(TextureState& textureState)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    LBASSERT(textureState.textureId);
-    _textureStack.push_back(textureState.textureId);
+    if (textureState.textureId == INVALID_TEXTURE_ID)
+        return;
+
+    if (_maxPages > 0)
+        _freeSlots.push_back({textureState.textureId,
+                              textureState.textureOffset});
+    else
+        _textureStack.push_back(textureState.textureId);
+}
+
+uint32_t TexturePool::_allocateTexture(const Vector3ui& size) const
+{
+    GLuint textureId = 0;
+    glGenTextures(1, &textureId);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_3D, textureId);
+
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+    // Allocate a texture
+    glTexImage3D(GL_TEXTURE_3D, 0, _internalTextureFormat, size[0], size[1],
+                 size[2], 0, _format, _textureType, (GLvoid*)NULL);
+
+    const GLenum glErr = glGetError();
+    if (glErr != GL_NO_ERROR)
+        LBERROR << "Error loading the texture into GPU, error number: "
+                << glErr << std::endl;
+    return textureId;
+}
+
+PixelBufferRing* TexturePool::_getPixelBuffers()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_hasPixelBuffers || !PixelBufferRing::isSupported())
+        return _pixelBuffers.get();
+
+    _hasPixelBuffers = true;
+    const size_t nBuffers = std::min(
+        maxPixelBuffers, std::max(pixelBuffersMemory / _slotMemory, size_t(2)));
+    try
+    {
+        _pixelBuffers.reset(new PixelBufferRing(_slotMemory, nBuffers));
+    }
+    catch (const std::runtime_error& error)
+    {
+        LBWARN << error.what() << ", uploading without pixel buffers"
+               << std::endl;
+    }
+    return _pixelBuffers.get();
+}
+
+void TexturePool::_allocatePage()
+{
+    const uint32_t textureId = _allocateTexture(_textureSize);
+    _pages.push_back(textureId);
+
+    // the first slots are taken first
+    for (uint32_t z = _slotGrid[2]; z > 0; --z)
+        for (uint32_t y = _slotGrid[1]; y > 0; --y)
+            for (uint32_t x = _slotGrid[0]; x > 0; --x)
+            {
+                const Vector3ui slot(x - 1, y - 1, z - 1);
+                _freeSlots.push_back({textureId, slot * _maxBlockSize});
+            }
 }
 }
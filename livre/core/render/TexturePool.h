@@ -31,6 +31,13 @@ namespace livre
 /**
  * Allocates texture slots and copies textures into the texture slots.
  * Thread safe.
+ *
+ * By default each slot is a texture of the maximum block size. In atlas mode
+ * the slots are a grid in a few large textures, the atlas pages, which are
+ * allocated on demand up to the atlas memory; the pool then holds at most
+ * getMaxSlots() bricks. The atlas saves texture objects and the binds of the
+ * bricks of a page, the bricks are still drawn one at a time: there is no
+ * indirection table to ray cast all of them in a single draw.
  */
 class TexturePool
 {
@@ -38,9 +45,15 @@ public:
     /**
      * Constructor.
      * @param dataSource the data source
-     * @throws std::runtime_error if data has multiple channels
+     * @param atlasMemory the GPU memory of the atlas pages in bytes, 0 for a
+     *        texture per slot
+     * @throws std::runtime_error if data has multiple channels, or if a brick
+     *         does not fit in the atlas memory
      */
-    LIVRECORE_API TexturePool(const DataSource& dataSource);
+    LIVRECORE_API TexturePool(const DataSource& dataSource,
+                              size_t atlasMemory = 0);
+
+    /** Deletes the textures if a GLContext is current. */
     LIVRECORE_API ~TexturePool();
 
     /** @return The OpenGL GPU internal format of the texture data. */
@@ -53,11 +66,24 @@ public:
     LIVRECORE_API uint32_t getFormat() const { return _format; }
     /** @return The OpenGL data type of the texture data. */
     LIVRECORE_API uint32_t getTextureType() const { return _textureType; };
+    /** @return The size in voxels of the textures holding the slots. */
+    LIVRECORE_API const Vector3ui& getTextureSize() const
+    {
+        return _textureSize;
+    }
+
+    /** @return The number of slots of the atlas, 0 without atlas. */
+    LIVRECORE_API size_t getMaxSlots() const;
+
+    /** @return The GPU memory of all the atlas pages, 0 without atlas. */
+    LIVRECORE_API size_t getAtlasMemory() const;
+
     /**
      * Generates / uses a preallocated a 3D OpenGL texture based on OpenGL
      * parameters.
      * @param textureState The destination state is filled with needed
-     * information.
+     * information. Its texture id stays INVALID_TEXTURE_ID if all the slots of
+     * the atlas are used.
      */
     LIVRECORE_API void generate(TextureState& textureState);
 
@@ -68,10 +94,41 @@ public:
      */
     LIVRECORE_API void release(TextureState& textureState);
 
+    /**
+     * Copies the data of a brick into the slot of a texture state, from a
+     * ring of persistently mapped pixel buffers if the GLContext supports
+     * them. The copy on the GPU is asynchronous, the renderers wait for it
+     * with TextureState::waitUpload().
+     * @param textureState the destination slot
+     * @param size the size of the data in voxels
+     * @param data the voxels of the brick
+     * @return false on OpenGL error
+     */
+    LIVRECORE_API bool upload(TextureState& textureState, const Vector3ui& size,
+                              const void* data);
+
 private:
+    struct Slot
+    {
+        uint32_t textureId;
+        Vector3ui offset;
+    };
+
+    uint32_t _allocateTexture(const Vector3ui& size) const;
+    void _allocatePage();
+    PixelBufferRing* _getPixelBuffers();
+
     UInt32s _textureStack;
+    UInt32s _pages;
+    std::vector<Slot> _freeSlots;
 
     const Vector3ui _maxBlockSize;
+    const size_t _slotMemory;
+    Vector3ui _slotGrid; //!< slots per atlas page in x, y and z
+    Vector3ui _textureSize;
+    size_t _maxPages;
+    std::unique_ptr<PixelBufferRing> _pixelBuffers;
+    bool _hasPixelBuffers; //!< the ring was created, or failed to be
     int32_t _internalTextureFormat;
     uint32_t _format;
     uint32_t _textureType;
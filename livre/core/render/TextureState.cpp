@@ -19,6 +19,7 @@
 
 #include "TextureState.h"
 
+#include <livre/core/render/GLContext.h>
 #include <livre/core/render/TexturePool.h>
 
 #include <eq/gl.h>
@@ -26,18 +27,28 @@
 
 namespace livre
 {
+#define glewGetContext() GLContext::getCurrent()->glewGetContext()
+
 TextureState::TextureState(TexturePool& texturePool)
     : textureCoordsMin(0.0f)
     , textureCoordsMax(0.0f)
     , textureSize(0.0f)
+    , textureClampMin(0.0f)
+    , textureClampMax(0.0f)
+    , textureOffset(0u)
     , textureId(INVALID_TEXTURE_ID)
     , _texturePool(texturePool)
+    , _uploadFence(nullptr)
+    , _uploaded(false)
 {
     _texturePool.generate(*this);
 }
 
 TextureState::~TextureState()
 {
+    GLsync fence = static_cast<GLsync>(_uploadFence.load());
+    if (fence && GLContext::getCurrent())
+        glDeleteSync(fence);
     _texturePool.release(*this);
 }
 
@@ -52,4 +63,25 @@ void TextureState::bind() const
     if (glErr != GL_NO_ERROR)
         LBERROR << "Error binding texture: " << glErr << std::endl;
 }
+
+bool TextureState::waitUpload() const
+{
+    if (_uploaded.load(std::memory_order_acquire))
+        return false;
+
+    GLsync fence = static_cast<GLsync>(_uploadFence.load());
+    if (!fence)
+        return false;
+
+    GLint status = GL_UNSIGNALED;
+    glGetSynciv(fence, GL_SYNC_STATUS, 1, nullptr, &status);
+    if (status != GL_SIGNALED)
+    {
+        glWaitSync(fence, 0, GL_TIMEOUT_IGNORED);
+        return true;
+    }
+
+    _uploaded.store(true, std::memory_order_release);
+    return true;
+}
 }
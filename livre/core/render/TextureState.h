@@ -23,6 +23,8 @@
 #include <livre/core/api.h>
 #include <livre/core/types.h>
 
+#include <atomic>
+
 namespace livre
 {
 /**
@@ -46,16 +48,38 @@ public:
     /** OpenGL bind() the texture. */
     LIVRECORE_API void bind() const;
 
+    /**
+     * Makes the GPU of the current context wait for the upload of the
+     * texture, which may still run after TexturePool::upload() returned. Does
+     * not block the calling thread.
+     * @return true if the texture needs to be bound again to see the uploaded
+     *         data, false if the upload was known to be complete.
+     */
+    LIVRECORE_API bool waitUpload() const;
+
     Vector3f textureCoordsMin; //!< Minimum texture coordinates in the maximum
                                //! texture block.
     Vector3f textureCoordsMax; //!< Maximum texture coordinates in the maximum
                                //! texture block.
     Vector3f textureSize;      //!< The texture size.
+    Vector3f textureClampMin;  //!< Texture coordinates of the first voxel
+                               //! center of the data, overlap included.
+    Vector3f textureClampMax;  //!< Texture coordinates of the last voxel
+                               //! center of the data, overlap included.
+    Vector3ui textureOffset;   //!< The slot position in the texture, in
+                               //! voxels, non-zero in an atlas.
     uint32_t textureId;        //!< The OpenGL texture id.
 
 private:
+    friend class TexturePool;
+
     TexturePool& _texturePool;
 
+    // GLsync of the upload, kept until the destruction: the threads which
+    // wait for it may still use it once another one saw it signaled
+    std::atomic<void*> _uploadFence;
+    mutable std::atomic<bool> _uploaded; // the fence is signaled
+
     TextureState(const TextureState&) = delete;
     TextureState& operator=(const TextureState&) = delete;
 };
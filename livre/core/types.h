@@ -67,12 +67,14 @@ class GLContext;
 class GLSLShaders;
 using Histogram = co::Distributable<::lexis::render::Histogram>;
 class Parameter;
+class PixelBufferRing;
 class Renderer;
 class RootNode;
 class TexturePool;
 
 /** Pipeline */
 class AsyncData;
+class CancelToken;
 class Executor;
 class Executable;
 class Filter;
@@ -99,6 +101,14 @@ using lunchbox::Strings;
 
 typedef Identifier CacheId;
 
+/** Priority classes of the executables run by the pipeline Workers */
+enum WorkPriority
+{
+    PRIORITY_RENDER = 0u,    //!< Render critical, e.g. the visible set
+    PRIORITY_UPLOAD = 1u,    //!< Data loading and texture uploads
+    PRIORITY_BACKGROUND = 2u //!< Anything else, e.g. histogram computation
+};
+
 /** SmartPtr definitions */
 typedef std::shared_ptr<GLContext> GLContextPtr;
 typedef std::shared_ptr<const GLContext> ConstGLContextPtr;
@@ -129,6 +139,7 @@ struct DeleteObject
 /** Vector definitions basic types */
 typedef std::vector<float> Floats;
 typedef std::vector<uint8_t> UInt8s;
+typedef std::vector<int32_t> Int32s;
 typedef std::vector<uint32_t> UInt32s;
 
 typedef std::vector<NodeId> NodeIds;
@@ -20,12 +20,192 @@
 
 #include <livre/data/DataSource.h>
 #include <livre/data/DataSourcePlugin.h>
+#include <livre/data/HistogramKernels.h>
 #include <livre/data/version.h>
 
 #include <lunchbox/pluginFactory.h>
 
+#include <boost/filesystem.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
 namespace livre
 {
+namespace
+{
+typedef boost::shared_lock<boost::shared_mutex> ReadLock;
+typedef boost::unique_lock<boost::shared_mutex> WriteLock;
+
+// The node cache is split in shards of their own lock, so that the lookups of
+// the threads rarely contend. Each shard bounds its memory and evicts one node
+// at a time, e.g. when playing back many time steps.
+const size_t nodeShardBits = 6;
+const size_t nNodeShards = 1 << nodeShardBits;
+const size_t maxShardNodes = (1 << 18) / nNodeShards;
+const size_t nEvictionSamples = 8;
+
+/**
+ * Caches the nodes of a part of the ids. A full shard evicts the least recently
+ * used of a few nodes picked at random, which approximates LRU in constant
+ * time. The lookups only mark their node with the number of insertions so far.
+ */
+class NodeShard
+{
+public:
+    bool find(const Identifier key, LODNode& lodNode) const
+    {
+        ReadLock lock(_mutex);
+        const auto it = _nodes.find(key);
+        if (it == _nodes.end())
+            return false;
+
+        it->second.lastUsed.store(_nInserted.load(std::memory_order_relaxed),
+                                  std::memory_order_relaxed);
+        lodNode = it->second.node;
+        return true;
+    }
+
+    void insert(const Identifier key, const LODNode& lodNode)
+    {
+        WriteLock lock(_mutex);
+        const uint64_t now = ++_nInserted;
+        const auto inserted = _nodes.emplace(std::piecewise_construct,
+                                             std::forward_as_tuple(key),
+                                             std::forward_as_tuple(lodNode,
+                                                                   now));
+        if (!inserted.second)
+            return; // computed by another thread meanwhile
+
+        if (_keys.size() < maxShardNodes)
+        {
+            _keys.push_back(key);
+            return;
+        }
+
+        size_t victim = _pick();
+        for (size_t i = 1; i < nEvictionSamples; ++i)
+        {
+            const size_t candidate = _pick();
+            if (_nodes.at(_keys[candidate]).lastUsed <
+                _nodes.at(_keys[victim]).lastUsed)
+            {
+                victim = candidate;
+            }
+        }
+        _nodes.erase(_keys[victim]);
+        _keys[victim] = key;
+    }
+
+    void clear()
+    {
+        WriteLock lock(_mutex);
+        _nodes.clear();
+        _keys.clear();
+    }
+
+private:
+    struct CachedNode
+    {
+        CachedNode(const LODNode& node_, const uint64_t lastUsed_)
+            : node(node_)
+            , lastUsed(lastUsed_)
+        {
+        }
+
+        const LODNode node;
+        mutable std::atomic<uint64_t> lastUsed;
+    };
+
+    std::unordered_map<Identifier, CachedNode> _nodes;
+    std::vector<Identifier> _keys; // the eviction candidates
+    std::atomic<uint64_t> _nInserted{0};
+    uint64_t _random{0x2545F4914F6CDD1Dull};
+    mutable boost::shared_mutex _mutex;
+
+    size_t _pick() // xorshift
+    {
+        _random ^= _random << 13;
+        _random ^= _random >> 7;
+        _random ^= _random << 17;
+        return _random % _keys.size();
+    }
+};
+
+NodeShard& getShard(NodeShard* shards, const Identifier key)
+{
+    // the ids pack the position and level bits, mix them for an even spread
+    return shards[(key * 0x9E3779B97F4A7C15ull) >> (64 - nodeShardBits)];
+}
+
+/** @return the 64 bit FNV-1a hash of a string, the same on all platforms */
+uint64_t hashFNV1a(const std::string& string)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const char c : string)
+    {
+        hash ^= uint8_t(c);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+const Range emptyRange = {{std::numeric_limits<float>::max(),
+                           std::numeric_limits<float>::lowest()}};
+
+template <class T>
+Range getTypeRange()
+{
+    return {{float(std::numeric_limits<T>::lowest()),
+             float(std::numeric_limits<T>::max())}};
+}
+
+/** Rounds the range of an integer type outwards, inside the type range */
+template <class T>
+Range roundRange(const Range& range)
+{
+    const Range typeRange = getTypeRange<T>();
+    return {{std::max(std::floor(range[0]), typeRange[0]),
+             std::min(std::ceil(range[1]), typeRange[1])}};
+}
+
+/**
+ * @return the range as the histograms bin it, so that the histograms of all
+ *         the bricks have this range
+ */
+Range normalizeRange(const Range& range, const DataType dataType)
+{
+    switch (dataType)
+    {
+    case DT_UINT8:
+        return roundRange<uint8_t>(range);
+    case DT_UINT16:
+        return roundRange<uint16_t>(range);
+    case DT_UINT32:
+        return roundRange<uint32_t>(range);
+    case DT_INT8:
+        return roundRange<int8_t>(range);
+    case DT_INT16:
+        return roundRange<int16_t>(range);
+    case DT_INT32:
+        return roundRange<int32_t>(range);
+    case DT_FLOAT:
+    case DT_UNDEFINED:
+    default:
+        return range;
+    }
+}
+}
+
 struct DataSource::Impl
 {
 public:
@@ -34,12 +214,191 @@ public:
     Impl(const servus::URI& uri, const AccessMode accessMode)
         : plugin(PluginFactory::getInstance().create(
               DataSourcePluginData(uri, accessMode)))
+        , uriString(std::to_string(uri))
+        , uriPath(uri.getPath())
     {
+        const VolumeInformation& info = plugin->getVolumeInfo();
+        if (info.hasValueRange())
+            plugin->setValueRange(normalizeRange(info.valueRange,
+                                                 info.dataType));
+        else if (info.dataType == DT_UINT8)
+            plugin->setValueRange(getTypeRange<uint8_t>());
+        else if (info.dataType == DT_INT8)
+            plugin->setValueRange(getTypeRange<int8_t>());
     }
 
+    // The nodes are computed once by the plugin and cached, as they are
+    // requested many times per frame (e.g. while sorting the bricks). The
+    // layout of the octree may change with the time step (e.g. UVF), so the
+    // time step is part of the key.
     LODNode getNode(const NodeId& nodeId) const
     {
-        return plugin->getNode(nodeId);
+        const Identifier key = nodeId.getId();
+        NodeShard& shard = getShard(nodeShards, key);
+        LODNode lodNode;
+        if (shard.find(key, lodNode))
+            return lodNode;
+
+        lodNode = plugin->getNode(nodeId);
+        shard.insert(key, lodNode);
+        return lodNode;
+    }
+
+    bool update()
+    {
+        if (!plugin->update())
+            return false;
+
+        for (NodeShard& shard : nodeShards)
+            shard.clear();
+        return true;
+    }
+
+    /**
+     * @return a hash which changes with the volume and with the size and
+     *         modification time of its file. It is saved in files, so it does
+     *         not depend on the standard library like std::hash.
+     */
+    uint64_t getDatasetHash() const
+    {
+        const VolumeInformation& info = plugin->getVolumeInfo();
+        std::ostringstream key;
+        key << uriString << " " << info.dataType << " " << info.voxels << " "
+            << info.frameRange;
+
+        boost::system::error_code error;
+        const boost::filesystem::path path(uriPath);
+        if (boost::filesystem::is_regular_file(path, error))
+            key << " " << boost::filesystem::file_size(path, error) << " "
+                << boost::filesystem::last_write_time(path, error);
+
+        return hashFNV1a(key.str());
+    }
+
+    /** @return the file caching the value range of the volume */
+    std::string getValueRangeFile() const
+    {
+        const std::string filename =
+            "livreValueRange" + std::to_string(getDatasetHash()) + ".txt";
+        boost::system::error_code error;
+        return (boost::filesystem::temp_directory_path(error) / filename)
+            .string();
+    }
+
+    Range scanValueRange(const size_t nThreads)
+    {
+        const VolumeInformation& info = plugin->getVolumeInfo();
+        if (info.hasValueRange())
+            return info.valueRange;
+
+        if (info.compCount > 1)
+            LBTHROW(std::runtime_error("Multiple channels are not supported"));
+        if (info.frameRange[1] == INVALID_TIMESTEP)
+            LBTHROW(std::runtime_error("Cannot scan an unbounded frame range"));
+
+        const std::string filename = getValueRangeFile();
+        Range range = emptyRange;
+        {
+            std::ifstream file(filename.c_str());
+            file >> range[0] >> range[1];
+        }
+
+        if (range[0] > range[1])
+        {
+            LBINFO << "Scanning the value range of " << uriString << std::endl;
+            switch (info.dataType)
+            {
+            case DT_UINT16:
+                range = scanLeaves<uint16_t>(nThreads);
+                break;
+            case DT_UINT32:
+                range = scanLeaves<uint32_t>(nThreads);
+                break;
+            case DT_INT16:
+                range = scanLeaves<int16_t>(nThreads);
+                break;
+            case DT_INT32:
+                range = scanLeaves<int32_t>(nThreads);
+                break;
+            case DT_FLOAT:
+                range = scanLeaves<float>(nThreads);
+                break;
+            case DT_UINT8: // set at construction
+            case DT_INT8:
+            case DT_UNDEFINED:
+            default:
+                LBTHROW(std::runtime_error("Unimplemented data type."));
+            }
+
+            std::ofstream file(filename.c_str());
+            file.precision(std::numeric_limits<float>::max_digits10);
+            file << range[0] << " " << range[1] << std::endl;
+            if (!file)
+                LBWARN << "Cannot cache the value range in " << filename
+                       << std::endl;
+        }
+
+        if (range[0] <= range[1])
+            plugin->setValueRange(normalizeRange(range, info.dataType));
+        return info.valueRange;
+    }
+
+    /** @return the range of the leaf nodes of all frames */
+    template <class T>
+    Range scanLeaves(size_t nThreads)
+    {
+        const VolumeInformation& info = plugin->getVolumeInfo();
+        const uint32_t level = info.rootNode.getDepth() - 1;
+        const Vector3ui size = info.rootNode.getBlockSize() * (1u << level);
+        const uint64_t nLeaves = uint64_t(size.x()) * size.y() * size.z();
+        const uint64_t nNodes =
+            nLeaves * (info.frameRange[1] - info.frameRange[0]);
+        nThreads = std::max(std::min(uint64_t(nThreads), nNodes), uint64_t(1));
+
+        std::atomic<uint64_t> next(0);
+        std::atomic<bool> failed(false);
+        std::vector<Range> ranges(nThreads, emptyRange);
+        const auto scan = [&](const size_t thread) {
+            Range& range = ranges[thread];
+            for (uint64_t i = next++; i < nNodes && !failed; i = next++)
+            {
+                const uint32_t index = uint32_t(i % nLeaves);
+                const Vector3ui position(index % size.x(),
+                                         index / size.x() % size.y(),
+                                         index / size.x() / size.y());
+                const NodeId nodeId(level, position,
+                                    info.frameRange[0] + uint32_t(i / nLeaves));
+                const LODNode lodNode = getNode(nodeId);
+                if (!lodNode.isValid())
+                    continue;
+
+                const ConstMemoryUnitPtr data = plugin->getData(lodNode);
+                if (!data)
+                {
+                    failed = true;
+                    return;
+                }
+                expandValueRange(data->getData<T>(),
+                                 lodNode.getVoxelBox().getSize(), info.overlap,
+                                 range[0], range[1]);
+            }
+        };
+
+        boost::thread_group threads;
+        for (size_t i = 1; i < nThreads; ++i)
+            threads.create_thread([&scan, i] { scan(i); });
+        scan(0);
+        threads.join_all();
+        if (failed)
+            LBTHROW(std::runtime_error("Cannot read the data of a node"));
+
+        Range range = emptyRange;
+        for (const Range& threadRange : ranges)
+        {
+            range[0] = std::min(range[0], threadRange[0]);
+            range[1] = std::max(range[1], threadRange[1]);
+        }
+        return range;
     }
 
     MemoryUnitPtr getData(const LODNode& node) { return plugin->getData(node); }
@@ -49,6 +408,9 @@ public:
     }
 
     std::unique_ptr<DataSourcePlugin> plugin;
+    const std::string uriString;
+    const std::string uriPath;
+    mutable NodeShard nodeShards[nNodeShards];
 };
 
 DataSource::DataSource(const servus::URI& uri, const AccessMode accessMode)
@@ -80,7 +442,17 @@ LODNode DataSource::getNode(const NodeId& nodeId) const
 
 bool DataSource::update()
 {
-    return _impl->plugin->update();
+    return _impl->update();
+}
+
+Range DataSource::scanValueRange(const size_t nThreads)
+{
+    return _impl->scanValueRange(nThreads);
+}
+
+uint64_t DataSource::getDatasetHash() const
+{
+    return _impl->getDatasetHash();
 }
 
 const VolumeInformation& DataSource::getVolumeInfo() const
@@ -78,6 +78,10 @@ public:
     LIVREDATA_API ConstMemoryUnitPtr getData(const NodeId& nodeId) const;
 
     /**
+     * The nodes of each time step are computed once by the plugin and then
+     * cached, so subsequent lookups are constant-time and do not allocate.
+     * The cache is bounded and restarts when full. Thread safe.
+     *
      * @param nodeId The nodeId to get the node for.
      * @return The LODNode for the ID or an invalid node if not found.
      */
@@ -86,6 +90,28 @@ public:
     /** @copydoc DataSourcePlugin::update() */
     LIVREDATA_API bool update();
 
+    /**
+     * Provides the value range of the volume information if the plugin did
+     * not read it from the metadata of the volume. The range of 8 bit types is
+     * the range of the type, which is set at construction. Other types need
+     * the range of the leaf nodes of all frames: they are read once in
+     * parallel, and the result is cached in the temporary directory for the
+     * next runs. Not thread safe.
+     *
+     * @param nThreads the number of threads reading the leaf nodes
+     * @return the value range of the volume information
+     * @throw std::runtime_error if the volume has several components or an
+     *        unbounded frame range, or if the data of a node cannot be read
+     */
+    LIVREDATA_API Range scanValueRange(size_t nThreads = 1);
+
+    /**
+     * @return a hash of the URI, type, size and frame range of the volume and
+     *         of the size and modification time of its file, to recognize the
+     *         data derived from the volume, e.g. the cached value range.
+     */
+    LIVREDATA_API uint64_t getDatasetHash() const;
+
 private:
     struct Impl;
     std::unique_ptr<Impl> _impl;
@@ -37,6 +37,11 @@ const VolumeInformation& DataSourcePlugin::getVolumeInfo() const
     return _volumeInfo;
 }
 
+void DataSourcePlugin::setValueRange(const Range& range)
+{
+    _volumeInfo.valueRange = range;
+}
+
 LODNode DataSourcePlugin::internalNodeToLODNode(
     const NodeId& internalNode) const
 {
@@ -69,6 +69,9 @@ public:
      */
     const VolumeInformation& getVolumeInfo() const;
 
+    /** Sets the value range of the volume information, see DataSource. */
+    LIVREDATA_API void setValueRange(const Range& range);
+
     /** Initializes the GL specific functions. */
     virtual bool initializeGL() { return true; }
     /** Last call with a valid and active GL context to clear GL objects. */
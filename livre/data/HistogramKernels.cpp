@@ -0,0 +1,356 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <livre/data/HistogramKernels.h>
+
+#include <lunchbox/debug.h>
+
+#include <boost/thread/thread.hpp>
+
+#include <cmath>
+#include <limits>
+
+namespace livre
+{
+namespace
+{
+const size_t nLanes = 16;        // independent min/max, vectorized together
+const size_t nSubHistograms = 4; // consecutive voxels go to different copies
+
+/** The rows along x of the inner box of a brick, in a range of slices */
+template <class T>
+struct InnerBox
+{
+    InnerBox(const T* data_, const Vector3ui& blockSize,
+             const Vector3ui& padding, const size_t chunk, const size_t nChunks)
+        : data(data_)
+        , rowSize(blockSize.x())
+        , nRows(blockSize.y())
+        , beginSlice(padding.z() + blockSize.z() * chunk / nChunks)
+        , endSlice(padding.z() + blockSize.z() * (chunk + 1) / nChunks)
+        , paddingX(padding.x())
+        , paddingY(padding.y())
+        , rowStride(blockSize.x() + 2 * padding.x())
+        , sliceStride(rowStride * (blockSize.y() + 2 * padding.y()))
+    {
+    }
+
+    template <class F>
+    void forEachRow(const F& function) const
+    {
+        for (size_t z = beginSlice; z < endSlice; ++z)
+            for (size_t y = paddingY; y < paddingY + nRows; ++y)
+                function(data + z * sliceStride + y * rowStride + paddingX,
+                         rowSize);
+    }
+
+    const T* const data;
+    const size_t rowSize;
+    const size_t nRows;
+    const size_t beginSlice;
+    const size_t endSlice;
+    const size_t paddingX;
+    const size_t paddingY;
+    const size_t rowStride;
+    const size_t sliceStride;
+};
+
+/** Runs function(chunk) for all chunks, the first one on the calling thread */
+template <class F>
+void parallelFor(const size_t nChunks, const F& function)
+{
+    std::vector<boost::thread> threads;
+    threads.reserve(nChunks - 1);
+    for (size_t chunk = 1; chunk < nChunks; ++chunk)
+        threads.emplace_back([&function, chunk] { function(chunk); });
+    function(0);
+    for (boost::thread& thread : threads)
+        thread.join();
+}
+
+/** Expands lo and hi to the values of a row, in a vectorizable way */
+template <class T>
+void expandRowRange(const T* row, const size_t size, T& lo, T& hi)
+{
+    T los[nLanes];
+    T his[nLanes];
+    for (size_t lane = 0; lane < nLanes; ++lane)
+    {
+        los[lane] = lo;
+        his[lane] = hi;
+    }
+
+    size_t i = 0;
+    for (; i + nLanes <= size; i += nLanes)
+        for (size_t lane = 0; lane < nLanes; ++lane)
+        {
+            const T value = row[i + lane];
+            los[lane] = value < los[lane] ? value : los[lane];
+            his[lane] = value > his[lane] ? value : his[lane];
+        }
+    for (; i < size; ++i)
+    {
+        lo = row[i] < lo ? row[i] : lo;
+        hi = row[i] > hi ? row[i] : hi;
+    }
+
+    for (size_t lane = 0; lane < nLanes; ++lane)
+    {
+        lo = los[lane] < lo ? los[lane] : lo;
+        hi = his[lane] > hi ? his[lane] : hi;
+    }
+}
+
+/** @return the range of the values in the inner box */
+template <class T>
+std::pair<T, T> getRange(const T* data, const Vector3ui& blockSize,
+                         const Vector3ui& padding, const size_t nChunks)
+{
+    std::vector<std::pair<T, T>> ranges(
+        nChunks, {std::numeric_limits<T>::max(),
+                  std::numeric_limits<T>::lowest()});
+    parallelFor(nChunks, [&](const size_t chunk) {
+        T lo = ranges[chunk].first;
+        T hi = ranges[chunk].second;
+        InnerBox<T>(data, blockSize, padding, chunk, nChunks)
+            .forEachRow([&lo, &hi](const T* row, const size_t size) {
+                expandRowRange(row, size, lo, hi);
+            });
+        ranges[chunk] = {lo, hi};
+    });
+
+    std::pair<T, T> range = ranges.front();
+    for (const std::pair<T, T>& chunkRange : ranges)
+    {
+        range.first = std::min(range.first, chunkRange.first);
+        range.second = std::max(range.second, chunkRange.second);
+    }
+    return range;
+}
+
+/** Bins integers by a power of two width */
+template <class T>
+struct ShiftBinner
+{
+    size_t operator()(const T value) const
+    {
+        return (uint32_t(value) - uint32_t(min)) >> shift;
+    }
+
+    T min;
+    uint32_t shift;
+};
+
+/** Bins integers by any width */
+template <class T>
+struct DivideBinner
+{
+    size_t operator()(const T value) const
+    {
+        return (uint32_t(value) - uint32_t(min)) / width;
+    }
+
+    T min;
+    uint32_t width;
+};
+
+/** Bins floats, the values rounded into the last bin are clamped into it */
+struct FloatBinner
+{
+    size_t operator()(const float value) const
+    {
+        const float bin = (value - min) / width;
+        return bin < last ? size_t(bin) : size_t(last);
+    }
+
+    float min;
+    float width;
+    float last;
+};
+
+/**
+ * Counts the voxels of the inner box in sub-histograms, so the increments of
+ * consecutive voxels do not wait for each other, then adds them to the bins.
+ */
+template <class T, class Binner>
+void countVoxels(const T* data, const Vector3ui& blockSize,
+                 const Vector3ui& padding, const uint64_t scaleFactor,
+                 const Binner& binner, std::vector<uint64_t>& bins,
+                 const size_t nChunks)
+{
+    const size_t nBins = bins.size();
+    std::vector<std::vector<uint32_t>> counts(nChunks);
+    parallelFor(nChunks, [&](const size_t chunk) {
+        std::vector<uint32_t>& chunkCounts = counts[chunk];
+        chunkCounts.resize(nSubHistograms * nBins);
+        uint32_t* const counts0 = chunkCounts.data();
+        uint32_t* const counts1 = counts0 + nBins;
+        uint32_t* const counts2 = counts1 + nBins;
+        uint32_t* const counts3 = counts2 + nBins;
+
+        InnerBox<T>(data, blockSize, padding, chunk, nChunks)
+            .forEachRow([&](const T* row, const size_t size) {
+                size_t i = 0;
+                for (; i + nSubHistograms <= size; i += nSubHistograms)
+                {
+                    ++counts0[binner(row[i])];
+                    ++counts1[binner(row[i + 1])];
+                    ++counts2[binner(row[i + 2])];
+                    ++counts3[binner(row[i + 3])];
+                }
+                for (; i < size; ++i)
+                    ++counts0[binner(row[i])];
+            });
+    });
+
+    for (const std::vector<uint32_t>& chunkCounts : counts)
+        for (size_t i = 0; i < chunkCounts.size(); ++i)
+            bins[i % nBins] += scaleFactor * chunkCounts[i];
+}
+
+template <class T>
+void binBrick(const T* data, const Vector3ui& blockSize,
+              const Vector3ui& padding, const uint64_t scaleFactor, float& min,
+              float& max, std::vector<uint64_t>& bins, const size_t nChunks)
+{
+    const int64_t lowest = std::numeric_limits<T>::lowest();
+    const int64_t highest = std::numeric_limits<T>::max();
+    int64_t lo = std::max(int64_t(std::floor(std::max(min, float(lowest)))),
+                          lowest);
+    int64_t hi = std::min(int64_t(std::ceil(std::min(max, float(highest)))),
+                          highest);
+
+    // the range of 8 bit types is usually already the range of the type
+    if (lo > lowest || hi < highest)
+    {
+        const std::pair<T, T> range =
+            getRange(data, blockSize, padding, nChunks);
+        lo = std::min(lo, int64_t(range.first));
+        hi = std::max(hi, int64_t(range.second));
+    }
+
+    min = lo;
+    max = hi;
+    if (lo == hi)
+    {
+        bins.assign(1, blockSize.product() * scaleFactor);
+        return;
+    }
+
+    const uint64_t range = hi - lo;
+    const uint64_t width = (range + bins.size() - 2) / (bins.size() - 1);
+    if ((width & (width - 1)) == 0)
+    {
+        uint32_t shift = 0;
+        while ((uint64_t(1) << shift) < width)
+            ++shift;
+        countVoxels(data, blockSize, padding, scaleFactor,
+                    ShiftBinner<T>{T(lo), shift}, bins, nChunks);
+    }
+    else
+        countVoxels(data, blockSize, padding, scaleFactor,
+                    DivideBinner<T>{T(lo), uint32_t(width)}, bins, nChunks);
+}
+
+void binBrick(const float* data, const Vector3ui& blockSize,
+              const Vector3ui& padding, const uint64_t scaleFactor, float& min,
+              float& max, std::vector<uint64_t>& bins, const size_t nChunks)
+{
+    const std::pair<float, float> range =
+        getRange(data, blockSize, padding, nChunks);
+    min = std::min(min, range.first);
+    max = std::max(max, range.second);
+    if (max - min == 0.0f)
+    {
+        bins.assign(1, blockSize.product() * scaleFactor);
+        return;
+    }
+
+    const float last = float(bins.size() - 1);
+    countVoxels(data, blockSize, padding, scaleFactor,
+                FloatBinner{min, (max - min) / last, last}, bins, nChunks);
+}
+
+size_t getChunkCount(const Vector3ui& blockSize, const size_t nThreads)
+{
+    return std::max(size_t(1), std::min(nThreads, size_t(blockSize.z())));
+}
+}
+
+template <class T>
+void binVoxels(const T* data, const Vector3ui& blockSize,
+               const Vector3ui& padding, const uint64_t scaleFactor,
+               float& min, float& max, std::vector<uint64_t>& bins,
+               const size_t nThreads)
+{
+    if (bins.size() < 2)
+        LBTHROW(std::invalid_argument("At least two bins are needed"));
+
+    binBrick(data, blockSize, padding, scaleFactor, min, max, bins,
+             getChunkCount(blockSize, nThreads));
+}
+
+template <class T>
+void expandValueRange(const T* data, const Vector3ui& blockSize,
+                      const Vector3ui& padding, float& min, float& max,
+                      const size_t nThreads)
+{
+    const std::pair<T, T> range = getRange(data, blockSize, padding,
+                                           getChunkCount(blockSize, nThreads));
+    min = std::min(min, float(range.first));
+    max = std::max(max, float(range.second));
+}
+
+size_t getHistogramBinCount(const DataType dataType)
+{
+    switch (dataType)
+    {
+    case DT_UINT8:
+    case DT_INT8:
+    case DT_FLOAT:
+        return 256;
+    case DT_UINT16:
+    case DT_INT16:
+        return 1024;
+    case DT_UINT32:
+    case DT_INT32:
+        return 4096;
+    case DT_UNDEFINED:
+    default:
+        LBTHROW(std::runtime_error("Unimplemented data type."));
+    }
+}
+
+#define INSTANTIATE_KERNELS(T)                                                \
+    template LIVREDATA_API void binVoxels(const T*, const Vector3ui&,         \
+                                          const Vector3ui&, uint64_t, float&, \
+                                          float&, std::vector<uint64_t>&,     \
+                                          size_t);                            \
+    template LIVREDATA_API void expandValueRange(const T*, const Vector3ui&,  \
+                                                 const Vector3ui&, float&,    \
+                                                 float&, size_t);
+
+INSTANTIATE_KERNELS(uint8_t)
+INSTANTIATE_KERNELS(uint16_t)
+INSTANTIATE_KERNELS(uint32_t)
+INSTANTIATE_KERNELS(int8_t)
+INSTANTIATE_KERNELS(int16_t)
+INSTANTIATE_KERNELS(int32_t)
+INSTANTIATE_KERNELS(float)
+#undef INSTANTIATE_KERNELS
+}
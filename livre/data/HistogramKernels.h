@@ -0,0 +1,78 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _HistogramKernels_h_
+#define _HistogramKernels_h_
+
+#include <livre/data/VolumeInformation.h>
+#include <livre/data/api.h>
+#include <livre/data/types.h>
+
+namespace livre
+{
+/**
+ * Adds the voxels of a brick to histogram bins which cover a value range.
+ *
+ * The range is expanded to the values of the brick. The bin of a voxel is
+ * (value - min) / width, where the width of a bin is ceil(range /
+ * (binCount - 1)) for integer types and range / (binCount - 1) for floats. For
+ * integer types, the range is rounded to integers inside the range of the
+ * type. If the expanded range is empty, the bins are replaced by a single bin
+ * counting all the voxels.
+ *
+ * Only the voxels of the inner box are read, the padding is skipped. The brick
+ * is split along z between the given number of threads, the calling thread
+ * being one of them. The voxels of one thread are counted in 32 bits.
+ *
+ * Supported types are the ones of DataType: [u]int8_t, [u]int16_t, [u]int32_t
+ * and float.
+ *
+ * @param data the voxels of the brick including its padding, x varying fastest
+ * @param blockSize the size of the brick without its padding
+ * @param padding the number of padding voxels on each side
+ * @param scaleFactor the number of voxels of the volume a voxel stands for
+ * @param min the lower bound of the range, expanded by the brick
+ * @param max the upper bound of the range, expanded by the brick
+ * @param bins the bins to add the voxels to, at least two
+ * @param nThreads the maximum number of threads binning the brick
+ */
+template <class T>
+LIVREDATA_API void binVoxels(const T* data, const Vector3ui& blockSize,
+                             const Vector3ui& padding, uint64_t scaleFactor,
+                             float& min, float& max,
+                             std::vector<uint64_t>& bins, size_t nThreads = 1);
+
+/**
+ * Expands a value range to the voxels of the inner box of a brick.
+ * @param data the voxels of the brick including its padding, x varying fastest
+ * @param blockSize the size of the brick without its padding
+ * @param padding the number of padding voxels on each side
+ * @param min the lower bound of the range, expanded by the brick
+ * @param max the upper bound of the range, expanded by the brick
+ * @param nThreads the maximum number of threads reading the brick
+ */
+template <class T>
+LIVREDATA_API void expandValueRange(const T* data, const Vector3ui& blockSize,
+                                    const Vector3ui& padding, float& min,
+                                    float& max, size_t nThreads = 1);
+
+/** @return the number of histogram bins for a data type */
+LIVREDATA_API size_t getHistogramBinCount(DataType dataType);
+}
+
+#endif // _HistogramKernels_h_
@@ -0,0 +1,418 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <livre/data/DataSource.h>
+#include <livre/data/HistogramKernels.h>
+#include <livre/data/HistogramPyramid.h>
+#include <livre/data/NodeId.h>
+
+#include <boost/filesystem/operations.hpp>
+
+#include <fstream>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace livre
+{
+namespace
+{
+const char magic[8] = {'L', 'i', 'v', 'r', 'e', 'H', 'P', 'y'};
+const uint32_t version = 2; // with the dataset hash
+
+template <class T>
+void write(std::ostream& os, const T& value)
+{
+    os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <class T>
+void read(std::istream& is, T& value)
+{
+    is.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+}
+
+struct HistogramPyramid::Impl
+{
+    Impl(const DataSource& dataSource, const uint32_t timeStep_,
+         const size_t nThreads)
+        : datasetHash(dataSource.getDatasetHash())
+        , timeStep(timeStep_)
+    {
+        const VolumeInformation& volumeInfo = dataSource.getVolumeInfo();
+        if (volumeInfo.compCount > 1)
+            LBTHROW(std::runtime_error("Multiple channels are not supported"));
+
+        setTree(volumeInfo);
+
+        switch (dataType)
+        {
+        case DT_UINT8:
+            computeLeaves<uint8_t>(dataSource, nThreads);
+            break;
+        case DT_UINT16:
+            computeLeaves<uint16_t>(dataSource, nThreads);
+            break;
+        case DT_UINT32:
+            computeLeaves<uint32_t>(dataSource, nThreads);
+            break;
+        case DT_INT8:
+            computeLeaves<int8_t>(dataSource, nThreads);
+            break;
+        case DT_INT16:
+            computeLeaves<int16_t>(dataSource, nThreads);
+            break;
+        case DT_INT32:
+            computeLeaves<int32_t>(dataSource, nThreads);
+            break;
+        case DT_FLOAT:
+            computeLeaves<float>(dataSource, nThreads);
+            break;
+        case DT_UNDEFINED:
+        default:
+            LBTHROW(std::runtime_error("Unimplemented data type."));
+        }
+
+        for (uint32_t level = depth - 1; level > 0; --level)
+            forEachNode(level, [this](const NodeId& nodeId) {
+                uint64_t* parentBins = getBins(nodeId.getParent());
+                const uint64_t* childBins = getBins(nodeId);
+                for (size_t i = 0; i < nBins; ++i)
+                    parentBins[i] += childBins[i];
+            });
+    }
+
+    explicit Impl(const std::string& filename)
+    {
+        std::ifstream file(filename.c_str(), std::ios::binary);
+        char fileMagic[sizeof(magic)];
+        file.read(fileMagic, sizeof(magic));
+        uint32_t fileVersion = 0;
+        read(file, fileVersion);
+        if (!file || !std::equal(magic, magic + sizeof(magic), fileMagic) ||
+            fileVersion != version)
+        {
+            LBTHROW(std::runtime_error("Not a histogram pyramid file: " +
+                                       filename));
+        }
+
+        uint32_t type = DT_UNDEFINED;
+        uint64_t binCount = 0;
+        read(file, datasetHash);
+        read(file, timeStep);
+        read(file, depth);
+        for (size_t i = 0; i < 3; ++i)
+            read(file, blockCount[i]);
+        read(file, type);
+        read(file, range[0]);
+        read(file, range[1]);
+        read(file, binCount);
+        if (!file || depth == 0 || depth > INVALID_LEVEL ||
+            type >= DT_UNDEFINED || binCount == 0 ||
+            binCount > getHistogramBinCount(DataType(type)))
+        {
+            LBTHROW(std::runtime_error("Invalid histogram pyramid file: " +
+                                       filename));
+        }
+
+        dataType = DataType(type);
+        nBins = binCount;
+        setLevelOffsets();
+        bins.resize(levelOffsets.back() * nBins);
+        file.read(reinterpret_cast<char*>(bins.data()),
+                  bins.size() * sizeof(uint64_t));
+        if (!file)
+            LBTHROW(std::runtime_error("Truncated histogram pyramid file: " +
+                                       filename));
+    }
+
+    // Written to a temporary file which replaces the file at once, so the
+    // readers on other nodes never see a partially written pyramid
+    void save(const std::string& filename) const
+    {
+        boost::system::error_code error;
+        const boost::filesystem::path path(filename);
+        const boost::filesystem::path tmpPath =
+            path.string() +
+            boost::filesystem::unique_path(".%%%%-%%%%.tmp", error).string();
+        if (error)
+            LBTHROW(std::runtime_error("Cannot write histogram pyramid file: " +
+                                       filename));
+
+        std::ofstream file(tmpPath.string().c_str(), std::ios::binary);
+        file.write(magic, sizeof(magic));
+        write(file, version);
+        write(file, datasetHash);
+        write(file, timeStep);
+        write(file, depth);
+        for (size_t i = 0; i < 3; ++i)
+            write(file, blockCount[i]);
+        write(file, uint32_t(dataType));
+        write(file, range[0]);
+        write(file, range[1]);
+        write(file, uint64_t(nBins));
+        file.write(reinterpret_cast<const char*>(bins.data()),
+                   bins.size() * sizeof(uint64_t));
+        file.close();
+        if (file)
+            boost::filesystem::rename(tmpPath, path, error);
+        if (!file || error)
+        {
+            boost::filesystem::remove(tmpPath, error);
+            LBTHROW(std::runtime_error("Cannot write histogram pyramid file: " +
+                                       filename));
+        }
+    }
+
+    void setTree(const VolumeInformation& volumeInfo)
+    {
+        depth = volumeInfo.rootNode.getDepth();
+        blockCount = volumeInfo.rootNode.getBlockSize();
+        dataType = volumeInfo.dataType;
+        if (depth == 0)
+            LBTHROW(std::runtime_error("Empty LOD tree"));
+        setLevelOffsets();
+    }
+
+    /** The nodes of a level are stored with x varying fastest */
+    void setLevelOffsets()
+    {
+        levelOffsets.assign(1, 0);
+        for (uint32_t level = 0; level < depth; ++level)
+            levelOffsets.push_back(levelOffsets.back() +
+                                   getLevelSize(level).product());
+    }
+
+    Vector3ui getLevelSize(const uint32_t level) const
+    {
+        return blockCount * (1u << level);
+    }
+
+    template <class F>
+    void forEachNode(const uint32_t level, const F& function) const
+    {
+        const Vector3ui size = getLevelSize(level);
+        for (uint32_t z = 0; z < size.z(); ++z)
+            for (uint32_t y = 0; y < size.y(); ++y)
+                for (uint32_t x = 0; x < size.x(); ++x)
+                    function(NodeId(level, Vector3ui(x, y, z), timeStep));
+    }
+
+    /** @return the offset of the node, or the total size if none */
+    size_t getOffset(const NodeId& nodeId) const
+    {
+        const size_t invalid = levelOffsets.back() * nBins;
+        const uint32_t level = nodeId.getLevel();
+        if (!nodeId.isValid() || nodeId.getTimeStep() != timeStep ||
+            level >= depth)
+        {
+            return invalid;
+        }
+
+        const Vector3ui size = getLevelSize(level);
+        const Vector3ui position = nodeId.getPosition();
+        if (position.x() >= size.x() || position.y() >= size.y() ||
+            position.z() >= size.z())
+        {
+            return invalid;
+        }
+
+        const size_t index =
+            (size_t(position.z()) * size.y() + position.y()) * size.x() +
+            position.x();
+        return (levelOffsets[level] + index) * nBins;
+    }
+
+    uint64_t* getBins(const NodeId& nodeId)
+    {
+        const size_t offset = getOffset(nodeId);
+        return offset < bins.size() ? &bins[offset] : nullptr;
+    }
+
+    const uint64_t* getBins(const NodeId& nodeId) const
+    {
+        const size_t offset = getOffset(nodeId);
+        return offset < bins.size() ? &bins[offset] : nullptr;
+    }
+
+    template <class T>
+    void computeLeaves(const DataSource& dataSource, const size_t nThreads)
+    {
+        const VolumeInformation& volumeInfo = dataSource.getVolumeInfo();
+        const uint32_t leafLevel = depth - 1;
+        const auto readLeaf = [&dataSource](
+            const NodeId& nodeId) -> ConstMemoryUnitPtr {
+            const ConstMemoryUnitPtr data = dataSource.getData(nodeId);
+            if (!data)
+                LBTHROW(std::runtime_error("Cannot read the data of a node"));
+            return data;
+        };
+
+        float min = std::numeric_limits<T>::lowest();
+        float max = std::numeric_limits<T>::max();
+        if (volumeInfo.hasValueRange())
+        {
+            min = volumeInfo.valueRange[0];
+            max = volumeInfo.valueRange[1];
+        }
+        else if (sizeof(T) > 1)
+        {
+            min = std::numeric_limits<float>::max();
+            max = std::numeric_limits<float>::lowest();
+            forEachNode(leafLevel, [&](const NodeId& nodeId) {
+                const ConstMemoryUnitPtr data = readLeaf(nodeId);
+                const Vector3ui voxels =
+                    dataSource.getNode(nodeId).getVoxelBox().getSize();
+                expandValueRange(data->getData<T>(), voxels,
+                                 volumeInfo.overlap, min, max, nThreads);
+            });
+        }
+        range = {{min, max}};
+
+        // all the voxels are in one bin, like in a histogram of one brick
+        nBins = min == max ? 1 : getHistogramBinCount(dataType);
+        bins.resize(levelOffsets.back() * nBins);
+
+        std::vector<uint64_t> leafBins;
+        forEachNode(leafLevel, [&](const NodeId& nodeId) {
+            const ConstMemoryUnitPtr data = readLeaf(nodeId);
+            const Vector3ui voxels =
+                dataSource.getNode(nodeId).getVoxelBox().getSize();
+            leafBins.assign(getHistogramBinCount(dataType), 0);
+            float leafMin = min;
+            float leafMax = max;
+            binVoxels(data->getData<T>(), voxels,
+                      volumeInfo.overlap, 1, leafMin, leafMax, leafBins,
+                      nThreads);
+            std::copy(leafBins.begin(), leafBins.begin() + nBins,
+                      getBins(nodeId));
+        });
+    }
+
+    uint64_t datasetHash; // see DataSource::getDatasetHash()
+    uint32_t timeStep;
+    uint32_t depth;
+    Vector3ui blockCount;
+    DataType dataType;
+    Range range;
+    size_t nBins;
+    std::vector<size_t> levelOffsets; // in nodes, with the total at the end
+    std::vector<uint64_t> bins;
+};
+
+HistogramPyramid::HistogramPyramid(const DataSource& dataSource,
+                                   const uint32_t timeStep,
+                                   const size_t nThreads)
+    : _impl(new Impl(dataSource, timeStep, nThreads))
+{
+}
+
+HistogramPyramid::HistogramPyramid(const std::string& filename)
+    : _impl(new Impl(filename))
+{
+}
+
+HistogramPyramid::~HistogramPyramid()
+{
+}
+
+void HistogramPyramid::save(const std::string& filename) const
+{
+    _impl->save(filename);
+}
+
+bool HistogramPyramid::matches(const DataSource& dataSource,
+                               const uint32_t timeStep) const
+{
+    const VolumeInformation& volumeInfo = dataSource.getVolumeInfo();
+    return dataSource.getDatasetHash() == _impl->datasetHash &&
+           timeStep == _impl->timeStep &&
+           volumeInfo.rootNode.getDepth() == _impl->depth &&
+           volumeInfo.rootNode.getBlockSize() == _impl->blockCount &&
+           volumeInfo.dataType == _impl->dataType &&
+           (!volumeInfo.hasValueRange() ||
+            volumeInfo.valueRange == _impl->range);
+}
+
+uint32_t HistogramPyramid::getTimeStep() const
+{
+    return _impl->timeStep;
+}
+
+Range HistogramPyramid::getRange() const
+{
+    return _impl->range;
+}
+
+size_t HistogramPyramid::getBinCount() const
+{
+    return _impl->nBins;
+}
+
+const uint64_t* HistogramPyramid::getBins(const NodeId& nodeId) const
+{
+    return static_cast<const Impl&>(*_impl).getBins(nodeId);
+}
+
+bool HistogramPyramid::accumulate(const NodeIds& nodeIds,
+                                  std::vector<uint64_t>& bins) const
+{
+    bins.assign(_impl->nBins, 0);
+    for (const NodeId& nodeId : nodeIds)
+    {
+        const uint64_t* nodeBins = getBins(nodeId);
+        if (!nodeBins)
+            return false;
+        for (size_t i = 0; i < bins.size(); ++i)
+            bins[i] += nodeBins[i];
+    }
+    return true;
+}
+
+NodeIds HistogramPyramid::getCover(const NodeIds& nodeIds)
+{
+    std::vector<NodeIds> levels;
+    for (const NodeId& nodeId : nodeIds)
+    {
+        if (levels.size() <= nodeId.getLevel())
+            levels.resize(nodeId.getLevel() + 1);
+        levels[nodeId.getLevel()].push_back(nodeId);
+    }
+
+    NodeIds cover;
+    for (size_t level = levels.size(); level-- > 0;)
+    {
+        std::unordered_map<Identifier, size_t> children;
+        if (level > 0)
+            for (const NodeId& nodeId : levels[level])
+                ++children[nodeId.getParent().getId()];
+
+        std::unordered_set<Identifier> parents;
+        for (const NodeId& nodeId : levels[level])
+        {
+            const NodeId parent = nodeId.getParent();
+            if (level == 0 || children[parent.getId()] < 8)
+                cover.push_back(nodeId);
+            else if (parents.insert(parent.getId()).second)
+                levels[level - 1].push_back(parent);
+        }
+    }
+    return cover;
+}
+}
@@ -0,0 +1,119 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _HistogramPyramid_h_
+#define _HistogramPyramid_h_
+
+#include <livre/data/api.h>
+#include <livre/data/types.h>
+
+namespace livre
+{
+/**
+ * The histograms of all the nodes of the LOD tree of a time step, at full
+ * resolution: the histograms of the leaf nodes are computed from their
+ * voxels, the ones of the other nodes are the sums of their children.
+ *
+ * The bins of all the nodes cover the value range of the volume, or of the
+ * whole time step if it is unknown, so the histogram of any region covered by
+ * nodes is the sum of their bins, without reading voxels. The pyramid holds
+ * (8^depth - 1) / 7 histograms per root block.
+ */
+class HistogramPyramid
+{
+public:
+    /**
+     * Computes the pyramid by reading the leaf nodes twice: for the value
+     * range of the time step, then for their histograms. If the value range
+     * of the volume is known, e.g. for 8 bit types, the bins cover it and a
+     * single pass is needed.
+     * @param dataSource the volume
+     * @param timeStep the time step of the nodes
+     * @param nThreads the maximum number of threads binning a node
+     * @throw std::runtime_error if the data type is not supported or if the
+     *        data of a node cannot be read
+     */
+    LIVREDATA_API HistogramPyramid(const DataSource& dataSource,
+                                   uint32_t timeStep, size_t nThreads = 1);
+
+    /**
+     * Loads a pyramid saved with save().
+     * @throw std::runtime_error if the file cannot be read
+     */
+    LIVREDATA_API explicit HistogramPyramid(const std::string& filename);
+
+    LIVREDATA_API ~HistogramPyramid();
+
+    /**
+     * Saves the pyramid, e.g. next to the dataset. The file is replaced
+     * atomically, a concurrent reader loads the previous or the new pyramid.
+     * @throw std::runtime_error if the file cannot be written
+     */
+    LIVREDATA_API void save(const std::string& filename) const;
+
+    /**
+     * @param dataSource the volume
+     * @param timeStep the time step of the nodes
+     * @return true if the pyramid was computed for the time step of the
+     *         volume, see DataSource::getDatasetHash(), and has its LOD tree
+     *         and type, and its value range if it is known
+     */
+    LIVREDATA_API bool matches(const DataSource& dataSource,
+                               uint32_t timeStep) const;
+
+    /** @return the time step of the nodes */
+    LIVREDATA_API uint32_t getTimeStep() const;
+
+    /** @return the value range covered by the bins */
+    LIVREDATA_API Range getRange() const;
+
+    /** @return the number of bins of each node */
+    LIVREDATA_API size_t getBinCount() const;
+
+    /**
+     * @return the bins of a node, or nullptr if the node is not in the
+     *         pyramid, e.g. if it is of another time step
+     */
+    LIVREDATA_API const uint64_t* getBins(const NodeId& nodeId) const;
+
+    /**
+     * Adds up the histograms of nodes.
+     * @param nodeIds the nodes, which do not overlap
+     * @param bins the sum of their bins, getBinCount() values
+     * @return false if a node is not in the pyramid
+     */
+    LIVREDATA_API bool accumulate(const NodeIds& nodeIds,
+                                  std::vector<uint64_t>& bins) const;
+
+    /**
+     * @param nodeIds nodes which do not overlap
+     * @return the coarsest nodes covering the same region: the parents whose
+     *         children are all given replace them
+     */
+    LIVREDATA_API static NodeIds getCover(const NodeIds& nodeIds);
+
+private:
+    HistogramPyramid(const HistogramPyramid&) = delete;
+    HistogramPyramid& operator=(const HistogramPyramid&) = delete;
+
+    struct Impl;
+    std::unique_ptr<Impl> _impl;
+};
+}
+
+#endif // _HistogramPyramid_h_
@@ -105,6 +105,9 @@ struct RawDataSource::Impl
         {
             _outputType = getDataType(output->second);
             volInfo.dataType = _outputType;
+            // the values are scaled to the output type
+            if (_outputType != _inputType)
+                volInfo.valueRange = VolumeInformation().valueRange;
         }
     }
 
@@ -193,6 +196,7 @@ struct RawDataSource::Impl
                 boost::filesystem::path(filename).parent_path();
             dataFilePath /= dataInfo["datafile"];
             dataFile = dataFilePath.string();
+            _headerSize = 0; // the detached data starts at the file begin
         }
 
         if (!_mmap.map(dataFile))
@@ -216,6 +220,21 @@ struct RawDataSource::Impl
         volInfo.voxels[1] = vec[1];
         volInfo.voxels[2] = vec[2];
         volInfo.bigEndian = dataInfo["endian"] == "big";
+
+        // optional fields of the header
+        if (dataInfo.count("min") > 0 && dataInfo.count("max") > 0)
+        {
+            try
+            {
+                volInfo.valueRange = {{lexical_cast<float>(dataInfo["min"]),
+                                       lexical_cast<float>(dataInfo["max"])}};
+            }
+            catch (const boost::bad_lexical_cast&)
+            {
+                LBWARN << "Ignoring invalid min or max in " << filename
+                       << std::endl;
+            }
+        }
     }
 
     lunchbox::MemoryMap _mmap;
@@ -21,16 +21,41 @@
 
 #include <livre/data/LODNode.h>
 #include <livre/data/types.h>
-//#define LIVRE_STATIC_DECOMPOSITION
+
+#include <algorithm>
+#include <numeric>
 
 namespace livre
 {
+namespace
+{
+// Interleaves the bits of the brick position at the finest level, which gives
+// its position on the Z-order curve, i.e. the order of a kd traversal which
+// alternates the split axis. Bricks of an octree subtree are contiguous.
+uint64_t getZOrderKey(const NodeId& nodeId, const uint32_t depth)
+{
+    const uint32_t shift = depth - 1 - nodeId.getLevel();
+    const Vector3ui position = nodeId.getPosition();
+
+    uint64_t key = 0;
+    for (uint32_t bit = 0; bit < NODEID_BLOCK_BITS; ++bit)
+    {
+        for (size_t axis = 0; axis < 3; ++axis)
+        {
+            const uint64_t value = uint64_t(position[axis]) << shift;
+            key |= ((value >> bit) & 1u) << (3 * bit + 2 - axis);
+        }
+    }
+    return key;
+}
+}
+
 struct SelectVisibles::Impl
 {
     Impl(const DataSource& dataSource, const Frustum& frustum,
          const uint32_t windowHeight, const float screenSpaceError,
          const uint32_t minLOD, const uint32_t maxLOD, const Range& range,
-         const ClipPlanes& clipPlanes)
+         const ClipPlanes& clipPlanes, const Decomposition decomposition)
         : _dataSource(dataSource)
         , _frustum(frustum)
         , _windowHeight(windowHeight)
@@ -39,6 +64,7 @@ struct SelectVisibles::Impl
         , _maxLOD(maxLOD)
         , _range(range)
         , _clipPlanes(clipPlanes)
+        , _decomposition(decomposition)
     {
     }
 
@@ -101,31 +127,70 @@ struct SelectVisibles::Impl
                      (lodNode.getRefLevel() == depth - 1);
 
         if (lodVisible)
+        {
             _visibles.push_back(lodNode.getNodeId());
+            _costs.push_back(lodNode.getVoxelBox().getSize().product());
+        }
 
         return !lodVisible;
     }
 
-    void visitPre() { _visibles.clear(); }
+    void visitPre()
+    {
+        _visibles.clear();
+        _costs.clear();
+    }
+
     void visitPost()
     {
-// Sort-last range selection:
-#ifndef LIVRE_STATIC_DECOMPOSITION
+        // Sort-last range selection
+        if (_range[0] <= 0.f && _range[1] >= 1.f)
+            return;
+
+        if (_decomposition == DECOMPOSITION_SPATIAL)
+            selectSpatial();
+        else
+            selectOrdered();
+    }
+
+    void selectOrdered()
+    {
         const size_t startIndex = _range[0] * _visibles.size();
         const size_t endIndex = _range[1] * _visibles.size();
-#endif
+
         NodeIds selected;
+        for (size_t i = startIndex; i < endIndex && i < _visibles.size(); ++i)
+            selected.push_back(_visibles[i]);
+        _visibles.swap(selected);
+    }
+
+    // Orders the bricks along the Z-order curve and assigns each brick to the
+    // range containing the center of its cost interval. The split positions
+    // only move with the cost distribution, so under camera motion the bricks
+    // of a range stay in the same region of the volume, and changing the range
+    // (e.g. by a load equalizer) only reassigns the bricks at the boundaries.
+    void selectSpatial()
+    {
+        const uint32_t depth = _dataSource.getVolumeInfo().rootNode.getDepth();
+        std::vector<std::pair<uint64_t, size_t>> keys;
+        keys.reserve(_visibles.size());
         for (size_t i = 0; i < _visibles.size(); ++i)
+            keys.emplace_back(getZOrderKey(_visibles[i], depth), i);
+        std::sort(keys.begin(), keys.end());
+
+        const float totalCost =
+            std::accumulate(_costs.begin(), _costs.end(), 0.f);
+
+        NodeIds selected;
+        float cost = 0.f;
+        for (const auto& key : keys)
         {
-#ifdef LIVRE_STATIC_DECOMPOSITION
-            const Range& nodeRange = _visibles[i].getRange();
-            const bool isInRange =
-                nodeRange[1] > _range[0] && nodeRange[1] <= _range[1];
-#else
-            const bool isInRange = i >= startIndex && i < endIndex;
-#endif
-            if (isInRange)
-                selected.push_back(_visibles[i]);
+            const float brickCost = _costs[key.second];
+            const float center = (cost + brickCost * 0.5f) / totalCost;
+            cost += brickCost;
+
+            if (center >= _range[0] && center < _range[1])
+                selected.push_back(_visibles[key.second]);
         }
         _visibles.swap(selected);
     }
@@ -138,7 +203,9 @@ struct SelectVisibles::Impl
     const uint32_t _maxLOD;
     const Range _range;
     NodeIds _visibles;
+    std::vector<float> _costs;
     const ClipPlanes _clipPlanes;
+    const Decomposition _decomposition;
 };
 
 SelectVisibles::SelectVisibles(const DataSource& dataSource,
@@ -146,11 +213,12 @@ SelectVisibles::SelectVisibles(const DataSource& dataSource,
                                const uint32_t windowHeight,
                                const float screenSpaceError,
                                const uint32_t minLOD, const uint32_t maxLOD,
-                               const Range& range, const ClipPlanes& clipPlanes)
+                               const Range& range, const ClipPlanes& clipPlanes,
+                               const Decomposition decomposition)
     : DataSourceVisitor(dataSource)
     , _impl(new SelectVisibles::Impl(dataSource, frustum, windowHeight,
                                      screenSpaceError, minLOD, maxLOD, range,
-                                     clipPlanes))
+                                     clipPlanes, decomposition))
 {
 }
 
@@ -163,6 +231,11 @@ const NodeIds& SelectVisibles::getVisibles() const
     return _impl->_visibles;
 }
 
+NodeIds SelectVisibles::takeVisibles()
+{
+    return std::move(_impl->_visibles);
+}
+
 void SelectVisibles::visitPre()
 {
     _impl->visitPre();
@@ -40,11 +40,15 @@ public:
      * @param maxLOD maximum level of detail
      * @param range range of the data
      * @param ClipPlanes clip planes
+     * @param decomposition how the range selects the visible bricks. The
+     *        spatial decomposition keeps the bricks of a range stable under
+     *        camera motion.
      */
     SelectVisibles(const DataSource& dataSource, const Frustum& frustum,
                    const uint32_t windowHeight, const float screenSpaceError,
                    const uint32_t minLOD, const uint32_t maxLOD,
-                   const Range& range, const ClipPlanes& clipPlanes);
+                   const Range& range, const ClipPlanes& clipPlanes,
+                   Decomposition decomposition = DECOMPOSITION_SPATIAL);
 
     ~SelectVisibles();
 
@@ -53,6 +57,11 @@ public:
      */
     const NodeIds& getVisibles() const;
 
+    /**
+     * @return the list of visibles, moved out of the visitor
+     */
+    NodeIds takeVisibles();
+
 protected:
     void visitPre() final;
     bool visit(const LODNode& lodNode) final;
@@ -19,6 +19,8 @@
 
 #include <livre/data/VolumeInformation.h>
 
+#include <limits>
+
 namespace livre
 {
 VolumeInformation::VolumeInformation()
@@ -33,7 +35,14 @@ VolumeInformation::VolumeInformation()
     , worldSpacePerVoxel(0.0f)
     , meterToDataUnitRatio(1.0f)
     , frameRange(INVALID_FRAME_RANGE)
+    , valueRange({{std::numeric_limits<float>::max(),
+                   std::numeric_limits<float>::lowest()}})
+{
+}
+
+bool VolumeInformation::hasValueRange() const
 {
+    return valueRange[0] <= valueRange[1];
 }
 
 size_t VolumeInformation::getBytesPerVoxel() const
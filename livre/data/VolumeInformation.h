@@ -106,6 +106,16 @@ struct VolumeInformation
       */
     Vector2ui frameRange;
 
+    /** The range of the voxel values of all frames, which fixes the binning
+      * of the histograms. It is read from the metadata of the volume by the
+      * data source plugin, or scanned by DataSource::scanValueRange(). Empty
+      * (min > max) if unknown.
+      */
+    Range valueRange;
+
+    /** @return true if the value range is known. */
+    LIVREDATA_API bool hasValueRange() const;
+
     /** Optional description for end users. */
     std::string description;
 };
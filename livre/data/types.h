@@ -43,6 +43,7 @@ class VisitState;
 class DataSource;
 class DataSourcePlugin;
 class DataSourcePluginData;
+class HistogramPyramid;
 
 struct VolumeInformation;
 
@@ -71,6 +72,13 @@ enum AccessMode
     MODE_WRITE = 1u
 };
 
+/** Sort-last decomposition of the visible bricks between render nodes */
+enum Decomposition
+{
+    DECOMPOSITION_ORDERED = 0u, //!< Split the traversal order by brick count
+    DECOMPOSITION_SPATIAL = 1u  //!< Split space along the octree by brick cost
+};
+
 /** SmartPtr definitions */
 typedef std::shared_ptr<AllocMemoryUnit> AllocMemoryUnitPtr;
 typedef std::shared_ptr<MemoryUnit> MemoryUnitPtr;
@@ -26,6 +26,7 @@
 #include <livre/eq/Event.h>
 #include <livre/eq/FrameData.h>
 #include <livre/eq/FrameGrabber.h>
+#include <livre/eq/HistogramCodec.h>
 #include <livre/eq/Node.h>
 #include <livre/eq/Pipe.h>
 #include <livre/eq/Window.h>
@@ -39,6 +40,7 @@
 #include <livre/lib/cache/TextureObject.h>
 #include <livre/lib/configuration/VolumeRendererParameters.h>
 #include <livre/lib/pipeline/RenderPipeline.h>
+#include <livre/lib/render/CPURayCastRenderer.h>
 
 #include <livre/core/cache/Cache.h>
 #include <livre/core/cache/CacheStatistics.h>
@@ -62,6 +64,8 @@
 #include <eq/gl.h>
 #include <lexis/data/Progress.h>
 
+#include <mutex>
+
 namespace livre
 {
 const float nearPlane = 0.1f;
@@ -93,16 +97,30 @@ struct RedrawFilter : public Filter
     Channel* _channel;
 };
 
+/** The histograms sent by a channel, encoded against the previous one */
+struct SentHistogram
+{
+    std::mutex mutex; // the filters of several frames may run at once
+    HistogramEncoder encoder;
+};
+
 struct SendHistogramFilter : public Filter
 {
-    explicit SendHistogramFilter(Channel* channel)
+    SendHistogramFilter(Channel* channel, SentHistogram& sent,
+                        const bool send)
         : _channel(channel)
+        , _sent(sent)
+        , _send(send)
     {
     }
 
     ~SendHistogramFilter() {}
     void execute(const FutureMap& inputs, PromiseMap&) const final
     {
+        // all the channels skip the same frames, see Config::frame()
+        if (!_send)
+            return;
+
         const auto viewport = inputs.get<Viewport>("RelativeViewport").front();
         const auto frameCounter = inputs.get<uint32_t>("Id").front();
 
@@ -110,10 +128,22 @@ struct SendHistogramFilter : public Filter
         for (const auto& histogram : inputs.get<Histogram>("Histogram"))
             histogramAccumulated += histogram;
 
+        // The application keeps the last histogram of the view, an unchanged
+        // one is not sent again. Histograms of a part of the view are always
+        // sent, the application adds them up per frame, but an unchanged one
+        // is encoded in a few bytes.
+        const float area = viewport[2] * viewport[3]; // w * h
+        std::lock_guard<std::mutex> lock(_sent.mutex); // keeps the order
+        if (std::abs(1.0f - area) <= 0.0001f &&
+            histogramAccumulated == _sent.encoder.getLast())
+        {
+            return;
+        }
+
         const_cast<eq::Config*>(_channel->getConfig())
                 ->sendEvent(HISTOGRAM_DATA)
-            << histogramAccumulated
-            << (viewport[2] * viewport[3]) // area of the viewport ( w * h )
+            << _channel->getID()
+            << _sent.encoder.encode(histogramAccumulated) << area
             << frameCounter;
     }
 
@@ -125,6 +155,8 @@ struct SendHistogramFilter : public Filter
     }
 
     Channel* _channel;
+    SentHistogram& _sent;
+    const bool _send;
 };
 
 struct EqRaycastRenderer : public RayCastRenderer
@@ -143,6 +175,37 @@ struct EqRaycastRenderer : public RayCastRenderer
     Channel::Impl& _channel;
 };
 
+/** Draws the image of the CPU renderer into the channel */
+struct EqCPURayCastRenderer : public CPURayCastRenderer
+{
+    EqCPURayCastRenderer(Channel::Impl& channel, const DataSource& dataSource,
+                         const Cache& dataCache, uint32_t samplesPerRay)
+        : CPURayCastRenderer(dataSource, dataCache, samplesPerRay)
+        , _channel(channel)
+    {
+    }
+
+    void update(const FrameData& frameData)
+    {
+        const auto& vrParams = frameData.getVRParameters();
+        const auto& renderSettings = frameData.getRenderSettings();
+        setTransferFunction(renderSettings.getTransferFunction());
+        setSamplesPerRay(vrParams.getSamplesPerRay());
+        setQuality(vrParams.getInteractionQuality());
+        setLinearFiltering(vrParams.getLinearFiltering());
+    }
+
+    void _onFrameStart(const Frustum& frustum, const ClipPlanes& planes,
+                       const PixelViewport& view,
+                       const NodeIds& renderBricks) final;
+
+    void _onFrameEnd(const Frustum& frustum, const ClipPlanes& planes,
+                     const PixelViewport& view,
+                     const NodeIds& renderBricks) final;
+
+    Channel::Impl& _channel;
+};
+
 struct Channel::Impl
 {
 public:
@@ -176,10 +239,41 @@ public:
 
         const Window* window =
             static_cast<const Window*>(_channel->getWindow());
-        const Node* node = static_cast<const Node*>(_channel->getNode());
-        _renderer.reset(new EqRaycastRenderer(*this, node->getDataSource(),
-                                              window->getTextureCache(),
-                                              nSamplesPerRay));
+        Node* node = static_cast<Node*>(_channel->getNode());
+        if (getFrameData().getVRParameters().getRenderer() == RENDERER_CPU)
+        {
+            _cpuRenderer.reset(
+                new EqCPURayCastRenderer(*this, node->getDataSource(),
+                                         node->getDataCache(), nSamplesPerRay));
+        }
+        else
+        {
+            _renderer.reset(new EqRaycastRenderer(*this, node->getDataSource(),
+                                                  window->getTextureCache(),
+                                                  nSamplesPerRay));
+        }
+    }
+
+    Renderer& getRenderer()
+    {
+        if (_cpuRenderer)
+            return *_cpuRenderer;
+        return *_renderer;
+    }
+
+    const NodeIds& getVisibleNodes() const
+    {
+        if (_cpuRenderer)
+            return _cpuRenderer->getVisibleNodes();
+        return _renderer->getVisibleNodes();
+    }
+
+    void updateRenderer()
+    {
+        if (_cpuRenderer)
+            _cpuRenderer->update(getFrameData());
+        else
+            _renderer->update(getFrameData());
     }
 
     Frustum setupFrustum() const
@@ -299,7 +393,7 @@ public:
             static_cast<const livre::Window*>(_channel->getWindow());
         const RenderPipeline& renderPipeline = window->getRenderPipeline();
 
-        _renderer->update(getFrameData());
+        updateRenderer();
         renderPipeline.render(
             {getFrameData().getVRParameters(),
              _frameInfo,
@@ -310,8 +404,10 @@ public:
              getFrameData().getRenderSettings().getClipPlanes(),
              getFrameData().getFrameSettings().isIdle()},
             PipeFilterT<RedrawFilter>("RedrawFilter", _channel),
-            PipeFilterT<SendHistogramFilter>("SendHistogramFilter", _channel),
-            *_renderer, _availability);
+            PipeFilterT<SendHistogramFilter>(
+                "SendHistogramFilter", _channel, _sentHistogram,
+                getFrameData().getFrameSettings().getSendHistogram()),
+            getRenderer(), _availability);
 
 #ifdef UXMAL
         const auto xfm = frustum.getInvMVMatrix();
@@ -323,7 +419,7 @@ public:
 
         livre::Node* node = static_cast<livre::Node*>(_channel->getNode());
         const auto& dataSource = node->getDataSource();
-        for (const auto& id : _renderer->getVisibleNodes())
+        for (const auto& id : getVisibleNodes())
         {
             const auto& box = dataSource.getNode(id).getWorldBox();
             _publisher.publish(
@@ -381,7 +477,7 @@ public:
         const VolumeInformation& info = node->getDataSource().getVolumeInfo();
 
         std::ostringstream os;
-        const size_t nBricks = _renderer->getVisibleNodes().size();
+        const size_t nBricks = getVisibleNodes().size();
         const float mbBricks = float(info.maximumBlockSize.product()) / 1024.f /
                                1024.f * float(nBricks);
         os << nBricks << " bricks / " << mbBricks << " MB rendered" << std::endl
@@ -609,7 +705,9 @@ public:
     FrameInfo _frameInfo;
     NodeAvailability _availability;
     std::unique_ptr<RayCastRenderer> _renderer;
+    std::unique_ptr<EqCPURayCastRenderer> _cpuRenderer; // replaces _renderer
     ::lexis::data::Progress _progress;
+    SentHistogram _sentHistogram;
 #ifdef LIVRE_USE_ZEROEQ
     zeroeq::Publisher _publisher;
 #endif
@@ -624,6 +722,42 @@ void EqRaycastRenderer::_onFrameStart(const Frustum& frustum,
     RayCastRenderer::_onFrameStart(frustum, planes, view, renderBricks);
 }
 
+void EqCPURayCastRenderer::_onFrameStart(const Frustum& frustum,
+                                         const ClipPlanes& planes,
+                                         const PixelViewport& view,
+                                         const NodeIds& renderBricks)
+{
+    _channel.updateRegions(renderBricks, frustum);
+    CPURayCastRenderer::_onFrameStart(frustum, planes, view, renderBricks);
+}
+
+void EqCPURayCastRenderer::_onFrameEnd(const Frustum&, const ClipPlanes&,
+                                       const PixelViewport& view,
+                                       const NodeIds&)
+{
+    const Floats& image = getImage();
+    if (image.empty())
+        return;
+
+    // the image covers the viewport of the channel
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    glDisable(GL_BLEND);
+    glDisable(GL_DEPTH_TEST);
+    glRasterPos2f(-1.f, -1.f);
+    glDrawPixels(view[2], view[3], GL_RGBA, GL_FLOAT, image.data());
+
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+}
+
 Channel::Channel(eq::Window* parent)
     : eq::Channel(parent)
     , _impl(new Impl(this))
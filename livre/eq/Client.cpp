@@ -215,6 +215,11 @@ const Histogram& Client::getHistogram() const
     return _impl->config->getHistogram();
 }
 
+uint64_t Client::getHistogramBytes() const
+{
+    return _impl->config->getHistogramBytes();
+}
+
 const FrameData& Client::getFrameData() const
 {
     return _impl->config->getFrameData();
@@ -75,6 +75,9 @@ public:
     /** @return the current histogram. */
     const Histogram& getHistogram() const;
 
+    /** @return the bytes of the histograms received from the channels. */
+    uint64_t getHistogramBytes() const;
+
     /** @return The per-frame data. */
     const FrameData& getFrameData() const;
     FrameData& getFrameData();
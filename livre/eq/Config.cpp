@@ -23,11 +23,13 @@
 #include <livre/eq/Client.h>
 #include <livre/eq/Event.h>
 #include <livre/eq/FrameData.h>
+#include <livre/eq/HistogramCodec.h>
 #include <livre/eq/serialization.h>
 #include <livre/eq/settings/CameraSettings.h>
 #include <livre/eq/settings/FrameSettings.h>
 #include <livre/eq/settings/RenderSettings.h>
 #include <livre/lib/configuration/ApplicationParameters.h>
+#include <livre/lib/configuration/QualityGovernor.h>
 #include <livre/lib/configuration/VolumeRendererParameters.h>
 
 #include <livre/core/util/FrameUtils.h>
@@ -39,6 +41,9 @@
 
 #include <eq/eq.h>
 
+#include <deque>
+#include <map>
+
 namespace livre
 {
 namespace
@@ -155,6 +160,25 @@ public:
             histogramQueue.pop_back();
     }
 
+    bool isHistogramDue() const
+    {
+        const float rate = framedata.getVRParameters().getHistogramRate();
+        return rate <= 0.f ||
+               float(config.getTime() - lastHistogramTime) >= 1000.f / rate;
+    }
+
+    // Limit the histograms sent by the channels to the histogram rate. A
+    // skipped histogram is sent by a redraw once it is due, so the last one is
+    // up to date when the rendering stops, see needRedraw().
+    void updateHistogramRate()
+    {
+        const bool send = isHistogramDue();
+        if (send)
+            lastHistogramTime = config.getTime();
+        histogramPending = !send;
+        framedata.getFrameSettings().setSendHistogram(send);
+    }
+
     void resetCamera()
     {
         framedata.getCameraSettings().setCameraPosition(
@@ -163,6 +187,38 @@ public:
             framedata.getApplicationParameters().cameraLookAt);
     }
 
+    // adapt the interaction quality to hold the target frame rate, the
+    // quality is distributed to the render clients with the frame data
+    void updateQuality()
+    {
+        auto& vrParams = framedata.getVRParameters();
+        const float quality =
+            governor.update(renderTime, framedata.getFrameSettings().isIdle(),
+                            vrParams.getTargetFps());
+        renderTime = 0.f; // each frame is measured once
+        if (quality != vrParams.getInteractionQuality())
+            vrParams.setInteractionQuality(quality);
+    }
+
+    // the render time of a frame is from its start to its finish, which is
+    // latency frames later; the time of idle frames is not measured
+    void startFrame(const uint32_t frame, const int64_t start)
+    {
+        frameTimings.push_back(
+            {frame, start, framedata.getFrameSettings().isIdle()});
+    }
+
+    void finishFrame(const uint32_t frame)
+    {
+        const int64_t now = config.getTime();
+        while (!frameTimings.empty() && frameTimings.front().frame <= frame)
+        {
+            const FrameTiming& timing = frameTimings.front();
+            renderTime = timing.idle ? 0.f : float(now - timing.start);
+            frameTimings.pop_front();
+        }
+    }
+
     void initCommunicator(const int argc LB_UNUSED, char** argv LB_UNUSED)
     {
 #ifdef LIVRE_USE_ZEROEQ
@@ -187,10 +243,24 @@ public:
     VolumeInformation volumeInfo;
     int64_t frameStart;
 
+    struct FrameTiming
+    {
+        uint32_t frame;
+        int64_t start;
+        bool idle;
+    };
+    std::deque<FrameTiming> frameTimings;
+    float renderTime{0.f}; // of the last finished frame, 0 if unknown
+    QualityGovernor governor;
+
     Boxf volumeBBox;
 
     ViewHistogramQueue histogramQueue;
     Histogram histogram;
+    std::map<eq::uint128_t, HistogramDecoder> histogramDecoders; // per channel
+    int64_t lastHistogramTime{0};
+    bool histogramPending{false};
+    uint64_t histogramBytes{0}; // payload of the received HISTOGRAM_DATA
 };
 
 Config::Config(eq::ServerPtr parent)
@@ -244,6 +314,11 @@ const Histogram& Config::getHistogram() const
     return _impl->histogram;
 }
 
+uint64_t Config::getHistogramBytes() const
+{
+    return _impl->histogramBytes;
+}
+
 const VolumeInformation& Config::getVolumeInformation() const
 {
     return _impl->volumeInfo;
@@ -312,6 +387,8 @@ bool Config::frame()
         frameUtils.getCurrent(frameSettings.getFrameNumber(), keepToLatest);
 
     frameSettings.setFrameNumber(current);
+    _impl->updateQuality();
+    _impl->updateHistogramRate();
     const eq::uint128_t& version = _impl->framedata.commit();
 
     if (_impl->framedata.getVRParameters().getSynchronousMode())
@@ -329,15 +406,18 @@ bool Config::frame()
         // reset starting time for new frame
         _impl->frameStart = getTime();
     }
-    _impl->redraw = false;
+    // keep refining until the full quality is reached
+    _impl->redraw =
+        _impl->framedata.getVRParameters().getInteractionQuality() < 1.f;
 
 #ifdef LIVRE_USE_ZEROEQ
     if (_impl->communicator)
         _impl->communicator->publishFrame();
 #endif
 
-    eq::Config::startFrame(version);
-    eq::Config::finishFrame();
+    const int64_t start = getTime();
+    _impl->startFrame(eq::Config::startFrame(version), start);
+    _impl->finishFrame(eq::Config::finishFrame());
     return true;
 }
 
@@ -349,7 +429,8 @@ void Config::postRedraw()
 bool Config::needRedraw()
 {
     return _impl->redraw ||
-           _impl->framedata.getApplicationParameters().animation != 0;
+           _impl->framedata.getApplicationParameters().animation != 0 ||
+           (_impl->histogramPending && _impl->isHistogramDue());
 }
 
 bool Config::publish(const servus::Serializable& serializable LB_UNUSED)
@@ -491,10 +572,25 @@ bool Config::handleEvent(eq::EventICommand command)
     {
     case HISTOGRAM_DATA:
     {
-        const Histogram& histogram = command.read<Histogram>();
+        const eq::uint128_t channel = command.read<eq::uint128_t>();
+        const auto encoding = command.read<std::vector<uint8_t>>();
         const float area = command.read<float>();
         const uint32_t id = command.read<uint32_t>();
-        _impl->gatherHistogram(histogram, area, id);
+        _impl->histogramBytes += sizeof(channel) + sizeof(uint64_t) +
+                                 encoding.size() + sizeof(area) + sizeof(id);
+        try
+        {
+            const Histogram& histogram =
+                _impl->histogramDecoders[channel].decode(encoding);
+            _impl->gatherHistogram(histogram, area, id);
+        }
+        catch (const std::runtime_error& error)
+        {
+            // the histograms of the channel are dropped until the next full
+            // encoding, which the encoder sends at least every 64 histograms
+            LBWARN << "Dropping histogram: " << error.what() << std::endl;
+            _impl->histogramDecoders[channel].reset();
+        }
         return false;
     }
 
@@ -94,6 +94,12 @@ public:
     /** @return the current histogram. */
     const Histogram& getHistogram() const;
 
+    /**
+     * @return the bytes of the histograms received from the channels so far,
+     *         i.e. the payload of their HISTOGRAM_DATA events.
+     */
+    uint64_t getHistogramBytes() const;
+
     bool handleEvent(eq::EventICommand command) final; //!< @internal
 
 private:
@@ -143,6 +143,11 @@ const Histogram& Engine::getHistogram() const
     return _impl->client->getHistogram();
 }
 
+uint64_t Engine::getHistogramBytes() const
+{
+    return _impl->client->getHistogramBytes();
+}
+
 FrameData& Engine::getFrameData()
 {
     return _impl->client->getFrameData();
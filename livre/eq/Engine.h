@@ -71,6 +71,12 @@ public:
     /** @return the current histogram. */
     LIVREEQ_API const Histogram& getHistogram() const;
 
+    /**
+     * @return the bytes of the histograms received from the channels so far,
+     *         e.g. to measure their traffic per frame.
+     */
+    LIVREEQ_API uint64_t getHistogramBytes() const;
+
     /** @return the application parameters */
     LIVREEQ_API ApplicationParameters& getApplicationParameters();
 
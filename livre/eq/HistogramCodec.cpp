@@ -0,0 +1,240 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <livre/eq/HistogramCodec.h>
+
+#include <cstring>
+
+namespace livre
+{
+namespace
+{
+// The encoding is
+//   uint8_t type: DELTA, or FULL if the range or bin count changed
+//   FULL only: float min, float max, varint bin count
+//   varint number of changed bins
+//   per changed bin: varint index gap to the previous one, varint zigzag delta
+// The deltas of FULL encodings are relative to empty bins.
+enum EncodingType : uint8_t
+{
+    DELTA,
+    FULL
+};
+
+const uint64_t maxBinCount = 1 << 20; // rejects corrupted bin counts
+const size_t maxDeltas = 63;          // between two full encodings
+
+void writeVarint(uint64_t value, std::vector<uint8_t>& buffer)
+{
+    while (value >= 0x80)
+    {
+        buffer.push_back(uint8_t(value) | 0x80);
+        value >>= 7;
+    }
+    buffer.push_back(uint8_t(value));
+}
+
+void writeFloat(const float value, std::vector<uint8_t>& buffer)
+{
+    uint8_t bytes[sizeof(float)];
+    std::memcpy(bytes, &value, sizeof(float));
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(float));
+}
+
+class Reader
+{
+public:
+    explicit Reader(const std::vector<uint8_t>& buffer)
+        : _current(buffer.data())
+        , _end(buffer.data() + buffer.size())
+    {
+    }
+
+    uint8_t readByte()
+    {
+        if (_current == _end)
+            LBTHROW(std::runtime_error("Truncated histogram encoding"));
+        return *_current++;
+    }
+
+    uint64_t readVarint()
+    {
+        uint64_t value = 0;
+        for (uint32_t shift = 0; shift < 64; shift += 7)
+        {
+            const uint8_t byte = readByte();
+            value |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+        LBTHROW(std::runtime_error("Invalid varint in histogram encoding"));
+    }
+
+    float readFloat()
+    {
+        if (size_t(_end - _current) < sizeof(float))
+            LBTHROW(std::runtime_error("Truncated histogram encoding"));
+        float value;
+        std::memcpy(&value, _current, sizeof(float));
+        _current += sizeof(float);
+        return value;
+    }
+
+    bool isDone() const { return _current == _end; }
+
+private:
+    const uint8_t* _current;
+    const uint8_t* const _end;
+};
+
+// deltas of small magnitude, negative or not, get short varints
+uint64_t zigzag(const uint64_t delta)
+{
+    return (delta << 1) ^ uint64_t(int64_t(delta) >> 63);
+}
+
+uint64_t unzigzag(const uint64_t value)
+{
+    return (value >> 1) ^ (~(value & 1) + 1);
+}
+
+void setBins(Histogram& histogram, const std::vector<uint64_t>& bins)
+{
+    histogram.getBins().clear();
+    for (const uint64_t bin : bins)
+        histogram.getBins().push_back(bin);
+}
+}
+
+HistogramEncoder::HistogramEncoder()
+    : _nDeltas(0)
+{
+}
+
+HistogramEncoder::~HistogramEncoder()
+{
+}
+
+std::vector<uint8_t> HistogramEncoder::encode(const Histogram& histogram)
+{
+    const size_t nBins = histogram.getBins().size();
+    const uint64_t* bins = histogram.getBins().data();
+    const bool isFull = histogram.getMin() != _last.getMin() ||
+                        histogram.getMax() != _last.getMax() ||
+                        nBins != _last.getBins().size() ||
+                        _nDeltas >= maxDeltas;
+    _nDeltas = isFull ? 0 : _nDeltas + 1;
+    const uint64_t* lastBins = isFull ? nullptr : _last.getBins().data();
+
+    std::vector<uint64_t> changes; // index gap, zigzag delta
+    size_t next = 0;
+    for (size_t i = 0; i < nBins; ++i)
+    {
+        const uint64_t delta = bins[i] - (lastBins ? lastBins[i] : 0);
+        if (delta == 0)
+            continue;
+        changes.push_back(i - next);
+        changes.push_back(zigzag(delta));
+        next = i + 1;
+    }
+
+    std::vector<uint8_t> encoding;
+    encoding.reserve(16 + changes.size() * 2);
+    encoding.push_back(isFull ? FULL : DELTA);
+    if (isFull)
+    {
+        writeFloat(histogram.getMin(), encoding);
+        writeFloat(histogram.getMax(), encoding);
+        writeVarint(nBins, encoding);
+    }
+    writeVarint(changes.size() / 2, encoding);
+    for (const uint64_t value : changes)
+        writeVarint(value, encoding);
+
+    _last = histogram;
+    return encoding;
+}
+
+const Histogram& HistogramEncoder::getLast() const
+{
+    return _last;
+}
+
+HistogramDecoder::HistogramDecoder()
+    : _isSynchronized(true)
+{
+}
+
+HistogramDecoder::~HistogramDecoder()
+{
+}
+
+const Histogram& HistogramDecoder::decode(const std::vector<uint8_t>& encoding)
+{
+    Reader reader(encoding);
+    const uint8_t type = reader.readByte();
+    if (type != DELTA && type != FULL)
+        LBTHROW(std::runtime_error("Unknown histogram encoding"));
+
+    if (type == DELTA && !_isSynchronized)
+        LBTHROW(std::runtime_error("Histogram delta before a full encoding"));
+
+    std::vector<uint64_t> bins;
+    float min = _last.getMin();
+    float max = _last.getMax();
+    if (type == FULL)
+    {
+        min = reader.readFloat();
+        max = reader.readFloat();
+        const uint64_t nBins = reader.readVarint();
+        if (nBins > maxBinCount)
+            LBTHROW(std::runtime_error("Invalid histogram bin count"));
+        bins.resize(nBins);
+    }
+    else
+    {
+        const uint64_t* lastBins = _last.getBins().data();
+        bins.assign(lastBins, lastBins + _last.getBins().size());
+    }
+
+    const uint64_t nChanges = reader.readVarint();
+    size_t index = 0;
+    for (uint64_t i = 0; i < nChanges; ++i)
+    {
+        const uint64_t gap = reader.readVarint();
+        if (gap >= bins.size() - index)
+            LBTHROW(std::runtime_error("Histogram bin out of range"));
+        index += gap;
+        bins[index++] += unzigzag(reader.readVarint());
+    }
+    if (!reader.isDone())
+        LBTHROW(std::runtime_error("Trailing data in histogram encoding"));
+
+    _last.setMin(min);
+    _last.setMax(max);
+    setBins(_last, bins);
+    _isSynchronized = true;
+    return _last;
+}
+
+void HistogramDecoder::reset()
+{
+    _last = Histogram();
+    _isSynchronized = false;
+}
+}
@@ -0,0 +1,86 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _HistogramCodec_h_
+#define _HistogramCodec_h_
+
+#include <livre/eq/api.h>
+#include <livre/eq/types.h>
+
+namespace livre
+{
+/**
+ * Encodes the histograms sent by a channel to the application: only the bins
+ * which changed since the previous histogram of the channel are written, as
+ * variable length deltas. A histogram with another range or bin count than
+ * the previous one is written with its non-zero bins, and so is every 64th
+ * histogram: a decoder which lost track recovers with it.
+ *
+ * The histograms are decoded by a HistogramDecoder in the same order, which
+ * the events of a channel preserve.
+ */
+class HistogramEncoder
+{
+public:
+    LIVREEQ_API HistogramEncoder();
+    LIVREEQ_API ~HistogramEncoder();
+
+    /** @return the encoding of the histogram, relative to the previous one */
+    LIVREEQ_API std::vector<uint8_t> encode(const Histogram& histogram);
+
+    /** @return the last encoded histogram */
+    LIVREEQ_API const Histogram& getLast() const;
+
+private:
+    HistogramEncoder(const HistogramEncoder&) = delete;
+    HistogramEncoder& operator=(const HistogramEncoder&) = delete;
+
+    Histogram _last;
+    size_t _nDeltas; // since the last full encoding
+};
+
+/** Decodes the histograms of a HistogramEncoder. */
+class HistogramDecoder
+{
+public:
+    LIVREEQ_API HistogramDecoder();
+    LIVREEQ_API ~HistogramDecoder();
+
+    /**
+     * @return the histogram of the next encoding of the encoder
+     * @throw std::runtime_error if the encoding is corrupted or does not
+     *        follow the previously decoded one
+     */
+    LIVREEQ_API const Histogram& decode(const std::vector<uint8_t>& encoding);
+
+    /**
+     * Discards the decoded histogram after a failed decode(): the following
+     * deltas are rejected until the next full encoding of the encoder.
+     */
+    LIVREEQ_API void reset();
+
+private:
+    HistogramDecoder(const HistogramDecoder&) = delete;
+    HistogramDecoder& operator=(const HistogramDecoder&) = delete;
+
+    Histogram _last;
+    bool _isSynchronized; // false from reset() to the next full encoding
+};
+}
+
+#endif // _HistogramCodec_h_
@@ -36,13 +36,39 @@
 #include <livre/lib/configuration/VolumeRendererParameters.h>
 
 #include <livre/core/cache/Cache.h>
+#include <livre/core/pipeline/Tracer.h>
 #include <livre/data/DataSource.h>
+#include <livre/data/HistogramPyramid.h>
 
 #include <eq/eq.h>
 #include <eq/gl.h>
 
+#include <boost/thread/thread.hpp>
+
+#include <sstream>
+
 namespace livre
 {
+namespace
+{
+/** @return the file name with the process id before the extension */
+std::string getProcessFile(const std::string& filename)
+{
+    const size_t slash = filename.find_last_of("/\\");
+    size_t dot = filename.find_last_of('.');
+    if (dot == std::string::npos ||
+        (slash != std::string::npos && dot < slash))
+    {
+        dot = filename.size();
+    }
+
+    std::ostringstream processFile;
+    processFile << filename.substr(0, dot) << '.' << Tracer::getProcessId()
+                << filename.substr(dot);
+    return processFile.str();
+}
+}
+
 struct Node::Impl
 {
 public:
@@ -83,9 +109,98 @@ public:
             return false;
         }
 
+        initializeValueRange();
         return true;
     }
 
+    /**
+     * Fixes the binning of the histograms before the first frame. Only the
+     * application node scans the volume, and distributes the range with the
+     * volume settings: the other nodes accumulate their histograms in it, but
+     * bin their bricks in the range of each brick.
+     */
+    void initializeValueRange()
+    {
+        const VolumeInformation& volumeInfo = _dataSource->getVolumeInfo();
+        if (!_node->isApplicationNode() || volumeInfo.hasValueRange() ||
+            volumeInfo.frameRange[1] == INVALID_TIMESTEP)
+        {
+            return;
+        }
+
+        try
+        {
+            const Range range = _dataSource->scanValueRange(
+                boost::thread::hardware_concurrency());
+            _config->getFrameData().getVolumeSettings().setDataSourceRange(
+                Vector2f(range[0], range[1]));
+        }
+        catch (const std::runtime_error& error)
+        {
+            LBWARN << "Could not scan the value range of the volume: "
+                   << error.what() << std::endl;
+        }
+    }
+
+    /**
+     * Loads the histogram pyramid. If it is missing or outdated, the
+     * application node computes and saves it, the other nodes bin the bricks
+     * until a later run finds the saved pyramid.
+     */
+    void initializeHistogramPyramid()
+    {
+        const std::string& filename = _config->getFrameData()
+                                          .getVRParameters()
+                                          .getHistogramPyramidString();
+        if (filename.empty())
+            return;
+
+        const VolumeInformation& volumeInfo = _dataSource->getVolumeInfo();
+        try
+        {
+            _histogramPyramid.reset(new HistogramPyramid(filename));
+            if (_histogramPyramid->matches(*_dataSource,
+                                           volumeInfo.frameRange[0]))
+            {
+                return;
+            }
+            _histogramPyramid.reset();
+        }
+        catch (const std::runtime_error&)
+        {
+        }
+
+        if (!_node->isApplicationNode())
+        {
+            LBINFO << "No histogram pyramid " << filename
+                   << " for the volume, binning the bricks" << std::endl;
+            return;
+        }
+
+        try
+        {
+            LBINFO << "Computing histogram pyramid " << filename << std::endl;
+            _histogramPyramid.reset(
+                new HistogramPyramid(*_dataSource, volumeInfo.frameRange[0],
+                                     boost::thread::hardware_concurrency()));
+        }
+        catch (const std::runtime_error& error)
+        {
+            LBWARN << "Could not compute histogram pyramid: " << error.what()
+                   << std::endl;
+            return;
+        }
+
+        try
+        {
+            _histogramPyramid->save(filename);
+        }
+        catch (const std::runtime_error& error)
+        {
+            LBWARN << error.what() << std::endl;
+        }
+    }
+
     bool configInit()
     {
         if (!initializeVolume())
@@ -94,6 +209,7 @@ public:
         auto event = _config->sendEvent(VOLUME_INFO);
         event << _dataSource->getVolumeInfo();
         initializeCache();
+        initializeHistogramPyramid();
         return true;
     }
 
@@ -101,6 +217,35 @@ public:
     {
         if (!_node->isApplicationNode())
             _config->getFrameData().sync(frameId);
+        updateTracer();
+    }
+
+    /** Starts tracing on a new trace file, writes the previous one */
+    void updateTracer()
+    {
+        const std::string& traceFile =
+            _config->getFrameData().getVRParameters().getTraceFileString();
+        if (traceFile == _traceFile)
+            return;
+
+        writeTrace();
+        _traceFile = traceFile;
+        Tracer::clear();
+        Tracer::setEnabled(!_traceFile.empty());
+    }
+
+    void writeTrace()
+    {
+        if (_traceFile.empty())
+            return;
+
+        // all the nodes get the same trace file parameter
+        const std::string traceFile = getProcessFile(_traceFile);
+        if (Tracer::write(traceFile))
+            LBINFO << "Wrote pipeline trace " << traceFile << std::endl;
+        else
+            LBWARN << "Could not write pipeline trace " << traceFile
+                   << std::endl;
     }
 
     void updateDataSource()
@@ -117,6 +262,8 @@ public:
     std::unique_ptr<DataSource> _dataSource;
     std::unique_ptr<Cache> _dataCache;
     std::unique_ptr<Cache> _histogramCache;
+    std::unique_ptr<HistogramPyramid> _histogramPyramid; // optional
+    std::string _traceFile; // empty if not tracing
 };
 
 Node::Node(eq::Config* parent)
@@ -155,6 +302,9 @@ bool Node::configInit(const eq::uint128_t& initId)
 
 bool Node::configExit()
 {
+    _impl->writeTrace();
+    Tracer::setEnabled(false);
+
     livre::Client* client = static_cast<livre::Client*>(getClient().get());
     client->setIdleFunction(IdleFunc());
     if (!isApplicationNode())
@@ -186,6 +336,11 @@ livre::Cache& livre::Node::getHistogramCache()
     return *_impl->_histogramCache;
 }
 
+const HistogramPyramid* Node::getHistogramPyramid() const
+{
+    return _impl->_histogramPyramid.get();
+}
+
 void Node::frameStart(const eq::uint128_t& frameId, const uint32_t frameNumber)
 {
     _impl->frameStart(frameId);
@@ -54,6 +54,9 @@ public:
     /** @return The histogram cache. */
     Cache& getHistogramCache();
 
+    /** @return The histogram pyramid, or nullptr if there is none. */
+    const HistogramPyramid* getHistogramPyramid() const;
+
 private:
     bool configInit(const eq::uint128_t& initId) final;
     void frameStart(const eq::uint128_t& frameId,
@@ -36,6 +36,7 @@
 #include <livre/lib/pipeline/RenderPipeline.h>
 
 #include <livre/core/cache/Cache.h>
+#include <livre/core/pipeline/Workers.h>
 #include <livre/core/render/TexturePool.h>
 #include <livre/data/DataSource.h>
 
@@ -59,16 +60,40 @@ public:
 
         Node* node = static_cast<Node*>(_window->getNode());
         Pipe* pipe = static_cast<Pipe*>(_window->getPipe());
-        const size_t maxGpuMemory =
-            pipe->getFrameData().getVRParameters().getMaxGpuCacheMemory();
-
-        _texturePool.reset(new TexturePool(node->getDataSource()));
+        const VolumeRendererParameters& vrParams =
+            pipe->getFrameData().getVRParameters();
+        const size_t maxGpuMemory = vrParams.getMaxGpuCacheMemory();
+
+        const size_t atlasMemory =
+            vrParams.getTextureAtlas() ? maxGpuMemory * LB_1MB : 0;
+        _texturePool.reset(new TexturePool(node->getDataSource(), atlasMemory));
+
+        // the cache evicts a brick when the atlas is full, which frees a slot
+        const size_t cacheMemory = atlasMemory > 0
+                                       ? _texturePool->getAtlasMemory()
+                                       : maxGpuMemory * LB_1MB;
         _textureCache.reset(
-            new CacheT<TextureObject>("TextureCache", maxGpuMemory * LB_1MB));
+            new CacheT<TextureObject>("TextureCache", cacheMemory));
         Caches caches = {node->getDataCache(), *_textureCache,
-                         node->getHistogramCache()};
-        _renderPipeline.reset(new RenderPipeline(node->getDataSource(), caches,
-                                                 *_texturePool, *_glContext));
+                         node->getHistogramCache(),
+                         node->getHistogramPyramid()};
+        // Created by the pipe thread, so the workers inherit its affinity
+        // unless one is given
+        Int32s affinities;
+        try
+        {
+            affinities =
+                Workers::parseAffinities(vrParams.getWorkerAffinityString());
+        }
+        catch (const std::runtime_error& error)
+        {
+            LBWARN << error.what() << std::endl;
+        }
+        _renderPipeline.reset(
+            new RenderPipeline(node->getDataSource(), caches, *_texturePool,
+                               *_glContext, vrParams.getWorkerThreads(),
+                               affinities,
+                               RendererType(vrParams.getRenderer())));
     }
 
     bool configExitGL()
@@ -32,6 +32,7 @@
 #include <livre/lib/data/BoundingAxis.h>
 
 #include <livre/core/cache/Cache.h>
+#include <livre/core/render/BrickOrder.h>
 #include <livre/core/render/GLContext.h>
 #include <livre/core/render/GLSLShaders.h>
 #include <livre/core/render/TransferFunction1D.h>
@@ -52,34 +53,6 @@ const uint32_t SH_INT = 1u;
 const uint32_t SH_FLOAT = 2u;
 }
 
-// Sort helper function for sorting the textures with their distances to
-// viewpoint
-struct DistanceOperator
-{
-    explicit DistanceOperator(const DataSource& dataSource,
-                              const Frustum& frustum)
-        : _frustum(frustum)
-        , _dataSource(dataSource)
-    {
-    }
-
-    bool operator()(const NodeId& rb1, const NodeId& rb2)
-    {
-        const LODNode& lodNode1 = _dataSource.getNode(rb1);
-        const LODNode& lodNode2 = _dataSource.getNode(rb2);
-
-        const float distance1 =
-            (_frustum.getMVMatrix() * lodNode1.getWorldBox().getCenter())
-                .length();
-        const float distance2 =
-            (_frustum.getMVMatrix() * lodNode2.getWorldBox().getCenter())
-                .length();
-        return distance1 < distance2;
-    }
-    const Frustum& _frustum;
-    const DataSource& _dataSource;
-};
-
 #define glewGetContext() GLContext::getCurrent()->glewGetContext()
 
 namespace
@@ -91,7 +64,12 @@ std::string where(const char* file, const int line)
 
 const uint32_t maxSamplesPerRay = 32;
 const uint32_t minSamplesPerRay = 512;
+const uint32_t minInteractiveSamplesPerRay = 64;
 const size_t nVerticesRenderBrick = 36;
+// The volume textures are on the units after the transfer function, bricks
+// in the same atlas page share a unit and need no bind
+const GLint firstVolumeUnit = 2;
+const size_t nVolumeUnits = 8;
 const GLfloat fullScreenQuad[] = {-1.0f, -1.0f, 0.0f, 1.0f,  -1.0f, 0.0f,
                                   -1.0f, 1.0f,  0.0f, -1.0f, 1.0f,  0.0f,
                                   1.0f,  -1.0f, 0.0f, 1.0f,  1.0f,  0.0f};
@@ -152,10 +130,7 @@ struct RayCastRenderer::Impl
 
     NodeIds order(const NodeIds& bricks, const Frustum& frustum) const
     {
-        NodeIds rbs = bricks;
-        DistanceOperator distanceOp(_dataSource, frustum);
-        std::sort(rbs.begin(), rbs.end(), distanceOp);
-        return rbs;
+        return orderFrontToBack(_dataSource, bricks, frustum);
     }
 
     void update(const FrameData& frameData)
@@ -164,6 +139,7 @@ struct RayCastRenderer::Impl
             frameData.getRenderSettings().getTransferFunction());
         _nSamplesPerRay = frameData.getVRParameters().getSamplesPerRay();
         _computedSamplesPerRay = _nSamplesPerRay;
+        _quality = frameData.getVRParameters().getInteractionQuality();
         _drawAxis = frameData.getVRParameters().getShowAxes();
         _linearFiltering = frameData.getVRParameters().getLinearFiltering();
 
@@ -233,6 +209,12 @@ struct RayCastRenderer::Impl
                 std::max(maxVoxelsAtLOD, (float)minSamplesPerRay);
         }
 
+        // take fewer samples while interacting, see QualityGovernor
+        if (_quality < 1.0f)
+            _computedSamplesPerRay = std::max(
+                uint32_t(_computedSamplesPerRay * _quality),
+                std::min(_computedSamplesPerRay, minInteractiveSamplesPerRay));
+
         Vector2f dataSourceRange;
         uint32_t shaderDataType;
         switch (_dataSource.getVolumeInfo().dataType)
@@ -469,6 +451,10 @@ struct RayCastRenderer::Impl
         _visibleNodes.clear();
         const GLuint posVBO = createAndFillVertexBuffer(bricks);
 
+        // rebind once per pass, the upload thread may have changed the pages
+        _unitTextures.assign(nVolumeUnits, INVALID_TEXTURE_ID);
+        _nextUnit = 0;
+
         size_t index = 0;
         for (const NodeId& brick : bricks)
             renderBrick(brick, index++, posVBO);
@@ -478,6 +464,33 @@ struct RayCastRenderer::Impl
         // The flush is needed because the textures are loaded asynchronously by
         // a thread pool.
         glFlush();
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    GLint bindVolumeTexture(const TextureState& texState)
+    {
+        const bool needsRebind = texState.waitUpload();
+        const auto i = std::find(_unitTextures.begin(), _unitTextures.end(),
+                                 texState.textureId);
+        size_t unit = i - _unitTextures.begin();
+        if (i != _unitTextures.end() && !needsRebind)
+            return firstVolumeUnit + GLint(unit);
+
+        if (i == _unitTextures.end())
+        {
+            unit = _nextUnit;
+            _nextUnit = (_nextUnit + 1) % nVolumeUnits;
+            _unitTextures[unit] = texState.textureId;
+        }
+
+        glActiveTexture(GL_TEXTURE0 + firstVolumeUnit + unit);
+        texState.bind();
+
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER,
+                        _linearFiltering ? GL_LINEAR : GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER,
+                        _linearFiltering ? GL_LINEAR : GL_NEAREST);
+        return firstVolumeUnit + GLint(unit);
     }
 
     void renderBrickVBO(const size_t index, const GLuint posVBO, bool front,
@@ -533,27 +546,27 @@ struct RayCastRenderer::Impl
         tParamNameGL = glGetUniformLocation(program, "textureMax");
         glUniform3fv(tParamNameGL, 1, texState.textureCoordsMax.array);
 
+        tParamNameGL = glGetUniformLocation(program, "textureClampMin");
+        glUniform3fv(tParamNameGL, 1, texState.textureClampMin.array);
+
+        tParamNameGL = glGetUniformLocation(program, "textureClampMax");
+        glUniform3fv(tParamNameGL, 1, texState.textureClampMax.array);
+
         const Vector3f& voxSize =
             texState.textureSize / lodNode.getWorldBox().getSize();
         tParamNameGL = glGetUniformLocation(program, "voxelSpacePerWorldSpace");
         glUniform3fv(tParamNameGL, 1, voxSize.array);
 
-        glActiveTexture(GL_TEXTURE0);
-        texState.bind();
-
-        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER,
-                        _linearFiltering ? GL_LINEAR : GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER,
-                        _linearFiltering ? GL_LINEAR : GL_NEAREST);
+        const GLint unit = bindVolumeTexture(texState);
 
         tParamNameGL = glGetUniformLocation(program, "volumeTexUint");
-        glUniform1i(tParamNameGL, 0);
+        glUniform1i(tParamNameGL, unit);
 
         tParamNameGL = glGetUniformLocation(program, "volumeTexInt");
-        glUniform1i(tParamNameGL, 0);
+        glUniform1i(tParamNameGL, unit);
 
         tParamNameGL = glGetUniformLocation(program, "volumeTexFloat");
-        glUniform1i(tParamNameGL, 0);
+        glUniform1i(tParamNameGL, unit);
 
         const uint32_t refLevel = lodNode.getRefLevel();
 
@@ -643,8 +656,11 @@ struct RayCastRenderer::Impl
     GLSLShaders _axisShaders;
     uint32_t _nSamplesPerRay;
     uint32_t _computedSamplesPerRay;
+    float _quality{1.0f};
     uint32_t _transferFunctionTexture;
     std::vector<uint32_t> _usedTextures[2]; // last, current frame
+    UInt32s _unitTextures; // the volume texture per unit in this pass
+    size_t _nextUnit{0};
     NodeIds _visibleNodes;
     const Cache& _textureCache;
     const DataSource& _dataSource;
@@ -27,6 +27,7 @@
 #include <livre/lib/configuration/VolumeRendererParameters.h>
 
 #include <livre/core/cache/Cache.h>
+#include <livre/core/render/BrickOrder.h>
 #include <livre/core/render/GLContext.h>
 #include <livre/core/render/GLSLShaders.h>
 #include <livre/core/render/TransferFunction1D.h>
@@ -47,34 +48,6 @@ const int32_t SH_INT = 1;
 const int32_t SH_FLOAT = 2;
 }
 
-// Sort helper function for sorting the textures with their distances to
-// viewpoint
-struct DistanceOperator
-{
-    explicit DistanceOperator(const DataSource& dataSource,
-                              const Frustum& frustum)
-        : _frustum(frustum)
-        , _dataSource(dataSource)
-    {
-    }
-
-    bool operator()(const NodeId& rb1, const NodeId& rb2)
-    {
-        const LODNode& lodNode1 = _dataSource.getNode(rb1);
-        const LODNode& lodNode2 = _dataSource.getNode(rb2);
-
-        const float distance1 =
-            (_frustum.getMVMatrix() * lodNode1.getWorldBox().getCenter())
-                .length();
-        const float distance2 =
-            (_frustum.getMVMatrix() * lodNode2.getWorldBox().getCenter())
-                .length();
-        return distance1 < distance2;
-    }
-    const Frustum& _frustum;
-    const DataSource& _dataSource;
-};
-
 #define glewGetContext() GLContext::getCurrent()->glewGetContext()
 
 namespace
@@ -86,6 +59,7 @@ std::string where(const char* file, const int line)
 
 const uint32_t maxSamplesPerRay = 32;
 const uint32_t minSamplesPerRay = 512;
+const uint32_t minInteractiveSamplesPerRay = 64;
 }
 
 struct RayCastRenderer::Impl
@@ -115,10 +89,7 @@ struct RayCastRenderer::Impl
     ~Impl() { _framebufferTexture.flush(); }
     NodeIds order(const NodeIds& bricks, const Frustum& frustum) const
     {
-        NodeIds rbs = bricks;
-        DistanceOperator distanceOp(_dataSource, frustum);
-        std::sort(rbs.begin(), rbs.end(), distanceOp);
-        return rbs;
+        return orderFrontToBack(_dataSource, bricks, frustum);
     }
 
     void update(const FrameData& frameData)
@@ -127,6 +98,7 @@ struct RayCastRenderer::Impl
             frameData.getRenderSettings().getTransferFunction());
         _nSamplesPerRay = frameData.getVRParameters().getSamplesPerRay();
         _computedSamplesPerRay = _nSamplesPerRay;
+        _quality = frameData.getVRParameters().getInteractionQuality();
     }
 
     void initTransferFunction(const TransferFunction1D& transferFunction)
@@ -179,6 +151,12 @@ struct RayCastRenderer::Impl
                 std::max(maxVoxelsAtLOD, (float)minSamplesPerRay);
         }
 
+        // take fewer samples while interacting, see QualityGovernor
+        if (_quality < 1.0f)
+            _computedSamplesPerRay = std::max(
+                uint32_t(_computedSamplesPerRay * _quality),
+                std::min(_computedSamplesPerRay, minInteractiveSamplesPerRay));
+
         glDisable(GL_LIGHTING);
         glEnable(GL_CULL_FACE);
         glDisable(GL_DEPTH_TEST);
@@ -443,6 +421,12 @@ struct RayCastRenderer::Impl
         tParamNameGL = glGetUniformLocation(program, "textureMax");
         glUniform3fv(tParamNameGL, 1, texState.textureCoordsMax.array);
 
+        tParamNameGL = glGetUniformLocation(program, "textureClampMin");
+        glUniform3fv(tParamNameGL, 1, texState.textureClampMin.array);
+
+        tParamNameGL = glGetUniformLocation(program, "textureClampMax");
+        glUniform3fv(tParamNameGL, 1, texState.textureClampMax.array);
+
         const Vector3f& voxSize =
             texState.textureSize / lodNode.getWorldBox().getSize();
         tParamNameGL = glGetUniformLocation(program, "voxelSpacePerWorldSpace");
@@ -467,6 +451,7 @@ struct RayCastRenderer::Impl
         glUniform1i(tParamNameGL, 1); // f-shader
 
         glActiveTexture(GL_TEXTURE0);
+        texState.waitUpload();
         texState.bind();
         tParamNameGL = glGetUniformLocation(program, "volumeTexUint8");
         glUniform1i(tParamNameGL, 0);
@@ -515,6 +500,7 @@ struct RayCastRenderer::Impl
     GLSLShaders _shaders;
     uint32_t _nSamplesPerRay;
     uint32_t _computedSamplesPerRay;
+    float _quality{1.0f};
     uint32_t _transferFunctionTexture;
     std::vector<uint32_t> _usedTextures[2]; // last, current frame
     const Cache& _textureCache;
@@ -36,6 +36,8 @@ uniform vec3 aabbMin;
 uniform vec3 aabbMax;
 uniform vec3 textureMin;
 uniform vec3 textureMax;
+uniform vec3 textureClampMin;
+uniform vec3 textureClampMax;
 uniform vec3 voxelSpacePerWorldSpace;
 uniform vec3 worldEyePosition;
 uniform bool firstPass;
@@ -71,8 +73,11 @@ float rand(vec2 co)
 // Compute texture position.
 vec3 calcTexturePositionFromAABBPos(vec3 pos)
 {
-    return (pos - aabbMin) / (aabbMax - aabbMin) * (textureMax - textureMin) +
-           textureMin;
+    // stay in the slot of the brick when it is in a texture atlas
+    vec3 texPos =
+        (pos - aabbMin) / (aabbMax - aabbMin) * (textureMax - textureMin) +
+        textureMin;
+    return clamp(texPos, textureClampMin, textureClampMax);
 }
 
 // AABB-Ray intersection ( http://prideout.net/blog/?p=64 ).
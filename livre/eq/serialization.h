@@ -35,7 +35,8 @@ inline co::DataOStream& operator<<(co::DataOStream& os,
        << info.dataToLivreTransform << info.resolution
        << info.worldSpacePerVoxel << info.meterToDataUnitRatio
        << info.rootNode.getDepth() << info.rootNode.getBlockSize()
-       << info.frameRange << info.description;
+       << info.frameRange << info.valueRange[0] << info.valueRange[1]
+       << info.description;
     return os;
 }
 
@@ -47,7 +48,8 @@ inline co::DataIStream& operator>>(co::DataIStream& is, VolumeInformation& info)
         info.maximumBlockSize >> info.voxels >> info.worldSize >>
         info.dataToLivreTransform >> info.resolution >>
         info.worldSpacePerVoxel >> info.meterToDataUnitRatio >> depth >>
-        blockSize >> info.frameRange >> info.description;
+        blockSize >> info.frameRange >> info.valueRange[0] >>
+        info.valueRange[1] >> info.description;
     info.rootNode = RootNode(depth, blockSize);
     return is;
 }
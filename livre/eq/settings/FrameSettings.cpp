@@ -43,12 +43,14 @@ void FrameSettings::reset()
 
 void FrameSettings::serialize(co::DataOStream& os, uint64_t)
 {
-    os << frameNumber_ << statistics_ << info_ << grabFrame_ << idle_;
+    os << frameNumber_ << statistics_ << info_ << grabFrame_ << idle_
+       << sendHistogram_;
 }
 
 void FrameSettings::deserialize(co::DataIStream& is, uint64_t)
 {
-    is >> frameNumber_ >> statistics_ >> info_ >> grabFrame_ >> idle_;
+    is >> frameNumber_ >> statistics_ >> info_ >> grabFrame_ >> idle_
+       >> sendHistogram_;
 }
 
 void FrameSettings::setFrameNumber(uint32_t frame)
@@ -109,4 +111,18 @@ bool FrameSettings::isIdle() const
 {
     return idle_;
 }
+
+void FrameSettings::setSendHistogram(const bool send)
+{
+    if (send == sendHistogram_)
+        return;
+
+    sendHistogram_ = send;
+    setDirty(DIRTY_ALL);
+}
+
+bool FrameSettings::getSendHistogram() const
+{
+    return sendHistogram_;
+}
 }
@@ -85,6 +85,15 @@ public:
     /** @return true if idle rendering is active. */
     bool isIdle() const;
 
+    /**
+     * Enable/disable sending the histograms of the current frame to the
+     * application, which limits their rate.
+     */
+    void setSendHistogram(bool send);
+
+    /** @return true if the histograms of the current frame are sent. */
+    bool getSendHistogram() const;
+
 private:
     void serialize(co::DataOStream& os, const uint64_t dirtyBits) final;
     void deserialize(co::DataIStream& is, const uint64_t dirtyBits) final;
@@ -94,6 +103,7 @@ private:
     bool info_;
     bool grabFrame_;
     bool idle_{true};
+    bool sendHistogram_{true};
 };
 }
 
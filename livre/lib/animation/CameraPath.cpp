@@ -27,6 +27,18 @@
 
 namespace livre
 {
+namespace
+{
+Matrix4f rotate(const Vector3f& angles)
+{
+    Matrix4f x, y, z;
+    x.rotate_x(angles.x());
+    y.rotate_y(angles.y());
+    z.rotate_z(angles.z());
+    return x * y * z;
+}
+}
+
 Step::Step()
     : frame(0)
     , position(Vector3f(.0f, .0f, -1.0f))
@@ -68,6 +80,13 @@ const Vector3f& CameraPath::modelRotation() const
     return modelRotation_;
 }
 
+Matrix4f CameraPath::getModelViewMatrix(const Step& step) const
+{
+    Matrix4f position;
+    position.setTranslation(step.position);
+    return rotate(step.rotation) * position * rotate(modelRotation_);
+}
+
 Step CameraPath::getNextStep()
 {
     LBASSERT(!steps_.empty());
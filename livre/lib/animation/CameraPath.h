@@ -21,6 +21,7 @@
 #define _CameraPath_h_
 
 #include <livre/core/types.h>
+#include <livre/lib/api.h>
 
 namespace livre
 {
@@ -29,8 +30,8 @@ namespace livre
  */
 struct Step
 {
-    Step();
-    Step(int32_t fr, const Vector3f& pos, const Vector3f& rot);
+    LIVRE_API Step();
+    LIVRE_API Step(int32_t fr, const Vector3f& pos, const Vector3f& rot);
 
     int32_t frame;
     Vector3f position;
@@ -46,39 +47,45 @@ struct Step
 class CameraPath
 {
 public:
-    CameraPath();
+    LIVRE_API CameraPath();
 
     /**
      * Loads the animation text file form the filename.
      * @param fileName Animation filename to load.
      * @return False if the animation cannot be loaded.
      */
-    bool loadAnimation(const std::string& fileName);
+    LIVRE_API bool loadAnimation(const std::string& fileName);
 
     /**
      * @return The number of frames loaded.
      */
-    uint32_t getNumberOfFrames() const;
+    LIVRE_API uint32_t getNumberOfFrames() const;
 
     /**
      * @return True if animation is loaded.
      */
-    bool isValid() const;
+    LIVRE_API bool isValid() const;
 
     /**
      * @return The next step of the animation.
      */
-    Step getNextStep();
+    LIVRE_API Step getNextStep();
 
     /**
      * @return The current step of animation.
      */
-    uint32_t getCurrentFrame() const;
+    LIVRE_API uint32_t getCurrentFrame() const;
 
     /**
      * @return The rotation angles in degrees in x,y and z.
      */
-    const Vector3f& modelRotation() const;
+    LIVRE_API const Vector3f& modelRotation() const;
+
+    /**
+     * @return The model view matrix of a step: the camera rotation, the
+     *         camera position and the model rotation, like in eqPly.
+     */
+    LIVRE_API Matrix4f getModelViewMatrix(const Step& step) const;
 
 private:
     Vector3f modelRotation_;
@@ -22,106 +22,37 @@
 
 #include <livre/core/cache/Cache.h>
 #include <livre/data/DataSource.h>
+#include <livre/data/HistogramKernels.h>
+
+#include <boost/thread/thread.hpp>
 
 namespace livre
 {
 namespace
 {
-template <class SRC_TYPE>
-void binDataSlow(const SRC_TYPE* rawData, Histogram& histogram,
-                 const Vector3ui& blockSize, const Vector3ui& padding,
-                 const uint64_t scaleFactor)
-{
-    std::map<SRC_TYPE, size_t> values;
-    const Vector3ui dataBlockSize = blockSize + padding * 2;
-    for (size_t i = padding.x(); i < dataBlockSize.x() - padding.x(); ++i)
-        for (size_t j = padding.y(); j < dataBlockSize.y() - padding.y(); ++j)
-            for (size_t k = padding.z(); k < dataBlockSize.z() - padding.z();
-                 ++k)
-            {
-                const size_t index = i * dataBlockSize.y() * dataBlockSize.z() +
-                                     j * dataBlockSize.z() + k;
-                const SRC_TYPE data = rawData[index];
-                ++values[data];
-            }
-
-    const float minVal =
-        std::min(float(values.begin()->first), histogram.getMin());
-    const float maxVal =
-        std::max(float(values.rbegin()->first), histogram.getMax());
-    const float range = maxVal - minVal;
-
-    histogram.setMin(minVal);
-    histogram.setMax(maxVal);
-
-    if (range == 0.0f)
-    {
-        histogram.getBins().clear();
-        const size_t bins = blockSize.product() * scaleFactor;
-        histogram.getBins().push_back(bins);
-        return;
-    }
+const size_t minVoxelsPerThread = 1 << 21;
 
-    const size_t binCount = histogram.getBins().size();
-    uint64_t* dstData = histogram.getBins().data();
-    const SRC_TYPE perBinCount = range / (binCount - 1);
-    for (const auto& value : values)
-    {
-        const size_t binIndex = (value.first - minVal) / perBinCount;
-        dstData[binIndex] += (scaleFactor * value.second);
-    }
-}
-
-template <class SRC_TYPE>
-void binData(const SRC_TYPE* rawData, Histogram& histogram,
+template <class T>
+void binData(const void* rawData, Histogram& histogram,
              const Vector3ui& blockSize, const Vector3ui& padding,
              const uint64_t scaleFactor)
 {
-    if (padding != Vector3ui())
-    {
-        binDataSlow(rawData, histogram, blockSize, padding, scaleFactor);
-        return;
-    }
-
-    SRC_TYPE minVal = histogram.getMin();
-    SRC_TYPE maxVal = histogram.getMax();
-
-    std::vector<size_t> values(std::numeric_limits<SRC_TYPE>::max() -
-                               std::numeric_limits<SRC_TYPE>::min() + 1);
-    const size_t numVoxels = blockSize.x() * blockSize.y() * blockSize.z();
-    for (size_t i = 0; i < numVoxels; ++i)
-    {
-        const SRC_TYPE data = rawData[i];
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wpragmas"
-#pragma GCC diagnostic ignored "-Wabsolute-value"
-        ++values[data + std::abs(std::numeric_limits<SRC_TYPE>::min())];
-#pragma GCC diagnostic pop
-        minVal = std::min(data, minVal);
-        maxVal = std::max(data, maxVal);
-    }
-
-    histogram.setMin(minVal);
-    histogram.setMax(maxVal);
-    const float range = maxVal - minVal;
-
-    if (range == 0.0f)
-    {
-        histogram.getBins().clear();
-        const size_t bins = blockSize.product() * scaleFactor;
-        histogram.getBins().push_back(bins);
-        return;
-    }
-
-    const size_t binCount = histogram.getBins().size();
-    uint64_t* dstData = histogram.getBins().data();
-    const size_t perBinCount = std::ceil(range / (binCount - 1));
-
-    for (size_t i = 0; i < values.size(); ++i)
-    {
-        const size_t binIndex = std::lround(i / perBinCount);
-        dstData[binIndex] += scaleFactor * values[i];
-    }
+    // only large bricks are worth the start of threads
+    const size_t nThreads =
+        std::min(size_t(boost::thread::hardware_concurrency()),
+                 blockSize.product() / minVoxelsPerThread);
+
+    float min = histogram.getMin();
+    float max = histogram.getMax();
+    std::vector<uint64_t> bins(histogram.getBins().size());
+    binVoxels(static_cast<const T*>(rawData), blockSize, padding, scaleFactor,
+              min, max, bins, nThreads);
+
+    histogram.setMin(min);
+    histogram.setMax(max);
+    histogram.getBins().clear();
+    for (const uint64_t bin : bins)
+        histogram.getBins().push_back(bin);
 }
 }
 
@@ -161,56 +92,55 @@ public:
             scaleFactor1d * scaleFactor1d * scaleFactor1d;
 
         const DataType dataType = volumeInfo.dataType;
+        _histogram.resize(getHistogramBinCount(dataType));
+        // the value range of the volume gives all the bricks the same bins
+        const auto setRange = [&](const float min, const float max) {
+            const bool fixed = volumeInfo.hasValueRange();
+            _histogram.setMin(fixed ? volumeInfo.valueRange[0] : min);
+            _histogram.setMax(fixed ? volumeInfo.valueRange[1] : max);
+        };
         switch (dataType)
         {
         case DT_UINT8:
-            _histogram.setMin(std::numeric_limits<uint8_t>::min());
-            _histogram.setMax(std::numeric_limits<uint8_t>::max());
-            _histogram.resize(256);
-            binData(static_cast<const uint8_t*>(rawData), _histogram, voxelBox,
-                    padding, scaleFactor);
+            setRange(std::numeric_limits<uint8_t>::min(),
+                     std::numeric_limits<uint8_t>::max());
+            binData<uint8_t>(rawData, _histogram, voxelBox, padding,
+                             scaleFactor);
             break;
         case DT_UINT16:
-            _histogram.setMin(std::numeric_limits<uint16_t>::max());
-            _histogram.setMax(std::numeric_limits<uint16_t>::min());
-            _histogram.resize(1024);
-            binData(static_cast<const uint16_t*>(rawData), _histogram, voxelBox,
-                    padding, scaleFactor);
+            setRange(std::numeric_limits<uint16_t>::max(),
+                     std::numeric_limits<uint16_t>::min());
+            binData<uint16_t>(rawData, _histogram, voxelBox, padding,
+                              scaleFactor);
             break;
         case DT_UINT32:
-            _histogram.setMin(std::numeric_limits<uint32_t>::max());
-            _histogram.setMax(std::numeric_limits<uint32_t>::min());
-            _histogram.resize(4096);
-            binDataSlow(static_cast<const uint32_t*>(rawData), _histogram,
-                        voxelBox, padding, scaleFactor);
+            setRange(std::numeric_limits<uint32_t>::max(),
+                     std::numeric_limits<uint32_t>::min());
+            binData<uint32_t>(rawData, _histogram, voxelBox, padding,
+                              scaleFactor);
             break;
         case DT_INT8:
-            _histogram.setMin(std::numeric_limits<int8_t>::min());
-            _histogram.setMax(std::numeric_limits<int8_t>::max());
-            _histogram.resize(256);
-            binData(static_cast<const int8_t*>(rawData), _histogram, voxelBox,
-                    padding, scaleFactor);
+            setRange(std::numeric_limits<int8_t>::min(),
+                     std::numeric_limits<int8_t>::max());
+            binData<int8_t>(rawData, _histogram, voxelBox, padding,
+                            scaleFactor);
             break;
         case DT_INT16:
-            _histogram.setMin(std::numeric_limits<int16_t>::max());
-            _histogram.setMax(std::numeric_limits<int16_t>::min());
-            _histogram.resize(1024);
-            binData(static_cast<const int16_t*>(rawData), _histogram, voxelBox,
-                    padding, scaleFactor);
+            setRange(std::numeric_limits<int16_t>::max(),
+                     std::numeric_limits<int16_t>::min());
+            binData<int16_t>(rawData, _histogram, voxelBox, padding,
+                             scaleFactor);
             break;
         case DT_INT32:
-            _histogram.setMin(std::numeric_limits<int32_t>::max());
-            _histogram.setMax(std::numeric_limits<int32_t>::min());
-            _histogram.resize(4096);
-            binDataSlow(static_cast<const int32_t*>(rawData), _histogram,
-                        voxelBox, padding, scaleFactor);
+            setRange(std::numeric_limits<int32_t>::max(),
+                     std::numeric_limits<int32_t>::min());
+            binData<int32_t>(rawData, _histogram, voxelBox, padding,
+                             scaleFactor);
             break;
         case DT_FLOAT:
-            _histogram.setMin(dataSourceRange[0]);
-            _histogram.setMax(dataSourceRange[1]);
-            _histogram.resize(256);
-            binDataSlow(static_cast<const float*>(rawData), _histogram,
-                        voxelBox, padding, scaleFactor);
+            setRange(dataSourceRange[0], dataSourceRange[1]);
+            binData<float>(rawData, _histogram, voxelBox, padding,
+                           scaleFactor);
             break;
         case DT_UNDEFINED:
         default:
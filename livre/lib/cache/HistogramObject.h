@@ -40,7 +40,8 @@ public:
      * @param dataSource the data source
      * @param dataSourceRange range of the data source. The range is expanded
      * with the loaded
-     * data
+     * data. The value range of the volume, if known, is used instead for all
+     * the data types
      * @throws CacheLoadException when the data cache does not have the data for
      * cache id
      */
@@ -21,14 +21,11 @@
 #include <livre/lib/cache/TextureObject.h>
 
 #include <livre/core/cache/Cache.h>
-#include <livre/core/render/GLContext.h>
 #include <livre/core/render/Renderer.h>
 #include <livre/core/render/TexturePool.h>
 #include <livre/data/DataSource.h>
 #include <livre/data/LODNode.h>
 
-#include <eq/gl.h>
-
 namespace livre
 {
 namespace
@@ -41,8 +38,6 @@ size_t getTextureSize(const DataSource& dataSource)
 }
 }
 
-#define glewGetContext() GLContext::glewGetContext()
-
 /**
  * The TextureObject class holds the informarmation for the data which is on the
  * GPU.
@@ -54,7 +49,8 @@ struct TextureObject::Impl
         : _textureState(texturePool)
         , _textureSize(getTextureSize(dataSource))
     {
-        LBASSERT(_textureState.textureId);
+        if (_textureState.textureId == INVALID_TEXTURE_ID)
+            LBTHROW(CacheLoadException(cacheId, "No free texture slot"));
         if (!load(cacheId, dataCache, dataSource, texturePool))
             LBTHROW(
                 CacheLoadException(cacheId,
@@ -63,7 +59,7 @@ struct TextureObject::Impl
 
     ~Impl() {}
     bool load(const CacheId& cacheId, const Cache& dataCache,
-              const DataSource& dataSource, const TexturePool& texturePool)
+              const DataSource& dataSource, TexturePool& texturePool)
     {
         ConstDataObjectPtr data = dataCache.get<DataObject>(cacheId);
         if (!data)
@@ -74,26 +70,33 @@ struct TextureObject::Impl
     }
 
     void initialize(const CacheId& cacheId, const DataSource& dataSource,
-                    const TexturePool& texturePool,
-                    const ConstDataObjectPtr& data)
+                    TexturePool& texturePool, const ConstDataObjectPtr& data)
     {
         // TODO: The internal format size should be calculated correctly
         const Vector3f& overlap = dataSource.getVolumeInfo().overlap;
         const LODNode& lodNode = dataSource.getNode(NodeId(cacheId));
         const Vector3f& size = lodNode.getVoxelBox().getSize();
-        const Vector3f& maxSize = dataSource.getVolumeInfo().maximumBlockSize;
-        const Vector3f& overlapf = overlap / maxSize;
-        _textureState.textureCoordsMax = overlapf + size / maxSize;
-        _textureState.textureCoordsMin = overlapf;
+        const Vector3f& textureSize = texturePool.getTextureSize();
+        const Vector3f& offset = _textureState.textureOffset;
+        _textureState.textureCoordsMin = (offset + overlap) / textureSize;
+        _textureState.textureCoordsMax =
+            (offset + overlap + size) / textureSize;
         _textureState.textureSize =
             _textureState.textureCoordsMax - _textureState.textureCoordsMin;
 
+        const Vector3f& blockSize = lodNode.getBlockSize();
+        const Vector3f dataSize = blockSize + overlap * 2.0f;
+        const Vector3f halfVoxel(0.5f);
+        _textureState.textureClampMin = (offset + halfVoxel) / textureSize;
+        _textureState.textureClampMax =
+            (offset + dataSize - halfVoxel) / textureSize;
+
         loadTextureToGPU(lodNode, dataSource, texturePool, data);
     }
 
     bool loadTextureToGPU(const LODNode& lodNode, const DataSource& dataSource,
-                          const TexturePool& texturePool,
-                          const ConstDataObjectPtr& data) const
+                          TexturePool& texturePool,
+                          const ConstDataObjectPtr& data)
     {
 #ifdef LIVRE_DEBUG_RENDERING
         std::cout << "Upload " << lodNode.getNodeId().getLevel() << ' '
@@ -102,21 +105,8 @@ struct TextureObject::Impl
 #endif
         const Vector3ui& overlap = dataSource.getVolumeInfo().overlap;
         const Vector3ui& voxSizeVec = lodNode.getBlockSize() + overlap * 2;
-        _textureState.bind();
-
-        glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, voxSizeVec[0], voxSizeVec[1],
-                        voxSizeVec[2], texturePool.getFormat(),
-                        texturePool.getTextureType(), data->getDataPtr());
-
-        const GLenum glErr = glGetError();
-        if (glErr != GL_NO_ERROR)
-        {
-            LBERROR << "Error loading the texture into GPU, error number : "
-                    << glErr << std::endl;
-            return false;
-        }
-
-        return true;
+        return texturePool.upload(_textureState, voxSizeVec,
+                                  data->getDataPtr());
     }
 
     TextureState _textureState;
@@ -0,0 +1,91 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "QualityGovernor.h"
+#include "VolumeRendererParameters.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace livre
+{
+namespace
+{
+const float minQuality = 1.0f / 16.0f;
+const float refineStep = 0.25f; // quality gained per idle frame
+const float smoothing = 0.3f;   // weight of the last frame time
+const float deadBand = 0.1f;    // tolerated relative frame time error
+const float minFactor = 0.5f;   // fastest quality decrease per frame
+const float maxFactor = 1.25f;  // fastest quality increase per frame
+}
+
+QualityGovernor::QualityGovernor()
+    : _quality(1.0f)
+    , _frameTime(0.0f)
+{
+}
+
+float QualityGovernor::update(const float frameTime, const bool idle,
+                              const float targetFPS)
+{
+    if (idle || targetFPS <= 0.0f)
+    {
+        _frameTime = 0.0f;
+        _quality = targetFPS <= 0.0f ? 1.0f
+                                     : std::min(_quality + refineStep, 1.0f);
+        return _quality;
+    }
+
+    if (frameTime <= 0.0f)
+        return _quality;
+
+    _frameTime = _frameTime == 0.0f
+                     ? frameTime
+                     : _frameTime + smoothing * (frameTime - _frameTime);
+
+    // The cost of a frame scales roughly with the number of bricks times the
+    // samples per ray, so the square root of the time ratio avoids overshoot.
+    const float ratio = 1000.0f / targetFPS / _frameTime;
+    if (std::abs(ratio - 1.0f) <= deadBand)
+        return _quality;
+
+    const float factor =
+        std::max(minFactor, std::min(std::sqrt(ratio), maxFactor));
+    _quality = std::max(minQuality, std::min(_quality * factor, 1.0f));
+    return _quality;
+}
+
+float QualityGovernor::getMinQuality()
+{
+    return minQuality;
+}
+
+void QualityGovernor::applyQuality(VolumeRendererParameters& vrParams)
+{
+    const float quality =
+        std::max(minQuality, std::min(vrParams.getInteractionQuality(), 1.0f));
+    if (quality >= 1.0f)
+        return;
+
+    vrParams.setScreenSpaceError(vrParams.getScreenSpaceError() / quality);
+
+    const uint32_t minLod = vrParams.getMinLod();
+    const uint32_t maxLod = std::max(vrParams.getMaxLod(), minLod);
+    vrParams.setMaxLod(minLod + uint32_t(quality * float(maxLod - minLod)));
+}
+}
@@ -0,0 +1,66 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _QualityGovernor_h_
+#define _QualityGovernor_h_
+
+#include <livre/lib/api.h>
+#include <livre/lib/types.h>
+
+namespace livre
+{
+/**
+ * Closed-loop controller which computes a rendering quality in ]0, 1] from the
+ * measured render times of the frames, such that a target frame rate is held
+ * while the user is interacting. When idle, the quality is refined back to 1
+ * over a few frames.
+ */
+class QualityGovernor
+{
+public:
+    LIVRE_API QualityGovernor();
+
+    /**
+     * Updates the quality with the render time of the last finished frame.
+     * @param frameTime render time of the last finished frame in
+     *        milliseconds, 0 if no frame was measured
+     * @param idle true if the user is not interacting
+     * @param targetFPS frame rate to hold while interacting
+     * @return the new quality
+     */
+    LIVRE_API float update(float frameTime, bool idle, float targetFPS);
+
+    /** @return the current quality in [getMinQuality(), 1] */
+    float getQuality() const { return _quality; }
+    /** @return the lowest quality the governor can select */
+    LIVRE_API static float getMinQuality();
+
+    /**
+     * Lowers the screen space error and the maximum level of detail of the
+     * given parameters according to their interaction quality.
+     * @param vrParams the parameters to adapt
+     */
+    LIVRE_API static void applyQuality(VolumeRendererParameters& vrParams);
+
+private:
+    float _quality;
+    float _frameTime; // smoothed, 0 if no frame measured while interacting
+};
+}
+
+#endif // _QualityGovernor_h_
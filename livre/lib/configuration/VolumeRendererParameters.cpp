@@ -20,6 +20,8 @@
 
 #include "VolumeRendererParameters.h"
 
+#include <livre/core/pipeline/Workers.h>
+
 #include <lunchbox/term.h>
 
 namespace livre
@@ -34,6 +36,16 @@ const char MINLOD_PARAM[] = "min-lod";
 const char MAXLOD_PARAM[] = "max-lod";
 const char SAMPLESPERRAY_PARAM[] = "samples-per-ray";
 const char LINEARFILTERING_PARAM[] = "linear-filtering";
+const char UPLOADBUDGET_PARAM[] = "upload-budget";
+const char TARGETFPS_PARAM[] = "target-fps";
+const char DECOMPOSITION_PARAM[] = "decomposition";
+const char WORKERTHREADS_PARAM[] = "worker-threads";
+const char TRACE_PARAM[] = "trace";
+const char WORKERAFFINITY_PARAM[] = "worker-affinity";
+const char HISTOGRAMPYRAMID_PARAM[] = "histogram-pyramid";
+const char HISTOGRAMRATE_PARAM[] = "histogram-rate";
+const char RENDERER_PARAM[] = "renderer";
+const char TEXTUREATLAS_PARAM[] = "texture-atlas";
 }
 
 VolumeRendererParameters::VolumeRendererParameters()
@@ -80,6 +92,19 @@ VolumeRendererParameters::VolumeRendererParameters(const int32_t argc,
     setMaxLod(vm[MAXLOD_PARAM].as<uint32_t>());
     setSamplesPerRay(vm[SAMPLESPERRAY_PARAM].as<uint32_t>());
     setLinearFiltering(vm[LINEARFILTERING_PARAM].as<bool>());
+    setUploadTimeBudget(vm[UPLOADBUDGET_PARAM].as<float>());
+    setTargetFps(vm[TARGETFPS_PARAM].as<float>());
+    setDecomposition(vm[DECOMPOSITION_PARAM].as<uint32_t>());
+    setWorkerThreads(vm[WORKERTHREADS_PARAM].as<uint32_t>());
+    setTraceFile(vm[TRACE_PARAM].as<std::string>());
+
+    const std::string& affinity = vm[WORKERAFFINITY_PARAM].as<std::string>();
+    Workers::parseAffinities(affinity); // throws if invalid
+    setWorkerAffinity(affinity);
+    setHistogramPyramid(vm[HISTOGRAMPYRAMID_PARAM].as<std::string>());
+    setHistogramRate(vm[HISTOGRAMRATE_PARAM].as<float>());
+    setRenderer(vm[RENDERER_PARAM].as<uint32_t>());
+    setTextureAtlas(vm[TEXTUREATLAS_PARAM].as<bool>());
 }
 
 options_description VolumeRendererParameters::_getOptions() const
@@ -104,6 +129,61 @@ options_description VolumeRendererParameters::_getOptions() const
               getSamplesPerRay());
     addOption(options, LINEARFILTERING_PARAM,
               "Use linear texture filtering instead of nearest", false);
+    addOption(options, UPLOADBUDGET_PARAM,
+              "Time budget (ms) per frame for texture uploads in asynchronous "
+              "mode. The value of 0 uploads one texture per frame",
+              getUploadTimeBudget());
+    addOption(options, TARGETFPS_PARAM,
+              "Frame rate to hold while interacting by lowering the screen "
+              "space error, level of detail and samples per ray. The value of "
+              "0 renders the minimum level of detail while interacting",
+              getTargetFps());
+    addOption(options, DECOMPOSITION_PARAM,
+              "Sort-last decomposition of the bricks. The value of 0 splits "
+              "the list of visible bricks, 1 (default) splits the volume along "
+              "the octree, keeping the bricks of each node stable",
+              getDecomposition());
+    addOption(options, WORKERTHREADS_PARAM,
+              "Number of pipeline threads per window. They are shared by the "
+              "rendering, the data loading of the CPU renderer and the "
+              "histogram computation, in this order of priority. The texture "
+              "uploads have one more thread",
+              getWorkerThreads());
+    addOption(options, TRACE_PARAM,
+              "Record the pipeline filters of each frame with their run time "
+              "and the time they wait for a worker thread, and write them to "
+              "the given file in the Chrome trace format at exit; each "
+              "process adds its id to the file name, e.g. trace.1234.json",
+              getTraceFileString());
+    addOption(options, WORKERAFFINITY_PARAM,
+              "CPU affinity of the pipeline threads: 'socket:N' binds them to "
+              "the cores of the processor socket N, i.e. to its NUMA node, "
+              "'cores:2-5,7' binds each thread to one of the listed cores. By "
+              "default, they keep the affinity of their Equalizer pipe, which "
+              "is set with the hint_affinity pipe attribute",
+              getWorkerAffinityString());
+    addOption(options, HISTOGRAMPYRAMID_PARAM,
+              "File of the precomputed histograms of the nodes of the first "
+              "time step. The application node computes and saves the "
+              "histograms to it if it does not match the volume, which reads "
+              "the whole volume once at startup; the render nodes of other "
+              "processes use the file from the next run on",
+              getHistogramPyramidString());
+    addOption(options, HISTOGRAMRATE_PARAM,
+              "Maximum number of histograms per second sent by the render "
+              "nodes to the application. The value of 0 sends the histogram "
+              "of every frame",
+              getHistogramRate());
+    addOption(options, RENDERER_PARAM,
+              "Renderer of the bricks. The value of 0 (default) ray casts them "
+              "on the GPU, 1 ray casts their data on the CPU, which needs no "
+              "GPU and no texture memory",
+              getRenderer());
+    addOption(options, TEXTUREATLAS_PARAM,
+              "Store the bricks in a few large textures of the GPU cache size "
+              "instead of one texture per brick, which needs fewer texture "
+              "binds per frame",
+              false);
     return options;
 }
 
@@ -24,56 +24,135 @@
 
 #include <livre/core/cache/Cache.h>
 #include <livre/core/pipeline/Pipeline.h>
+#include <livre/data/DataSource.h>
+#include <livre/data/Frustum.h>
 #include <livre/data/NodeId.h>
 
-#include <eq/gl.h>
+#include <lunchbox/clock.h>
 
 namespace livre
 {
+namespace
+{
+// Upload priority of a brick: coarse levels first, then the bricks closest to
+// the center of the view.
+struct UploadPriority
+{
+    uint32_t level;
+    float distanceToCenter;
+    NodeId nodeId;
+
+    bool operator<(const UploadPriority& rhs) const
+    {
+        if (level != rhs.level)
+            return level < rhs.level;
+        return distanceToCenter < rhs.distanceToCenter;
+    }
+};
+}
+
 struct DataUploadFilter::Impl
 {
 public:
     Impl(Cache& dataCache, Cache& textureCache, DataSource& dataSource,
-         TexturePool& texturePool)
+         TexturePool& texturePool, const bool uploadTextures)
         : _dataCache(dataCache)
         , _textureCache(textureCache)
         , _dataSource(dataSource)
         , _texturePool(texturePool)
+        , _uploadTextures(uploadTextures)
+    {
+    }
+
+    /** @return the loaded texture, or data without textures, of a node */
+    ConstCacheObjectPtr getLoaded(const NodeId& nodeId) const
     {
+        if (_uploadTextures)
+            return _textureCache.get<TextureObject>(nodeId.getId());
+        return _dataCache.get<DataObject>(nodeId.getId());
     }
 
-    ConstCacheObjects load(const NodeIds& visibles) const
+    ConstCacheObjectPtr loadNode(const NodeId& nodeId) const
     {
+        ConstCacheObjectPtr data =
+            _dataCache.load<DataObject>(nodeId.getId(), _dataSource);
+        if (!data || !_uploadTextures)
+            return data;
+
+        return _textureCache.load<TextureObject>(nodeId.getId(), _dataCache,
+                                                 _dataSource, _texturePool);
+    }
+
+    ConstCacheObjects load(const NodeIds& visibles,
+                           const CancelToken& token) const
+    {
+        // The uploads run on the GPU after the textures are returned, the
+        // renderer waits for them, see TextureState::waitUpload()
         ConstCacheObjects cacheObjects;
         cacheObjects.reserve(visibles.size());
-        bool isTextureUploaded = false;
         for (const NodeId& nodeId : visibles)
         {
-            ConstTextureObjectPtr texture =
-                _textureCache.get<TextureObject>(nodeId.getId());
-            if (!texture)
-            {
-                if (!_dataCache.load<DataObject>(nodeId.getId(), _dataSource))
-                    continue;
-
-                texture =
-                    _textureCache.load<TextureObject>(nodeId.getId(),
-                                                      _dataCache, _dataSource,
-                                                      _texturePool);
-                if (!texture)
-                    continue;
+            if (token.isCanceled())
+                break;
+
+            ConstCacheObjectPtr object = getLoaded(nodeId);
+            if (!object)
+                object = loadNode(nodeId);
+            if (object)
+                cacheObjects.push_back(object);
+        }
+        return cacheObjects;
+    }
 
-                cacheObjects.push_back(texture);
-                isTextureUploaded = true;
-            }
-            else
-                cacheObjects.push_back(texture);
+    NodeIds getMissing(const NodeIds& visibles, const Frustum& frustum) const
+    {
+        const Matrix4f& mvpMatrix = frustum.getMVPMatrix();
+        std::vector<UploadPriority> priorities;
+        for (const NodeId& nodeId : visibles)
+        {
+            if (getLoaded(nodeId))
+                continue;
+
+            const LODNode& lodNode = _dataSource.getNode(nodeId);
+            Vector4f center = lodNode.getWorldBox().getCenter();
+            center[3] = 1.0f;
+            const Vector4f ndcCenter = mvpMatrix * center;
+            const float w = std::abs(ndcCenter[3]) > 0.0f ? ndcCenter[3] : 1.0f;
+            const Vector2f screenPos(ndcCenter[0] / w, ndcCenter[1] / w);
+            priorities.push_back(
+                {nodeId.getLevel(), screenPos.squared_length(), nodeId});
         }
 
-        if (isTextureUploaded)
-            glFinish();
+        std::sort(priorities.begin(), priorities.end());
 
-        return cacheObjects;
+        NodeIds missing;
+        missing.reserve(priorities.size());
+        for (const auto& priority : priorities)
+            missing.push_back(priority.nodeId);
+        return missing;
+    }
+
+    // Uploads the missing bricks in priority order until the time budget is
+    // spent or a newer frame cancels the upload. At least one brick is
+    // uploaded per frame to guarantee progress. Bricks which do not fit are
+    // not queued: the next frame recomputes the missing set, so bricks which
+    // left the frustum are never uploaded.
+    void loadWithinBudget(const NodeIds& missing, const float budgetMs,
+                          const CancelToken& token) const
+    {
+        lunchbox::Clock clock;
+        bool isTextureUploaded = false;
+        for (const NodeId& nodeId : missing)
+        {
+            if (isTextureUploaded &&
+                (clock.getTimef() >= budgetMs || token.isCanceled()))
+            {
+                break;
+            }
+
+            if (loadNode(nodeId))
+                isTextureUploaded = true;
+        }
     }
 
     ConstCacheObjects get(const NodeIds& visibles) const
@@ -82,22 +161,23 @@ public:
         cacheObjects.reserve(visibles.size());
         for (const NodeId& nodeId : visibles)
         {
-            ConstCacheObjectPtr texture =
-                _textureCache.get<TextureObject>(nodeId.getId());
-            if (texture)
-                cacheObjects.push_back(texture);
+            ConstCacheObjectPtr object = getLoaded(nodeId);
+            if (object)
+                cacheObjects.push_back(object);
         }
 
         return cacheObjects;
     }
 
-    void execute(const FutureMap& input, PromiseMap& output) const
+    void execute(const FutureMap& input, PromiseMap& output,
+                 const CancelToken& token) const
     {
         const UniqueFutureMap uniqueInputs(input.getFutures());
         const auto& vrParams =
             uniqueInputs.get<VolumeRendererParameters>("Params");
 
         const auto& visibles = uniqueInputs.get<NodeIds>("VisibleNodes");
+        const auto& frustum = uniqueInputs.get<Frustum>("Frustum");
 
         const bool isAsync = !vrParams.getSynchronousMode();
 
@@ -105,21 +185,15 @@ public:
         {
             output.set("CacheObjects", get(visibles)); // Already loaded ones
 
-            // only load 1 missing texture at a time aka per frame. This might
-            // seem a waste of bandwidth but leads to a more responsive
-            // application as blocks which are not visible anymore won't still
-            // be queued for uploading.
-            for (const auto& node : visibles)
-            {
-                if (!_textureCache.get<TextureObject>(node.getId()))
-                {
-                    load(NodeIds(1, node)); // load
-                    break;
-                }
-            }
+            // Load the most important missing textures within the time budget
+            // of this frame. Keeping the budget small leads to a more
+            // responsive application, as blocks which are not visible anymore
+            // won't still be queued for uploading.
+            loadWithinBudget(getMissing(visibles, frustum),
+                             vrParams.getUploadTimeBudget(), token);
         }
         else
-            output.set("CacheObjects", load(visibles)); // load all
+            output.set("CacheObjects", load(visibles, token)); // load all
     }
 
     DataInfos getInputDataInfos() const
@@ -127,6 +201,7 @@ public:
         return {
             {"Params", getType<VolumeRendererParameters>()},
             {"VisibleNodes", getType<NodeIds>()},
+            {"Frustum", getType<Frustum>()},
         };
     }
 
@@ -141,13 +216,15 @@ public:
     Cache& _textureCache;
     DataSource& _dataSource;
     TexturePool& _texturePool;
+    const bool _uploadTextures;
 };
 
 DataUploadFilter::DataUploadFilter(Cache& dataCache, Cache& textureCache,
                                    DataSource& dataSource,
-                                   TexturePool& texturePool)
+                                   TexturePool& texturePool,
+                                   const bool uploadTextures)
     : _impl(new DataUploadFilter::Impl(dataCache, textureCache, dataSource,
-                                       texturePool))
+                                       texturePool, uploadTextures))
 {
 }
 
@@ -157,7 +234,13 @@ DataUploadFilter::~DataUploadFilter()
 
 void DataUploadFilter::execute(const FutureMap& input, PromiseMap& output) const
 {
-    _impl->execute(input, output);
+    _impl->execute(input, output, CancelToken());
+}
+
+void DataUploadFilter::execute(const FutureMap& input, PromiseMap& output,
+                               const CancelToken& token) const
+{
+    _impl->execute(input, output, token);
 }
 
 DataInfos DataUploadFilter::getInputDataInfos() const
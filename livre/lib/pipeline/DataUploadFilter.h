@@ -38,9 +38,12 @@ public:
      * @param textureCache texture cache
      * @param dataSource data source
      * @param texturePool the pool for 3D textures
+     * @param uploadTextures false to only load the data of the bricks, which
+     *        is then the output cache objects, e.g. for the CPU renderer
      */
     DataUploadFilter(Cache& dataCache, Cache& textureCache,
-                     DataSource& dataSource, TexturePool& texturePool);
+                     DataSource& dataSource, TexturePool& texturePool,
+                     bool uploadTextures = true);
     ~DataUploadFilter();
 
     /**
@@ -48,6 +51,12 @@ public:
      */
     void execute(const FutureMap& input, PromiseMap& output) const final;
 
+    /**
+     * @copydoc Filter::execute(const FutureMap&,PromiseMap&,const CancelToken&)
+     */
+    void execute(const FutureMap& input, PromiseMap& output,
+                 const CancelToken& token) const final;
+
     /**
      * @copydoc Filter::getInputDataInfos
      */
@@ -23,6 +23,12 @@
 #include <livre/core/cache/Cache.h>
 #include <livre/data/DataSource.h>
 #include <livre/data/Frustum.h>
+#include <livre/data/HistogramPyramid.h>
+#include <livre/data/NodeId.h>
+
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace livre
 {
@@ -31,13 +37,54 @@ namespace
 const float infinite = std::numeric_limits<float>::max();
 }
 
+struct IncrementalHistogram::Impl
+{
+    /** A brick of the last frame */
+    struct Brick
+    {
+        ConstHistogramObjectPtr histogram;
+        bool added; // in the viewport and in the bins
+    };
+
+    /** Forgets the bricks, the next frame is computed from scratch */
+    void reset(const Matrix4f& mvp_, const Viewport& viewport_,
+               const Vector2f& dataSourceRange_)
+    {
+        mvp = mvp_;
+        viewport = viewport_;
+        dataSourceRange = dataSourceRange_;
+        bricks.clear();
+        bins.clear();
+    }
+
+    std::mutex mutex;
+    Matrix4f mvp;
+    Viewport viewport;
+    Vector2f dataSourceRange;
+    std::unordered_map<CacheId, Brick> bricks;
+    std::vector<uint64_t> bins; // empty until a histogram is loaded
+};
+
+IncrementalHistogram::IncrementalHistogram()
+    : _impl(new IncrementalHistogram::Impl)
+{
+}
+
+IncrementalHistogram::~IncrementalHistogram()
+{
+}
+
 struct HistogramFilter::Impl
 {
     Impl(Cache& histogramCache, const Cache& dataCache,
-         const DataSource& dataSource)
+         const DataSource& dataSource,
+         const HistogramPyramid* histogramPyramid,
+         IncrementalHistogram::Impl* incrementalHistogram)
         : _histogramCache(histogramCache)
         , _dataCache(dataCache)
         , _dataSource(dataSource)
+        , _histogramPyramid(histogramPyramid)
+        , _incrementalHistogram(incrementalHistogram)
     {
     }
 
@@ -75,20 +122,241 @@ struct HistogramFilter::Impl
         return ndcCube.isIn(mvpCenterHom);
     }
 
-    void execute(const FutureMap& input, PromiseMap& output) const
+    /**
+     * Sums the pyramid histograms of the nodes whose center is in the
+     * viewport.
+     * @return false if a node is not in the pyramid, e.g. of another time step
+     */
+    bool accumulatePyramid(const FutureMap& input, const Frustum& frustum,
+                           const Viewport& viewport, const CancelToken& token,
+                           Histogram& histogram) const
+    {
+        NodeIds nodeIds;
+        for (const auto& cacheObjects : input.getFutures("CacheObjects"))
+            for (const auto& cacheObject :
+                 cacheObjects.get<ConstCacheObjects>())
+            {
+                if (token.isCanceled())
+                    return false;
+
+                const NodeId nodeId(cacheObject->getId());
+                const LODNode& lodNode = _dataSource.getNode(nodeId);
+                if (isCenterInViewport(frustum, lodNode.getWorldBox(),
+                                       viewport))
+                {
+                    nodeIds.push_back(nodeId);
+                }
+            }
+
+        std::vector<uint64_t> bins;
+        if (!_histogramPyramid->accumulate(HistogramPyramid::getCover(nodeIds),
+                                           bins))
+        {
+            return false;
+        }
+
+        const Range& range = _histogramPyramid->getRange();
+        histogram.setMin(range[0]);
+        histogram.setMax(range[1]);
+        for (const uint64_t bin : bins)
+            histogram.getBins().push_back(bin);
+        return true;
+    }
+
+    /**
+     * Updates the histogram of the last frame with the bricks which entered or
+     * left the frame, and with the ones whose histogram was recomputed. The
+     * result is the one of the loop of execute() as long as no histogram
+     * expands the data source range: the histogram then has the data source
+     * range and the bin count of the first brick, and the compatible bricks
+     * in the viewport are added up.
+     * @return false if the histogram has to be computed from scratch
+     */
+    bool accumulateIncremental(const FutureMap& input, const Frustum& frustum,
+                               const Viewport& viewport,
+                               const Vector2f& dataSourceRange,
+                               const CancelToken& token,
+                               Histogram& histogram) const
+    {
+        IncrementalHistogram::Impl& state = *_incrementalHistogram;
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (state.mvp != frustum.getMVPMatrix() || state.viewport != viewport ||
+            state.dataSourceRange != dataSourceRange)
+        {
+            state.reset(frustum.getMVPMatrix(), viewport, dataSourceRange);
+        }
+
+        std::unordered_set<CacheId> unchanged;
+        std::vector<std::pair<CacheId, ConstHistogramObjectPtr>> entered;
+        size_t binCount = 0; // of the first histogram
+        for (const auto& cacheObjects : input.getFutures("CacheObjects"))
+            for (const auto& cacheObject :
+                 cacheObjects.get<ConstCacheObjects>())
+            {
+                if (token.isCanceled())
+                    return false;
+
+                const CacheId cacheId = cacheObject->getId();
+                ConstHistogramObjectPtr histCacheObject =
+                    _histogramCache.get<HistogramObject>(cacheId);
+                const auto brick = state.bricks.find(cacheId);
+                if (brick != state.bricks.end() && histCacheObject &&
+                    brick->second.histogram == histCacheObject)
+                {
+                    unchanged.insert(cacheId);
+                }
+                else
+                {
+                    if (!histCacheObject)
+                        histCacheObject = _histogramCache.load<HistogramObject>(
+                            cacheId, _dataCache, _dataSource, dataSourceRange);
+                    if (!histCacheObject)
+                        continue;
+
+                    const Vector2f& range =
+                        histCacheObject->getHistogram().getRange();
+                    if (range[0] < dataSourceRange[0] ||
+                        range[1] > dataSourceRange[1])
+                    {
+                        state.reset(frustum.getMVPMatrix(), viewport,
+                                    dataSourceRange);
+                        return false;
+                    }
+                    entered.emplace_back(cacheId, histCacheObject);
+                }
+
+                if (binCount == 0)
+                    binCount = histCacheObject->getHistogram().getBins().size();
+            }
+
+        // remove the bricks which left, including the recomputed ones
+        for (auto i = state.bricks.begin(); i != state.bricks.end();)
+        {
+            if (unchanged.count(i->first))
+            {
+                ++i;
+                continue;
+            }
+
+            if (i->second.added)
+            {
+                const uint64_t* bins =
+                    i->second.histogram->getHistogram().getBins().data();
+                for (size_t j = 0; j < state.bins.size(); ++j)
+                    state.bins[j] -= bins[j];
+            }
+            i = state.bricks.erase(i);
+        }
+
+        // no histogram at all gives an empty histogram
+        if (binCount == 0)
+        {
+            state.bins.clear();
+            return true;
+        }
+
+        if (state.bins.empty())
+            state.bins.resize(binCount, 0);
+        else if (state.bins.size() != binCount)
+        {
+            state.reset(frustum.getMVPMatrix(), viewport, dataSourceRange);
+            return false;
+        }
+
+        for (const auto& brick : entered)
+        {
+            const CacheId cacheId = brick.first;
+            const Histogram& brickHistogram = brick.second->getHistogram();
+            try
+            {
+                const LODNode& lodNode = _dataSource.getNode(NodeId(cacheId));
+                if (!isCenterInViewport(frustum, lodNode.getWorldBox(),
+                                        viewport))
+                {
+                    state.bricks[cacheId] = {brick.second, false};
+                    continue;
+                }
+            }
+            catch (const std::runtime_error&)
+            {
+                _histogramCache.purge(cacheId);
+                continue;
+            }
+
+            // incompatible histograms are purged and retried, see execute()
+            if (brickHistogram.getMin() != dataSourceRange[0] ||
+                brickHistogram.getMax() != dataSourceRange[1] ||
+                brickHistogram.getBins().size() != binCount)
+            {
+                _histogramCache.purge(cacheId);
+                continue;
+            }
+
+            const uint64_t* bins = brickHistogram.getBins().data();
+            for (size_t j = 0; j < binCount; ++j)
+                state.bins[j] += bins[j];
+            state.bricks[cacheId] = {brick.second, true};
+        }
+
+        histogram.setMin(dataSourceRange[0]);
+        histogram.setMax(dataSourceRange[1]);
+        for (const uint64_t bin : state.bins)
+            histogram.getBins().push_back(bin);
+        return true;
+    }
+
+    void execute(const FutureMap& input, PromiseMap& output,
+                 const CancelToken& token) const
     {
         const auto& frustums = input.get<Frustum>("Frustum");
         const auto& viewports = input.get<Viewport>("RelativeViewport");
 
-        auto dataSourceRange = input.get<Vector2f>("DataSourceRange").front();
+        if (_histogramPyramid)
+        {
+            Histogram histogram;
+            if (accumulatePyramid(input, frustums.front(), viewports.front(),
+                                  token, histogram))
+            {
+                output.set("Histogram", std::move(histogram));
+                return;
+            }
+            // a partial histogram is not sent, the output is flushed
+            if (token.isCanceled())
+                return;
+        }
+
+        // with the value range of the volume, all the histograms have the
+        // same bins from the first frame and are never purged
+        const VolumeInformation& volumeInfo = _dataSource.getVolumeInfo();
+        auto dataSourceRange =
+            volumeInfo.hasValueRange()
+                ? Vector2f(volumeInfo.valueRange[0], volumeInfo.valueRange[1])
+                : input.get<Vector2f>("DataSourceRange").front();
         const auto& frustum = frustums.front();
         const auto& viewport = viewports.front();
 
+        if (_incrementalHistogram)
+        {
+            Histogram histogram;
+            if (accumulateIncremental(input, frustum, viewport,
+                                      dataSourceRange, token, histogram))
+            {
+                output.set("Histogram", std::move(histogram));
+                return;
+            }
+            if (token.isCanceled())
+                return;
+        }
+
         Histogram histogramAccumulated;
         for (const auto& cacheObjects : input.getFutures("CacheObjects"))
             for (const auto& cacheObject :
                  cacheObjects.get<ConstCacheObjects>())
             {
+                // a partial histogram is not sent, the output is flushed
+                if (token.isCanceled())
+                    return;
+
                 const CacheId& cacheId = cacheObject->getId();
 
                 // Hist cache object expands the data source range if data has
@@ -145,7 +413,7 @@ struct HistogramFilter::Impl
                 }
             }
 
-        output.set("Histogram", histogramAccumulated);
+        output.set("Histogram", std::move(histogramAccumulated));
     }
 
     DataInfos getInputDataInfos() const
@@ -168,11 +436,17 @@ struct HistogramFilter::Impl
     Cache& _histogramCache;
     const Cache& _dataCache;
     const DataSource& _dataSource;
+    const HistogramPyramid* const _histogramPyramid;
+    IncrementalHistogram::Impl* const _incrementalHistogram;
 };
 
 HistogramFilter::HistogramFilter(Cache& histogramCache, const Cache& dataCache,
-                                 const DataSource& dataSource)
-    : _impl(new HistogramFilter::Impl(histogramCache, dataCache, dataSource))
+                                 const DataSource& dataSource,
+                                 const HistogramPyramid* histogramPyramid,
+                                 IncrementalHistogram* incrementalHistogram)
+    : _impl(new HistogramFilter::Impl(
+          histogramCache, dataCache, dataSource, histogramPyramid,
+          incrementalHistogram ? incrementalHistogram->_impl.get() : nullptr))
 {
 }
 
@@ -182,7 +456,13 @@ HistogramFilter::~HistogramFilter()
 
 void HistogramFilter::execute(const FutureMap& input, PromiseMap& output) const
 {
-    _impl->execute(input, output);
+    _impl->execute(input, output, CancelToken());
+}
+
+void HistogramFilter::execute(const FutureMap& input, PromiseMap& output,
+                              const CancelToken& token) const
+{
+    _impl->execute(input, output, token);
 }
 
 DataInfos HistogramFilter::getInputDataInfos() const
@@ -26,10 +26,32 @@
 
 namespace livre
 {
+/**
+ * The histogram of the last frame of the histogram filters sharing it, kept to
+ * update it with the bricks entering and leaving the next frame instead of
+ * recomputing it. It is thread safe.
+ */
+class IncrementalHistogram
+{
+public:
+    IncrementalHistogram();
+    ~IncrementalHistogram();
+
+private:
+    IncrementalHistogram(const IncrementalHistogram&) = delete;
+    IncrementalHistogram& operator=(const IncrementalHistogram&) = delete;
+
+    friend class HistogramFilter;
+    struct Impl;
+    std::unique_ptr<Impl> _impl;
+};
+
 /**
  * Histogram filter computes the accumulated histogram for given node ids that
  * are in or intersecting the frustum.
  *
+ * With a histogram pyramid, the histogram is the sum of the coarsest pyramid
+ * nodes covering the nodes, without reading their data.
  */
 class HistogramFilter : public Filter
 {
@@ -39,9 +61,15 @@ public:
      * @param histogramCache the cache for histogram
      * @param dataCache data cache
      * @param dataSource data source
+     * @param histogramPyramid optional precomputed histograms of the nodes
+     * @param incrementalHistogram optional histogram of the last frame, which
+     *        is updated instead of recomputed if the frustum, the viewport and
+     *        the data source range are unchanged
      */
     HistogramFilter(Cache& histogramCache, const Cache& dataCache,
-                    const DataSource& dataSource);
+                    const DataSource& dataSource,
+                    const HistogramPyramid* histogramPyramid = nullptr,
+                    IncrementalHistogram* incrementalHistogram = nullptr);
     ~HistogramFilter();
 
     /**
@@ -49,6 +77,12 @@ public:
      */
     void execute(const FutureMap& input, PromiseMap& output) const final;
 
+    /**
+     * @copydoc Filter::execute(const FutureMap&,PromiseMap&,const CancelToken&)
+     */
+    void execute(const FutureMap& input, PromiseMap& output,
+                 const CancelToken& token) const final;
+
     /**
      * @copydoc Filter::getInputDataInfos
      */
@@ -17,9 +17,9 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
-#include <livre/lib/cache/TextureObject.h>
 #include <livre/lib/pipeline/RenderFilter.h>
 
+#include <livre/core/cache/CacheObject.h>
 #include <livre/core/render/Renderer.h>
 #include <livre/data/DataSource.h>
 #include <livre/data/Frustum.h>
@@ -28,9 +28,8 @@ namespace livre
 {
 struct RenderFilter::Impl
 {
-    Impl(const DataSource& dataSource, Renderer& renderer)
+    explicit Impl(const DataSource& dataSource)
         : _dataSource(dataSource)
-        , _renderer(renderer)
     {
     }
 
@@ -41,21 +40,17 @@ struct RenderFilter::Impl
         {
             const auto& objects = cacheObjects.get<ConstCacheObjects>();
             renderBricks.reserve(renderBricks.size() + objects.size());
-            for (const auto& cacheObject : objects)
-            {
-                const ConstTextureObjectPtr& texture =
-                    std::static_pointer_cast<const TextureObject>(cacheObject);
-
-                renderBricks.emplace_back(texture->getId());
-            }
+            for (const auto& cacheObject : objects) // textures or data
+                renderBricks.emplace_back(cacheObject->getId());
         }
 
         const auto& frustums = input.get<Frustum>("Frustum");
         const auto& clipPlanes = input.get<ClipPlanes>("ClipPlanes");
         const auto& viewports = input.get<PixelViewport>("Viewport");
         const auto& renderStages = input.get<uint32_t>("RenderStages");
-        _renderer.render(frustums[0], clipPlanes[0], viewports[0], renderBricks,
-                         renderStages[0]);
+        const auto& renderers = input.get<Renderer*>("Renderer");
+        renderers[0]->render(frustums[0], clipPlanes[0], viewports[0],
+                             renderBricks, renderStages[0]);
     }
 
     DataInfos getInputDataInfos() const
@@ -64,15 +59,15 @@ struct RenderFilter::Impl
                 {"Frustum", getType<Frustum>()},
                 {"Viewport", getType<PixelViewport>()},
                 {"ClipPlanes", getType<ClipPlanes>()},
-                {"RenderStages", getType<uint32_t>()}};
+                {"RenderStages", getType<uint32_t>()},
+                {"Renderer", getType<Renderer*>()}};
     }
 
     const DataSource& _dataSource;
-    Renderer& _renderer;
 };
 
-RenderFilter::RenderFilter(const DataSource& dataSource, Renderer& renderer)
-    : _impl(new RenderFilter::Impl(dataSource, renderer))
+RenderFilter::RenderFilter(const DataSource& dataSource)
+    : _impl(new RenderFilter::Impl(dataSource))
 {
 }
 
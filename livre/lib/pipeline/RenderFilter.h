@@ -27,7 +27,8 @@
 namespace livre
 {
 /**
- * RenderFilter implements the rendering of loaded textures given the renderer.
+ * RenderFilter implements the rendering of loaded textures given the renderer
+ * ( RayCaster, etc ), which is set on the "Renderer" port.
  */
 class RenderFilter : public Filter
 {
@@ -35,9 +36,8 @@ public:
     /**
      * Constructor
      * @param dataSource the data source
-     * @param renderer the renderer ( RayCaster, etc )
      */
-    RenderFilter(const DataSource& dataSource, Renderer& renderer);
+    explicit RenderFilter(const DataSource& dataSource);
     ~RenderFilter();
 
     /**
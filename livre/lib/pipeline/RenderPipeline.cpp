@@ -17,6 +17,7 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <livre/lib/configuration/QualityGovernor.h>
 #include <livre/lib/pipeline/DataUploadFilter.h>
 #include <livre/lib/pipeline/HistogramFilter.h>
 #include <livre/lib/pipeline/RenderFilter.h>
@@ -25,8 +26,11 @@
 #include <livre/lib/pipeline/VisibleSetGeneratorFilter.h>
 
 #include <livre/core/cache/Cache.h>
+#include <livre/core/pipeline/CancelToken.h>
+#include <livre/core/pipeline/DependencyExecutor.h>
 #include <livre/core/pipeline/Pipeline.h>
-#include <livre/core/pipeline/SimpleExecutor.h>
+#include <livre/core/pipeline/Tracer.h>
+#include <livre/core/pipeline/Workers.h>
 #include <livre/data/DataSource.h>
 
 #include <livre/core/render/Renderer.h>
@@ -34,30 +38,154 @@
 
 #include <boost/progress.hpp>
 
+#include <algorithm>
+
 namespace livre
 {
 namespace
 {
-const size_t nRenderThreads = 2;
-const size_t nUploadThreads = 1;
-const size_t nComputeThreads = 4; // for faster histogram calculation
+// The frames in flight: each frame cancels the previous ones, so more graphs
+// are only needed if the redraw or histogram filters of the caller are slow
+const size_t maxAsyncGraphs = 4;
+
+/** Executes a pipe filter and marks the end of its execution */
+class NotifyingExecutable : public Executable
+{
+public:
+    NotifyingExecutable(const PipeFilter& filter, const Promise& done)
+        : _filter(filter)
+        , _done(done)
+    {
+    }
+
+    void execute() final
+    {
+        try
+        {
+            _filter.execute();
+        }
+        catch (...)
+        {
+            _done.set(true); // or getIdleGraph() would wait forever
+            throw;
+        }
+        _done.set(true);
+    }
+
+    Futures getPostconditions() const final { return {Future(_done)}; }
+    Futures getPreconditions() const final
+    {
+        return _filter.getPreconditions();
+    }
+
+    ExecutablePtr clone() const final
+    {
+        return ExecutablePtr(new NotifyingExecutable(*this));
+    }
+
+private:
+    PipeFilter _filter;
+    Promise _done;
+};
+
+/**
+ * The filters of an asynchronous frame. They are connected once, and reset
+ * and reused for a later frame once the previous frame, including the redraw
+ * and histogram filters of the caller, has been executed. At most
+ * maxAsyncGraphs graphs are kept, see getIdleGraph().
+ */
+struct AsyncGraph
+{
+    AsyncGraph(DataSource& dataSource, Cache& dataCache, Cache& textureCache,
+               Cache& histogramCache, TexturePool& texturePool,
+               const HistogramPyramid* histogramPyramid,
+               IncrementalHistogram& incrementalHistogram,
+               const RendererType rendererType)
+        : histogramFilter("HistogramFilter", histogramCache, dataCache,
+                          dataSource, histogramPyramid, &incrementalHistogram)
+        , renderFilter("RenderFilter", dataSource)
+        , visibleSetGenerator(renderPipeline.add<VisibleSetGeneratorFilter>(
+              "VisibleSetGenerator", dataSource))
+        , renderingSetGenerator(
+              renderPipeline.add<RenderingSetGeneratorFilter>(
+                  "RenderingSetGenerator",
+                  rendererType == RENDERER_CPU ? dataCache : textureCache))
+        , uploader(uploadPipeline.add<DataUploadFilter>(
+              "DataUploader", dataCache, textureCache, dataSource, texturePool,
+              rendererType != RENDERER_CPU))
+        , redrawDone(DataInfo("RedrawDone", getType<bool>()))
+        , histogramDone(DataInfo("HistogramDone", getType<bool>()))
+    {
+        visibleSetGenerator.connect("VisibleNodes", renderingSetGenerator,
+                                    "VisibleNodes");
+        renderingSetGenerator.connect("CacheObjects", renderFilter,
+                                      "CacheObjects");
+        renderingSetGenerator.connect("CacheObjects", histogramFilter,
+                                      "CacheObjects");
+        visibleSetGenerator.connect("VisibleNodes", uploader, "VisibleNodes");
+        visibleSetGenerator.connect("Params", uploader, "Params");
+
+        redrawDone.set(true);
+        histogramDone.set(true);
+    }
+
+    bool isIdle() const
+    {
+        return Future(redrawDone).isReady() &&
+               Future(histogramDone).isReady();
+    }
+
+    void reset()
+    {
+        renderPipeline.reset();
+        uploadPipeline.reset();
+        histogramFilter.reset();
+        renderFilter.reset();
+        redrawDone.reset();
+        histogramDone.reset();
+    }
+
+    Pipeline renderPipeline;
+    Pipeline uploadPipeline;
+    PipeFilterT<HistogramFilter> histogramFilter;
+    PipeFilterT<RenderFilter> renderFilter;
+    PipeFilter visibleSetGenerator;
+    PipeFilter renderingSetGenerator;
+    PipeFilter uploader;
+    Promise redrawDone;
+    Promise histogramDone;
+};
 }
 
 struct RenderPipeline::Impl
 {
     Impl(DataSource& dataSource, Caches& caches, TexturePool& texturePool,
-         const GLContext& glContext)
+         const GLContext& glContext, const size_t nThreads,
+         const Int32s& affinities, const RendererType rendererType)
         : _dataSource(dataSource)
         , _dataCache(caches.dataCache)
         , _textureCache(caches.textureCache)
         , _histogramCache(caches.histogramCache)
+        , _histogramPyramid(caches.histogramPyramid)
         , _texturePool(texturePool)
-        , _renderExecutor("Render", nRenderThreads, glContext)
-        , _computeExecutor("Compute", nComputeThreads, glContext)
-        , _uploadExecutor("Upload", nUploadThreads, glContext)
+        , _rendererType(rendererType)
+        , _workers("Pipeline", nThreads, glContext, affinities)
+        , _uploadWorkers(rendererType == RENDERER_CPU
+                             ? nullptr
+                             : new Workers("Upload", 1, glContext, affinities))
+        , _renderExecutor(_workers, PRIORITY_RENDER)
+        , _computeExecutor(_workers, PRIORITY_BACKGROUND)
+        , _uploadExecutor(_uploadWorkers ? *_uploadWorkers : _workers,
+                          PRIORITY_UPLOAD)
     {
     }
 
+    ~Impl()
+    {
+        // The filters of the last frame still in the Workers finish soon
+        _frameToken.cancel();
+    }
+
     void setupVisibleGeneratorFilter(PipeFilter& visibleSetGenerator,
                                      const RenderParams& renderParams) const
     {
@@ -68,9 +196,16 @@ struct RenderPipeline::Impl
         visibleSetGenerator.getPromise("DataRange")
             .set(renderParams.renderDataRange);
 
-        // lower LOD level if the user is interacting through the volume
+        // lower the quality if the user is interacting through the volume
         auto vrParams = renderParams.vrParams;
-        if (!renderParams.idle)
+        if (vrParams.getTargetFps() > 0.f)
+        {
+            const VolumeInformation& volInfo = _dataSource.getVolumeInfo();
+            const uint32_t maxLevel = volInfo.rootNode.getDepth() - 1;
+            vrParams.setMaxLod(std::min(vrParams.getMaxLod(), maxLevel));
+            QualityGovernor::applyQuality(vrParams);
+        }
+        else if (!renderParams.idle)
             vrParams.setMaxLod(vrParams.getMinLod());
         visibleSetGenerator.getPromise("Params").set(vrParams);
         visibleSetGenerator.getPromise("Viewport")
@@ -81,8 +216,10 @@ struct RenderPipeline::Impl
 
     void setupRenderFilter(PipeFilter& renderFilter,
                            const RenderParams& renderParams,
+                           Renderer& renderer,
                            const uint32_t renderStages) const
     {
+        renderFilter.getPromise("Renderer").set(&renderer);
         renderFilter.getPromise("Frustum").set(renderParams.frameInfo.frustum);
         renderFilter.getPromise("Viewport").set(renderParams.pixelViewPort);
         renderFilter.getPromise("ClipPlanes").set(renderParams.clipPlanes);
@@ -131,7 +268,8 @@ struct RenderPipeline::Impl
 
         for (uint32_t i = 0; i < numberOfPasses; ++i)
         {
-            uint32_t renderStages = RENDER_FRAME;
+            // the bricks are ordered once for all passes
+            uint32_t renderStages = RENDER_FRAME | RENDER_ORDERED;
             if (i == 0)
                 renderStages |= RENDER_BEGIN;
 
@@ -140,12 +278,12 @@ struct RenderPipeline::Impl
 
             const uint32_t startIndex = i * maxNodesPerPass;
             const uint32_t endIndex = (i + 1) * maxNodesPerPass;
-            const NodeIds nodesPerPass(nodeIds.begin() + startIndex,
-                                       endIndex > nodeIds.size()
-                                           ? nodeIds.end()
-                                           : nodeIds.begin() + endIndex);
+            NodeIds nodesPerPass(nodeIds.begin() + startIndex,
+                                 endIndex > nodeIds.size()
+                                     ? nodeIds.end()
+                                     : nodeIds.begin() + endIndex);
 
-            createAndExecuteSyncPass(nodesPerPass, renderParams,
+            createAndExecuteSyncPass(std::move(nodesPerPass), renderParams,
                                      sendHistogramFilter, renderer,
                                      renderStages);
             if (numberOfPasses > 1)
@@ -157,14 +295,56 @@ struct RenderPipeline::Impl
         availability.nNotAvailable = 0;
     }
 
+    // The graphs are ordered from the least to the most recently used one
+    AsyncGraph& getIdleGraph() const
+    {
+        auto i = std::find_if(_asyncGraphs.begin(), _asyncGraphs.end(),
+                              [](const AsyncGraph& graph) {
+                                  return graph.isIdle();
+                              });
+
+        if (i == _asyncGraphs.end())
+        {
+            if (_asyncGraphs.size() < maxAsyncGraphs)
+            {
+                // The previous frames are still uploading or computing
+                // histograms
+                _asyncGraphs.emplace_back(_dataSource, _dataCache,
+                                          _textureCache, _histogramCache,
+                                          _texturePool, _histogramPyramid,
+                                          _incrementalHistogram,
+                                          _rendererType);
+                i = std::prev(_asyncGraphs.end());
+            }
+            else
+            {
+                // The oldest frame is canceled, its filters finish soon
+                i = _asyncGraphs.begin();
+                Future(i->redrawDone).wait();
+                Future(i->histogramDone).wait();
+            }
+        }
+
+        _asyncGraphs.splice(_asyncGraphs.end(), _asyncGraphs, i);
+        AsyncGraph& graph = _asyncGraphs.back();
+        graph.reset();
+        return graph;
+    }
+
     void renderAsync(const RenderParams& renderParams,
                      PipeFilter& sendHistogramFilter, Renderer& renderer,
                      NodeAvailability& availability,
                      PipeFilter& redrawFilter) const
     {
-        PipeFilterT<HistogramFilter> histogramFilter("HistogramFilter",
-                                                     _histogramCache,
-                                                     _dataCache, _dataSource);
+        AsyncGraph& graph = getIdleGraph();
+
+        // The uploads, histograms and redraws are canceled by the next frame
+        graph.uploadPipeline.setCancelToken(_frameToken);
+        graph.histogramFilter.setCancelToken(_frameToken);
+        redrawFilter.setCancelToken(_frameToken);
+        sendHistogramFilter.setCancelToken(_frameToken);
+
+        PipeFilter& histogramFilter = graph.histogramFilter;
         histogramFilter.getPromise("Frustum").set(
             renderParams.frameInfo.frustum);
         histogramFilter.connect("Histogram", sendHistogramFilter, "Histogram");
@@ -177,50 +357,27 @@ struct RenderPipeline::Impl
         sendHistogramFilter.getPromise("Id").set(
             renderParams.frameInfo.frameId);
 
-        Pipeline renderPipeline;
-        Pipeline uploadPipeline;
-
-        PipeFilterT<RenderFilter> renderFilter("RenderFilter", _dataSource,
-                                               renderer);
-
-        PipeFilter visibleSetGenerator =
-            renderPipeline.add<VisibleSetGeneratorFilter>("VisibleSetGenerator",
-                                                          _dataSource);
-        setupVisibleGeneratorFilter(visibleSetGenerator, renderParams);
-
-        PipeFilter renderingSetGenerator =
-            renderPipeline.add<RenderingSetGeneratorFilter>(
-                "RenderingSetGenerator", _textureCache);
-
-        visibleSetGenerator.connect("VisibleNodes", renderingSetGenerator,
-                                    "VisibleNodes");
-        renderingSetGenerator.connect("CacheObjects", renderFilter,
-                                      "CacheObjects");
-        renderingSetGenerator.connect("CacheObjects", histogramFilter,
-                                      "CacheObjects");
-        renderingSetGenerator.connect("RenderingDone", redrawFilter,
-                                      "RenderingDone");
-
-        PipeFilter uploader =
-            uploadPipeline.add<DataUploadFilter>("DataUploader", _dataCache,
-                                                 _textureCache, _dataSource,
-                                                 _texturePool);
-
-        visibleSetGenerator.connect("VisibleNodes", uploader, "VisibleNodes");
-        visibleSetGenerator.connect("Params", uploader, "Params");
-        uploader.connect("CacheObjects", redrawFilter, "CacheObjects");
+        setupVisibleGeneratorFilter(graph.visibleSetGenerator, renderParams);
+        graph.renderingSetGenerator.connect("RenderingDone", redrawFilter,
+                                            "RenderingDone");
+        graph.uploader.getPromise("Frustum").set(
+            renderParams.frameInfo.frustum);
+        graph.uploader.connect("CacheObjects", redrawFilter, "CacheObjects");
 
-        setupRenderFilter(renderFilter, renderParams, RENDER_ALL);
+        setupRenderFilter(graph.renderFilter, renderParams, renderer,
+                          RENDER_ALL);
 
-        redrawFilter.schedule(_renderExecutor);
-        renderPipeline.schedule(_renderExecutor);
-        uploadPipeline.schedule(_uploadExecutor);
-        sendHistogramFilter.schedule(_computeExecutor);
+        NotifyingExecutable(redrawFilter, graph.redrawDone)
+            .schedule(_renderExecutor);
+        graph.renderPipeline.schedule(_renderExecutor);
+        graph.uploadPipeline.schedule(_uploadExecutor);
+        NotifyingExecutable(sendHistogramFilter, graph.histogramDone)
+            .schedule(_computeExecutor);
         histogramFilter.schedule(_computeExecutor);
-        renderFilter.execute();
+        graph.renderFilter.execute();
 
         const UniqueFutureMap futures(
-            renderingSetGenerator.getPostconditions());
+            graph.renderingSetGenerator.getPostconditions());
         availability = futures.get<NodeAvailability>("NodeAvailability");
     }
 
@@ -230,9 +387,12 @@ struct RenderPipeline::Impl
                                   Renderer& renderer,
                                   const uint32_t renderStages) const
     {
-        PipeFilterT<HistogramFilter> histogramFilter("HistogramFilter",
-                                                     _histogramCache,
-                                                     _dataCache, _dataSource);
+        // the passes of a multipass frame have different bricks
+        const bool singlePass =
+            (renderStages & RENDER_BEGIN) && (renderStages & RENDER_END);
+        PipeFilterT<HistogramFilter> histogramFilter(
+            "HistogramFilter", _histogramCache, _dataCache, _dataSource,
+            _histogramPyramid, singlePass ? &_incrementalHistogram : nullptr);
         histogramFilter.getPromise("Frustum").set(
             renderParams.frameInfo.frustum);
         histogramFilter.connect("Histogram", sendHistogramFilter, "Histogram");
@@ -244,17 +404,18 @@ struct RenderPipeline::Impl
         Pipeline renderPipeline;
         Pipeline uploadPipeline;
 
-        PipeFilterT<RenderFilter> renderFilter("RenderFilter", _dataSource,
-                                               renderer);
-        setupRenderFilter(renderFilter, renderParams, renderStages);
+        PipeFilterT<RenderFilter> renderFilter("RenderFilter", _dataSource);
+        setupRenderFilter(renderFilter, renderParams, renderer, renderStages);
 
         PipeFilter uploader =
             uploadPipeline.add<DataUploadFilter>("DataUploader", _dataCache,
                                                  _textureCache, _dataSource,
-                                                 _texturePool);
+                                                 _texturePool,
+                                                 _rendererType != RENDERER_CPU);
 
-        uploader.getPromise("VisibleNodes").set(nodeIds);
+        uploader.getPromise("VisibleNodes").set(std::move(nodeIds));
         uploader.getPromise("Params").set(renderParams.vrParams);
+        uploader.getPromise("Frustum").set(renderParams.frameInfo.frustum);
         uploader.connect("CacheObjects", renderFilter, "CacheObjects");
         uploader.connect("CacheObjects", histogramFilter, "CacheObjects");
 
@@ -269,6 +430,12 @@ struct RenderPipeline::Impl
                 PipeFilter& sendHistogramFilter, Renderer& renderer,
                 NodeAvailability& availability) const
     {
+        Tracer::setFrame(renderParams.frameInfo.frameId);
+
+        // The pending work of the previous frames is obsolete
+        _frameToken.cancel();
+        _frameToken = CancelToken();
+
         if (renderParams.vrParams.getSynchronousMode())
             renderSync(renderParams, sendHistogramFilter, renderer,
                        availability);
@@ -281,17 +448,34 @@ struct RenderPipeline::Impl
     Cache& _dataCache;
     Cache& _textureCache;
     Cache& _histogramCache;
+    const HistogramPyramid* _histogramPyramid;
     TexturePool& _texturePool;
-    mutable SimpleExecutor _renderExecutor;
-    mutable SimpleExecutor _computeExecutor;
-    mutable SimpleExecutor _uploadExecutor;
+    const RendererType _rendererType;
+
+    // Used by the filters in the Workers, so destroyed once the executors
+    // waited for them and the Workers are joined
+    mutable std::list<AsyncGraph> _asyncGraphs;
+    mutable CancelToken _frameToken; // of the last asynchronous frame
+    mutable IncrementalHistogram _incrementalHistogram;
+
+    Workers _workers;
+    // The texture uploads are serialized on one GL context, the CPU renderer
+    // loads its data in the shared pool
+    const std::unique_ptr<Workers> _uploadWorkers;
+    mutable DependencyExecutor _renderExecutor;
+    mutable DependencyExecutor _computeExecutor;
+    mutable DependencyExecutor _uploadExecutor;
 };
 
 RenderPipeline::RenderPipeline(DataSource& dataSource, Caches& caches,
                                TexturePool& texturePool,
-                               const GLContext& glContext)
-    : _impl(
-          new RenderPipeline::Impl(dataSource, caches, texturePool, glContext))
+                               const GLContext& glContext,
+                               const size_t nThreads,
+                               const Int32s& affinities,
+                               const RendererType rendererType)
+    : _impl(new RenderPipeline::Impl(dataSource, caches, texturePool,
+                                     glContext, nThreads, affinities,
+                                     rendererType))
 {
 }
 
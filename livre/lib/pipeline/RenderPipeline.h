@@ -33,6 +33,7 @@ struct Caches
     Cache& dataCache;
     Cache& textureCache;
     Cache& histogramCache;
+    const HistogramPyramid* histogramPyramid; //!< optional, may be nullptr
 };
 
 /** Parameters for rendering */
@@ -60,9 +61,15 @@ public:
      * @param dataSource the data source
      * @param texturePool the pool for textures
      * @param glContext the gl context that will be shared
+     * @param nThreads the number of threads for executing the pipeline
+     * @param affinities of the threads, see Workers
+     * @param rendererType the renderer of the frames: the CPU renderer is
+     *        given the data of the bricks, no textures are uploaded
      */
     RenderPipeline(DataSource& dataSource, Caches& caches,
-                   TexturePool& texturePool, const GLContext& glContext);
+                   TexturePool& texturePool, const GLContext& glContext,
+                   size_t nThreads, const Int32s& affinities = Int32s(),
+                   RendererType rendererType = RENDERER_GL);
 
     ~RenderPipeline();
 
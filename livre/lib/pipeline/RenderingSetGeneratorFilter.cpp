@@ -124,7 +124,7 @@ struct RenderingSetGeneratorFilter::Impl
         ConstCacheObjects cacheObjects;
         size_t nVisible = 0;
         NodeAvailability cumulativeAvailability;
-        for (const auto& visibles : input.get<NodeIds>("VisibleNodes"))
+        for (const NodeIds& visibles : input.getRefs<NodeIds>("VisibleNodes"))
         {
             NodeAvailability avaliability;
             const ConstCacheObjects& objs =
@@ -134,8 +134,8 @@ struct RenderingSetGeneratorFilter::Impl
             cumulativeAvailability += avaliability;
         }
 
-        output.set("CacheObjects", cacheObjects);
         output.set("RenderingDone", cacheObjects.size() == nVisible);
+        output.set("CacheObjects", std::move(cacheObjects));
         output.set("NodeAvailability", cumulativeAvailability);
     }
 
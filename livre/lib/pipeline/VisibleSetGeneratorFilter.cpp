@@ -54,14 +54,16 @@ struct VisibleSetGeneratorFilter::Impl
         const uint32_t minLOD = params.getMinLod();
         const uint32_t maxLOD = params.getMaxLod();
 
+        const auto decomposition = Decomposition(params.getDecomposition());
+
         SelectVisibles visitor(_dataSource, frustum, windowHeight, sse, minLOD,
-                               maxLOD, range, clipPlanes);
+                               maxLOD, range, clipPlanes, decomposition);
 
         DFSTraversal traverser;
         traverser.traverse(_dataSource.getVolumeInfo().rootNode, visitor,
                            frame);
 
-        output.set("VisibleNodes", visitor.getVisibles());
+        output.set("VisibleNodes", visitor.takeVisibles());
         output.set("Params", params);
     }
 
@@ -0,0 +1,447 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <livre/lib/cache/DataObject.h>
+#include <livre/lib/configuration/VolumeRendererParameters.h>
+#include <livre/lib/render/BatchRenderer.h>
+#include <livre/lib/render/CPURayCastRenderer.h>
+
+#include <livre/core/cache/Cache.h>
+#include <livre/core/render/TransferFunction1D.h>
+#include <livre/data/DFSTraversal.h>
+#include <livre/data/DataSource.h>
+#include <livre/data/Frustum.h>
+#include <livre/data/SelectVisibles.h>
+#include <livre/data/VolumeInformation.h>
+
+#include <lunchbox/mtQueue.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <limits>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace livre
+{
+namespace
+{
+/** The frames using a brick, in ascending order */
+typedef std::unordered_map<Identifier, std::vector<size_t>> BrickUses;
+
+struct Image
+{
+    size_t index;
+    std::vector<uint8_t> rgba;
+};
+typedef std::shared_ptr<const Image> ConstImagePtr;
+
+const size_t noUse = std::numeric_limits<size_t>::max();
+
+/** @return the first frame from the given one using a brick, or noUse */
+size_t getNextUse(const std::vector<size_t>& uses, const size_t frame)
+{
+    const auto i = std::lower_bound(uses.begin(), uses.end(), frame);
+    return i == uses.end() ? noUse : *i;
+}
+
+/**
+ * Gives the images to the writer from a background thread. The queue holds a
+ * few groups of images to keep the renderers busy. Destroyed without
+ * finish(), it drops the queued images and joins the thread.
+ */
+class Encoder
+{
+public:
+    Encoder(const BatchRenderer::ImageWriter& writer, const size_t queueSize)
+        : _images(queueSize)
+        , _stopped(false)
+        , _thread([this, &writer] { _run(writer); })
+    {
+    }
+
+    ~Encoder()
+    {
+        if (!_thread.joinable())
+            return;
+        _stopped = true;
+        _images.push(ConstImagePtr());
+        _thread.join();
+    }
+
+    void push(const ConstImagePtr& image) { _images.push(image); }
+
+    /** @return true if the writer failed, the batch can stop */
+    bool hasFailed() const { return _stopped; }
+
+    /** Writes the queued images, rethrows the exception of the writer. */
+    void finish()
+    {
+        _images.push(ConstImagePtr());
+        _thread.join();
+        if (_error)
+            std::rethrow_exception(_error);
+    }
+
+private:
+    void _run(const BatchRenderer::ImageWriter& writer)
+    {
+        while (const ConstImagePtr image = _images.pop())
+        {
+            if (_stopped)
+                continue;
+            try
+            {
+                writer(image->index, image->rgba);
+            }
+            catch (...)
+            {
+                _error = std::current_exception();
+                _stopped = true;
+            }
+        }
+    }
+
+    lunchbox::MTQueue<ConstImagePtr> _images;
+    std::exception_ptr _error;
+    std::atomic<bool> _stopped;
+    std::thread _thread;
+};
+
+/** Joins the threads when destroyed, also when the caller throws */
+struct JoiningThreads
+{
+    ~JoiningThreads()
+    {
+        for (std::thread& thread : threads)
+            if (thread.joinable())
+                thread.join();
+    }
+
+    std::vector<std::thread> threads;
+};
+
+/** The storage order of the volumes: time steps, levels, then z, y, x */
+bool isBeforeInStorage(const NodeId& a, const NodeId& b)
+{
+    if (a.getTimeStep() != b.getTimeStep())
+        return a.getTimeStep() < b.getTimeStep();
+    if (a.getLevel() != b.getLevel())
+        return a.getLevel() < b.getLevel();
+    const Vector3ui& posA = a.getPosition();
+    const Vector3ui& posB = b.getPosition();
+    return std::make_tuple(posA.z(), posA.y(), posA.x()) <
+           std::make_tuple(posB.z(), posB.y(), posB.x());
+}
+}
+
+struct BatchRenderer::Impl
+{
+    Impl(const servus::URI& uri, const VolumeRendererParameters& params,
+         const size_t nParallelFrames)
+        : _dataSource(uri)
+        , _dataCache("DataCache", params.getMaxCpuCacheMemory() * LB_1MB)
+        , _params(params)
+    {
+        const size_t nRenderers =
+            nParallelFrames > 0
+                ? nParallelFrames
+                : std::max(std::thread::hardware_concurrency(), 1u);
+
+        // the frames are rendered in parallel instead of their tiles
+        for (size_t i = 0; i < nRenderers; ++i)
+        {
+            _renderers.emplace_back(
+                new CPURayCastRenderer(_dataSource, _dataCache,
+                                       params.getSamplesPerRay(), 1));
+            _renderers.back()->setLinearFiltering(params.getLinearFiltering());
+            _renderers.back()->setTransferFunction(TransferFunction1D());
+        }
+
+        const VolumeInformation& volInfo = _dataSource.getVolumeInfo();
+        const Vector3ui& blockSize = volInfo.maximumBlockSize;
+        const size_t brickMemory = size_t(blockSize[0]) * blockSize[1] *
+                                   blockSize[2] * volInfo.compCount *
+                                   volInfo.getBytesPerVoxel();
+        _maxBricks = std::max(params.getMaxCpuCacheMemory() * LB_1MB /
+                                  std::max(brickMemory, size_t(1)),
+                              size_t(1));
+    }
+
+    BatchStatistics render(const BatchFrames& frames,
+                           const Frustumf& projection, const Vector2ui& size,
+                           const ImageWriter& writer)
+    {
+        const auto startTime = std::chrono::steady_clock::now();
+        const VolumeInformation& volInfo = _dataSource.getVolumeInfo();
+        for (const BatchFrame& frame : frames)
+        {
+            if (frame.timeStep < volInfo.frameRange[0] ||
+                frame.timeStep >= volInfo.frameRange[1])
+            {
+                LBTHROW(std::runtime_error(
+                    "Time step " + std::to_string(frame.timeStep) +
+                    " is not in the volume"));
+            }
+        }
+
+        // The level of detail cuts of all the frames, in rendering order
+        const Matrix4f projectionMatrix = projection.computePerspectiveMatrix();
+        std::vector<NodeIds> cuts;
+        cuts.reserve(frames.size());
+        BrickUses uses;
+        for (size_t i = 0; i < frames.size(); ++i)
+        {
+            const Frustum frustum(frames[i].modelView, projectionMatrix);
+            cuts.push_back(_renderers.front()->order(
+                select(frustum, frames[i].timeStep, size[1]), frustum));
+            for (const NodeId& nodeId : cuts.back())
+                uses[nodeId.getId()].push_back(i);
+        }
+
+        BatchStatistics statistics;
+        statistics.frames = frames.size();
+        statistics.bricks = uses.size();
+
+        try
+        {
+            renderGroups(frames, projectionMatrix, size, cuts, uses, writer,
+                         statistics);
+        }
+        catch (...)
+        {
+            _loaded.clear();
+            throw;
+        }
+        _loaded.clear();
+
+        statistics.seconds =
+            std::chrono::duration<float>(std::chrono::steady_clock::now() -
+                                         startTime)
+                .count();
+        return statistics;
+    }
+
+    void renderGroups(const BatchFrames& frames,
+                      const Matrix4f& projectionMatrix, const Vector2ui& size,
+                      const std::vector<NodeIds>& cuts, const BrickUses& uses,
+                      const ImageWriter& writer, BatchStatistics& statistics)
+    {
+        Encoder encoder(writer, _renderers.size() * 2);
+        const PixelViewport view(0, 0, size[0], size[1]);
+        size_t begin = 0;
+        size_t end = getGroupEnd(cuts, begin);
+        load(cuts, uses, begin, begin, end, false, statistics);
+
+        while (begin < frames.size() && !encoder.hasFailed())
+        {
+            std::vector<std::exception_ptr> errors(end - begin);
+            const size_t nextEnd = getGroupEnd(cuts, end);
+            {
+                JoiningThreads group;
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const Frustum frustum(frames[i].modelView,
+                                          projectionMatrix);
+                    CPURayCastRenderer& renderer = *_renderers[i - begin];
+                    const NodeIds& cut = cuts[i];
+                    std::exception_ptr& error = errors[i - begin];
+                    group.threads.emplace_back(
+                        [this, frustum, view, &renderer, &cut, &error] {
+                            try
+                            {
+                                renderer.render(frustum, _clipPlanes, view,
+                                                cut, RENDER_BEGIN |
+                                                         RENDER_FRAME |
+                                                         RENDER_END |
+                                                         RENDER_ORDERED);
+                            }
+                            catch (...)
+                            {
+                                error = std::current_exception();
+                            }
+                        });
+                }
+
+                // reads the bricks of the next group which fit meanwhile
+                load(cuts, uses, begin, end, nextEnd, true, statistics);
+            }
+
+            for (const std::exception_ptr& error : errors)
+                if (error)
+                    std::rethrow_exception(error);
+
+            for (size_t i = begin; i < end; ++i)
+                encoder.push(std::make_shared<Image>(
+                    Image{i, _renderers[i - begin]->getRGBA8()}));
+
+            begin = end;
+            end = nextEnd;
+            load(cuts, uses, begin, begin, end, false, statistics);
+        }
+        encoder.finish();
+    }
+
+    NodeIds select(const Frustum& frustum, const uint32_t timeStep,
+                   const uint32_t windowHeight) const
+    {
+        const Range fullRange = {{0.f, 1.f}};
+        SelectVisibles visitor(_dataSource, frustum, windowHeight,
+                               _params.getScreenSpaceError(),
+                               _params.getMinLod(), _params.getMaxLod(),
+                               fullRange, _clipPlanes);
+
+        DFSTraversal traverser;
+        traverser.traverse(_dataSource.getVolumeInfo().rootNode, visitor,
+                           timeStep);
+        return visitor.takeVisibles();
+    }
+
+    // A group has a frame per renderer, and as many more frames as its bricks
+    // fit in the cache memory
+    size_t getGroupEnd(const std::vector<NodeIds>& cuts,
+                       const size_t begin) const
+    {
+        std::unordered_set<Identifier> bricks;
+        size_t end = begin;
+        while (end < cuts.size() && end - begin < _renderers.size())
+        {
+            std::unordered_set<Identifier> groupBricks = bricks;
+            for (const NodeId& nodeId : cuts[end])
+                groupBricks.insert(nodeId.getId());
+            if (end > begin && groupBricks.size() > _maxBricks)
+                break;
+            bricks.swap(groupBricks);
+            ++end;
+        }
+        return end;
+    }
+
+    // Releases the loaded bricks which are not used from the frame first on.
+    // Then loads the missing bricks of the frames [begin, end) in storage
+    // order. When prefetching, the frames [first, begin) are being rendered
+    // and only the bricks which fit are loaded. Otherwise, if the bricks do
+    // not fit, the loaded ones which are used again last are released first.
+    void load(const std::vector<NodeIds>& cuts, const BrickUses& uses,
+              const size_t first, const size_t begin, const size_t end,
+              const bool prefetch, BatchStatistics& statistics)
+    {
+        std::unordered_set<Identifier> groupBricks;
+        NodeIds missing;
+        for (size_t i = begin; i < end; ++i)
+        {
+            for (const NodeId& nodeId : cuts[i])
+            {
+                const Identifier id = nodeId.getId();
+                if (groupBricks.insert(id).second && !_loaded.count(id))
+                    missing.push_back(nodeId);
+            }
+        }
+
+        std::vector<std::pair<size_t, Identifier>> releasable; // next use, id
+        for (auto i = _loaded.begin(); i != _loaded.end();)
+        {
+            const size_t nextUse = getNextUse(uses.at(i->first), first);
+            if (nextUse == noUse)
+            {
+                i = _loaded.erase(i);
+                continue;
+            }
+            if (!groupBricks.count(i->first))
+                releasable.emplace_back(nextUse, i->first);
+            ++i;
+        }
+
+        if (!prefetch)
+        {
+            std::sort(releasable.begin(), releasable.end());
+            while (!releasable.empty() &&
+                   _loaded.size() + missing.size() > _maxBricks)
+            {
+                _loaded.erase(releasable.back().second);
+                releasable.pop_back();
+            }
+        }
+
+        std::sort(missing.begin(), missing.end(), isBeforeInStorage);
+        for (const NodeId& nodeId : missing)
+        {
+            if (prefetch && _loaded.size() >= _maxBricks)
+                return;
+
+            const Identifier id = nodeId.getId();
+            if (!_dataCache.get(id))
+                ++statistics.brickReads;
+            ConstDataObjectPtr data =
+                _dataCache.load<DataObject>(id, _dataSource);
+            if (data)
+                _loaded[id] = data;
+        }
+    }
+
+    DataSource _dataSource;
+    CacheT<DataObject> _dataCache;
+    VolumeRendererParameters _params;
+    ClipPlanes _clipPlanes;
+    std::vector<std::unique_ptr<CPURayCastRenderer>> _renderers;
+    size_t _maxBricks; //!< the bricks which fit in the cache memory
+
+    // The referenced bricks are not unloaded by the cache
+    std::unordered_map<Identifier, ConstDataObjectPtr> _loaded;
+};
+
+BatchRenderer::BatchRenderer(const servus::URI& uri,
+                             const VolumeRendererParameters& params,
+                             const size_t nParallelFrames)
+    : _impl(new BatchRenderer::Impl(uri, params, nParallelFrames))
+{
+}
+
+BatchRenderer::~BatchRenderer()
+{
+}
+
+const DataSource& BatchRenderer::getDataSource() const
+{
+    return _impl->_dataSource;
+}
+
+void BatchRenderer::setTransferFunction(
+    const TransferFunction1D& transferFunction)
+{
+    for (auto& renderer : _impl->_renderers)
+        renderer->setTransferFunction(transferFunction);
+}
+
+void BatchRenderer::setClipPlanes(const ClipPlanes& clipPlanes)
+{
+    _impl->_clipPlanes = clipPlanes;
+}
+
+BatchStatistics BatchRenderer::render(const BatchFrames& frames,
+                                      const Frustumf& projection,
+                                      const Vector2ui& size,
+                                      const ImageWriter& writer)
+{
+    return _impl->render(frames, projection, size, writer);
+}
+}
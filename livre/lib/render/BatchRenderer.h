@@ -0,0 +1,127 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _BatchRenderer_h_
+#define _BatchRenderer_h_
+
+#include <livre/lib/api.h>
+#include <livre/lib/types.h>
+
+#include <servus/uri.h>
+
+#include <functional>
+
+namespace livre
+{
+/** A frame of a batch: the camera and the time step of the volume */
+struct BatchFrame
+{
+    Matrix4f modelView;
+    uint32_t timeStep;
+};
+typedef std::vector<BatchFrame> BatchFrames;
+
+/** The statistics of a batch */
+struct BatchStatistics
+{
+    size_t frames = 0;     //!< rendered frames
+    size_t bricks = 0;     //!< distinct bricks of all the frames
+    size_t brickReads = 0; //!< bricks read from the data source
+    float seconds = 0.f;   //!< wall time, from the first selection to the
+                           //!  last written image
+
+    /** @return the throughput of the batch */
+    float getFramesPerHour() const
+    {
+        return seconds > 0.f ? frames * 3600.f / seconds : 0.f;
+    }
+};
+
+/**
+ * The BatchRenderer class renders the images of a sequence of frames known up
+ * front, like the steps of a CameraPath, without a window system.
+ *
+ * The visible bricks of all the frames are selected first. The frames are
+ * then rendered in order, in groups of consecutive frames rendered in parallel
+ * by CPURayCastRenderers, one per frame. While a group renders, the missing
+ * bricks of the next group which fit in the CPU cache memory are read. Before
+ * a group, its remaining missing bricks are read, and the loaded bricks which
+ * are not used again or are used last are released to fit in the CPU cache
+ * memory: each brick is read once if the bricks used between its uses fit. A
+ * frame whose bricks do not fit is rendered with all of them loaded. The
+ * bricks are read in the storage order of the volume: time steps, levels,
+ * then z, y and x. The images are given to the writer by a background thread.
+ */
+class BatchRenderer
+{
+public:
+    /**
+     * Receives the RGBA image of a frame, over a black background with 8 bit
+     * per channel, row by row from the bottom.
+     */
+    typedef std::function<void(size_t index, const std::vector<uint8_t>& rgba)>
+        ImageWriter;
+
+    /**
+     * Constructor
+     * @param uri the URI of the volume
+     * @param params the level of detail, the sampling and the CPU cache memory
+     *        of the rendering
+     * @param nParallelFrames the maximum number of frames rendered in
+     *        parallel, 0 for one per core
+     * @throw std::runtime_error if the data source cannot be created
+     */
+    LIVRE_API BatchRenderer(const servus::URI& uri,
+                            const VolumeRendererParameters& params,
+                            size_t nParallelFrames = 0);
+    LIVRE_API ~BatchRenderer();
+
+    /** @return the data source of the volume */
+    LIVRE_API const DataSource& getDataSource() const;
+
+    /** Sets the transfer function of the frames. */
+    LIVRE_API void setTransferFunction(
+        const TransferFunction1D& transferFunction);
+
+    /** Sets the clip planes of the frames. */
+    LIVRE_API void setClipPlanes(const ClipPlanes& clipPlanes);
+
+    /**
+     * Renders a sequence of frames.
+     * @param frames the cameras and time steps of the frames
+     * @param projection the projection of all the frames
+     * @param size the width and height of the images in pixels
+     * @param writer called with the image of each frame in order, from a
+     *        background thread
+     * @return the statistics of the batch
+     * @throw std::runtime_error if a time step is not in the volume
+     * @throw the exception of a renderer or of the writer, which stops the
+     *        batch
+     */
+    LIVRE_API BatchStatistics render(const BatchFrames& frames,
+                                     const Frustumf& projection,
+                                     const Vector2ui& size,
+                                     const ImageWriter& writer);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> _impl;
+};
+}
+
+#endif // _BatchRenderer_h_
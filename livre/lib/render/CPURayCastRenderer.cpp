@@ -0,0 +1,1185 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <livre/lib/cache/DataObject.h>
+#include <livre/lib/render/CPURayCastRenderer.h>
+
+#include <livre/core/cache/Cache.h>
+#include <livre/core/render/BrickOrder.h>
+#include <livre/core/render/TransferFunction1D.h>
+#include <livre/data/DataSource.h>
+#include <livre/data/Frustum.h>
+#include <livre/data/LODNode.h>
+#include <livre/data/VolumeInformation.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LIVRE_USE_SSE2
+#else
+#include <cstring>
+#endif
+
+namespace livre
+{
+namespace
+{
+// The constants of fragRayCast.glsl and RayCastRenderer
+const float EARLY_EXIT = 0.999f;
+const float EPSILON = 0.0000000001f;
+const uint32_t maxSamplesPerRay = 32;
+const uint32_t minSamplesPerRay = 512;
+const uint32_t minInteractiveSamplesPerRay = 64;
+
+const int tileSize = 32;      // pixels, a multiple of the packet size
+const int packetSize = 4;     // rays traced together, one SSE register
+const int nTilePixels = tileSize * tileSize;
+
+/** The rays of the pixels of a tile, in structure of arrays layout */
+struct TileRays
+{
+    float dir[3][nTilePixels];
+    float invDir[3][nTilePixels];
+    float tNearPlane[nTilePixels];
+};
+
+/** A brick to render, in world and texture space */
+struct Brick
+{
+    Vector3f aabbMin;
+    Vector3f aabbMax;
+    Vector3f textureMin;
+    Vector3f textureMax;
+    Vector3i dataSize;       // voxels of the data, overlap included
+    ConstDataObjectPtr data; // keeps the data of the frame in memory
+    Vector4i screenRect;     // x0, y0, x1, y1 inclusive, in pixels of the view
+};
+
+/** The parameters of a frame, the uniforms of the shader */
+struct FrameParams
+{
+    Vector3f eye;
+    Vector3f globalAABBMin;
+    Vector3f globalAABBMax;
+    std::vector<Vector4f> clipPlanes;
+    float stepSize;
+    float alphaCorrection;
+    float multiplier;
+    float addedValue;
+    Vector3f textureSize; // of the texture of a brick, the maximum block size
+    bool linearFiltering;
+};
+
+/** The transfer function, for linear interpolation clamped to the edges */
+struct TransferFunction
+{
+    Floats rgba[4];
+    size_t size = 0;
+
+    void set(const std::vector<Vector4ub>& lut)
+    {
+        size = std::max(lut.size(), size_t(1));
+        for (size_t i = 0; i < 4; ++i)
+        {
+            rgba[i].assign(size, 0.f); // an empty lut is transparent
+            for (size_t j = 0; j < lut.size(); ++j)
+                rgba[i][j] = float(lut[j][i]) / 255.f;
+        }
+    }
+};
+
+/**
+ * The lanes of a packet of rays, an SSE register on x86 and an array of
+ * floats elsewhere. Masks have all bits of a lane set where true.
+ */
+struct Lanes
+{
+#ifdef LIVRE_USE_SSE2
+    __m128 v;
+#else
+    float v[packetSize];
+#endif
+};
+
+#ifdef LIVRE_USE_SSE2
+inline Lanes load(const float* values)
+{
+    return {_mm_loadu_ps(values)};
+}
+
+inline Lanes splat(const float value)
+{
+    return {_mm_set1_ps(value)};
+}
+
+inline void store(const Lanes& lanes, float* values)
+{
+    _mm_storeu_ps(values, lanes.v);
+}
+
+/** Stores the lanes truncated to integers */
+inline void store(const Lanes& lanes, int32_t* values)
+{
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(values),
+                     _mm_cvttps_epi32(lanes.v));
+}
+
+inline Lanes operator+(const Lanes& a, const Lanes& b)
+{
+    return {_mm_add_ps(a.v, b.v)};
+}
+
+inline Lanes operator-(const Lanes& a, const Lanes& b)
+{
+    return {_mm_sub_ps(a.v, b.v)};
+}
+
+inline Lanes operator*(const Lanes& a, const Lanes& b)
+{
+    return {_mm_mul_ps(a.v, b.v)};
+}
+
+inline Lanes operator/(const Lanes& a, const Lanes& b)
+{
+    return {_mm_div_ps(a.v, b.v)};
+}
+
+/** @return the lanes of b where the mask a is set, zero elsewhere */
+inline Lanes operator&(const Lanes& a, const Lanes& b)
+{
+    return {_mm_and_ps(a.v, b.v)};
+}
+
+inline Lanes minimum(const Lanes& a, const Lanes& b)
+{
+    return {_mm_min_ps(a.v, b.v)};
+}
+
+inline Lanes maximum(const Lanes& a, const Lanes& b)
+{
+    return {_mm_max_ps(a.v, b.v)};
+}
+
+inline Lanes lessEqual(const Lanes& a, const Lanes& b)
+{
+    return {_mm_cmple_ps(a.v, b.v)};
+}
+
+inline Lanes greater(const Lanes& a, const Lanes& b)
+{
+    return {_mm_cmpgt_ps(a.v, b.v)};
+}
+
+/** @return true if any lane of the mask is set */
+inline bool any(const Lanes& mask)
+{
+    return _mm_movemask_ps(mask.v) != 0;
+}
+
+/** std::floor of values below 2^31 */
+inline Lanes floor(const Lanes& lanes)
+{
+    const Lanes truncated = {_mm_cvtepi32_ps(_mm_cvttps_epi32(lanes.v))};
+    return truncated - (greater(truncated, lanes) & splat(1.f));
+}
+#else
+inline Lanes load(const float* values)
+{
+    Lanes lanes;
+    std::copy(values, values + packetSize, lanes.v);
+    return lanes;
+}
+
+inline Lanes splat(const float value)
+{
+    Lanes lanes;
+    std::fill(lanes.v, lanes.v + packetSize, value);
+    return lanes;
+}
+
+inline void store(const Lanes& lanes, float* values)
+{
+    std::copy(lanes.v, lanes.v + packetSize, values);
+}
+
+/** Stores the lanes truncated to integers */
+inline void store(const Lanes& lanes, int32_t* values)
+{
+    for (int l = 0; l < packetSize; ++l)
+        values[l] = int32_t(lanes.v[l]);
+}
+
+template <class Op>
+inline Lanes apply(const Lanes& a, const Lanes& b, const Op& op)
+{
+    Lanes lanes;
+    for (int l = 0; l < packetSize; ++l)
+        lanes.v[l] = op(a.v[l], b.v[l]);
+    return lanes;
+}
+
+inline float toMask(const bool value)
+{
+    uint32_t bits = value ? ~0u : 0u;
+    float mask;
+    std::memcpy(&mask, &bits, sizeof(mask));
+    return mask;
+}
+
+inline Lanes operator+(const Lanes& a, const Lanes& b)
+{
+    return apply(a, b, [](float x, float y) { return x + y; });
+}
+
+inline Lanes operator-(const Lanes& a, const Lanes& b)
+{
+    return apply(a, b, [](float x, float y) { return x - y; });
+}
+
+inline Lanes operator*(const Lanes& a, const Lanes& b)
+{
+    return apply(a, b, [](float x, float y) { return x * y; });
+}
+
+inline Lanes operator/(const Lanes& a, const Lanes& b)
+{
+    return apply(a, b, [](float x, float y) { return x / y; });
+}
+
+/** @return the lanes of b where the mask a is set, zero elsewhere */
+inline Lanes operator&(const Lanes& a, const Lanes& b)
+{
+    return apply(a, b, [](float x, float y) {
+        uint32_t bits[2];
+        std::memcpy(&bits[0], &x, sizeof(x));
+        std::memcpy(&bits[1], &y, sizeof(y));
+        bits[0] &= bits[1];
+        float result;
+        std::memcpy(&result, &bits[0], sizeof(result));
+        return result;
+    });
+}
+
+inline Lanes minimum(const Lanes& a, const Lanes& b)
+{
+    return apply(a, b, [](float x, float y) { return x < y ? x : y; });
+}
+
+inline Lanes maximum(const Lanes& a, const Lanes& b)
+{
+    return apply(a, b, [](float x, float y) { return x > y ? x : y; });
+}
+
+inline Lanes lessEqual(const Lanes& a, const Lanes& b)
+{
+    return apply(a, b, [](float x, float y) { return toMask(x <= y); });
+}
+
+inline Lanes greater(const Lanes& a, const Lanes& b)
+{
+    return apply(a, b, [](float x, float y) { return toMask(x > y); });
+}
+
+/** @return true if any lane of the mask is set */
+inline bool any(const Lanes& mask)
+{
+    for (int l = 0; l < packetSize; ++l)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &mask.v[l], sizeof(bits));
+        if (bits)
+            return true;
+    }
+    return false;
+}
+
+/** std::floor of values below 2^31 */
+inline Lanes floor(const Lanes& lanes)
+{
+    Lanes floored;
+    for (int l = 0; l < packetSize; ++l)
+        floored.v[l] = std::floor(lanes.v[l]);
+    return floored;
+}
+#endif
+
+// GLSL mod()
+inline float glslMod(const float x, const float y)
+{
+    return x - y * std::floor(x / y);
+}
+
+// The AABB-ray intersection of the shader, with the inverse ray direction
+inline bool intersectBox(const Vector3f& origin, const float invDir[3],
+                         const Vector3f& aabbMin, const Vector3f& aabbMax,
+                         float& t0, float& t1)
+{
+    t0 = -std::numeric_limits<float>::max();
+    t1 = std::numeric_limits<float>::max();
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const float tbot = invDir[i] * (aabbMin[i] - origin[i]);
+        const float ttop = invDir[i] * (aabbMax[i] - origin[i]);
+        t0 = std::max(t0, std::min(ttop, tbot));
+        t1 = std::min(t1, std::max(ttop, tbot));
+    }
+    return t0 <= t1;
+}
+
+/**
+ * Samples the data of a brick like the 3D texture of the GPU: the texture has
+ * the maximum block size, the data fills its lower corner.
+ */
+template <class T>
+struct Sampler
+{
+    Sampler(const Brick& brick, const FrameParams& params)
+        : data(static_cast<const T*>(brick.data->getDataPtr()))
+        , maxIndex(brick.dataSize - Vector3i(1))
+        , strideY(brick.dataSize[0])
+        , strideZ(brick.dataSize[0] * brick.dataSize[1])
+        , textureSize(params.textureSize)
+    {
+    }
+
+    inline int clamp(const int index, const size_t axis) const
+    {
+        return std::min(std::max(index, 0), maxIndex[axis]);
+    }
+
+    inline float value(const int x, const int y, const int z) const
+    {
+        return float(data[x + y * strideY + z * strideZ]);
+    }
+
+    // GL_NEAREST with GL_CLAMP_TO_EDGE, for all lanes of a packet
+    inline void nearest(const Lanes texPos[3], float values[packetSize]) const
+    {
+        int32_t voxel[3][packetSize];
+        for (size_t i = 0; i < 3; ++i)
+        {
+            // clamped before the truncation, which then rounds down
+            const Lanes index = texPos[i] * splat(textureSize[i]);
+            store(minimum(maximum(index, splat(0.f)), splat(maxIndex[i])),
+                  voxel[i]);
+        }
+        for (int l = 0; l < packetSize; ++l)
+            values[l] = value(voxel[0][l], voxel[1][l], voxel[2][l]);
+    }
+
+    // GL_LINEAR with GL_CLAMP_TO_EDGE
+    inline float linear(const float u, const float v, const float w) const
+    {
+        const float coords[3] = {u * textureSize[0] - 0.5f,
+                                 v * textureSize[1] - 0.5f,
+                                 w * textureSize[2] - 0.5f};
+        int i0[3];
+        int i1[3];
+        float f[3];
+        for (size_t i = 0; i < 3; ++i)
+        {
+            const float base = std::floor(coords[i]);
+            f[i] = coords[i] - base;
+            i0[i] = clamp(int(base), i);
+            i1[i] = clamp(int(base) + 1, i);
+        }
+
+        const float c00 = value(i0[0], i0[1], i0[2]) * (1.f - f[0]) +
+                          value(i1[0], i0[1], i0[2]) * f[0];
+        const float c10 = value(i0[0], i1[1], i0[2]) * (1.f - f[0]) +
+                          value(i1[0], i1[1], i0[2]) * f[0];
+        const float c01 = value(i0[0], i0[1], i1[2]) * (1.f - f[0]) +
+                          value(i1[0], i0[1], i1[2]) * f[0];
+        const float c11 = value(i0[0], i1[1], i1[2]) * (1.f - f[0]) +
+                          value(i1[0], i1[1], i1[2]) * f[0];
+        const float c0 = c00 * (1.f - f[1]) + c10 * f[1];
+        const float c1 = c01 * (1.f - f[1]) + c11 * f[1];
+        return c0 * (1.f - f[2]) + c1 * f[2];
+    }
+
+    // GL_LINEAR for all lanes of a packet
+    inline void linear(const Lanes texPos[3], float values[packetSize]) const
+    {
+        float coords[3][packetSize];
+        for (size_t i = 0; i < 3; ++i)
+            store(texPos[i], coords[i]);
+        for (int l = 0; l < packetSize; ++l)
+            values[l] = linear(coords[0][l], coords[1][l], coords[2][l]);
+    }
+
+    const T* const data;
+    const Vector3i maxIndex;
+    const int strideY;
+    const int strideZ;
+    const Vector3f textureSize;
+};
+
+/**
+ * Traces a packet of rays through a brick, as fragRayCast.glsl traces the
+ * ray of a fragment. The rays are set up one by one, then sampled and
+ * composited in lockstep in the lanes of SIMD registers, finished lanes are
+ * masked out. The voxels, the transfer function entries and the opacity
+ * correction are computed per lane.
+ */
+template <class T>
+void tracePacket(const Brick& brick, const FrameParams& params,
+                 const TransferFunction& tf, const TileRays& rays,
+                 const int firstRay, const bool valid[packetSize],
+                 float* const pixels[packetSize])
+{
+    float dstInit[4][packetSize];
+    float posInit[3][packetSize];
+    float stepInit[3][packetSize];
+    float travelInit[packetSize];
+    bool anyActive = false;
+
+    for (int l = 0; l < packetSize; ++l)
+    {
+        travelInit[l] = 0.f; // inactive
+        for (size_t i = 0; i < 4; ++i)
+            dstInit[i][l] = valid[l] ? pixels[l][i] : 1.f;
+        for (size_t i = 0; i < 3; ++i)
+            posInit[i][l] = stepInit[i][l] = 0.f;
+        if (!valid[l] || dstInit[3][l] > EARLY_EXIT)
+            continue;
+
+        const int ray = firstRay + l;
+        const float invDir[3] = {rays.invDir[0][ray], rays.invDir[1][ray],
+                                 rays.invDir[2][ray]};
+        const Vector3f dir(rays.dir[0][ray], rays.dir[1][ray],
+                           rays.dir[2][ray]);
+
+        float tnear, tfar;
+        if (!intersectBox(params.eye, invDir, brick.aabbMin, brick.aabbMax,
+                          tnear, tfar))
+        {
+            continue;
+        }
+        float tnearGlobal, tfarGlobal;
+        intersectBox(params.eye, invDir, params.globalAABBMin,
+                     params.globalAABBMax, tnearGlobal, tfarGlobal);
+
+        if (tnear < rays.tNearPlane[ray])
+            tnear = rays.tNearPlane[ray];
+
+        // samples on a grid starting at the volume, the bricks fit seamlessly
+        const float residu = glslMod(tnear - tnearGlobal, params.stepSize);
+        if (residu > 0.f)
+            tnear += params.stepSize - residu;
+
+        if (tnear > tfar)
+            continue;
+
+        for (const Vector4f& plane : params.clipPlanes)
+        {
+            const Vector3f normal(plane[0], plane[1], plane[2]);
+            float rn = dir.dot(normal);
+            if (rn == 0.f)
+                rn = EPSILON;
+            const float t = -(normal.dot(params.eye) + plane[3]) / rn;
+            if (rn > 0.f) // opposite direction plane
+                tnear = std::max(tnear, t);
+            else
+                tfar = std::min(tfar, t);
+        }
+
+        if (tnear > tfar)
+            continue;
+
+        const Vector3f rayStart = params.eye + dir * tnear;
+        const Vector3f rayStop = params.eye + dir * tfar;
+        const float travel = (rayStop - rayStart).length();
+        if (travel <= 0.f)
+            continue;
+
+        const Vector3f rayStep =
+            vmml::normalize(rayStop - rayStart) * params.stepSize;
+        for (size_t i = 0; i < 3; ++i)
+        {
+            posInit[i][l] = rayStart[i];
+            stepInit[i][l] = rayStep[i];
+        }
+        travelInit[l] = travel;
+        anyActive = true;
+    }
+
+    if (!anyActive)
+        return;
+
+    const Sampler<T> sampler(brick, params);
+    Lanes dst[4];
+    Lanes pos[3];
+    Lanes step[3];
+    Lanes aabbMin[3];
+    Lanes aabbSize[3];
+    Lanes textureMin[3];
+    Lanes textureSize[3];
+    for (size_t i = 0; i < 3; ++i)
+    {
+        pos[i] = load(posInit[i]);
+        step[i] = load(stepInit[i]);
+        aabbMin[i] = splat(brick.aabbMin[i]);
+        aabbSize[i] = splat(brick.aabbMax[i] - brick.aabbMin[i]);
+        textureMin[i] = splat(brick.textureMin[i]);
+        textureSize[i] = splat(brick.textureMax[i] - brick.textureMin[i]);
+    }
+    for (size_t i = 0; i < 4; ++i)
+        dst[i] = load(dstInit[i]);
+
+    const Lanes zero = splat(0.f);
+    const Lanes one = splat(1.f);
+    const Lanes stepSize = splat(params.stepSize);
+    const Lanes earlyExit = splat(EARLY_EXIT);
+    const Lanes multiplier = splat(params.multiplier);
+    const Lanes addedValue = splat(params.addedValue);
+    const Lanes tfSize = splat(float(tf.size));
+    const Lanes tfMinIndex = splat(-0.5f);
+    const Lanes tfMaxIndex = splat(float(tf.size) - 0.5f);
+    const Lanes tfLastEntry = splat(float(tf.size - 1));
+    Lanes travel = load(travelInit);
+    Lanes active = greater(travel, zero);
+
+    while (any(active))
+    {
+        // calcTexturePositionFromAABBPos()
+        Lanes texPos[3];
+        for (size_t i = 0; i < 3; ++i)
+            texPos[i] = (pos[i] - aabbMin[i]) / aabbSize[i] * textureSize[i] +
+                        textureMin[i];
+
+        float values[packetSize];
+        if (params.linearFiltering)
+            sampler.linear(texPos, values);
+        else
+            sampler.nearest(texPos, values);
+
+        // transfer function lookup, linear interpolation of the entries
+        const Lanes density = load(values) * multiplier + addedValue;
+        const Lanes index = minimum(
+            tfMaxIndex, maximum(tfMinIndex, density * tfSize - splat(0.5f)));
+        const Lanes base = floor(index);
+        const Lanes f = index - base;
+        int32_t i0[packetSize];
+        int32_t i1[packetSize];
+        store(maximum(base, zero), i0);
+        store(minimum(base + one, tfLastEntry), i1);
+
+        Lanes src[4];
+        for (size_t i = 0; i < 4; ++i)
+        {
+            float entry0[packetSize];
+            float entry1[packetSize];
+            for (int l = 0; l < packetSize; ++l)
+            {
+                entry0[l] = tf.rgba[i][i0[l]];
+                entry1[l] = tf.rgba[i][i1[l]];
+            }
+            src[i] = load(entry0) * (one - f) + load(entry1) * f;
+        }
+
+        // composite, the alpha correction behaves badly around maximum alpha
+        float alphas[packetSize];
+        store(src[3], alphas);
+        for (int l = 0; l < packetSize; ++l)
+            alphas[l] =
+                1.f - std::pow(1.f - std::min(alphas[l], 1.f - 1.f / 256.f),
+                               params.alphaCorrection);
+
+        const Lanes weight = active & (load(alphas) * (one - dst[3]));
+        for (size_t i = 0; i < 3; ++i)
+            dst[i] = dst[i] + src[i] * weight;
+        dst[3] = dst[3] + weight;
+
+        for (size_t i = 0; i < 3; ++i)
+            pos[i] = pos[i] + step[i];
+        travel = travel - stepSize;
+        active = active & lessEqual(dst[3], earlyExit) & greater(travel, zero);
+    }
+
+    for (size_t i = 0; i < 4; ++i)
+        store(dst[i], dstInit[i]);
+    for (int l = 0; l < packetSize; ++l)
+        if (valid[l])
+            for (size_t i = 0; i < 4; ++i)
+                pixels[l][i] = dstInit[i][l];
+}
+
+void traceBrickPacket(const Brick& brick, const FrameParams& params,
+                      const TransferFunction& tf, const TileRays& rays,
+                      const int firstRay, const bool valid[packetSize],
+                      float* const pixels[packetSize], const DataType dataType)
+{
+    switch (dataType)
+    {
+    case DT_UINT8:
+        tracePacket<uint8_t>(brick, params, tf, rays, firstRay, valid, pixels);
+        break;
+    case DT_UINT16:
+        tracePacket<uint16_t>(brick, params, tf, rays, firstRay, valid,
+                              pixels);
+        break;
+    case DT_UINT32:
+        tracePacket<uint32_t>(brick, params, tf, rays, firstRay, valid,
+                              pixels);
+        break;
+    case DT_INT8:
+        tracePacket<int8_t>(brick, params, tf, rays, firstRay, valid, pixels);
+        break;
+    case DT_INT16:
+        tracePacket<int16_t>(brick, params, tf, rays, firstRay, valid, pixels);
+        break;
+    case DT_INT32:
+        tracePacket<int32_t>(brick, params, tf, rays, firstRay, valid, pixels);
+        break;
+    case DT_FLOAT:
+        tracePacket<float>(brick, params, tf, rays, firstRay, valid, pixels);
+        break;
+    case DT_UNDEFINED:
+    default:
+        break;
+    }
+}
+}
+
+/**
+ * The threads which render the tiles of the frames, they live as long as the
+ * renderer and wait for the next frame. The calling thread renders along.
+ */
+class RenderThreads
+{
+public:
+    typedef std::function<void(TileRays&)> Job;
+
+    explicit RenderThreads(const size_t nThreads)
+    {
+        for (size_t i = 0; i < std::max(nThreads, size_t(1)); ++i)
+            _rays.emplace_back(new TileRays);
+        for (size_t i = 1; i < nThreads; ++i)
+            _threads.emplace_back([this, i] { _work(i); });
+    }
+
+    ~RenderThreads()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _started.notify_all();
+        for (std::thread& thread : _threads)
+            thread.join();
+    }
+
+    /**
+     * Runs the job on nThreads threads, the caller included, with the rays of
+     * each thread. Returns once all are done, rethrows the first exception.
+     */
+    void run(const Job& job, const size_t nThreads)
+    {
+        const size_t nJobThreads = std::min(nThreads, _rays.size());
+        if (nJobThreads <= 1)
+        {
+            job(*_rays[0]);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _job = &job;
+            _nJobThreads = nJobThreads;
+            _nBusy = nJobThreads - 1;
+            _error = nullptr;
+            ++_generation;
+        }
+        _started.notify_all();
+
+        std::exception_ptr error;
+        try
+        {
+            job(*_rays[0]);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _finished.wait(lock, [this] { return _nBusy == 0; });
+        _job = nullptr;
+        if (!error)
+            error = _error;
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+private:
+    void _work(const size_t index)
+    {
+        uint64_t generation = 0;
+        for (;;)
+        {
+            const Job* job = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _started.wait(lock, [&] {
+                    return _stopping || _generation != generation;
+                });
+                if (_stopping)
+                    return;
+                generation = _generation;
+                if (index >= _nJobThreads) // not needed for this frame
+                    continue;
+                job = _job;
+            }
+
+            std::exception_ptr error;
+            try
+            {
+                (*job)(*_rays[index]);
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (error && !_error)
+                _error = error;
+            if (--_nBusy == 0)
+                _finished.notify_one();
+        }
+    }
+
+    std::vector<std::unique_ptr<TileRays>> _rays; // of each thread
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _started;
+    std::condition_variable _finished;
+    const Job* _job = nullptr;
+    size_t _nJobThreads = 0;
+    size_t _nBusy = 0;
+    uint64_t _generation = 0;
+    std::exception_ptr _error;
+    bool _stopping = false;
+};
+
+struct CPURayCastRenderer::Impl
+{
+    Impl(const DataSource& dataSource, const Cache& dataCache,
+         const uint32_t samplesPerRay, const size_t nThreads)
+        : _nSamplesPerRay(samplesPerRay)
+        , _computedSamplesPerRay(samplesPerRay)
+        , _nThreads(nThreads > 0
+                        ? nThreads
+                        : std::max(std::thread::hardware_concurrency(), 1u))
+        , _dataCache(dataCache)
+        , _dataSource(dataSource)
+        , _volInfo(dataSource.getVolumeInfo())
+        , _renderThreads(_nThreads)
+    {
+        setTransferFunction(TransferFunction1D());
+    }
+
+    NodeIds order(const NodeIds& bricks, const Frustum& frustum) const
+    {
+        return orderFrontToBack(_dataSource, bricks, frustum);
+    }
+
+    void setTransferFunction(const TransferFunction1D& transferFunction)
+    {
+        _transferFunction.set(transferFunction.getLUT());
+        const auto& range = transferFunction.getRange();
+        _dataSourceRange = {float(range[0]), float(range[1])};
+    }
+
+    Vector2f getDataTypeRange() const
+    {
+        switch (_volInfo.dataType)
+        {
+        case DT_UINT8:
+            return Vector2f(std::numeric_limits<uint8_t>::min(),
+                            std::numeric_limits<uint8_t>::max());
+        case DT_UINT16:
+            return Vector2f(std::numeric_limits<uint16_t>::min(),
+                            std::numeric_limits<uint16_t>::max());
+        case DT_UINT32:
+            return Vector2f(std::numeric_limits<uint32_t>::min(),
+                            std::numeric_limits<uint32_t>::max());
+        case DT_FLOAT:
+            return Vector2f(std::numeric_limits<float>::min(),
+                            std::numeric_limits<float>::max());
+        case DT_INT8:
+            return Vector2f(std::numeric_limits<int8_t>::min(),
+                            std::numeric_limits<int8_t>::max());
+        case DT_INT16:
+            return Vector2f(std::numeric_limits<int16_t>::min(),
+                            std::numeric_limits<int16_t>::max());
+        case DT_INT32:
+            return Vector2f(std::numeric_limits<int32_t>::min(),
+                            std::numeric_limits<int32_t>::max());
+        case DT_UNDEFINED:
+        default:
+            LBTHROW(std::runtime_error("Unsupported type in the renderer."));
+        }
+    }
+
+    void onFrameStart(const Frustum& frustum, const ClipPlanes& planes,
+                      const PixelViewport& view, const NodeIds& renderBricks)
+    {
+        _computedSamplesPerRay = _nSamplesPerRay;
+        if (_nSamplesPerRay == 0) // Find sampling rate
+        {
+            uint32_t maxLOD = 0;
+            for (const NodeId& rb : renderBricks)
+            {
+                const LODNode& lodNode = _dataSource.getNode(rb);
+                maxLOD = std::max(maxLOD, lodNode.getRefLevel());
+            }
+
+            const float maxVoxelDim = _volInfo.voxels.find_max();
+            const float maxVoxelsAtLOD =
+                maxVoxelDim /
+                (float)(1u << (_volInfo.rootNode.getDepth() - maxLOD - 1));
+            // Nyquist limited nb of samples according to voxel size
+            _computedSamplesPerRay =
+                std::max(maxVoxelsAtLOD, (float)minSamplesPerRay);
+        }
+
+        // take fewer samples while interacting, see QualityGovernor
+        if (_quality < 1.0f)
+            _computedSamplesPerRay = std::max(
+                uint32_t(_computedSamplesPerRay * _quality),
+                std::min(_computedSamplesPerRay, minInteractiveSamplesPerRay));
+
+        // use materialLUT data range only if valid, otherwise full data range
+        Vector2f dataSourceRange = getDataTypeRange();
+        if (_dataSourceRange[1] > 0 &&
+            _dataSourceRange[1] - _dataSourceRange[0] > 0)
+        {
+            dataSourceRange = _dataSourceRange;
+        }
+
+        // Because the volume is centered to the origin we can compute the
+        // volume AABB by using the volume total size.
+        const Vector3f halfWorldSize = _volInfo.worldSize / 2.0;
+
+        _params.eye = frustum.getEyePos();
+        _params.globalAABBMin = -halfWorldSize;
+        _params.globalAABBMax = halfWorldSize;
+        _params.clipPlanes.clear();
+        for (const auto& plane : planes.getPlanes())
+        {
+            const float* normal = plane.getNormal();
+            _params.clipPlanes.emplace_back(normal[0], normal[1], normal[2],
+                                            plane.getD());
+        }
+        _params.stepSize = 1.f / float(_computedSamplesPerRay);
+        // http://stackoverflow.com/questions/12494439/opacity-correction-in-raycasting-volume-rendering
+        _params.alphaCorrection =
+            float(maxSamplesPerRay) / float(_computedSamplesPerRay);
+        _params.multiplier = 1.f / (dataSourceRange[1] - dataSourceRange[0]);
+        _params.addedValue = -dataSourceRange[0] /
+                             (dataSourceRange[1] - dataSourceRange[0]);
+        _params.textureSize = _volInfo.maximumBlockSize;
+        _params.linearFiltering = _linearFiltering;
+
+        _width = std::max(view[2], 0);
+        _height = std::max(view[3], 0);
+        _image.assign(size_t(_width) * size_t(_height) * 4, 0.f);
+    }
+
+    /** @return the pixels of the view covered by the projection of a box */
+    Vector4i getScreenRect(const Boxf& box, const Matrix4f& mvp) const
+    {
+        const Vector4i all(0, 0, _width - 1, _height - 1);
+        Vector2f min(std::numeric_limits<float>::max());
+        Vector2f max(-std::numeric_limits<float>::max());
+        for (size_t i = 0; i < 8; ++i)
+        {
+            const Vector4f corner(i & 1 ? box.getMax()[0] : box.getMin()[0],
+                                  i & 2 ? box.getMax()[1] : box.getMin()[1],
+                                  i & 4 ? box.getMax()[2] : box.getMin()[2],
+                                  1.f);
+            const Vector4f clip = mvp * corner;
+            if (clip[3] <= 0.f) // behind the eye, may cover the whole view
+                return all;
+            for (size_t j = 0; j < 2; ++j)
+            {
+                min[j] = std::min(min[j], clip[j] / clip[3]);
+                max[j] = std::max(max[j], clip[j] / clip[3]);
+            }
+        }
+
+        // normalized device coordinates to pixels, conservatively
+        const Vector4i rect(int(std::floor((min[0] + 1.f) * .5f * _width)) - 1,
+                            int(std::floor((min[1] + 1.f) * .5f * _height)) - 1,
+                            int(std::ceil((max[0] + 1.f) * .5f * _width)) + 1,
+                            int(std::ceil((max[1] + 1.f) * .5f * _height)) + 1);
+        return Vector4i(std::max(rect[0], all[0]), std::max(rect[1], all[1]),
+                        std::min(rect[2], all[2]), std::min(rect[3], all[3]));
+    }
+
+    std::vector<Brick> getBricks(const NodeIds& orderedBricks,
+                                 const Frustum& frustum)
+    {
+        const Matrix4f mvp = frustum.getMVPMatrix();
+        const Vector3f& overlap = _volInfo.overlap;
+        const Vector3f& maxSize = _volInfo.maximumBlockSize;
+
+        _visibleNodes.clear();
+        std::vector<Brick> bricks;
+        bricks.reserve(orderedBricks.size());
+        for (const NodeId& nodeId : orderedBricks)
+        {
+            ConstDataObjectPtr data =
+                _dataCache.get<DataObject>(nodeId.getId());
+            if (!data)
+            {
+                LBVERB << "No data for node : " << nodeId << std::endl;
+                continue;
+            }
+
+            const LODNode& lodNode = _dataSource.getNode(nodeId);
+            const Boxf& worldBox = lodNode.getWorldBox();
+            const Vector3f& size = lodNode.getVoxelBox().getSize();
+            const Vector4i rect = getScreenRect(worldBox, mvp);
+            _visibleNodes.push_back(nodeId);
+            if (rect[0] > rect[2] || rect[1] > rect[3])
+                continue;
+
+            Brick brick;
+            brick.aabbMin = worldBox.getMin();
+            brick.aabbMax = worldBox.getMax();
+            brick.textureMin = overlap / maxSize;
+            brick.textureMax = brick.textureMin + size / maxSize;
+            brick.dataSize = lodNode.getBlockSize() + _volInfo.overlap * 2;
+            brick.data = std::move(data);
+            brick.screenRect = rect;
+            bricks.push_back(std::move(brick));
+        }
+        return bricks;
+    }
+
+    /** The rays through the centers of the pixels, as the fragments */
+    void setupRays(const Frustum& frustum, const int x0, const int y0,
+                   TileRays& rays) const
+    {
+        const Matrix4f& invProj = frustum.getInvProjMatrix();
+        const Matrix4f& invMV = frustum.getInvMVMatrix();
+        const float nearPlane = frustum.nearPlane();
+
+        for (int y = 0; y < tileSize; ++y)
+        {
+            for (int x = 0; x < tileSize; ++x)
+            {
+                const Vector4f ndc((x0 + x + .5f) / _width * 2.f - 1.f,
+                                   (y0 + y + .5f) / _height * 2.f - 1.f, -1.f,
+                                   1.f);
+                Vector4f eyePos = invProj * ndc;
+                eyePos /= eyePos[3];
+
+                const Vector4f worldPos = invMV * eyePos;
+                const Vector3f pixelWorldSpacePos(worldPos[0], worldPos[1],
+                                                  worldPos[2]);
+                const Vector3f dir =
+                    vmml::normalize(pixelWorldSpacePos - _params.eye);
+                const Vector3f eyeDir =
+                    vmml::normalize(Vector3f(eyePos[0], eyePos[1], eyePos[2]));
+
+                const int ray = y * tileSize + x;
+                for (size_t i = 0; i < 3; ++i)
+                {
+                    // avoids the division by zero of the inverse direction
+                    const float d = dir[i] == 0.f ? EPSILON : dir[i];
+                    rays.dir[i][ray] = dir[i];
+                    rays.invDir[i][ray] = 1.f / d;
+                }
+                rays.tNearPlane[ray] = -nearPlane / eyeDir[2];
+            }
+        }
+    }
+
+    void renderTile(const std::vector<Brick>& bricks, const Frustum& frustum,
+                    const int tile, const int nTilesX, TileRays& rays)
+    {
+        const int x0 = (tile % nTilesX) * tileSize;
+        const int y0 = (tile / nTilesX) * tileSize;
+        const int x1 = std::min(x0 + tileSize, _width) - 1;
+        const int y1 = std::min(y0 + tileSize, _height) - 1;
+        bool raysReady = false;
+
+        for (const Brick& brick : bricks)
+        {
+            const Vector4i& rect = brick.screenRect;
+            if (rect[0] > x1 || rect[2] < x0 || rect[1] > y1 || rect[3] < y0)
+                continue;
+
+            if (!raysReady)
+            {
+                setupRays(frustum, x0, y0, rays);
+                raysReady = true;
+            }
+
+            for (int y = std::max(y0, rect[1]); y <= std::min(y1, rect[3]);
+                 ++y)
+            {
+                const int first = x0 + (std::max(x0, rect[0]) - x0) /
+                                           packetSize * packetSize;
+                const int last = std::min(x1, rect[2]);
+                for (int x = first; x <= last; x += packetSize)
+                {
+                    bool valid[packetSize];
+                    float* pixels[packetSize];
+                    for (int l = 0; l < packetSize; ++l)
+                    {
+                        valid[l] = x + l <= x1;
+                        const size_t pixel =
+                            size_t(y) * _width + std::min(x + l, x1);
+                        pixels[l] = &_image[pixel * 4];
+                    }
+
+                    const int firstRay = (y - y0) * tileSize + (x - x0);
+                    traceBrickPacket(brick, _params, _transferFunction, rays,
+                                     firstRay, valid, pixels,
+                                     _volInfo.dataType);
+                }
+            }
+        }
+    }
+
+    void onFrameRender(const Frustum& frustum, const NodeIds& orderedBricks)
+    {
+        const std::vector<Brick> bricks = getBricks(orderedBricks, frustum);
+        if (bricks.empty() || _width == 0 || _height == 0)
+            return;
+
+        const int nTilesX = (_width + tileSize - 1) / tileSize;
+        const int nTilesY = (_height + tileSize - 1) / tileSize;
+        const int nTiles = nTilesX * nTilesY;
+        std::atomic<int> nextTile(0);
+
+        _renderThreads.run(
+            [&](TileRays& rays) {
+                for (int tile = nextTile++; tile < nTiles; tile = nextTile++)
+                    renderTile(bricks, frustum, tile, nTilesX, rays);
+            },
+            std::min(_nThreads, size_t(nTiles)));
+    }
+
+    uint32_t _nSamplesPerRay;
+    uint32_t _computedSamplesPerRay;
+    float _quality{1.0f};
+    bool _linearFiltering{false};
+    const size_t _nThreads;
+    TransferFunction _transferFunction;
+    Vector2f _dataSourceRange;
+    FrameParams _params;
+    int _width{0};
+    int _height{0};
+    Floats _image;
+    NodeIds _visibleNodes;
+    const Cache& _dataCache;
+    const DataSource& _dataSource;
+    const VolumeInformation& _volInfo;
+    RenderThreads _renderThreads;
+};
+
+CPURayCastRenderer::CPURayCastRenderer(const DataSource& dataSource,
+                                       const Cache& dataCache,
+                                       const uint32_t samplesPerRay,
+                                       const size_t nThreads)
+    : _impl(new CPURayCastRenderer::Impl(dataSource, dataCache, samplesPerRay,
+                                         nThreads))
+{
+}
+
+CPURayCastRenderer::~CPURayCastRenderer()
+{
+}
+
+void CPURayCastRenderer::setTransferFunction(
+    const TransferFunction1D& transferFunction)
+{
+    _impl->setTransferFunction(transferFunction);
+}
+
+void CPURayCastRenderer::setSamplesPerRay(const uint32_t samplesPerRay)
+{
+    _impl->_nSamplesPerRay = samplesPerRay;
+}
+
+void CPURayCastRenderer::setQuality(const float quality)
+{
+    _impl->_quality = quality;
+}
+
+void CPURayCastRenderer::setLinearFiltering(const bool enable)
+{
+    _impl->_linearFiltering = enable;
+}
+
+const Floats& CPURayCastRenderer::getImage() const
+{
+    return _impl->_image;
+}
+
+std::vector<uint8_t> CPURayCastRenderer::getRGBA8() const
+{
+    const Floats& image = _impl->_image;
+    std::vector<uint8_t> rgba(image.size());
+    for (size_t i = 0; i < image.size(); ++i)
+    {
+        const float value = std::min(1.f, std::max(0.f, image[i]));
+        rgba[i] = uint8_t(value * 255.f + 0.5f);
+    }
+    return rgba;
+}
+
+const NodeIds& CPURayCastRenderer::getVisibleNodes() const
+{
+    return _impl->_visibleNodes;
+}
+
+NodeIds CPURayCastRenderer::order(const NodeIds& bricks,
+                                  const Frustum& frustum) const
+{
+    return _impl->order(bricks, frustum);
+}
+
+void CPURayCastRenderer::_onFrameStart(const Frustum& frustum,
+                                       const ClipPlanes& planes,
+                                       const PixelViewport& view,
+                                       const NodeIds& renderBricks)
+{
+    _impl->onFrameStart(frustum, planes, view, renderBricks);
+}
+
+void CPURayCastRenderer::_onFrameRender(const Frustum& frustum,
+                                        const ClipPlanes&, const PixelViewport&,
+                                        const NodeIds& orderedBricks)
+{
+    _impl->onFrameRender(frustum, orderedBricks);
+}
+}
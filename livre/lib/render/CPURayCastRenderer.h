@@ -0,0 +1,106 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _CPURayCastRenderer_h_
+#define _CPURayCastRenderer_h_
+
+#include <livre/core/render/Renderer.h>
+#include <livre/lib/api.h>
+#include <livre/lib/types.h>
+
+namespace livre
+{
+/**
+ * The CPURayCastRenderer class ray casts the bricks on the CPU, without an
+ * OpenGL context. It samples and composites like the single-pass ray caster
+ * of the RayCastRenderer, front to back with early ray termination, reading
+ * the DataObjects of the bricks from the data cache.
+ *
+ * The image is split in tiles which are rendered in parallel by threads which
+ * live as long as the renderer, the rays of a tile are traced in packets of
+ * neighbouring pixels. The passes of a frame accumulate into the image, which
+ * is cleared on frame start.
+ */
+class CPURayCastRenderer : public Renderer
+{
+public:
+    /**
+     * Constructor
+     * @param dataSource the data source
+     * @param dataCache the source for the cached data of the bricks
+     * @param samplesPerRay Number of samples per ray, 0 to compute it from
+     *        the resolution of the rendered bricks.
+     * @param nThreads the number of rendering threads, 0 for one per core
+     */
+    LIVRE_API CPURayCastRenderer(const DataSource& dataSource,
+                                 const Cache& dataCache,
+                                 uint32_t samplesPerRay, size_t nThreads = 0);
+    LIVRE_API ~CPURayCastRenderer();
+
+    /** Sets the transfer function and its range of data values. */
+    LIVRE_API void setTransferFunction(
+        const TransferFunction1D& transferFunction);
+
+    /** Sets the number of samples per ray, 0 for automatic. */
+    LIVRE_API void setSamplesPerRay(uint32_t samplesPerRay);
+
+    /** Sets the interaction quality, see QualityGovernor. */
+    LIVRE_API void setQuality(float quality);
+
+    /** Enables the trilinear interpolation of the data. */
+    LIVRE_API void setLinearFiltering(bool enable);
+
+    /**
+     * @return the RGBA image of the last frame, with the colors multiplied by
+     *         the opacity, row by row from the bottom of the viewport
+     */
+    LIVRE_API const Floats& getImage() const;
+
+    /**
+     * @return the image of the last frame over a black background, 8 bit per
+     *         channel, in the row order of getImage()
+     */
+    LIVRE_API std::vector<uint8_t> getRGBA8() const;
+
+    /** @internal @return the bricks rendered in the last render() pass */
+    LIVRE_API const NodeIds& getVisibleNodes() const;
+
+    /**
+     * @copydoc Renderer::order
+     */
+    LIVRE_API NodeIds order(const NodeIds& bricks,
+                            const Frustum& frustum) const final;
+
+protected:
+    LIVRE_API void _onFrameStart(const Frustum& frustum,
+                                 const ClipPlanes& planes,
+                                 const PixelViewport& view,
+                                 const NodeIds& renderBricks) override;
+
+    LIVRE_API void _onFrameRender(const Frustum& frustum,
+                                  const ClipPlanes& planes,
+                                  const PixelViewport& view,
+                                  const NodeIds& orderedBricks) final;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> _impl;
+};
+}
+
+#endif // _CPURayCastRenderer_h_
@@ -0,0 +1,182 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <livre/lib/cache/DataObject.h>
+#include <livre/lib/configuration/VolumeRendererParameters.h>
+#include <livre/lib/render/CPURayCastRenderer.h>
+#include <livre/lib/render/HeadlessRenderer.h>
+
+#include <livre/core/cache/Cache.h>
+#include <livre/core/render/TransferFunction1D.h>
+#include <livre/data/DFSTraversal.h>
+#include <livre/data/DataSource.h>
+#include <livre/data/SelectVisibles.h>
+#include <livre/data/VolumeInformation.h>
+
+namespace livre
+{
+struct HeadlessRenderer::Impl
+{
+    Impl(const servus::URI& uri, const VolumeRendererParameters& params,
+         const size_t nThreads)
+        : _dataSource(uri)
+        , _dataCache("DataCache", params.getMaxCpuCacheMemory() * LB_1MB)
+        , _renderer(_dataSource, _dataCache, params.getSamplesPerRay(),
+                    nThreads)
+    {
+        _renderer.setTransferFunction(TransferFunction1D());
+        setParameters(params);
+    }
+
+    void setParameters(const VolumeRendererParameters& params)
+    {
+        _params = params;
+        _renderer.setSamplesPerRay(params.getSamplesPerRay());
+        _renderer.setQuality(params.getInteractionQuality());
+        _renderer.setLinearFiltering(params.getLinearFiltering());
+    }
+
+    const Floats& render(const Frustum& frustum, const uint32_t frame,
+                         const Vector2ui& size)
+    {
+        const VolumeInformation& volInfo = _dataSource.getVolumeInfo();
+        if (frame < volInfo.frameRange[0] || frame >= volInfo.frameRange[1])
+            LBTHROW(std::runtime_error("Frame " + std::to_string(frame) +
+                                       " is not in the volume"));
+
+        const PixelViewport view(0, 0, size[0], size[1]);
+        const NodeIds ordered = _renderer.order(select(frustum, frame, size),
+                                                frustum);
+        _renderedNodes.clear();
+        _renderer.render(frustum, _clipPlanes, view, ordered,
+                         RENDER_BEGIN | RENDER_ORDERED);
+
+        // The loaded bricks of a pass are referenced until it is rendered, so
+        // the cache does not unload them; a new pass starts when the next
+        // brick overflows the cache memory, like the synchronous mode of the
+        // RenderPipeline with the GPU cache.
+        const size_t maxMemory = _params.getMaxCpuCacheMemory() * LB_1MB;
+        std::vector<ConstDataObjectPtr> loaded;
+        NodeIds pass;
+        size_t passMemory = 0;
+        for (const NodeId& nodeId : ordered)
+        {
+            ConstDataObjectPtr data =
+                _dataCache.load<DataObject>(nodeId.getId(), _dataSource);
+            if (!data)
+                continue;
+
+            if (!pass.empty() && passMemory + data->getSize() > maxMemory)
+            {
+                renderPass(frustum, view, pass);
+                loaded.clear();
+                pass.clear();
+                passMemory = 0;
+            }
+            passMemory += data->getSize();
+            loaded.push_back(data);
+            pass.push_back(nodeId);
+        }
+        if (!pass.empty())
+            renderPass(frustum, view, pass);
+
+        _renderer.render(frustum, _clipPlanes, view, NodeIds(),
+                         RENDER_END | RENDER_ORDERED);
+        return _renderer.getImage();
+    }
+
+    NodeIds select(const Frustum& frustum, const uint32_t frame,
+                   const Vector2ui& size) const
+    {
+        const Range fullRange = {{0.f, 1.f}};
+        SelectVisibles visitor(_dataSource, frustum, size[1],
+                               _params.getScreenSpaceError(),
+                               _params.getMinLod(), _params.getMaxLod(),
+                               fullRange, _clipPlanes);
+
+        DFSTraversal traverser;
+        traverser.traverse(_dataSource.getVolumeInfo().rootNode, visitor,
+                           frame);
+        return visitor.takeVisibles();
+    }
+
+    void renderPass(const Frustum& frustum, const PixelViewport& view,
+                    const NodeIds& pass)
+    {
+        _renderer.render(frustum, _clipPlanes, view, pass,
+                         RENDER_FRAME | RENDER_ORDERED);
+        _renderedNodes.insert(_renderedNodes.end(), pass.begin(), pass.end());
+    }
+
+    DataSource _dataSource;
+    CacheT<DataObject> _dataCache;
+    CPURayCastRenderer _renderer;
+    VolumeRendererParameters _params;
+    ClipPlanes _clipPlanes;
+    NodeIds _renderedNodes;
+};
+
+HeadlessRenderer::HeadlessRenderer(const servus::URI& uri,
+                                   const VolumeRendererParameters& params,
+                                   const size_t nThreads)
+    : _impl(new HeadlessRenderer::Impl(uri, params, nThreads))
+{
+}
+
+HeadlessRenderer::~HeadlessRenderer()
+{
+}
+
+const DataSource& HeadlessRenderer::getDataSource() const
+{
+    return _impl->_dataSource;
+}
+
+void HeadlessRenderer::setParameters(const VolumeRendererParameters& params)
+{
+    _impl->setParameters(params);
+}
+
+void HeadlessRenderer::setTransferFunction(
+    const TransferFunction1D& transferFunction)
+{
+    _impl->_renderer.setTransferFunction(transferFunction);
+}
+
+void HeadlessRenderer::setClipPlanes(const ClipPlanes& clipPlanes)
+{
+    _impl->_clipPlanes = clipPlanes;
+}
+
+const Floats& HeadlessRenderer::render(const Frustum& frustum,
+                                       const uint32_t frame,
+                                       const Vector2ui& size)
+{
+    return _impl->render(frustum, frame, size);
+}
+
+std::vector<uint8_t> HeadlessRenderer::getRGBA8() const
+{
+    return _impl->_renderer.getRGBA8();
+}
+
+const NodeIds& HeadlessRenderer::getRenderedNodes() const
+{
+    return _impl->_renderedNodes;
+}
+}
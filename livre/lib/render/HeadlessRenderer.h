@@ -0,0 +1,93 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _HeadlessRenderer_h_
+#define _HeadlessRenderer_h_
+
+#include <livre/lib/api.h>
+#include <livre/lib/types.h>
+
+#include <servus/uri.h>
+
+namespace livre
+{
+/**
+ * The HeadlessRenderer class renders images of a volume without a window
+ * system, an OpenGL context or an Equalizer configuration. Each render() call
+ * selects the visible bricks of the frame, loads their data synchronously and
+ * ray casts them with the CPURayCastRenderer.
+ *
+ * The bricks of a frame are loaded and rendered in passes which fit in the
+ * CPU cache memory of the parameters, in the front to back order of the
+ * renderer.
+ */
+class HeadlessRenderer
+{
+public:
+    /**
+     * Constructor
+     * @param uri the URI of the volume
+     * @param params the level of detail, the sampling and the CPU cache memory
+     *        of the rendering
+     * @param nThreads the number of rendering threads, 0 for one per core
+     * @throw std::runtime_error if the data source cannot be created
+     */
+    LIVRE_API HeadlessRenderer(const servus::URI& uri,
+                               const VolumeRendererParameters& params,
+                               size_t nThreads = 0);
+    LIVRE_API ~HeadlessRenderer();
+
+    /** @return the data source of the volume */
+    LIVRE_API const DataSource& getDataSource() const;
+
+    /** Sets the level of detail and the sampling of the next frames. */
+    LIVRE_API void setParameters(const VolumeRendererParameters& params);
+
+    /** Sets the transfer function of the next frames. */
+    LIVRE_API void setTransferFunction(
+        const TransferFunction1D& transferFunction);
+
+    /** Sets the clip planes of the next frames. */
+    LIVRE_API void setClipPlanes(const ClipPlanes& clipPlanes);
+
+    /**
+     * Renders a frame of the volume.
+     * @param frustum the camera, with the model view and projection matrices
+     * @param frame the time step of the volume
+     * @param size the width and height of the image in pixels
+     * @return the RGBA image, with the colors multiplied by the opacity, row
+     *         by row from the bottom; valid until the next render()
+     * @throw std::runtime_error if the frame is not in the frame range of the
+     *        volume
+     */
+    LIVRE_API const Floats& render(const Frustum& frustum, uint32_t frame,
+                                   const Vector2ui& size);
+
+    /** @copydoc CPURayCastRenderer::getRGBA8 */
+    LIVRE_API std::vector<uint8_t> getRGBA8() const;
+
+    /** @return the bricks of the last rendered image */
+    LIVRE_API const NodeIds& getRenderedNodes() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> _impl;
+};
+}
+
+#endif // _HeadlessRenderer_h_
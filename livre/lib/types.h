@@ -25,6 +25,9 @@
 
 namespace livre
 {
+class CPURayCastRenderer;
+class BatchRenderer;
+class HeadlessRenderer;
 class HistogramObject;
 class RenderPipeline;
 class DataObject;
@@ -37,6 +40,13 @@ typedef std::shared_ptr<const DataObject> ConstDataObjectPtr;
 typedef std::shared_ptr<const TextureObject> ConstTextureObjectPtr;
 typedef std::shared_ptr<const HistogramObject> ConstHistogramObjectPtr;
 
+/** The algorithm rendering the bricks */
+enum RendererType
+{
+    RENDERER_GL = 0u, //!< Ray casting of the textures on the GPU
+    RENDERER_CPU = 1u //!< Ray casting of the data on the CPU
+};
+
 template <class T>
 inline void addOption(options_description& set, const std::string& shortDesc,
                       const std::string& longDesc, const T defaultValue)
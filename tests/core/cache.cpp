@@ -26,6 +26,28 @@
 #include <livre/core/cache/Cache.h>
 #include <livre/core/cache/CacheStatistics.h>
 
+namespace
+{
+/** Holds one of a limited number of slots, like a brick in a texture atlas */
+class SlotCacheObject : public livre::CacheObject
+{
+public:
+    SlotCacheObject(const livre::CacheId& cacheId, size_t& freeSlots)
+        : livre::CacheObject(cacheId)
+        , _freeSlots(freeSlots)
+    {
+        if (_freeSlots == 0)
+            LBTHROW(livre::CacheLoadException(cacheId, "No free slot"));
+        --_freeSlots;
+    }
+
+    ~SlotCacheObject() { ++_freeSlots; }
+    size_t getSize() const final { return test::OBJECT_SIZE; }
+private:
+    size_t& _freeSlots;
+};
+}
+
 BOOST_AUTO_TEST_CASE(testCache)
 {
     const size_t maxMemBytes = 2048u;
@@ -76,3 +98,31 @@ BOOST_AUTO_TEST_CASE(testCache)
     BOOST_CHECK_EQUAL(cache.getCount(), 0);
     BOOST_CHECK_EQUAL(cache.getStatistics().getUsedMemory(), 0);
 }
+
+BOOST_AUTO_TEST_CASE(testCacheEvictsBeforeLoad)
+{
+    size_t freeSlots = 2;
+    livre::CacheT<SlotCacheObject> cache("Slot Cache", 2 * test::OBJECT_SIZE);
+
+    livre::ConstCacheObjectPtr first =
+        cache.load<SlotCacheObject>(1, freeSlots);
+    livre::ConstCacheObjectPtr second =
+        cache.load<SlotCacheObject>(2, freeSlots);
+    BOOST_CHECK(first);
+    BOOST_CHECK(second);
+    BOOST_CHECK_EQUAL(freeSlots, 0);
+
+    // All the slots are referenced, the cache is full and cannot evict
+    BOOST_CHECK(!cache.load<SlotCacheObject>(3, freeSlots));
+    BOOST_CHECK_EQUAL(cache.getCount(), 2);
+
+    // Once released, the least recently used object gives its slot to the
+    // next object
+    first.reset();
+    second.reset();
+    livre::ConstCacheObjectPtr third =
+        cache.load<SlotCacheObject>(3, freeSlots);
+    BOOST_CHECK(third);
+    BOOST_CHECK(!cache.get(1));
+    BOOST_CHECK_EQUAL(third->getId(), 3);
+}
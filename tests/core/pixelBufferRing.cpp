@@ -0,0 +1,157 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define BOOST_TEST_MODULE PixelBufferRing
+
+#include "render/OffscreenContext.h"
+
+#include <livre/core/render/PixelBufferRing.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#define glewGetContext() livre::GLContext::getCurrent()->glewGetContext()
+
+// The bricks are uploaded side by side in x into a texture of bytes, through
+// fewer buffers than bricks so the ring wraps around
+namespace
+{
+const uint32_t brickSize = 32;
+const size_t brickMemory = brickSize * brickSize * brickSize;
+const uint32_t nBricks = 8;
+const size_t nBuffers = 3;
+const size_t nBenchmarkBricks = 1024;
+
+class Texture
+{
+public:
+    Texture()
+    {
+        glGenTextures(1, &_name);
+        glBindTexture(GL_TEXTURE_3D, _name);
+        glTexImage3D(GL_TEXTURE_3D, 0, GL_R8UI, nBricks * brickSize,
+                     brickSize, brickSize, 0, GL_RED_INTEGER,
+                     GL_UNSIGNED_BYTE, nullptr);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    }
+
+    ~Texture() { glDeleteTextures(1, &_name); }
+    /** Uploads a brick like the TexturePool, directly if the ring fails. */
+    bool upload(livre::PixelBufferRing* ring, const uint32_t brick,
+                const std::vector<uint8_t>& data)
+    {
+        const livre::Vector3ui offset(brick * brickSize, 0, 0);
+        const livre::Vector3ui size(brickSize);
+        if (ring && ring->upload(offset, size, GL_RED_INTEGER,
+                                 GL_UNSIGNED_BYTE, data.data(), data.size()))
+        {
+            return true;
+        }
+
+        glTexSubImage3D(GL_TEXTURE_3D, 0, offset[0], offset[1], offset[2],
+                        size[0], size[1], size[2], GL_RED_INTEGER,
+                        GL_UNSIGNED_BYTE, data.data());
+        return false;
+    }
+
+    std::vector<uint8_t> read() const
+    {
+        std::vector<uint8_t> voxels(nBricks * brickMemory);
+        glGetTexImage(GL_TEXTURE_3D, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE,
+                      voxels.data());
+        return voxels;
+    }
+
+private:
+    GLuint _name;
+};
+
+/** @return the upload bandwidth in MB/s, with or without pixel buffers */
+double measure(Texture& texture, livre::PixelBufferRing* ring)
+{
+    const std::vector<uint8_t> data(brickMemory, 42);
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < nBenchmarkBricks; ++i)
+        texture.upload(ring, uint32_t(i % nBricks), data);
+    glFinish();
+
+    const std::chrono::duration<double> time =
+        std::chrono::steady_clock::now() - start;
+    return nBenchmarkBricks * brickMemory / time.count() / (1 << 20);
+}
+}
+
+BOOST_AUTO_TEST_CASE(uploadAndReadBack)
+{
+    const test::OffscreenContext context;
+    if (!context.isValid() || !livre::PixelBufferRing::isSupported())
+    {
+        BOOST_TEST_MESSAGE("No pixel buffers, skipping the upload");
+        return;
+    }
+
+    Texture texture;
+    livre::PixelBufferRing ring(brickMemory, nBuffers);
+    size_t ringUploads = 0;
+    for (uint32_t i = 0; i < nBricks; ++i)
+    {
+        const std::vector<uint8_t> data(brickMemory, uint8_t(i + 1));
+        if (texture.upload(&ring, i, data))
+            ++ringUploads;
+    }
+    BOOST_CHECK_EQUAL(glGetError(), GL_NO_ERROR);
+    BOOST_CHECK_GT(ringUploads, 0);
+
+    const std::vector<uint8_t> voxels = texture.read();
+    for (size_t i = 0; i < voxels.size(); ++i)
+        if (voxels[i] != (i % (nBricks * brickSize)) / brickSize + 1)
+            BOOST_FAIL("Wrong voxel at " << i << ": " << int(voxels[i]));
+
+    // Too large for a buffer, the data is left to the caller
+    const std::vector<uint8_t> data(brickMemory + 1);
+    BOOST_CHECK(!ring.upload(livre::Vector3ui(0), livre::Vector3ui(brickSize),
+                             GL_RED_INTEGER, GL_UNSIGNED_BYTE, data.data(),
+                             data.size()));
+    BOOST_CHECK_EQUAL(glGetError(), GL_NO_ERROR);
+}
+
+BOOST_AUTO_TEST_CASE(uploadBandwidth)
+{
+    const test::OffscreenContext context;
+    if (!context.isValid() || !livre::PixelBufferRing::isSupported())
+    {
+        BOOST_TEST_MESSAGE("No pixel buffers, skipping the benchmark");
+        return;
+    }
+
+    Texture texture;
+    livre::PixelBufferRing ring(brickMemory, nBuffers);
+    const double direct = measure(texture, nullptr);
+    const double pixelBuffers = measure(texture, &ring);
+
+    std::cout << "Upload bandwidth of " << brickMemory / 1024 << " KB bricks"
+              << std::endl
+              << "  direct: " << direct << " MB/s" << std::endl
+              << "  pixel buffer ring: " << pixelBuffers << " MB/s"
+              << std::endl;
+    BOOST_CHECK_EQUAL(glGetError(), GL_NO_ERROR);
+}
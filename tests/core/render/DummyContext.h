@@ -0,0 +1,46 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _DummyContext_h_
+#define _DummyContext_h_
+
+#include <livre/core/render/GLContext.h>
+
+namespace test
+{
+/**
+ * A GLContext without OpenGL, for the threads of the tests which do not
+ * render, e.g. the Workers of a pipeline.
+ */
+class DummyContext : public livre::GLContext
+{
+public:
+    DummyContext()
+        : livre::GLContext(nullptr)
+    {
+    }
+
+private:
+    livre::GLContextPtr clone() const final
+    {
+        return livre::GLContextPtr(new DummyContext);
+    }
+};
+}
+
+#endif // _DummyContext_h_
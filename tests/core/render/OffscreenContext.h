@@ -0,0 +1,135 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OffscreenContext_h_
+#define _OffscreenContext_h_
+
+#include <livre/core/render/GLContext.h>
+
+#include <eq/gl.h>
+#ifdef LIVRE_USE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+namespace test
+{
+/**
+ * A current OpenGL context of a pbuffer, e.g. of Mesa's llvmpipe, for the
+ * tests of the GL code. Without a display it uses the surfaceless platform of
+ * Mesa. The tests skip their GL checks if isValid() is false, i.e. without
+ * EGL or without an OpenGL driver.
+ */
+class OffscreenContext : public livre::GLContext
+{
+public:
+    OffscreenContext()
+        : livre::GLContext(&_glewContext)
+        , _isValid(false)
+    {
+#ifdef LIVRE_USE_EGL
+        _display = EGL_NO_DISPLAY;
+        _surface = EGL_NO_SURFACE;
+        _context = EGL_NO_CONTEXT;
+        _isValid = _create() && glewContextInit(&_glewContext) == GLEW_OK;
+#endif
+    }
+
+    ~OffscreenContext()
+    {
+        doneCurrent();
+#ifdef LIVRE_USE_EGL
+        if (_display == EGL_NO_DISPLAY)
+            return;
+
+        eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                       EGL_NO_CONTEXT);
+        if (_context != EGL_NO_CONTEXT)
+            eglDestroyContext(_display, _context);
+        if (_surface != EGL_NO_SURFACE)
+            eglDestroySurface(_display, _surface);
+        eglTerminate(_display);
+#endif
+    }
+
+    /** @return true if the context is current and GLEW is initialized. */
+    bool isValid() const { return _isValid; }
+private:
+    GLEWContext _glewContext;
+    bool _isValid;
+
+    livre::GLContextPtr clone() const final { return livre::GLContextPtr(); }
+#ifdef LIVRE_USE_EGL
+    EGLDisplay _display;
+    EGLSurface _surface;
+    EGLContext _context;
+
+    bool _create()
+    {
+        if (!_initialize(eglGetDisplay(EGL_DEFAULT_DISPLAY)) &&
+            !_initialize(_getSurfacelessDisplay()))
+        {
+            return false;
+        }
+
+        const EGLint configAttributes[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                                           EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                                           EGL_NONE};
+        EGLConfig config;
+        EGLint nConfigs = 0;
+        if (!eglBindAPI(EGL_OPENGL_API) ||
+            !eglChooseConfig(_display, configAttributes, &config, 1,
+                             &nConfigs) ||
+            nConfigs == 0)
+        {
+            return false;
+        }
+
+        const EGLint surfaceAttributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1,
+                                            EGL_NONE};
+        _surface = eglCreatePbufferSurface(_display, config, surfaceAttributes);
+        _context = eglCreateContext(_display, config, EGL_NO_CONTEXT, nullptr);
+        return _surface != EGL_NO_SURFACE && _context != EGL_NO_CONTEXT &&
+               eglMakeCurrent(_display, _surface, _surface, _context);
+    }
+
+    bool _initialize(const EGLDisplay display)
+    {
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, 0, 0))
+            return false;
+        _display = display;
+        return true;
+    }
+
+    static EGLDisplay _getSurfacelessDisplay()
+    {
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+        const auto getPlatformDisplay =
+            reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+                eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (getPlatformDisplay)
+            return getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                                      EGL_DEFAULT_DISPLAY, nullptr);
+#endif
+        return EGL_NO_DISPLAY;
+    }
+#endif
+};
+}
+
+#endif // _OffscreenContext_h_
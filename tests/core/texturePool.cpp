@@ -0,0 +1,139 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define BOOST_TEST_MODULE TexturePool
+
+#include "render/OffscreenContext.h"
+
+#include <livre/core/render/TexturePool.h>
+#include <livre/core/render/TextureState.h>
+#include <livre/data/DataSource.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <vector>
+
+#define glewGetContext() livre::GLContext::getCurrent()->glewGetContext()
+
+// The layout of the atlas needs no GL context, the pages are allocated on use.
+// The bricks of the volume are 40^3 bytes, 32 voxels and an overlap of 4.
+namespace
+{
+const size_t slotMemory = 40 * 40 * 40;
+}
+
+BOOST_AUTO_TEST_CASE(noAtlas)
+{
+    const livre::DataSource dataSource(
+        lunchbox::URI("mem://#256,256,256,32"));
+    const livre::TexturePool pool(dataSource);
+
+    BOOST_CHECK_EQUAL(pool.getTextureSize(), livre::Vector3ui(40));
+    BOOST_CHECK_EQUAL(pool.getMaxSlots(), 0);
+    BOOST_CHECK_EQUAL(pool.getAtlasMemory(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(atlasLayout)
+{
+    const livre::DataSource dataSource(
+        lunchbox::URI("mem://#256,256,256,32"));
+
+    // one page: a full row of 51 bricks in x, the slots of 64 MB fill 20 rows
+    const size_t smallAtlas = size_t(64) << 20;
+    const livre::TexturePool small(dataSource, smallAtlas);
+    BOOST_CHECK_EQUAL(small.getTextureSize(), livre::Vector3ui(2040, 800, 40));
+    BOOST_CHECK_EQUAL(small.getMaxSlots(), 51 * 20);
+    BOOST_CHECK_EQUAL(small.getAtlasMemory(), 51 * 20 * slotMemory);
+
+    // pages of at most 1 GB, the atlas memory is rounded down to whole pages
+    const size_t largeAtlas = size_t(4) << 30;
+    const livre::TexturePool large(dataSource, largeAtlas);
+    const livre::Vector3ui& pageSize = large.getTextureSize();
+    BOOST_CHECK_EQUAL(pageSize, livre::Vector3ui(2040, 2040, 240));
+    BOOST_CHECK_LE(pageSize.product(), size_t(1) << 30);
+    BOOST_CHECK_EQUAL(large.getMaxSlots(), 4 * 51 * 51 * 6);
+    BOOST_CHECK_LE(large.getAtlasMemory(), largeAtlas);
+    BOOST_CHECK_GT(large.getAtlasMemory(), largeAtlas - pageSize.product());
+}
+
+BOOST_AUTO_TEST_CASE(atlasTooSmall)
+{
+    const livre::DataSource dataSource(
+        lunchbox::URI("mem://#256,256,256,32"));
+    BOOST_CHECK_THROW(livre::TexturePool(dataSource, slotMemory - 1),
+                      std::runtime_error);
+
+    const livre::TexturePool pool(dataSource, slotMemory);
+    BOOST_CHECK_EQUAL(pool.getTextureSize(), livre::Vector3ui(40));
+    BOOST_CHECK_EQUAL(pool.getMaxSlots(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(atlasUpload)
+{
+    const test::OffscreenContext context;
+    if (!context.isValid())
+    {
+        BOOST_TEST_MESSAGE("No OpenGL context, skipping the atlas upload");
+        return;
+    }
+
+    const livre::DataSource dataSource(
+        lunchbox::URI("mem://#256,256,256,32"));
+    livre::TexturePool pool(dataSource, 3 * slotMemory);
+    BOOST_CHECK_EQUAL(pool.getTextureSize(), livre::Vector3ui(120, 40, 40));
+
+    // The slots of the only page, then none is left
+    std::unique_ptr<livre::TextureState> states[3];
+    for (size_t i = 0; i < 3; ++i)
+    {
+        states[i].reset(new livre::TextureState(pool));
+        BOOST_REQUIRE_NE(states[i]->textureId, livre::INVALID_TEXTURE_ID);
+        BOOST_CHECK_EQUAL(states[i]->textureId, states[0]->textureId);
+        BOOST_CHECK_EQUAL(states[i]->textureOffset,
+                          livre::Vector3ui(i * 40, 0, 0));
+
+        const std::vector<uint8_t> brick(slotMemory, uint8_t(i + 1));
+        BOOST_CHECK(
+            pool.upload(*states[i], livre::Vector3ui(40), brick.data()));
+    }
+    BOOST_CHECK_EQUAL(livre::TextureState(pool).textureId,
+                      livre::INVALID_TEXTURE_ID);
+
+    // Each brick is in its slot of the page
+    std::vector<uint8_t> page(3 * slotMemory);
+    states[0]->bind();
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_3D, 0, pool.getFormat(), pool.getTextureType(),
+                  page.data());
+    BOOST_CHECK_EQUAL(glGetError(), GL_NO_ERROR);
+    for (size_t i = 0; i < page.size(); ++i)
+        if (page[i] != (i % 120) / 40 + 1)
+            BOOST_FAIL("Wrong voxel at " << i << ": " << int(page[i]));
+
+    // A finished upload needs one more bind to be seen, then none
+    glFinish();
+    BOOST_CHECK_EQUAL(states[0]->waitUpload(), bool(GLEW_ARB_sync));
+    BOOST_CHECK(!states[0]->waitUpload());
+
+    // A released slot is reused
+    states[1].reset();
+    const livre::TextureState state(pool);
+    BOOST_CHECK_EQUAL(state.textureId, states[0]->textureId);
+    BOOST_CHECK_EQUAL(state.textureOffset, livre::Vector3ui(40, 0, 0));
+}
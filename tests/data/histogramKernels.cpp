@@ -0,0 +1,308 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define BOOST_TEST_MODULE HistogramKernels
+
+#include <livre/data/HistogramKernels.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <limits>
+#include <map>
+#include <random>
+
+namespace
+{
+const livre::Vector3ui blockSize(24);
+const uint64_t scaleFactor = 8;
+
+struct Histogram
+{
+    float min;
+    float max;
+    std::vector<uint64_t> bins;
+};
+
+/** The initial histogram of a brick in HistogramObject */
+template <class T>
+Histogram makeHistogram()
+{
+    switch (sizeof(T))
+    {
+    case 1:
+        return {float(std::numeric_limits<T>::min()),
+                float(std::numeric_limits<T>::max()),
+                std::vector<uint64_t>(256)};
+    case 2:
+        return {float(std::numeric_limits<T>::max()),
+                float(std::numeric_limits<T>::min()),
+                std::vector<uint64_t>(1024)};
+    default:
+        return {float(std::numeric_limits<T>::max()),
+                float(std::numeric_limits<T>::min()),
+                std::vector<uint64_t>(4096)};
+    }
+}
+
+template <>
+Histogram makeHistogram<float>()
+{
+    return {0.f, 1.f, std::vector<uint64_t>(256)};
+}
+
+// The former HistogramObject implementation, used for padded bricks and for
+// 32 bit and float types. It iterates on x as the slowest dimension, which is
+// equivalent for cubic bricks.
+template <class SRC_TYPE>
+void binDataSlow(const SRC_TYPE* rawData, Histogram& histogram,
+                 const livre::Vector3ui& blockSize,
+                 const livre::Vector3ui& padding, const uint64_t scaleFactor)
+{
+    std::map<SRC_TYPE, size_t> values;
+    const livre::Vector3ui dataBlockSize = blockSize + padding * 2;
+    for (size_t i = padding.x(); i < dataBlockSize.x() - padding.x(); ++i)
+        for (size_t j = padding.y(); j < dataBlockSize.y() - padding.y(); ++j)
+            for (size_t k = padding.z(); k < dataBlockSize.z() - padding.z();
+                 ++k)
+            {
+                const size_t index = i * dataBlockSize.y() * dataBlockSize.z() +
+                                     j * dataBlockSize.z() + k;
+                const SRC_TYPE data = rawData[index];
+                ++values[data];
+            }
+
+    const float minVal = std::min(float(values.begin()->first), histogram.min);
+    const float maxVal = std::max(float(values.rbegin()->first), histogram.max);
+    const float range = maxVal - minVal;
+
+    histogram.min = minVal;
+    histogram.max = maxVal;
+
+    if (range == 0.0f)
+    {
+        histogram.bins.clear();
+        const size_t bins = blockSize.product() * scaleFactor;
+        histogram.bins.push_back(bins);
+        return;
+    }
+
+    const size_t binCount = histogram.bins.size();
+    uint64_t* dstData = histogram.bins.data();
+    const SRC_TYPE perBinCount = range / (binCount - 1);
+    for (const auto& value : values)
+    {
+        const size_t binIndex = (value.first - minVal) / perBinCount;
+        dstData[binIndex] += (scaleFactor * value.second);
+    }
+}
+
+// The former HistogramObject implementation for unpadded 8 and 16 bit types.
+// The empty values are skipped, they were added out of the bins if the range
+// did not start at the lowest value of the type.
+template <class SRC_TYPE>
+void binData(const SRC_TYPE* rawData, Histogram& histogram,
+             const livre::Vector3ui& blockSize, const uint64_t scaleFactor)
+{
+    SRC_TYPE minVal = histogram.min;
+    SRC_TYPE maxVal = histogram.max;
+
+    std::vector<size_t> values(std::numeric_limits<SRC_TYPE>::max() -
+                               std::numeric_limits<SRC_TYPE>::min() + 1);
+    const size_t numVoxels = blockSize.x() * blockSize.y() * blockSize.z();
+    for (size_t i = 0; i < numVoxels; ++i)
+    {
+        const SRC_TYPE data = rawData[i];
+        ++values[data - std::numeric_limits<SRC_TYPE>::min()];
+        minVal = std::min(data, minVal);
+        maxVal = std::max(data, maxVal);
+    }
+
+    histogram.min = minVal;
+    histogram.max = maxVal;
+    const float range = maxVal - minVal;
+
+    if (range == 0.0f)
+    {
+        histogram.bins.clear();
+        const size_t bins = blockSize.product() * scaleFactor;
+        histogram.bins.push_back(bins);
+        return;
+    }
+
+    const size_t binCount = histogram.bins.size();
+    uint64_t* dstData = histogram.bins.data();
+    const size_t perBinCount = std::ceil(range / (binCount - 1));
+
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        if (values[i] == 0)
+            continue;
+        const size_t binIndex = std::lround(i / perBinCount);
+        dstData[binIndex] += scaleFactor * values[i];
+    }
+}
+
+/**
+ * @return a brick of random values in [lo, hi], with lo and hi in the inner
+ * box and values outside of it in the padding
+ */
+template <class T>
+std::vector<T> makeBrick(const livre::Vector3ui& padding, const T lo,
+                         const T hi)
+{
+    const livre::Vector3ui size = blockSize + padding * 2;
+    std::vector<T> brick(size.product(), std::numeric_limits<T>::lowest());
+    std::mt19937 engine(42);
+    typename std::conditional<
+        std::is_floating_point<T>::value, std::uniform_real_distribution<T>,
+        std::uniform_int_distribution<int64_t>>::type random(lo, hi);
+
+    for (size_t z = padding.z(); z < size.z() - padding.z(); ++z)
+        for (size_t y = padding.y(); y < size.y() - padding.y(); ++y)
+            for (size_t x = padding.x(); x < size.x() - padding.x(); ++x)
+                brick[(z * size.y() + y) * size.x() + x] = T(random(engine));
+
+    const size_t first = (padding.z() * size.y() + padding.y()) * size.x();
+    brick[first + padding.x()] = lo;
+    brick[first + padding.x() + 1] = hi;
+    return brick;
+}
+
+template <class T>
+void checkBins(const std::vector<T>& brick, const livre::Vector3ui& padding,
+               const Histogram& expected)
+{
+    for (const size_t nThreads : {1, 3, 64})
+    {
+        Histogram histogram = makeHistogram<T>();
+        livre::binVoxels(brick.data(), blockSize, padding, scaleFactor,
+                         histogram.min, histogram.max, histogram.bins,
+                         nThreads);
+
+        BOOST_CHECK_EQUAL(histogram.min, expected.min);
+        BOOST_CHECK_EQUAL(histogram.max, expected.max);
+        BOOST_CHECK_EQUAL_COLLECTIONS(histogram.bins.begin(),
+                                      histogram.bins.end(),
+                                      expected.bins.begin(),
+                                      expected.bins.end());
+    }
+}
+
+/** Compares with the former implementation for an unpadded brick */
+template <class T>
+void checkUnpadded(const T lo, const T hi)
+{
+    const std::vector<T> brick = makeBrick(livre::Vector3ui(), lo, hi);
+    Histogram expected = makeHistogram<T>();
+    binData(brick.data(), expected, blockSize, scaleFactor);
+    checkBins(brick, livre::Vector3ui(), expected);
+}
+
+/** Compares with the former implementation for a padded brick */
+template <class T>
+void checkPadded(const T lo, const T hi)
+{
+    const livre::Vector3ui padding(2);
+    const std::vector<T> brick = makeBrick(padding, lo, hi);
+    Histogram expected = makeHistogram<T>();
+    binDataSlow(brick.data(), expected, blockSize, padding, scaleFactor);
+    checkBins(brick, padding, expected);
+}
+}
+
+// The ranges are the ones where the former implementations are defined: it
+// wrote out of the bins for other ranges.
+BOOST_AUTO_TEST_CASE(testEightBits)
+{
+    checkUnpadded<uint8_t>(0, 255);
+    checkUnpadded<uint8_t>(10, 20);
+    checkPadded<uint8_t>(0, 255);
+    checkPadded<uint8_t>(10, 20);
+    checkUnpadded<int8_t>(-128, 127);
+    checkUnpadded<int8_t>(-10, 20);
+    checkPadded<int8_t>(-128, 127);
+    checkPadded<int8_t>(-10, 20);
+}
+
+BOOST_AUTO_TEST_CASE(testSixteenBits)
+{
+    checkUnpadded<uint16_t>(0, 65535);
+    checkUnpadded<uint16_t>(0, 3000);
+    checkUnpadded<uint16_t>(0, 4 * 1023);
+    checkPadded<uint16_t>(1000, 1000 + 1023);
+    checkPadded<uint16_t>(1000, 1000 + 3 * 1023);
+    checkPadded<uint16_t>(0, 64 * 1023);
+    checkUnpadded<int16_t>(-32768, 32767);
+    checkUnpadded<int16_t>(-32768, -30000);
+    checkPadded<int16_t>(-1000, -1000 + 2 * 1023);
+}
+
+BOOST_AUTO_TEST_CASE(testThirtyTwoBits)
+{
+    checkPadded<uint32_t>(100, 100 + 4095);
+    checkPadded<uint32_t>(0, 1000 * 4095);
+    checkPadded<int32_t>(-5000, -5000 + 3 * 4095);
+    checkPadded<int32_t>(-512 * 4095, 512 * 4095);
+}
+
+BOOST_AUTO_TEST_CASE(testFloats)
+{
+    checkPadded<float>(0.25f, 0.75f);
+    checkPadded<float>(-0.5f, 2.f);
+    checkPadded<float>(-1000.f, 1e6f);
+}
+
+BOOST_AUTO_TEST_CASE(testUniformBrick)
+{
+    checkPadded<uint32_t>(7, 7);
+    for (const livre::Vector3ui& padding :
+         {livre::Vector3ui(), livre::Vector3ui(1)})
+    {
+        const std::vector<uint16_t> brick = makeBrick<uint16_t>(padding, 7, 7);
+        Histogram histogram = makeHistogram<uint16_t>();
+        livre::binVoxels(brick.data(), blockSize, padding, scaleFactor,
+                         histogram.min, histogram.max, histogram.bins);
+        BOOST_CHECK_EQUAL(histogram.min, 7.f);
+        BOOST_CHECK_EQUAL(histogram.max, 7.f);
+        BOOST_REQUIRE_EQUAL(histogram.bins.size(), 1u);
+        BOOST_CHECK_EQUAL(histogram.bins[0], blockSize.product() * scaleFactor);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(testAccumulation)
+{
+    // the bins and range of a previous brick are kept
+    const std::vector<uint8_t> brick =
+        makeBrick<uint8_t>(livre::Vector3ui(), 0, 255);
+    Histogram histogram = makeHistogram<uint8_t>();
+    for (size_t i = 0; i < 2; ++i)
+        livre::binVoxels(brick.data(), blockSize, livre::Vector3ui(), 1,
+                         histogram.min, histogram.max, histogram.bins);
+
+    uint64_t sum = 0;
+    for (const uint64_t bin : histogram.bins)
+        sum += bin;
+    BOOST_CHECK_EQUAL(sum, 2 * blockSize.product());
+
+    std::vector<uint64_t> bins(1);
+    BOOST_CHECK_THROW(livre::binVoxels(brick.data(), blockSize,
+                                       livre::Vector3ui(), 1, histogram.min,
+                                       histogram.max, bins),
+                      std::invalid_argument);
+}
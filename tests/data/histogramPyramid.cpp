@@ -0,0 +1,199 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define BOOST_TEST_MODULE HistogramPyramid
+
+#include <livre/data/DataSource.h>
+#include <livre/data/HistogramKernels.h>
+#include <livre/data/HistogramPyramid.h>
+#include <livre/data/LODNode.h>
+#include <livre/data/MemoryUnit.h>
+#include <livre/data/NodeId.h>
+#include <livre/data/VolumeInformation.h>
+
+#include <servus/uri.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <fstream>
+
+namespace
+{
+// 4^3 leaves of 32^3 voxels in a tree of depth 3, a value per leaf
+const char* const volume = "mem://?datatype=uint16#128,128,128,32";
+const uint32_t depth = 3;
+
+livre::NodeIds getLevel(const uint32_t level, const uint32_t timeStep = 0)
+{
+    livre::NodeIds nodeIds;
+    const uint32_t size = 1u << level;
+    for (uint32_t x = 0; x < size; ++x)
+        for (uint32_t y = 0; y < size; ++y)
+            for (uint32_t z = 0; z < size; ++z)
+                nodeIds.emplace_back(level, livre::Vector3ui(x, y, z),
+                                     timeStep);
+    return nodeIds;
+}
+
+std::vector<uint64_t> getBins(const livre::HistogramPyramid& pyramid,
+                              const livre::NodeId& nodeId)
+{
+    const uint64_t* bins = pyramid.getBins(nodeId);
+    BOOST_REQUIRE(bins);
+    return std::vector<uint64_t>(bins, bins + pyramid.getBinCount());
+}
+
+uint64_t getSum(const std::vector<uint64_t>& bins)
+{
+    uint64_t sum = 0;
+    for (const uint64_t bin : bins)
+        sum += bin;
+    return sum;
+}
+}
+
+BOOST_AUTO_TEST_CASE(testPyramid)
+{
+    const livre::DataSource source((servus::URI(volume)));
+    const livre::VolumeInformation& info = source.getVolumeInfo();
+    BOOST_REQUIRE_EQUAL(info.rootNode.getDepth(), depth);
+
+    const livre::HistogramPyramid pyramid(source, 0);
+    BOOST_CHECK(pyramid.matches(source, 0));
+    BOOST_CHECK(!pyramid.matches(source, 1));
+    BOOST_CHECK_EQUAL(pyramid.getBinCount(), 1024u);
+
+    // the leaves are binned in the range of the time step
+    const livre::Range range = pyramid.getRange();
+    for (const livre::NodeId& leaf : getLevel(depth - 1))
+    {
+        float min = range[0];
+        float max = range[1];
+        std::vector<uint64_t> bins(pyramid.getBinCount());
+        livre::binVoxels(source.getData(leaf)->getData<uint16_t>(),
+                         source.getNode(leaf).getVoxelBox().getSize(),
+                         info.overlap, 1, min, max, bins);
+        BOOST_CHECK_EQUAL(min, range[0]);
+        BOOST_CHECK_EQUAL(max, range[1]);
+
+        const std::vector<uint64_t> leafBins = getBins(pyramid, leaf);
+        BOOST_CHECK_EQUAL_COLLECTIONS(leafBins.begin(), leafBins.end(),
+                                      bins.begin(), bins.end());
+    }
+
+    // the parents are the sums of their children
+    for (uint32_t level = 0; level < depth - 1; ++level)
+        for (const livre::NodeId& parent : getLevel(level))
+        {
+            std::vector<uint64_t> bins;
+            BOOST_CHECK(pyramid.accumulate(parent.getChildren(), bins));
+            const std::vector<uint64_t> parentBins = getBins(pyramid, parent);
+            BOOST_CHECK_EQUAL_COLLECTIONS(parentBins.begin(), parentBins.end(),
+                                          bins.begin(), bins.end());
+        }
+
+    const livre::NodeId root(0, livre::Vector3ui(0u), 0);
+    BOOST_CHECK_EQUAL(getSum(getBins(pyramid, root)), 128 * 128 * 128);
+
+    // other time steps are not in the pyramid
+    std::vector<uint64_t> bins;
+    BOOST_CHECK(!pyramid.getBins(livre::NodeId(0, livre::Vector3ui(0u), 1)));
+    BOOST_CHECK(!pyramid.accumulate(getLevel(1, 1), bins));
+}
+
+BOOST_AUTO_TEST_CASE(testCover)
+{
+    livre::NodeIds leaves = getLevel(depth - 1);
+    const livre::NodeIds all = livre::HistogramPyramid::getCover(leaves);
+    BOOST_REQUIRE_EQUAL(all.size(), 1u);
+    BOOST_CHECK_EQUAL(all.front().getLevel(), 0u);
+
+    // without a leaf, the other 7 leaves of its parent and the 7 other
+    // parents are left
+    leaves.erase(leaves.begin());
+    const livre::NodeIds partial = livre::HistogramPyramid::getCover(leaves);
+    BOOST_CHECK_EQUAL(partial.size(), 14u);
+
+    const livre::DataSource source((servus::URI(volume)));
+    const livre::HistogramPyramid pyramid(source, 0);
+    std::vector<uint64_t> leafBins;
+    std::vector<uint64_t> coverBins;
+    BOOST_CHECK(pyramid.accumulate(leaves, leafBins));
+    BOOST_CHECK(pyramid.accumulate(partial, coverBins));
+    BOOST_CHECK_EQUAL_COLLECTIONS(leafBins.begin(), leafBins.end(),
+                                  coverBins.begin(), coverBins.end());
+    BOOST_CHECK_EQUAL(getSum(coverBins), 63 * 32 * 32 * 32);
+}
+
+BOOST_AUTO_TEST_CASE(testPersistence)
+{
+    const livre::DataSource source((servus::URI(volume)));
+    const livre::HistogramPyramid pyramid(source, 0);
+    const std::string filename = "histogramPyramid.bin";
+    pyramid.save(filename);
+
+    const livre::HistogramPyramid loaded(filename);
+    std::remove(filename.c_str());
+
+    BOOST_CHECK(loaded.matches(source, 0));
+    BOOST_CHECK(!loaded.matches(source, 1));
+
+    // another volume with the same LOD tree and type
+    const livre::DataSource other(
+        (servus::URI("mem://?datatype=uint16&sparsity=0.5#128,128,128,32")));
+    BOOST_REQUIRE_EQUAL(other.getVolumeInfo().rootNode.getDepth(), depth);
+    BOOST_CHECK(!loaded.matches(other, 0));
+    BOOST_CHECK_EQUAL(loaded.getTimeStep(), pyramid.getTimeStep());
+    BOOST_CHECK_EQUAL(loaded.getRange()[0], pyramid.getRange()[0]);
+    BOOST_CHECK_EQUAL(loaded.getRange()[1], pyramid.getRange()[1]);
+    BOOST_REQUIRE_EQUAL(loaded.getBinCount(), pyramid.getBinCount());
+    for (uint32_t level = 0; level < depth; ++level)
+        for (const livre::NodeId& nodeId : getLevel(level))
+        {
+            const std::vector<uint64_t> expected = getBins(pyramid, nodeId);
+            const std::vector<uint64_t> bins = getBins(loaded, nodeId);
+            BOOST_CHECK_EQUAL_COLLECTIONS(bins.begin(), bins.end(),
+                                          expected.begin(), expected.end());
+        }
+
+    BOOST_CHECK_THROW(livre::HistogramPyramid("missing.bin"),
+                      std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(testAtomicSave)
+{
+    // The saved pyramid replaces an existing file, a failed save throws
+    const livre::DataSource source((servus::URI(volume)));
+    const livre::HistogramPyramid pyramid(source, 0);
+    const std::string filename = "histogramPyramidAtomic.bin";
+    {
+        std::ofstream file(filename.c_str());
+        file << "not a pyramid";
+    }
+    BOOST_CHECK_THROW(livre::HistogramPyramid loaded(filename),
+                      std::runtime_error);
+
+    pyramid.save(filename);
+    const livre::HistogramPyramid loaded(filename);
+    BOOST_CHECK(loaded.matches(source, 0));
+    std::remove(filename.c_str());
+
+    BOOST_CHECK_THROW(pyramid.save("missing/histogramPyramid.bin"),
+                      std::runtime_error);
+}
@@ -38,7 +38,10 @@ typedef std::vector<livre::Identifier> Identifiers;
 Identifiers getVisibles(const livre::DataSource& dataSource,
                         const uint32_t windowHeight,
                         const float screenSpaceError, const uint32_t minLOD,
-                        const uint32_t maxLOD)
+                        const uint32_t maxLOD,
+                        const livre::Range& range = {{0.0f, 1.0f}},
+                        const livre::Decomposition decomposition =
+                            livre::DECOMPOSITION_SPATIAL)
 {
     const float projArray[] = {
         2.0, 0,           0,  0, 0, 2.0,          0, 0, 0,
@@ -54,7 +57,7 @@ Identifiers getVisibles(const livre::DataSource& dataSource,
     livre::ClipPlanes planes;
     livre::SelectVisibles selectVisibles(dataSource, frustum, windowHeight,
                                          screenSpaceError, minLOD, maxLOD,
-                                         {{0.0f, 1.0f}}, planes);
+                                         range, planes, decomposition);
 
     livre::DFSTraversal traverser;
     traverser.traverse(dataSource.getVolumeInfo().rootNode, selectVisibles, 0);
@@ -206,3 +209,48 @@ BOOST_AUTO_TEST_CASE(testLODSelection)
             BOOST_CHECK_EQUAL(livre::NodeId(visible).getLevel(), maxMinLevel);
     }
 }
+
+BOOST_AUTO_TEST_CASE(testSortLastDecomposition)
+{
+    const lunchbox::URI uri("mem://#4096,4096,4096,256");
+    livre::DataSource dataSource(uri);
+
+    const Identifiers& all = getVisibles(dataSource, 512, 1.0, 0, 100);
+    const std::vector<float> splits = {0.0f, 0.3f, 0.5f, 0.8f, 1.0f};
+
+    for (const auto decomposition :
+         {livre::DECOMPOSITION_ORDERED, livre::DECOMPOSITION_SPATIAL})
+    {
+        Identifiers merged;
+        for (size_t i = 1; i < splits.size(); ++i)
+        {
+            const Identifiers& part =
+                getVisibles(dataSource, 512, 1.0, 0, 100,
+                            {{splits[i - 1], splits[i]}}, decomposition);
+
+            // all bricks have the same cost in this volume
+            const float expected = (splits[i] - splits[i - 1]) * all.size();
+            BOOST_CHECK_LE(std::abs(float(part.size()) - expected), 1.0f);
+            merged.insert(merged.end(), part.begin(), part.end());
+        }
+
+        // the ranges partition the visible bricks
+        std::sort(merged.begin(), merged.end());
+        BOOST_CHECK_EQUAL_COLLECTIONS(all.begin(), all.end(), merged.begin(),
+                                      merged.end());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(testSpatialDecompositionIsCompact)
+{
+    const lunchbox::URI uri("mem://#4096,4096,4096,256");
+    livre::DataSource dataSource(uri);
+
+    // with equal costs, each half of the volume is one half of the root
+    const uint32_t level = 1;
+    const Identifiers& firstHalf = getVisibles(dataSource, 512, 1.0, level,
+                                               level, {{0.0f, 0.5f}});
+    BOOST_REQUIRE(!firstHalf.empty());
+    for (const livre::Identifier& id : firstHalf)
+        BOOST_CHECK_EQUAL(livre::NodeId(id).getPosition()[0], 0u);
+}
@@ -32,6 +32,11 @@ const uint32_t VOXEL_SIZE_Z = 41;
 #include <livre/data/RawDataSource.h>
 #include <lunchbox/pluginRegisterer.h>
 
+#include <boost/filesystem.hpp>
+
+#include <cstdio>
+#include <fstream>
+
 // Explicit registration required because the folder of the data source plugin
 // is not
 // in the LD_LIBRARY_PATH of the test executable.
@@ -50,6 +55,11 @@ void createAndCheckDataSource(const lunchbox::URI& uri)
 
     BOOST_CHECK(info.overlap == livre::Vector3ui(OVERLAP_SIZE));
 
+    // the range of 8 bit types is known without reading the data
+    BOOST_CHECK(info.hasValueRange());
+    BOOST_CHECK_EQUAL(info.valueRange[0], 0.f);
+    BOOST_CHECK_EQUAL(info.valueRange[1], 255.f);
+
     const uint32_t level = 0;
     const livre::Vector3f position(0, 0, 0);
     const uint32_t frame = 0;
@@ -81,3 +91,33 @@ BOOST_AUTO_TEST_CASE(RawDataSource)
     const lunchbox::URI uri(volumeName.str());
     createAndCheckDataSource(uri);
 }
+
+BOOST_AUTO_TEST_CASE(scanValueRange)
+{
+    const std::string filename =
+        (boost::filesystem::temp_directory_path() / "scanValueRange.raw")
+            .string();
+    {
+        std::ofstream file(filename.c_str(), std::ios::binary);
+        for (uint16_t i = 0; i < 16 * 16 * 16; ++i)
+        {
+            const uint16_t value = 1000 + i % 2000;
+            file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+    }
+
+    const lunchbox::URI uri("raw://" + filename + "#16,16,16,uint16");
+    livre::DataSource source(uri);
+    BOOST_CHECK(!source.getVolumeInfo().hasValueRange());
+
+    const livre::Range range = source.scanValueRange(2);
+    BOOST_CHECK_EQUAL(range[0], 1000.f);
+    BOOST_CHECK_EQUAL(range[1], 2999.f);
+    BOOST_CHECK(source.getVolumeInfo().hasValueRange());
+    BOOST_CHECK(source.getVolumeInfo().valueRange == range);
+
+    // the second scan reads the cached range
+    livre::DataSource cached(uri);
+    BOOST_CHECK(cached.scanValueRange() == range);
+    std::remove(filename.c_str());
+}
@@ -0,0 +1,135 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define BOOST_TEST_MODULE HistogramCodec
+
+#include <livre/eq/HistogramCodec.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+
+namespace
+{
+livre::Histogram makeHistogram(const float min, const float max,
+                               const std::vector<uint64_t>& bins)
+{
+    livre::Histogram histogram;
+    histogram.setMin(min);
+    histogram.setMax(max);
+    for (const uint64_t bin : bins)
+        histogram.getBins().push_back(bin);
+    return histogram;
+}
+}
+
+BOOST_AUTO_TEST_CASE(roundTrip)
+{
+    livre::HistogramEncoder encoder;
+    livre::HistogramDecoder decoder;
+    std::mt19937 engine(42);
+    std::uniform_int_distribution<size_t> randomBin(0, 4095);
+    std::uniform_int_distribution<uint64_t> randomCount(0, 1u << 20);
+
+    std::vector<uint64_t> bins(4096);
+    for (size_t frame = 0; frame < 20; ++frame)
+    {
+        // a few bins change per frame, up and down, the range changes once
+        for (size_t i = 0; i < 10; ++i)
+            bins[randomBin(engine)] = randomCount(engine);
+        const float max = frame < 10 ? 65535.f : 4095.f;
+
+        const livre::Histogram histogram = makeHistogram(0.f, max, bins);
+        const std::vector<uint8_t> encoding = encoder.encode(histogram);
+        const bool isFull = frame == 0 || frame == 10;
+        BOOST_CHECK_LT(encoding.size(), isFull ? 1024u : 100u);
+
+        const livre::Histogram& decoded = decoder.decode(encoding);
+        BOOST_CHECK(decoded == histogram);
+        BOOST_CHECK_EQUAL(decoded.getMin(), histogram.getMin());
+        BOOST_CHECK_EQUAL(decoded.getMax(), histogram.getMax());
+    }
+
+    // an unchanged histogram is a type and an empty list of bins
+    const livre::Histogram same = makeHistogram(0.f, 4095.f, bins);
+    const std::vector<uint8_t> encoding = encoder.encode(same);
+    BOOST_CHECK_EQUAL(encoding.size(), 2u);
+    BOOST_CHECK(decoder.decode(encoding) == same);
+
+    // fewer bins, and no bins
+    const livre::Histogram small = makeHistogram(0.f, 255.f, {1, 0, 3});
+    BOOST_CHECK(decoder.decode(encoder.encode(small)) == small);
+    const livre::Histogram empty;
+    BOOST_CHECK(decoder.decode(encoder.encode(empty)) == empty);
+}
+
+BOOST_AUTO_TEST_CASE(corruptedEncoding)
+{
+    livre::HistogramEncoder encoder;
+    const std::vector<uint64_t> bins(256, 7);
+    std::vector<uint8_t> encoding =
+        encoder.encode(makeHistogram(0.f, 255.f, bins));
+
+    livre::HistogramDecoder truncated;
+    encoding.pop_back();
+    BOOST_CHECK_THROW(truncated.decode(encoding), std::runtime_error);
+
+    livre::HistogramDecoder unknown;
+    BOOST_CHECK_THROW(unknown.decode({42}), std::runtime_error);
+
+    // a delta does not apply to the empty bins of a new decoder
+    const std::vector<uint8_t> delta =
+        encoder.encode(makeHistogram(0.f, 255.f, std::vector<uint64_t>(256)));
+    livre::HistogramDecoder outOfOrder;
+    BOOST_CHECK_THROW(outOfOrder.decode(delta), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(resynchronization)
+{
+    livre::HistogramEncoder encoder;
+    livre::HistogramDecoder decoder;
+    std::vector<uint64_t> bins(256, 7);
+    decoder.decode(encoder.encode(makeHistogram(0.f, 255.f, bins)));
+
+    // after a corrupted delta, the decoder waits for the next full encoding,
+    // at the latest 64 histograms after the previous one
+    ++bins[0];
+    std::vector<uint8_t> corrupted =
+        encoder.encode(makeHistogram(0.f, 255.f, bins));
+    corrupted.pop_back();
+    BOOST_CHECK_THROW(decoder.decode(corrupted), std::runtime_error);
+    decoder.reset();
+
+    size_t nDropped = 0;
+    for (size_t i = 0; i < 64; ++i)
+    {
+        ++bins[i];
+        const livre::Histogram histogram = makeHistogram(0.f, 255.f, bins);
+        const std::vector<uint8_t> encoding = encoder.encode(histogram);
+        try
+        {
+            BOOST_CHECK(decoder.decode(encoding) == histogram);
+        }
+        catch (const std::runtime_error&)
+        {
+            decoder.reset();
+            ++nDropped;
+        }
+    }
+    BOOST_CHECK_EQUAL(nDropped, 62u);
+}
@@ -0,0 +1,189 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define BOOST_TEST_MODULE HistogramTraffic
+#define BOOST_TEST_NO_MAIN
+
+#include <livre/eq/Engine.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// A configuration of two render nodes on this host, the application node and
+// a node launched as another process of this executable. Each renders half of
+// a sort-first view into a pbuffer, so both send their histograms every frame.
+namespace
+{
+const size_t nWarmupFrames = 10;
+const size_t nFrames = 20;
+const size_t nChannels = 2;
+
+const char* const configuration = R"(#Equalizer 1.2 ascii
+
+server
+{
+    connection { hostname "127.0.0.1" }
+    config
+    {
+        appNode
+        {
+            connection { hostname "127.0.0.1" }
+            pipe
+            {
+                window
+                {
+                    viewport [ 0 0 64 64 ]
+                    attributes { hint_drawable pbuffer }
+                    channel { name "channel1" }
+                }
+            }
+        }
+        node
+        {
+            connection { hostname "127.0.0.1" }
+            attributes { launch_command "%c" }
+            pipe
+            {
+                window
+                {
+                    viewport [ 0 0 64 64 ]
+                    attributes { hint_drawable pbuffer }
+                    channel { name "channel2" }
+                }
+            }
+        }
+        observer {}
+        layout { name "Simple" view { observer 0 } }
+        canvas
+        {
+            layout "Simple"
+            wall {}
+            segment { channel "channel1" }
+        }
+        compound
+        {
+            channel ( segment 0 view 0 )
+            compound { viewport [ 0 0 .5 1 ] }
+            compound
+            {
+                channel "channel2"
+                viewport [ .5 0 .5 1 ]
+                outputframe { name "frame.channel2" }
+            }
+            inputframe { name "frame.channel2" }
+        }
+    }
+}
+)";
+
+/** Drops the images of the frames, only the histograms are measured */
+struct IgnoreImage
+{
+    template <class... Args>
+    void operator()(Args&&...) const
+    {
+    }
+};
+
+std::string writeConfiguration()
+{
+    const std::string filename =
+        (boost::filesystem::temp_directory_path() / "histogramTraffic.eqc")
+            .string();
+    std::ofstream file(filename.c_str());
+    file << configuration;
+    return filename;
+}
+}
+
+BOOST_AUTO_TEST_CASE(histogramBytesPerFrame)
+{
+    const std::string filename = writeConfiguration();
+    std::vector<std::string> args = {
+        boost::unit_test::framework::master_test_suite().argv[0],
+        "--eq-config", filename, "--volume", "mem:///#256,256,256,32",
+        "--synchronous", "--histogram-rate", "0"};
+    std::vector<char*> argv;
+    for (std::string& arg : args)
+        argv.push_back(&arg[0]);
+
+    std::unique_ptr<livre::Engine> engine;
+    try
+    {
+        engine.reset(new livre::Engine(int(argv.size()), argv.data()));
+    }
+    catch (const std::runtime_error& error)
+    {
+        // e.g. without a display or OpenGL for the pbuffers
+        BOOST_TEST_MESSAGE("No Equalizer configuration, skipping: "
+                           << error.what());
+        std::remove(filename.c_str());
+        return;
+    }
+
+    for (size_t i = 0; i < nWarmupFrames; ++i)
+        engine->render(IgnoreImage());
+
+    const uint64_t start = engine->getHistogramBytes();
+    for (size_t i = 0; i < nFrames; ++i)
+        engine->render(IgnoreImage());
+    const uint64_t bytesPerFrame =
+        (engine->getHistogramBytes() - start) / nFrames;
+
+    // The full histograms of the channels, as sent before the encoding
+    const size_t fullBytes =
+        nChannels * engine->getHistogram().getBins().size() * sizeof(uint64_t);
+    std::cout << "Histogram bytes per frame of " << nChannels
+              << " render nodes: " << bytesPerFrame << ", full histograms: "
+              << fullBytes << std::endl;
+
+    BOOST_CHECK_GT(bytesPerFrame, 0u);
+    BOOST_CHECK_LT(bytesPerFrame * 10, fullBytes);
+
+    engine.reset();
+    std::remove(filename.c_str());
+}
+
+int main(int argc, char* argv[])
+{
+    // The render node of the configuration runs this executable, until the
+    // application node exits the configuration
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--eq-client")
+        {
+            livre::Engine engine(argc, argv);
+            return EXIT_SUCCESS;
+        }
+    }
+
+#ifdef BOOST_TEST_DYN_LINK
+    return boost::unit_test::unit_test_main(&init_unit_test, argc, argv);
+#else
+    return boost::unit_test::unit_test_main(&init_unit_test_suite, argc, argv);
+#endif
+}
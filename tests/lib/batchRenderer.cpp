@@ -0,0 +1,166 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define BOOST_TEST_MODULE BatchRenderer
+
+#include <livre/lib/configuration/VolumeRendererParameters.h>
+#include <livre/lib/render/BatchRenderer.h>
+#include <livre/lib/render/HeadlessRenderer.h>
+
+#include <livre/core/render/TransferFunction1D.h>
+#include <livre/data/Frustum.h>
+#include <livre/data/RawDataSource.h>
+
+#include <lunchbox/pluginRegisterer.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+
+// Explicit registration required because the folder of the data source plugin
+// is not in the LD_LIBRARY_PATH of the test executable.
+lunchbox::PluginRegisterer<livre::RawDataSource> registerer;
+
+namespace
+{
+const livre::Vector2ui size(40, 30);
+const livre::Frustumf projection(-0.05f, 0.05f, -0.0375f, 0.0375f, 0.1f,
+                                 10.f);
+
+/** The camera turns around the volume and comes closer, the cuts change */
+livre::BatchFrames makeFrames(const size_t nFrames)
+{
+    livre::BatchFrames frames(nFrames);
+    for (size_t i = 0; i < nFrames; ++i)
+    {
+        livre::Matrix4f rotation;
+        rotation.rotate_y(i * 0.2f);
+        livre::Matrix4f translation;
+        translation.setTranslation(livre::Vector3f(0.f, 0.f, -3.f + i * 0.2f));
+        frames[i].modelView = translation * rotation;
+        frames[i].timeStep = 0;
+    }
+    return frames;
+}
+
+livre::VolumeRendererParameters makeParams(const uint64_t cacheMemory)
+{
+    livre::VolumeRendererParameters params;
+    params.setScreenSpaceError(1.f);
+    params.setSamplesPerRay(64);
+    params.setMaxCpuCacheMemory(cacheMemory);
+    return params;
+}
+
+typedef std::vector<std::vector<uint8_t>> Images;
+
+Images renderBatch(livre::BatchRenderer& renderer,
+                   const livre::BatchFrames& frames,
+                   livre::BatchStatistics& statistics)
+{
+    Images images;
+    statistics = renderer.render(frames, projection, size,
+                                 [&](const size_t index,
+                                     const std::vector<uint8_t>& rgba) {
+                                     BOOST_CHECK_EQUAL(index, images.size());
+                                     images.push_back(rgba);
+                                 });
+    return images;
+}
+}
+
+BOOST_AUTO_TEST_CASE(sequence)
+{
+    const servus::URI uri("mem://#128,128,128,16");
+    const livre::BatchFrames frames = makeFrames(8);
+
+    // each frame renders like a single headless frame
+    livre::HeadlessRenderer headless(uri, makeParams(1024), 1);
+    Images reference;
+    for (const livre::BatchFrame& frame : frames)
+    {
+        headless.render(livre::Frustum(frame.modelView,
+                                       projection.computePerspectiveMatrix()),
+                        frame.timeStep, size);
+        reference.push_back(headless.getRGBA8());
+    }
+
+    // the bricks of all the frames fit, each one is read once
+    livre::BatchRenderer batch(uri, makeParams(1024), 3);
+    livre::BatchStatistics statistics;
+    BOOST_CHECK(renderBatch(batch, frames, statistics) == reference);
+    BOOST_CHECK_EQUAL(statistics.frames, frames.size());
+    BOOST_CHECK_GT(statistics.bricks, 0u);
+    BOOST_CHECK_EQUAL(statistics.brickReads, statistics.bricks);
+    BOOST_CHECK_GT(statistics.getFramesPerHour(), 0.f);
+
+    // some bricks are read again, the images are the same
+    livre::BatchRenderer small(uri, makeParams(1), 2);
+    BOOST_CHECK(renderBatch(small, frames, statistics) == reference);
+}
+
+BOOST_AUTO_TEST_CASE(brickReads)
+{
+    // One brick of 104^3 bytes per time step, the 1 MB cache holds one
+    livre::BatchRenderer renderer(servus::URI("mem://#96,96,96,96"),
+                                  makeParams(1), 2);
+    livre::BatchFrames frames = makeFrames(6);
+    const uint32_t timeSteps[] = {0, 0, 1, 1, 0, 0};
+    for (size_t i = 0; i < frames.size(); ++i)
+        frames[i].timeStep = timeSteps[i];
+
+    // the groups of two frames use one brick, the one of the first group is
+    // released for the second and read again for the third
+    livre::BatchStatistics statistics;
+    BOOST_CHECK_EQUAL(renderBatch(renderer, frames, statistics).size(), 6u);
+    BOOST_CHECK_EQUAL(statistics.bricks, 2u);
+    BOOST_CHECK_EQUAL(statistics.brickReads, 3u);
+
+    // in time step order, each brick is read once: with room for three, the
+    // second one is read while the second group renders
+    livre::BatchRenderer large(servus::URI("mem://#96,96,96,96"),
+                               makeParams(4), 2);
+    std::sort(frames.begin(), frames.end(),
+              [](const livre::BatchFrame& a, const livre::BatchFrame& b) {
+                  return a.timeStep < b.timeStep;
+              });
+    BOOST_CHECK_EQUAL(renderBatch(large, frames, statistics).size(), 6u);
+    BOOST_CHECK_EQUAL(statistics.brickReads, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+    livre::BatchRenderer renderer(servus::URI("raw://" NRRD_DATA_FILE),
+                                  makeParams(64), 2);
+    livre::BatchFrames frames = makeFrames(3);
+    livre::BatchStatistics statistics;
+
+    // the raw volume has a single time step
+    frames[1].timeStep = 1;
+    BOOST_CHECK_THROW(renderBatch(renderer, frames, statistics),
+                      std::runtime_error);
+
+    // a failing writer stops the batch
+    frames[1].timeStep = 0;
+    BOOST_CHECK_THROW(renderer.render(frames, projection, size,
+                                      [](const size_t,
+                                         const std::vector<uint8_t>&) {
+                                          throw std::runtime_error("full");
+                                      }),
+                      std::runtime_error);
+}
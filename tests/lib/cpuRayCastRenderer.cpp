@@ -0,0 +1,368 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define BOOST_TEST_MODULE CPURayCastRenderer
+
+#include <livre/lib/cache/DataObject.h>
+#include <livre/lib/render/CPURayCastRenderer.h>
+
+#include <livre/core/cache/Cache.h>
+#include <livre/core/render/TransferFunction1D.h>
+#include <livre/data/DataSource.h>
+#include <livre/data/Frustum.h>
+#include <livre/data/LODNode.h>
+#include <livre/data/NodeId.h>
+#include <livre/data/RawDataSource.h>
+#include <livre/data/VolumeInformation.h>
+
+#include <lunchbox/pluginRegisterer.h>
+#include <servus/uri.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <iterator>
+
+// Explicit registration required because the folder of the data source plugin
+// is not in the LD_LIBRARY_PATH of the test executable.
+lunchbox::PluginRegisterer<livre::RawDataSource> registerer;
+
+namespace
+{
+const uint32_t nSamples = 256;
+
+/** Looks at the volume from the front, it covers the center of the view */
+livre::Frustum makeFrustum()
+{
+    livre::Matrix4f modelView;
+    modelView.setTranslation(livre::Vector3f(0.1f, -0.05f, -2.f));
+    const livre::Frustumf frustum(-0.05f, 0.05f, -0.05f, 0.05f, 0.1f, 10.f);
+    return livre::Frustum(modelView, frustum.computePerspectiveMatrix());
+}
+
+livre::NodeIds getNodes(const uint32_t level)
+{
+    livre::NodeIds nodeIds;
+    const uint32_t size = 1u << level;
+    for (uint32_t x = 0; x < size; ++x)
+        for (uint32_t y = 0; y < size; ++y)
+            for (uint32_t z = 0; z < size; ++z)
+                nodeIds.emplace_back(level, livre::Vector3ui(x, y, z), 0);
+    return nodeIds;
+}
+
+class Fixture
+{
+public:
+    explicit Fixture(const std::string& volume)
+        : source(servus::URI(volume))
+        , dataCache("DataCache", 256u << 20)
+        , frustum(makeFrustum())
+    {
+    }
+
+    void load(const livre::NodeIds& nodeIds)
+    {
+        for (const livre::NodeId& nodeId : nodeIds)
+            BOOST_REQUIRE(
+                dataCache.load<livre::DataObject>(nodeId.getId(), source));
+    }
+
+    livre::Floats render(const livre::NodeIds& nodeIds,
+                         const livre::TransferFunction1D& tf,
+                         const size_t nThreads, const size_t nPasses = 1)
+    {
+        livre::CPURayCastRenderer renderer(source, dataCache, nSamples,
+                                           nThreads);
+        renderer.setTransferFunction(tf);
+
+        // the passes of a frame render consecutive ranges of the ordered
+        // bricks, see RenderPipeline
+        const livre::NodeIds ordered = renderer.order(nodeIds, frustum);
+        const size_t perPass = (ordered.size() + nPasses - 1) / nPasses;
+        for (size_t i = 0; i < nPasses; ++i)
+        {
+            uint32_t stages = livre::RENDER_FRAME | livre::RENDER_ORDERED;
+            if (i == 0)
+                stages |= livre::RENDER_BEGIN;
+            if (i == nPasses - 1)
+                stages |= livre::RENDER_END;
+
+            const size_t begin = std::min(i * perPass, ordered.size());
+            const size_t end = std::min(begin + perPass, ordered.size());
+            renderer.render(frustum, livre::ClipPlanes(), view,
+                            livre::NodeIds(ordered.begin() + begin,
+                                           ordered.begin() + end),
+                            stages);
+        }
+        return renderer.getImage();
+    }
+
+    livre::DataSource source;
+    livre::CacheT<livre::DataObject> dataCache;
+    const livre::Frustum frustum;
+    const livre::PixelViewport view{0, 0, 70, 50}; // partial tiles and packets
+};
+
+/** The AABB-ray intersection of fragRayCast.glsl */
+bool intersectBox(const livre::Vector3f& origin, const livre::Vector3f& dir,
+                  const livre::Vector3f& min, const livre::Vector3f& max,
+                  float& t0, float& t1)
+{
+    t0 = -std::numeric_limits<float>::max();
+    t1 = std::numeric_limits<float>::max();
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const float invDir = 1.f / (dir[i] == 0.f ? 1e-10f : dir[i]);
+        const float tbot = invDir * (min[i] - origin[i]);
+        const float ttop = invDir * (max[i] - origin[i]);
+        t0 = std::max(t0, std::min(ttop, tbot));
+        t1 = std::min(t1, std::max(ttop, tbot));
+    }
+    return t0 <= t1;
+}
+
+/**
+ * A per-pixel port of fragRayCast.glsl for a volume of one 8 bit brick without
+ * overlap, with nearest sampling.
+ */
+livre::Floats renderReference(Fixture& fixture, const livre::NodeId& nodeId,
+                              const livre::TransferFunction1D& tf)
+{
+    const livre::VolumeInformation& info = fixture.source.getVolumeInfo();
+    const livre::Vector3ui& size = info.maximumBlockSize;
+    const uint8_t* voxels = static_cast<const uint8_t*>(
+        fixture.dataCache.get<livre::DataObject>(nodeId.getId())
+            ->getDataPtr());
+    const livre::Boxf& box = fixture.source.getNode(nodeId).getWorldBox();
+    const livre::Vector3f halfWorldSize = info.worldSize / 2.f;
+    const std::vector<livre::Vector4ub> lut = tf.getLUT();
+
+    livre::Vector2f range(0.f, 255.f);
+    if (tf.getRange()[1] > 0 && tf.getRange()[1] - tf.getRange()[0] > 0)
+        range = livre::Vector2f(tf.getRange()[0], tf.getRange()[1]);
+    const float multiplier = 1.f / (range[1] - range[0]);
+    const float addedValue = -range[0] / (range[1] - range[0]);
+
+    const livre::Frustum& frustum = fixture.frustum;
+    const livre::Vector3f& eye = frustum.getEyePos();
+    const int width = fixture.view[2];
+    const int height = fixture.view[3];
+    const float stepSize = 1.f / nSamples;
+    livre::Floats image(width * height * 4, 0.f);
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            livre::Vector4f eyePos =
+                frustum.getInvProjMatrix() *
+                livre::Vector4f((x + .5f) / width * 2.f - 1.f,
+                                (y + .5f) / height * 2.f - 1.f, -1.f, 1.f);
+            eyePos /= eyePos[3];
+            const livre::Vector4f world = frustum.getInvMVMatrix() * eyePos;
+            const livre::Vector3f dir = vmml::normalize(
+                livre::Vector3f(world[0], world[1], world[2]) - eye);
+            const float tNearPlane =
+                -frustum.nearPlane() /
+                vmml::normalize(
+                    livre::Vector3f(eyePos[0], eyePos[1], eyePos[2]))[2];
+
+            float tnear, tfar, tnearGlobal, tfarGlobal;
+            if (!intersectBox(eye, dir, box.getMin(), box.getMax(), tnear,
+                              tfar))
+            {
+                continue;
+            }
+            intersectBox(eye, dir, -halfWorldSize, halfWorldSize, tnearGlobal,
+                         tfarGlobal);
+
+            tnear = std::max(tnear, tNearPlane);
+            const float offset = tnear - tnearGlobal;
+            const float residu =
+                offset - stepSize * std::floor(offset / stepSize);
+            if (residu > 0.f)
+                tnear += stepSize - residu;
+            if (tnear > tfar)
+                continue;
+
+            const livre::Vector3f rayStart = eye + dir * tnear;
+            const livre::Vector3f rayStop = eye + dir * tfar;
+            const livre::Vector3f step =
+                vmml::normalize(rayStop - rayStart) * stepSize;
+            livre::Vector3f pos = rayStart;
+            livre::Vector4f dst(0.f);
+            for (float travel = (rayStop - rayStart).length(); travel > 0.f;
+                 pos += step, travel -= stepSize)
+            {
+                livre::Vector3ui voxel;
+                for (size_t i = 0; i < 3; ++i)
+                {
+                    const float texPos = (pos[i] - box.getMin()[i]) /
+                                         (box.getMax()[i] - box.getMin()[i]);
+                    const float index = std::floor(texPos * size[i]);
+                    voxel[i] = std::min(uint32_t(std::max(index, 0.f)),
+                                        size[i] - 1);
+                }
+                const size_t voxelIndex =
+                    voxel[0] + size[0] * (voxel[1] + size[1] * voxel[2]);
+                const float density =
+                    voxels[voxelIndex] * multiplier + addedValue;
+
+                const float index =
+                    std::min(lut.size() - .5f,
+                             std::max(-.5f, density * lut.size() - .5f));
+                const float base = std::floor(index);
+                const float f = index - base;
+                const size_t i0 = size_t(std::max(base, 0.f));
+                const size_t i1 = std::min(size_t(base + 1.f), lut.size() - 1);
+                livre::Vector4f src;
+                for (size_t i = 0; i < 4; ++i)
+                    src[i] = lut[i0][i] / 255.f * (1.f - f) +
+                             lut[i1][i] / 255.f * f;
+
+                const float alpha =
+                    1.f - std::pow(1.f - std::min(src[3], 1.f - 1.f / 256.f),
+                                   32.f / nSamples);
+                for (size_t i = 0; i < 3; ++i)
+                    dst[i] += src[i] * alpha * (1.f - dst[3]);
+                dst[3] += alpha * (1.f - dst[3]);
+                if (dst[3] > 0.999f)
+                    break;
+            }
+
+            for (size_t i = 0; i < 4; ++i)
+                image[(y * width + x) * 4 + i] = dst[i];
+        }
+    }
+    return image;
+}
+
+/** @return the number of values which differ by more than the tolerance */
+size_t countDifferences(const livre::Floats& image,
+                        const livre::Floats& reference, const float tolerance)
+{
+    BOOST_REQUIRE_EQUAL(image.size(), reference.size());
+    size_t differences = 0;
+    for (size_t i = 0; i < image.size(); ++i)
+        if (std::abs(image[i] - reference[i]) > tolerance)
+            ++differences;
+    return differences;
+}
+
+/** The conversion of CPURayCastRenderer::getRGBA8() */
+std::vector<uint8_t> toRGBA8(const livre::Floats& image)
+{
+    std::vector<uint8_t> rgba(image.size());
+    for (size_t i = 0; i < image.size(); ++i)
+        rgba[i] = uint8_t(std::min(1.f, std::max(0.f, image[i])) * 255.f + .5f);
+    return rgba;
+}
+
+float getAlpha(const livre::Floats& image, const livre::PixelViewport& view,
+               const int x, const int y)
+{
+    return image[(y * view[2] + x) * 4 + 3];
+}
+}
+
+BOOST_AUTO_TEST_CASE(nucleonReference)
+{
+    Fixture fixture("raw://" NRRD_DATA_FILE);
+    const livre::NodeId root(0, livre::Vector3ui(0), 0);
+    BOOST_REQUIRE(fixture.source.getNode(root).isValid());
+    fixture.load({root});
+
+    const livre::TransferFunction1D tf;
+    const livre::Floats reference = renderReference(fixture, root, tf);
+    const livre::Floats image = fixture.render({root}, tf, 4);
+    BOOST_CHECK_EQUAL(countDifferences(image, reference, 1e-4f), 0u);
+
+    // the volume is in the middle of the view, and does not cover its corner
+    float sum = 0.f;
+    for (const float value : image)
+        sum += value;
+    BOOST_CHECK_GT(sum, 0.f);
+    BOOST_CHECK_EQUAL(getAlpha(image, fixture.view, 0, 0), 0.f);
+}
+
+BOOST_AUTO_TEST_CASE(nucleonImage)
+{
+    // The stored image was rendered from nucleon.raw with the default transfer
+    // function by a standalone copy of renderReference(), it also checks the
+    // data read by the NRRD source.
+    std::ifstream file(NUCLEON_IMAGE_FILE, std::ios::binary);
+    const std::vector<uint8_t> reference((std::istreambuf_iterator<char>(file)),
+                                         std::istreambuf_iterator<char>());
+
+    Fixture fixture("raw://" NRRD_DATA_FILE);
+    const livre::NodeId root(0, livre::Vector3ui(0), 0);
+    fixture.load({root});
+
+    const std::vector<uint8_t> image =
+        toRGBA8(fixture.render({root}, livre::TransferFunction1D(), 4));
+    BOOST_REQUIRE_EQUAL(image.size(), reference.size());
+
+    // the rounding of the matrices may move a few samples by a voxel
+    size_t differences = 0;
+    for (size_t i = 0; i < image.size(); ++i)
+        if (std::abs(int(image[i]) - int(reference[i])) > 2)
+            ++differences;
+    BOOST_CHECK_EQUAL(differences, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(threadsAndPasses)
+{
+    // bricks with overlap, which are traced across tiles and passes
+    for (const std::string& type : {"uint8", "uint16", "float"})
+    {
+        Fixture fixture("mem://?datatype=" + type + "#64,64,64,16");
+        const livre::NodeIds nodeIds = getNodes(2);
+        fixture.load(nodeIds);
+
+        const livre::TransferFunction1D tf;
+        const livre::Floats image = fixture.render(nodeIds, tf, 1);
+        BOOST_CHECK(fixture.render(nodeIds, tf, 7) == image);
+        BOOST_CHECK(fixture.render(nodeIds, tf, 3, 5) == image);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(transferFunction)
+{
+    Fixture fixture("mem://#64,64,64,16");
+    const livre::NodeIds nodeIds = getNodes(1);
+    fixture.load(nodeIds);
+
+    livre::TransferFunction1D transparent;
+    livre::TransferFunction1D opaque;
+    for (size_t i = 0; i < transparent.getAlpha().size(); ++i)
+    {
+        transparent.getAlpha()[i] = 0.f;
+        opaque.getAlpha()[i] = 1.f;
+    }
+
+    const livre::Floats empty = fixture.render(nodeIds, transparent, 2);
+    BOOST_CHECK(empty == livre::Floats(empty.size(), 0.f));
+
+    // the rays through the volume terminate early, the others see nothing
+    const livre::PixelViewport& view = fixture.view;
+    const livre::Floats image = fixture.render(nodeIds, opaque, 2);
+    BOOST_CHECK_GT(getAlpha(image, view, view[2] / 2, view[3] / 2), 0.999f);
+    BOOST_CHECK_EQUAL(getAlpha(image, view, 0, 0), 0.f);
+    BOOST_CHECK_EQUAL(getAlpha(image, view, view[2] - 1, view[3] - 1), 0.f);
+}
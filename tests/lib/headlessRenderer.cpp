@@ -0,0 +1,104 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define BOOST_TEST_MODULE HeadlessRenderer
+
+#include <livre/lib/configuration/VolumeRendererParameters.h>
+#include <livre/lib/render/HeadlessRenderer.h>
+
+#include <livre/core/render/TransferFunction1D.h>
+#include <livre/data/Frustum.h>
+#include <livre/data/RawDataSource.h>
+
+#include <lunchbox/pluginRegisterer.h>
+
+#include <boost/test/unit_test.hpp>
+
+// Explicit registration required because the folder of the data source plugin
+// is not in the LD_LIBRARY_PATH of the test executable.
+lunchbox::PluginRegisterer<livre::RawDataSource> registerer;
+
+namespace
+{
+const livre::Vector2ui size(64, 48);
+
+livre::Frustum makeFrustum()
+{
+    livre::Matrix4f modelView;
+    modelView.setTranslation(livre::Vector3f(0.f, 0.f, -2.f));
+    const livre::Frustumf frustum(-0.05f, 0.05f, -0.0375f, 0.0375f, 0.1f,
+                                  10.f);
+    return livre::Frustum(modelView, frustum.computePerspectiveMatrix());
+}
+
+livre::VolumeRendererParameters makeParams(const uint32_t lod,
+                                           const uint64_t cacheMemory)
+{
+    livre::VolumeRendererParameters params;
+    params.setMinLod(lod);
+    params.setMaxLod(lod);
+    params.setSamplesPerRay(128);
+    params.setMaxCpuCacheMemory(cacheMemory);
+    return params;
+}
+
+livre::TransferFunction1D makeOpaque()
+{
+    livre::TransferFunction1D opaque;
+    for (float& alpha : opaque.getAlpha())
+        alpha = 1.f;
+    return opaque;
+}
+}
+
+BOOST_AUTO_TEST_CASE(passes)
+{
+    // 512 bricks of 32 KB: the frame does not fit in a 1 MB cache
+    const servus::URI uri("mem://#256,256,256,32");
+    livre::HeadlessRenderer reference(uri, makeParams(3, 1024));
+    livre::HeadlessRenderer multipass(uri, makeParams(3, 1));
+    const livre::Frustum frustum = makeFrustum();
+
+    const livre::Floats image = reference.render(frustum, 0, size);
+    BOOST_CHECK_EQUAL(image.size(), size[0] * size[1] * 4);
+    BOOST_CHECK(!reference.getRenderedNodes().empty());
+
+    BOOST_CHECK(multipass.render(frustum, 0, size) == image);
+    BOOST_CHECK_EQUAL(multipass.getRenderedNodes().size(),
+                      reference.getRenderedNodes().size());
+}
+
+BOOST_AUTO_TEST_CASE(image)
+{
+    livre::HeadlessRenderer renderer(servus::URI("raw://" NRRD_DATA_FILE),
+                                     makeParams(0, 64));
+    const livre::Frustum frustum = makeFrustum();
+
+    renderer.setTransferFunction(makeOpaque());
+    renderer.render(frustum, 0, size);
+    const std::vector<uint8_t> rgba = renderer.getRGBA8();
+    BOOST_REQUIRE_EQUAL(rgba.size(), size[0] * size[1] * 4);
+
+    // the volume covers the center of the view, not its corners
+    const size_t center = (size[1] / 2 * size[0] + size[0] / 2) * 4;
+    BOOST_CHECK_EQUAL(rgba[center + 3], 255);
+    BOOST_CHECK_EQUAL(rgba[3], 0);
+
+    // the raw volume has a single frame
+    BOOST_CHECK_THROW(renderer.render(frustum, 1, size), std::runtime_error);
+}
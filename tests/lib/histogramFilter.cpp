@@ -0,0 +1,165 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define BOOST_TEST_MODULE HistogramFilter
+
+#include <livre/lib/cache/DataObject.h>
+#include <livre/lib/cache/HistogramObject.h>
+#include <livre/lib/pipeline/HistogramFilter.h>
+
+#include <livre/core/cache/Cache.h>
+#include <livre/core/pipeline/FutureMap.h>
+#include <livre/core/pipeline/PipeFilter.h>
+#include <livre/data/DataSource.h>
+#include <livre/data/Frustum.h>
+#include <livre/data/NodeId.h>
+
+#include <servus/uri.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+/** A frame of the histogram filter */
+struct Frame
+{
+    livre::NodeIds nodeIds;
+    livre::Viewport viewport;
+    livre::Vector2f dataSourceRange;
+};
+
+/** Maps the unit cube of the volume to [-2, 2], so a part is out of view */
+livre::Frustum makeFrustum()
+{
+    livre::Matrix4f modelView;
+    modelView.setTranslation(livre::Vector3f(-0.5f));
+    livre::Matrix4f projection;
+    projection(0, 0) = 4.f;
+    projection(1, 1) = 4.f;
+    return livre::Frustum(modelView, projection);
+}
+
+/** The nodes from begin to end of a level, x varying slowest */
+livre::NodeIds getNodes(const uint32_t level, const size_t begin,
+                        const size_t end)
+{
+    livre::NodeIds nodeIds;
+    const uint32_t size = 1u << level;
+    for (uint32_t x = 0; x < size; ++x)
+        for (uint32_t y = 0; y < size; ++y)
+            for (uint32_t z = 0; z < size; ++z)
+                nodeIds.emplace_back(level, livre::Vector3ui(x, y, z), 0);
+    return livre::NodeIds(nodeIds.begin() + begin, nodeIds.begin() + end);
+}
+
+class Fixture
+{
+public:
+    explicit Fixture(const std::string& volume)
+        : source(servus::URI(volume))
+        , dataCache("DataCache", 256u << 20)
+        , histogramCache("HistogramCache", 32u << 20)
+        , frustum(makeFrustum())
+    {
+    }
+
+    livre::Histogram execute(const Frame& frame,
+                             livre::IncrementalHistogram* incremental)
+    {
+        livre::ConstCacheObjects cacheObjects;
+        for (const livre::NodeId& nodeId : frame.nodeIds)
+            cacheObjects.push_back(
+                dataCache.load<livre::DataObject>(nodeId.getId(), source));
+
+        livre::PipeFilterT<livre::HistogramFilter> filter(
+            "HistogramFilter", histogramCache, dataCache, source, nullptr,
+            incremental);
+        filter.getPromise("Frustum").set(frustum);
+        filter.getPromise("RelativeViewport").set(frame.viewport);
+        filter.getPromise("CacheObjects").set(cacheObjects);
+        filter.getPromise("DataSourceRange").set(frame.dataSourceRange);
+        filter.execute();
+
+        const livre::UniqueFutureMap futures(filter.getPostconditions());
+        return futures.get<livre::Histogram>("Histogram");
+    }
+
+    /** Checks that the incremental histograms are the recomputed ones */
+    void check(const std::vector<Frame>& frames)
+    {
+        livre::IncrementalHistogram incremental;
+        for (const Frame& frame : frames)
+        {
+            const livre::Histogram expected = execute(frame, nullptr);
+            const livre::Histogram histogram = execute(frame, &incremental);
+            BOOST_CHECK(histogram == expected);
+            BOOST_CHECK_EQUAL(histogram.getMin(), expected.getMin());
+            BOOST_CHECK_EQUAL(histogram.getMax(), expected.getMax());
+            BOOST_CHECK_EQUAL(histogram.getSum(), expected.getSum());
+        }
+    }
+
+    livre::DataSource source;
+    livre::CacheT<livre::DataObject> dataCache;
+    livre::CacheT<livre::HistogramObject> histogramCache;
+    const livre::Frustum frustum;
+};
+
+const livre::Viewport fullViewport(0.f, 0.f, 1.f, 1.f);
+const livre::Viewport centerViewport(0.25f, 0.25f, 0.5f, 0.5f);
+const livre::Vector2f byteRange(0.f, 255.f);
+}
+
+BOOST_AUTO_TEST_CASE(incrementalHistogram)
+{
+    Fixture fixture("mem://#256,256,256,32");
+
+    // bricks enter and leave, the view is static, then changes
+    const std::vector<Frame> frames = {
+        {getNodes(2, 0, 40), centerViewport, byteRange},
+        {getNodes(2, 10, 60), centerViewport, byteRange},
+        {getNodes(2, 10, 60), centerViewport, byteRange},
+        {getNodes(3, 0, 200), centerViewport, byteRange},
+        {getNodes(3, 100, 300), centerViewport, byteRange},
+        {getNodes(3, 100, 300), fullViewport, byteRange},
+        {livre::NodeIds(), fullViewport, byteRange},
+        {getNodes(2, 0, 64), fullViewport, byteRange},
+    };
+    fixture.check(frames);
+
+    // a part of the bricks is out of the center viewport
+    const livre::Histogram all = fixture.execute(frames.back(), nullptr);
+    const livre::Histogram center =
+        fixture.execute({getNodes(2, 0, 64), centerViewport, byteRange},
+                        nullptr);
+    BOOST_CHECK_GT(all.getSum(), center.getSum());
+    BOOST_CHECK_GT(center.getSum(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(incrementalHistogramPurges)
+{
+    // The histograms of 16 bit bricks have the range of the brick, they are
+    // not compatible with the data source range and are purged
+    Fixture fixture("mem://?datatype=uint16#256,256,256,32");
+    const livre::Vector2f shortRange(0.f, 65535.f);
+    fixture.check({
+        {getNodes(2, 0, 40), fullViewport, shortRange},
+        {getNodes(2, 0, 40), fullViewport, shortRange},
+        {getNodes(2, 20, 64), fullViewport, shortRange},
+    });
+}
@@ -0,0 +1,90 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define BOOST_TEST_MODULE QualityGovernor
+#include <boost/test/unit_test.hpp>
+
+#include <livre/lib/configuration/QualityGovernor.h>
+#include <livre/lib/configuration/VolumeRendererParameters.h>
+
+namespace
+{
+const float targetFPS = 20.0f;
+
+// Frame time of a renderer whose cost is proportional to the quality
+float simulateFrameTime(const float quality)
+{
+    return 5.0f + 195.0f * quality;
+}
+}
+
+BOOST_AUTO_TEST_CASE(holdTargetWhileInteracting)
+{
+    livre::QualityGovernor governor;
+    BOOST_CHECK_EQUAL(governor.getQuality(), 1.0f);
+
+    for (size_t i = 0; i < 50; ++i)
+        governor.update(simulateFrameTime(governor.getQuality()), false,
+                        targetFPS);
+
+    const float frameTime = simulateFrameTime(governor.getQuality());
+    BOOST_CHECK_LT(governor.getQuality(), 1.0f);
+    BOOST_CHECK_CLOSE(frameTime, 1000.0f / targetFPS, 15.0f);
+}
+
+BOOST_AUTO_TEST_CASE(refineWhenIdle)
+{
+    livre::QualityGovernor governor;
+    for (size_t i = 0; i < 50; ++i)
+        governor.update(1000.0f, false, targetFPS);
+    BOOST_CHECK_EQUAL(governor.getQuality(),
+                      livre::QualityGovernor::getMinQuality());
+
+    float quality = governor.getQuality();
+    while (governor.update(0.0f, true, targetFPS) < 1.0f)
+    {
+        BOOST_CHECK_GT(governor.getQuality(), quality);
+        quality = governor.getQuality();
+    }
+    BOOST_CHECK_EQUAL(governor.getQuality(), 1.0f);
+}
+
+BOOST_AUTO_TEST_CASE(disabled)
+{
+    livre::QualityGovernor governor;
+    for (size_t i = 0; i < 10; ++i)
+        BOOST_CHECK_EQUAL(governor.update(1000.0f, false, 0.0f), 1.0f);
+}
+
+BOOST_AUTO_TEST_CASE(applyQuality)
+{
+    livre::VolumeRendererParameters params;
+    params.setMinLod(1);
+    params.setMaxLod(7);
+    params.setScreenSpaceError(4.0f);
+
+    livre::VolumeRendererParameters fullQuality = params;
+    livre::QualityGovernor::applyQuality(fullQuality);
+    BOOST_CHECK(fullQuality == params);
+
+    params.setInteractionQuality(0.5f);
+    livre::QualityGovernor::applyQuality(params);
+    BOOST_CHECK_EQUAL(params.getScreenSpaceError(), 8.0f);
+    BOOST_CHECK_EQUAL(params.getMaxLod(), 4);
+    BOOST_CHECK_EQUAL(params.getMinLod(), 1);
+}
@@ -0,0 +1,259 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define BOOST_TEST_MODULE RenderPipeline
+
+#include "../core/render/DummyContext.h"
+
+#include <livre/lib/cache/DataObject.h>
+#include <livre/lib/cache/HistogramObject.h>
+#include <livre/lib/pipeline/RenderPipeline.h>
+#include <livre/lib/render/CPURayCastRenderer.h>
+
+#include <livre/core/cache/Cache.h>
+#include <livre/core/pipeline/Filter.h>
+#include <livre/core/pipeline/FutureMap.h>
+#include <livre/core/pipeline/PipeFilter.h>
+#include <livre/core/render/TexturePool.h>
+#include <livre/core/render/TransferFunction1D.h>
+#include <livre/data/DataSource.h>
+#include <livre/data/Frustum.h>
+
+#include <servus/uri.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+namespace
+{
+std::atomic<size_t> nAllocations(0);
+}
+
+void* operator new(const size_t size)
+{
+    ++nAllocations;
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+namespace
+{
+const size_t nWarmupFrames = 10;
+const size_t nFrames = 50;
+const std::chrono::seconds timeout(10);
+
+/** Counts the redraws of the asynchronous frames */
+class RedrawFilter : public livre::Filter
+{
+public:
+    explicit RedrawFilter(std::atomic<size_t>& count)
+        : _count(count)
+    {
+    }
+
+    void execute(const livre::FutureMap&, livre::PromiseMap&) const final
+    {
+        ++_count;
+    }
+
+    livre::DataInfos getInputDataInfos() const final
+    {
+        return {{"CacheObjects", livre::getType<livre::ConstCacheObjects>()},
+                {"RenderingDone", livre::getType<bool>()}};
+    }
+
+private:
+    std::atomic<size_t>& _count;
+};
+
+/** Records the last frame whose histogram was computed */
+class SendHistogramFilter : public livre::Filter
+{
+public:
+    explicit SendHistogramFilter(std::atomic<uint32_t>& lastFrame)
+        : _lastFrame(lastFrame)
+    {
+    }
+
+    void execute(const livre::FutureMap& input,
+                 livre::PromiseMap&) const final
+    {
+        _lastFrame = input.get<uint32_t>("Id").front();
+    }
+
+    livre::DataInfos getInputDataInfos() const final
+    {
+        return {{"Histogram", livre::getType<livre::Histogram>()},
+                {"RelativeViewport", livre::getType<livre::Viewport>()},
+                {"Id", livre::getType<uint32_t>()}};
+    }
+
+private:
+    std::atomic<uint32_t>& _lastFrame;
+};
+
+/** Looks at the volume from the front, it covers the center of the view */
+livre::Frustum makeFrustum()
+{
+    livre::Matrix4f modelView;
+    modelView.setTranslation(livre::Vector3f(0.f, 0.f, -2.f));
+    const livre::Frustumf frustum(-0.05f, 0.05f, -0.05f, 0.05f, 0.1f, 10.f);
+    return livre::Frustum(modelView, frustum.computePerspectiveMatrix());
+}
+
+template <class Predicate>
+bool waitFor(const Predicate& predicate)
+{
+    const auto end = std::chrono::steady_clock::now() + timeout;
+    while (!predicate())
+    {
+        if (std::chrono::steady_clock::now() > end)
+            return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+class Fixture
+{
+public:
+    Fixture()
+        : source(servus::URI("mem://#256,256,256,32"))
+        , dataCache("DataCache", 256u << 20)
+        , textureCache("TextureCache", 256u << 20)
+        , histogramCache("HistogramCache", 32u << 20)
+        , caches{dataCache, textureCache, histogramCache, nullptr}
+        , texturePool(source)
+        , renderer(source, dataCache, 64, 1)
+        , redraws(0)
+        , lastFrame(0)
+        // the pipeline threads need no GL context with the CPU renderer
+        , pipeline(source, caches, texturePool, test::DummyContext(), 4,
+                   livre::Int32s(), livre::RENDERER_CPU)
+        , frustum(makeFrustum())
+    {
+        renderer.setTransferFunction(livre::TransferFunction1D());
+    }
+
+    void render(const uint32_t frame, const bool synchronous)
+    {
+        livre::RenderParams params;
+        params.vrParams.setSynchronousMode(synchronous);
+        params.frameInfo = livre::FrameInfo(frustum, 0, frame);
+        params.renderDataRange = {{0.f, 1.f}};
+        params.dataSourceRange = livre::Vector2f(0.f, 255.f);
+        params.pixelViewPort = livre::PixelViewport(0, 0, 64, 64);
+        params.viewport = livre::Viewport(0.f, 0.f, 1.f, 1.f);
+        params.idle = true;
+
+        livre::NodeAvailability availability;
+        pipeline.render(params,
+                        livre::PipeFilterT<RedrawFilter>("RedrawFilter",
+                                                         redraws),
+                        livre::PipeFilterT<SendHistogramFilter>(
+                            "SendHistogramFilter", lastFrame),
+                        renderer, availability);
+    }
+
+    /** @return the heap allocations per frame of rendering frames */
+    size_t measure(const bool synchronous)
+    {
+        size_t allocations = 0;
+        for (uint32_t i = 1; i <= nWarmupFrames + nFrames; ++i)
+        {
+            const size_t start = nAllocations;
+            const size_t redrawn = redraws;
+            render(i, synchronous);
+            if (i > nWarmupFrames)
+                allocations += nAllocations - start;
+
+            // the next frame would cancel the filters of this one
+            BOOST_REQUIRE(waitFor([&] { return lastFrame == i; }));
+            if (!synchronous)
+                BOOST_REQUIRE(waitFor([&] { return redraws > redrawn; }));
+        }
+        return allocations / nFrames;
+    }
+
+    livre::DataSource source;
+    livre::CacheT<livre::DataObject> dataCache;
+    livre::CacheT<livre::DataObject> textureCache; // unused by the CPU
+    livre::CacheT<livre::HistogramObject> histogramCache;
+    livre::Caches caches;
+    livre::TexturePool texturePool;
+    livre::CPURayCastRenderer renderer;
+    // counted by the filters of the pipeline, so destroyed after it
+    std::atomic<size_t> redraws;
+    std::atomic<uint32_t> lastFrame;
+    livre::RenderPipeline pipeline;
+    const livre::Frustum frustum;
+};
+}
+
+BOOST_AUTO_TEST_CASE(testFrameAllocations)
+{
+    // The synchronous frames set up their filters every frame, the
+    // asynchronous ones reuse the graph of a finished frame. Both do the same
+    // work otherwise, the bricks of the view are cached after the warmup.
+    Fixture fixture;
+    const size_t synchronous = fixture.measure(true);
+    const size_t asynchronous = fixture.measure(false);
+
+    std::cout << "Heap allocations per frame of the render pipeline"
+              << std::endl
+              << "  synchronous, new filters: " << synchronous << std::endl
+              << "  asynchronous, reused graph: " << asynchronous
+              << std::endl;
+    BOOST_CHECK_LT(asynchronous, synchronous);
+}
+
+BOOST_AUTO_TEST_CASE(testBackToBackFrames)
+{
+    // The frames cancel each other, the graphs of the canceled frames are
+    // reused or waited for once the maximum number of graphs is reached
+    Fixture fixture;
+    const uint32_t lastFrame = 200;
+    for (uint32_t i = 1; i <= lastFrame; ++i)
+        fixture.render(i, false);
+
+    BOOST_CHECK(waitFor([&] { return fixture.lastFrame == lastFrame; }));
+    BOOST_CHECK(waitFor([&] { return fixture.redraws > 0; }));
+}
+
+BOOST_AUTO_TEST_CASE(testDestroyWhileRendering)
+{
+    // The pipeline is destroyed while the filters of its last frames run,
+    // they finish before the graphs and the histogram they use are destroyed
+    for (size_t i = 0; i < 10; ++i)
+    {
+        Fixture fixture;
+        for (uint32_t frame = 1; frame <= 3; ++frame)
+            fixture.render(frame, false);
+    }
+}
@@ -31,6 +31,11 @@ BOOST_AUTO_TEST_CASE(defaultValues)
     BOOST_CHECK(!params.getSynchronousMode());
     BOOST_CHECK_EQUAL(params.getSamplesPerRay(), 0);
     BOOST_CHECK(!params.getShowAxes());
+    BOOST_CHECK_EQUAL(params.getUploadTimeBudget(), 8.0f);
+    BOOST_CHECK_EQUAL(params.getTargetFps(), 15.0f);
+    BOOST_CHECK_EQUAL(params.getInteractionQuality(), 1.0f);
+    BOOST_CHECK_EQUAL(params.getDecomposition(), livre::DECOMPOSITION_SPATIAL);
+    BOOST_CHECK_EQUAL(params.getRenderer(), livre::RENDERER_GL);
 
 #ifdef __i386__
     BOOST_CHECK_EQUAL(params.getScreenSpaceError(), 8.0f);
@@ -74,7 +79,16 @@ BOOST_AUTO_TEST_CASE(initFromArgv)
                           "--max-lod",
                           "6",
                           "--samples-per-ray",
-                          "42"};
+                          "42",
+                          "--upload-budget",
+                          "2.5",
+                          "--target-fps",
+                          "30",
+                          "--decomposition",
+                          "0",
+                          "--renderer",
+                          "1",
+                          "--texture-atlas"};
     const int argc = sizeof(argv) / sizeof(char*);
 
     livre::VolumeRendererParameters params(argc, argv);
@@ -86,4 +100,9 @@ BOOST_AUTO_TEST_CASE(initFromArgv)
     BOOST_CHECK_EQUAL(params.getScreenSpaceError(), 1.4f);
     BOOST_CHECK_EQUAL(params.getMaxGpuCacheMemory(), 12345u);
     BOOST_CHECK_EQUAL(params.getMaxCpuCacheMemory(), 54321u);
+    BOOST_CHECK_EQUAL(params.getUploadTimeBudget(), 2.5f);
+    BOOST_CHECK_EQUAL(params.getTargetFps(), 30.0f);
+    BOOST_CHECK_EQUAL(params.getDecomposition(), livre::DECOMPOSITION_ORDERED);
+    BOOST_CHECK_EQUAL(params.getRenderer(), livre::RENDERER_CPU);
+    BOOST_CHECK(params.getTextureAtlas());
 }
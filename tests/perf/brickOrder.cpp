@@ -0,0 +1,105 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define BOOST_TEST_MODULE PerfBrickOrder
+#include <boost/test/unit_test.hpp>
+
+#include <livre/core/render/BrickOrder.h>
+#include <livre/data/DataSource.h>
+#include <livre/data/Frustum.h>
+#include <livre/data/LODNode.h>
+#include <livre/data/NodeId.h>
+
+#include <lunchbox/clock.h>
+
+namespace
+{
+const size_t nBricks = 10000;
+const size_t nLoops = 10;
+
+livre::Frustum createFrustum()
+{
+    const float projArray[] = {
+        2.0, 0,           0,  0, 0, 2.0,          0, 0, 0,
+        0,   -1.01342285, -1, 0, 0, -0.201342285, 0};
+    const float mvArray[] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, -1.0, 1};
+
+    return livre::Frustum(livre::Matrix4f(mvArray, mvArray + 16),
+                          livre::Matrix4f(projArray, projArray + 16));
+}
+
+float getDistance(const livre::DataSource& dataSource,
+                  const livre::Frustum& frustum, const livre::NodeId& nodeId)
+{
+    const livre::LODNode& lodNode = dataSource.getNode(nodeId);
+    return (frustum.getMVMatrix() * lodNode.getWorldBox().getCenter())
+        .length();
+}
+
+// The previous implementation: distances computed in the comparator
+livre::NodeIds sortByDistance(const livre::DataSource& dataSource,
+                              const livre::NodeIds& bricks,
+                              const livre::Frustum& frustum)
+{
+    livre::NodeIds sorted = bricks;
+    std::sort(sorted.begin(), sorted.end(),
+              [&](const livre::NodeId& a, const livre::NodeId& b) {
+                  return getDistance(dataSource, frustum, a) <
+                         getDistance(dataSource, frustum, b);
+              });
+    return sorted;
+}
+}
+
+BOOST_AUTO_TEST_CASE(orderFrontToBack)
+{
+    const livre::DataSource dataSource(servus::URI("mem://#2048,2048,2048,32"));
+    const livre::Frustum frustum = createFrustum();
+
+    // bricks of the finest level, spread over the volume
+    const uint32_t level = dataSource.getVolumeInfo().rootNode.getDepth() - 1;
+    const uint32_t width = 1u << level;
+    livre::NodeIds bricks;
+    for (size_t i = 0; i < nBricks; ++i)
+    {
+        const size_t index = (i * 7919) % (width * width * width);
+        bricks.emplace_back(level,
+                            livre::Vector3ui(index % width,
+                                             (index / width) % width,
+                                             index / (width * width)));
+    }
+
+    livre::NodeIds ordered;
+    lunchbox::Clock clock;
+    for (size_t i = 0; i < nLoops; ++i)
+        ordered = livre::orderFrontToBack(dataSource, bricks, frustum);
+    const float radixTime = clock.resetTimef() / nLoops;
+
+    livre::NodeIds sorted;
+    for (size_t i = 0; i < nLoops; ++i)
+        sorted = sortByDistance(dataSource, bricks, frustum);
+    const float sortTime = clock.resetTimef() / nLoops;
+
+    BOOST_REQUIRE_EQUAL(ordered.size(), bricks.size());
+    for (size_t i = 0; i < ordered.size(); ++i)
+        BOOST_CHECK_EQUAL(getDistance(dataSource, frustum, ordered[i]),
+                          getDistance(dataSource, frustum, sorted[i]));
+
+    std::cout << "Ordering " << nBricks << " bricks: radix sort " << radixTime
+              << " ms, comparison sort " << sortTime << " ms" << std::endl;
+}
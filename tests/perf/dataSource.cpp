@@ -0,0 +1,150 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define BOOST_TEST_MODULE PerfDataSource
+#include <boost/test/unit_test.hpp>
+
+#include <livre/data/DataSource.h>
+#include <livre/data/LODNode.h>
+#include <livre/data/MemoryDataSource.h>
+#include <livre/data/NodeId.h>
+#include <livre/data/VolumeInformation.h>
+
+#include <lunchbox/clock.h>
+#include <lunchbox/pluginRegisterer.h>
+
+#include <atomic>
+
+namespace
+{
+const size_t nPasses = 20; // e.g. the comparisons of a sort
+
+/** Memory data source which counts the computed nodes */
+class CountingDataSource : public livre::MemoryDataSource
+{
+public:
+    explicit CountingDataSource(const livre::DataSourcePluginData& initData)
+        : livre::MemoryDataSource(initData)
+    {
+    }
+
+    livre::LODNode internalNodeToLODNode(
+        const livre::NodeId& nodeId) const final
+    {
+        ++calls;
+        return livre::MemoryDataSource::internalNodeToLODNode(nodeId);
+    }
+
+    static bool handles(const livre::DataSourcePluginData& initData)
+    {
+        return initData.getURI().getScheme() == "count";
+    }
+
+    static std::string getDescription() { return "count://#x,y,z,block"; }
+    static std::atomic<size_t> calls;
+};
+
+std::atomic<size_t> CountingDataSource::calls{0};
+lunchbox::PluginRegisterer<CountingDataSource> registerer;
+
+livre::NodeIds getAllNodes(const livre::VolumeInformation& info,
+                           const uint32_t timeStep)
+{
+    livre::NodeIds nodeIds;
+    const livre::RootNode& rootNode = info.rootNode;
+    for (uint32_t level = 0; level < rootNode.getDepth(); ++level)
+    {
+        const livre::Vector3ui blocks = rootNode.getBlockSize(level);
+        for (uint32_t x = 0; x < blocks.x(); ++x)
+            for (uint32_t y = 0; y < blocks.y(); ++y)
+                for (uint32_t z = 0; z < blocks.z(); ++z)
+                    nodeIds.emplace_back(level, livre::Vector3ui(x, y, z),
+                                         timeStep);
+    }
+    return nodeIds;
+}
+
+template <class T>
+float lookup(const T& source, const livre::NodeIds& nodeIds)
+{
+    lunchbox::Clock clock;
+    float sum = 0.f;
+    for (size_t i = 0; i < nPasses; ++i)
+        for (const livre::NodeId& nodeId : nodeIds)
+            sum += source.getNode(nodeId).getWorldBox().getMin().x();
+    const float time = clock.getTimef();
+    BOOST_CHECK(sum == sum); // use result
+    return time;
+}
+}
+
+BOOST_AUTO_TEST_CASE(lodNodeLookup)
+{
+    const servus::URI uri("count://#1024,1024,1024,32");
+    const CountingDataSource plugin{livre::DataSourcePluginData(uri)};
+    const livre::DataSource source(uri);
+
+    const livre::NodeIds& nodeIds = getAllNodes(source.getVolumeInfo(), 0);
+    const size_t nLookups = nodeIds.size() * nPasses;
+
+    CountingDataSource::calls = 0;
+    const float uncachedTime = lookup(plugin, nodeIds);
+    const size_t uncachedCalls = CountingDataSource::calls;
+
+    CountingDataSource::calls = 0;
+    const float cachedTime = lookup(source, nodeIds);
+    const size_t cachedCalls = CountingDataSource::calls;
+
+    // the layout may change with the time step, other ones are computed once
+    CountingDataSource::calls = 0;
+    const float otherTime =
+        lookup(source, getAllNodes(source.getVolumeInfo(), 1));
+    BOOST_CHECK_EQUAL(CountingDataSource::calls.load(), nodeIds.size());
+
+    BOOST_CHECK_EQUAL(uncachedCalls, nLookups);
+    BOOST_CHECK_EQUAL(cachedCalls, nodeIds.size());
+
+    std::cout << nLookups << " lookups of " << nodeIds.size() << " nodes"
+              << std::endl
+              << "  plugin: " << uncachedCalls << " computed nodes, "
+              << nLookups / uncachedTime << " lookups/ms" << std::endl
+              << "  cached: " << cachedCalls << " computed nodes, "
+              << nLookups / cachedTime << " lookups/ms" << std::endl
+              << "  other time step: " << nLookups / otherTime
+              << " lookups/ms" << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(lodNodeEviction)
+{
+    // The nodes of the time steps played back once exceed the cache, the ones
+    // looked up in every frame mostly stay cached. Clearing the cache would
+    // recompute all of them.
+    const livre::DataSource source(servus::URI("count://#1024,1024,1024,32"));
+    const livre::NodeIds& inUse = getAllNodes(source.getVolumeInfo(), 0);
+    lookup(source, inUse);
+
+    size_t recomputed = 0;
+    for (uint32_t timeStep = 1; timeStep <= 10; ++timeStep)
+    {
+        lookup(source, getAllNodes(source.getVolumeInfo(), timeStep));
+        CountingDataSource::calls = 0;
+        lookup(source, inUse);
+        recomputed += CountingDataSource::calls;
+    }
+    BOOST_CHECK_LT(recomputed, inUse.size() / 10);
+}
@@ -0,0 +1,117 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define BOOST_TEST_MODULE PerfExecutor
+#include <boost/test/unit_test.hpp>
+
+#include "../core/render/DummyContext.h"
+
+#include <livre/core/pipeline/DependencyExecutor.h>
+#include <livre/core/pipeline/Filter.h>
+#include <livre/core/pipeline/FutureMap.h>
+#include <livre/core/pipeline/FuturePromise.h>
+#include <livre/core/pipeline/PipeFilter.h>
+#include <livre/core/pipeline/Pipeline.h>
+#include <livre/core/pipeline/PromiseMap.h>
+#include <livre/core/pipeline/SimpleExecutor.h>
+
+#include <lunchbox/clock.h>
+
+#include <sstream>
+
+namespace
+{
+const size_t nThreads = 4;
+const size_t nRounds = 20;
+const size_t chainLength = 200;
+
+class ForwardFilter : public livre::Filter
+{
+    void execute(const livre::FutureMap& input,
+                 livre::PromiseMap& output) const final
+    {
+        output.set("Output", input.get<uint32_t>("Input")[0] + 1);
+    }
+
+    livre::DataInfos getInputDataInfos() const final
+    {
+        return {{"Input", livre::getType<uint32_t>()}};
+    }
+
+    livre::DataInfos getOutputDataInfos() const final
+    {
+        return {{"Output", livre::getType<uint32_t>()}};
+    }
+};
+
+/**
+ * @return the average time in milliseconds from setting the input of a chain
+ * of filters until its output is ready, i.e. the scheduling latency of
+ * chainLength dependent filters.
+ */
+float measureLatency(livre::Executor& executor)
+{
+    float time = 0.f;
+    for (size_t i = 0; i < nRounds; ++i)
+    {
+        livre::Pipeline pipeline;
+        livre::PipeFilter first = pipeline.add<ForwardFilter>("Filter0");
+        livre::PipeFilter previous = first;
+        for (size_t j = 1; j < chainLength; ++j)
+        {
+            std::stringstream name;
+            name << "Filter" << j;
+            livre::PipeFilter filter = pipeline.add<ForwardFilter>(name.str());
+            previous.connect("Output", filter, "Input");
+            previous = filter;
+        }
+
+        livre::Promise input = first.getPromise("Input");
+        pipeline.schedule(executor);
+
+        lunchbox::Clock clock;
+        input.set(uint32_t(0));
+        const livre::UniqueFutureMap futures(previous.getPostconditions());
+        BOOST_CHECK_EQUAL(futures.get<uint32_t>("Output"), chainLength);
+        time += clock.getTimef();
+    }
+    return time / nRounds;
+}
+}
+
+BOOST_AUTO_TEST_CASE(schedulingLatency)
+{
+    const test::DummyContext context;
+    float simpleTime, dependencyTime;
+    {
+        livre::SimpleExecutor executor("Simple", nThreads, context);
+        simpleTime = measureLatency(executor);
+    }
+    {
+        livre::DependencyExecutor executor("Dependency", nThreads, context);
+        dependencyTime = measureLatency(executor);
+    }
+
+    std::cout << "Latency of a chain of " << chainLength << " filters"
+              << std::endl
+              << "  SimpleExecutor:     " << simpleTime << " ms, "
+              << 1000.f * simpleTime / chainLength << " us/filter" << std::endl
+              << "  DependencyExecutor: " << dependencyTime << " ms, "
+              << 1000.f * dependencyTime / chainLength << " us/filter"
+              << std::endl;
+}
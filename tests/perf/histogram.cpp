@@ -0,0 +1,95 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define BOOST_TEST_MODULE PerfHistogram
+#include <boost/test/unit_test.hpp>
+
+#include <livre/data/HistogramKernels.h>
+
+#include <lunchbox/clock.h>
+
+#include <boost/thread/thread.hpp>
+
+#include <limits>
+#include <random>
+
+namespace
+{
+const livre::Vector3ui blockSize(128);
+const livre::Vector3ui padding(1); // e.g. an overlap of one voxel
+const size_t nBricks = 10;
+
+template <class T>
+std::vector<T> makeBrick()
+{
+    const livre::Vector3ui size = blockSize + padding * 2;
+    std::vector<T> brick(size.product());
+    std::mt19937 engine(42);
+    std::normal_distribution<float> random(0.f, 1000.f);
+    for (T& voxel : brick)
+        voxel = T(std::max(std::min(random(engine),
+                                    float(std::numeric_limits<T>::max())),
+                           float(std::numeric_limits<T>::lowest())));
+    return brick;
+}
+
+/** @return the binned voxels per ms */
+template <class T>
+float binBricks(const std::vector<T>& brick, const size_t nBins,
+                const size_t nThreads)
+{
+    uint64_t sum = 0;
+    lunchbox::Clock clock;
+    for (size_t i = 0; i < nBricks; ++i)
+    {
+        float min = std::numeric_limits<float>::max();
+        float max = std::numeric_limits<float>::lowest();
+        std::vector<uint64_t> bins(nBins);
+        livre::binVoxels(brick.data(), blockSize, padding, 1, min, max, bins,
+                         nThreads);
+        for (const uint64_t bin : bins)
+            sum += bin;
+    }
+    const float time = clock.getTimef();
+    BOOST_CHECK_EQUAL(sum, nBricks * blockSize.product());
+    return nBricks * blockSize.product() / time;
+}
+
+template <class T>
+void benchmark(const std::string& type, const size_t nBins)
+{
+    const std::vector<T> brick = makeBrick<T>();
+    const size_t nThreads = boost::thread::hardware_concurrency();
+    std::cout << "  " << type << ": " << binBricks(brick, nBins, 1)
+              << " voxels/ms, " << binBricks(brick, nBins, nThreads)
+              << " voxels/ms on " << nThreads << " threads" << std::endl;
+}
+}
+
+BOOST_AUTO_TEST_CASE(binVoxels)
+{
+    std::cout << "Binning of " << nBricks << " padded bricks of "
+              << blockSize.product() << " voxels" << std::endl;
+    benchmark<uint8_t>("uint8", 256);
+    benchmark<uint16_t>("uint16", 1024);
+    benchmark<uint32_t>("uint32", 4096);
+    benchmark<int8_t>("int8", 256);
+    benchmark<int16_t>("int16", 1024);
+    benchmark<int32_t>("int32", 4096);
+    benchmark<float>("float", 256);
+}
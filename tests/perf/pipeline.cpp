@@ -0,0 +1,249 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define BOOST_TEST_MODULE PerfPipeline
+#include <boost/test/unit_test.hpp>
+
+#include "../core/render/DummyContext.h"
+
+#include <livre/core/pipeline/DependencyExecutor.h>
+#include <livre/core/pipeline/Filter.h>
+#include <livre/core/pipeline/FutureMap.h>
+#include <livre/core/pipeline/FuturePromise.h>
+#include <livre/core/pipeline/PipeFilter.h>
+#include <livre/core/pipeline/Pipeline.h>
+#include <livre/core/pipeline/PromiseMap.h>
+#include <livre/core/pipeline/SimpleExecutor.h>
+#include <livre/core/pipeline/Tracer.h>
+#include <livre/core/pipeline/Workers.h>
+
+#include <lunchbox/clock.h>
+
+#include <set>
+
+namespace
+{
+const size_t nThreads = 4;
+const size_t nPromises = 100000;
+const size_t nFilters = 10000;
+const size_t nChained = 2000;
+
+class ForwardFilter : public livre::Filter
+{
+    void execute(const livre::FutureMap& input,
+                 livre::PromiseMap& output) const final
+    {
+        output.set("Output", input.get<uint32_t>("Input")[0] + 1);
+    }
+
+    livre::DataInfos getInputDataInfos() const final
+    {
+        return {{"Input", livre::getType<uint32_t>()}};
+    }
+
+    livre::DataInfos getOutputDataInfos() const final
+    {
+        return {{"Output", livre::getType<uint32_t>()}};
+    }
+};
+
+/** @return the time in milliseconds to run nFilters independent filters */
+float measureThroughput(livre::Executor& executor)
+{
+    livre::Pipeline pipeline;
+    livre::Promises inputs;
+    livre::Futures outputs;
+    for (size_t i = 0; i < nFilters; ++i)
+    {
+        livre::PipeFilter filter =
+            pipeline.add<ForwardFilter>(std::to_string(i));
+        inputs.push_back(filter.getPromise("Input"));
+        const livre::Futures& futures = filter.getPostconditions();
+        outputs.insert(outputs.end(), futures.begin(), futures.end());
+    }
+
+    lunchbox::Clock clock;
+    for (livre::Promise& input : inputs)
+        input.set(uint32_t(0));
+    pipeline.schedule(executor);
+    livre::FutureMap(outputs).wait();
+    return clock.getTimef();
+}
+}
+
+BOOST_AUTO_TEST_CASE(promiseCreation)
+{
+    lunchbox::Clock clock;
+    std::set<uint64_t> ids;
+    for (size_t i = 0; i < nPromises; ++i)
+    {
+        livre::Promise promise(livre::DataInfo("Data",
+                                               livre::getType<uint32_t>()));
+        ids.insert(livre::Future(promise).getId());
+    }
+    const float createTime = clock.getTimef();
+
+    livre::Promise promise(livre::DataInfo("Data", livre::getType<uint32_t>()));
+    const livre::Future future(promise);
+    clock.reset();
+    for (size_t i = 0; i < nPromises; ++i)
+    {
+        promise.reset();
+        ids.insert(future.getId());
+    }
+    const float resetTime = clock.getTimef();
+
+    // identifiers are never reused, neither by new promises nor by resets
+    BOOST_CHECK_EQUAL(ids.size(), 2 * nPromises);
+
+    std::cout << nPromises << " promises" << std::endl
+              << "  creation: " << nPromises / createTime << " promises/ms"
+              << std::endl
+              << "  reset:    " << nPromises / resetTime << " resets/ms"
+              << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(filterCreation)
+{
+    lunchbox::Clock clock;
+    livre::Pipeline pipeline;
+    for (size_t i = 0; i < nFilters; ++i)
+        pipeline.add<ForwardFilter>(std::to_string(i));
+    const float createTime = clock.getTimef();
+
+    clock.reset();
+    pipeline.reset();
+    const float resetTime = clock.getTimef();
+
+    BOOST_CHECK_EQUAL(pipeline.getPostconditions().size(), nFilters);
+    std::cout << nFilters << " filters" << std::endl
+              << "  creation: " << nFilters / createTime << " filters/ms"
+              << std::endl
+              << "  reset:    " << nFilters / resetTime << " filters/ms"
+              << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(schedulingThroughput)
+{
+    const test::DummyContext context;
+    float simpleTime, dependencyTime;
+    {
+        livre::SimpleExecutor executor("Simple", nThreads, context);
+        simpleTime = measureThroughput(executor);
+    }
+    {
+        livre::DependencyExecutor executor("Dependency", nThreads, context);
+        dependencyTime = measureThroughput(executor);
+    }
+
+    std::cout << "Throughput of " << nFilters << " independent filters"
+              << std::endl
+              << "  SimpleExecutor:     " << nFilters / simpleTime
+              << " filters/ms" << std::endl
+              << "  DependencyExecutor: " << nFilters / dependencyTime
+              << " filters/ms" << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(tracingOverhead)
+{
+    const test::DummyContext context;
+    livre::DependencyExecutor executor("Dependency", nThreads, context);
+    measureThroughput(executor); // warm up
+
+    livre::Tracer::setEnabled(false);
+    const float disabledTime = measureThroughput(executor);
+    livre::Tracer::setEnabled(true);
+    const float enabledTime = measureThroughput(executor);
+    livre::Tracer::setEnabled(false);
+    livre::Tracer::clear();
+
+    std::cout << "Throughput of " << nFilters << " independent filters"
+              << std::endl
+              << "  tracing disabled: " << nFilters / disabledTime
+              << " filters/ms" << std::endl
+              << "  tracing enabled:  " << nFilters / enabledTime
+              << " filters/ms" << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(affinityThroughput)
+{
+    // e.g. "socket:0" or "cores:0-3", the first argument after '--'
+    const auto& argv = boost::unit_test::framework::master_test_suite().argv;
+    const std::string affinity =
+        boost::unit_test::framework::master_test_suite().argc > 1
+            ? argv[1]
+            : "cores:0-" + std::to_string(nThreads - 1);
+
+    const test::DummyContext context;
+    float inheritedTime, boundTime;
+    {
+        livre::Workers workers("Inherited", nThreads, context);
+        livre::DependencyExecutor executor(workers, livre::PRIORITY_RENDER);
+        measureThroughput(executor); // warm up
+        inheritedTime = measureThroughput(executor);
+    }
+    {
+        livre::Workers workers("Bound", nThreads, context,
+                               livre::Workers::parseAffinities(affinity));
+        livre::DependencyExecutor executor(workers, livre::PRIORITY_RENDER);
+        measureThroughput(executor); // warm up
+        boundTime = measureThroughput(executor);
+    }
+
+    std::cout << "Throughput of " << nFilters << " independent filters"
+              << std::endl
+              << "  inherited affinity: " << nFilters / inheritedTime
+              << " filters/ms" << std::endl
+              << "  " << affinity << ": " << nFilters / boundTime
+              << " filters/ms" << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(chainExecution)
+{
+    // the names sort the filters in the reverse order of the chain
+    livre::Pipeline pipeline;
+    std::vector<livre::PipeFilter> filters;
+    for (size_t i = 0; i < nChained; ++i)
+    {
+        const std::string name = std::to_string(nChained - i + nChained);
+        filters.push_back(pipeline.add<ForwardFilter>(name));
+        if (i > 0)
+            filters[i - 1].connect("Output", filters[i], "Input");
+    }
+    livre::Promise input = filters.front().getPromise("Input");
+    const livre::PipeFilter& last = filters.back();
+
+    lunchbox::Clock clock;
+    input.set(uint32_t(0));
+    pipeline.execute();
+    const float firstTime = clock.getTimef();
+    BOOST_CHECK_EQUAL(livre::UniqueFutureMap(last.getPostconditions())
+                          .get<uint32_t>("Output"),
+                      nChained);
+
+    pipeline.reset();
+    clock.reset();
+    input.set(uint32_t(0));
+    pipeline.execute();
+    const float nextTime = clock.getTimef();
+
+    std::cout << "Synchronous execution of a chain of " << nChained
+              << " filters" << std::endl
+              << "  first execution: " << firstTime << " ms" << std::endl
+              << "  next execution:  " << nextTime << " ms" << std::endl;
+}
@@ -0,0 +1,166 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define BOOST_TEST_MODULE PerfPortData
+#include <boost/test/unit_test.hpp>
+
+#include <livre/core/pipeline/Filter.h>
+#include <livre/core/pipeline/FutureMap.h>
+#include <livre/core/pipeline/FuturePromise.h>
+#include <livre/core/pipeline/PipeFilter.h>
+#include <livre/core/pipeline/PromiseMap.h>
+
+#include <lunchbox/clock.h>
+
+#include <atomic>
+
+namespace
+{
+const size_t nObjects = 100000; // e.g. the cache objects of a frame
+const size_t nRounds = 20;
+const size_t nConsumers = 2; // e.g. the render and histogram filters
+
+/** Shared pointer which counts the reference count increments */
+struct CountedPtr
+{
+    CountedPtr()
+        : ptr(std::make_shared<const int>(0))
+    {
+    }
+
+    CountedPtr(const CountedPtr& other)
+        : ptr(other.ptr)
+    {
+        ++increments;
+    }
+
+    CountedPtr(CountedPtr&&) = default;
+
+    std::shared_ptr<const int> ptr;
+    static std::atomic<size_t> increments;
+};
+
+std::atomic<size_t> CountedPtr::increments{0};
+typedef std::vector<CountedPtr> CountedPtrs;
+
+template <bool move>
+class ProducerFilter : public livre::Filter
+{
+    void execute(const livre::FutureMap&,
+                 livre::PromiseMap& output) const final
+    {
+        CountedPtrs objects(nObjects);
+        if (move)
+            output.set("Objects", std::move(objects));
+        else
+            output.set("Objects", objects);
+    }
+
+    livre::DataInfos getOutputDataInfos() const final
+    {
+        return {{"Objects", livre::getType<CountedPtrs>()}};
+    }
+};
+
+template <bool reference>
+class ConsumerFilter : public livre::Filter
+{
+    void execute(const livre::FutureMap& input,
+                 livre::PromiseMap& output) const final
+    {
+        size_t count = 0;
+        if (reference)
+        {
+            for (const CountedPtrs& objects :
+                 input.getRefs<CountedPtrs>("Objects"))
+                count += objects.size();
+        }
+        else
+        {
+            for (const CountedPtrs& objects :
+                 input.get<CountedPtrs>("Objects"))
+                count += objects.size();
+        }
+        output.set("Count", count);
+    }
+
+    livre::DataInfos getInputDataInfos() const final
+    {
+        return {{"Objects", livre::getType<CountedPtrs>()}};
+    }
+
+    livre::DataInfos getOutputDataInfos() const final
+    {
+        return {{"Count", livre::getType<size_t>()}};
+    }
+};
+
+/**
+ * Runs a producer feeding nConsumers consumers nRounds times.
+ * @return the time in milliseconds per round
+ */
+template <bool zeroCopy>
+float measure(size_t& increments)
+{
+    livre::PipeFilterT<ProducerFilter<zeroCopy>> producer("Producer");
+    std::vector<livre::PipeFilter> consumers;
+    for (size_t i = 0; i < nConsumers; ++i)
+    {
+        consumers.push_back(livre::PipeFilterT<ConsumerFilter<zeroCopy>>(
+            "Consumer" + std::to_string(i)));
+        producer.connect("Objects", consumers.back(), "Objects");
+    }
+
+    CountedPtr::increments = 0;
+    lunchbox::Clock clock;
+    for (size_t i = 0; i < nRounds; ++i)
+    {
+        producer.execute();
+        for (livre::PipeFilter& consumer : consumers)
+        {
+            consumer.execute();
+            const livre::UniqueFutureMap futures(consumer.getPostconditions());
+            BOOST_CHECK_EQUAL(futures.get<size_t>("Count"), nObjects);
+            consumer.reset();
+        }
+        producer.reset();
+    }
+    increments = CountedPtr::increments;
+    return clock.getTimef() / nRounds;
+}
+}
+
+BOOST_AUTO_TEST_CASE(portDataCopies)
+{
+    size_t copyIncrements, zeroCopyIncrements;
+    const float copyTime = measure<false>(copyIncrements);
+    const float zeroCopyTime = measure<true>(zeroCopyIncrements);
+
+    // one copy into the port, one copy out of it per consumer
+    BOOST_CHECK_EQUAL(copyIncrements, nRounds * nObjects * (1 + nConsumers));
+    BOOST_CHECK_EQUAL(zeroCopyIncrements, 0);
+
+    std::cout << nObjects << " objects to " << nConsumers << " consumers"
+              << std::endl
+              << "  copy:      " << copyIncrements / nRounds
+              << " refcount increments, " << copyTime << " ms/frame"
+              << std::endl
+              << "  zero copy: " << zeroCopyIncrements / nRounds
+              << " refcount increments, " << zeroCopyTime << " ms/frame"
+              << std::endl;
+}
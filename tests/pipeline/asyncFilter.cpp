@@ -0,0 +1,173 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define BOOST_TEST_MODULE AsyncFilter
+
+#include "../core/render/DummyContext.h"
+
+#include <livre/core/pipeline/AsyncFilter.h>
+#include <livre/core/pipeline/DependencyExecutor.h>
+#include <livre/core/pipeline/FutureMap.h>
+#include <livre/core/pipeline/PipeFilter.h>
+#include <livre/core/pipeline/PromiseMap.h>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <atomic>
+
+namespace
+{
+const size_t nFilters = 1000;
+const size_t nThreads = 4;
+
+/** Adds the result of an I/O request, which it waits for, to its input */
+class ReadFilter : public livre::AsyncFilter
+{
+public:
+    ReadFilter(const livre::Future& request, std::atomic<size_t>& suspended)
+        : _request(request)
+        , _suspended(suspended)
+    {
+    }
+
+private:
+    void execute(const livre::FutureMap&, livre::PromiseMap&,
+                 livre::Suspension& suspension) const final
+    {
+        ++_suspended;
+        suspension.await({_request}, [this](const livre::FutureMap& input,
+                                            livre::PromiseMap& output,
+                                            livre::Suspension&) {
+            --_suspended;
+            output.set("Output", input.get<uint32_t>("Input")[0] +
+                                     _request.get<uint32_t>());
+        });
+    }
+
+    livre::DataInfos getInputDataInfos() const final
+    {
+        return {{"Input", livre::getType<uint32_t>()}};
+    }
+
+    livre::DataInfos getOutputDataInfos() const final
+    {
+        return {{"Output", livre::getType<uint32_t>()}};
+    }
+
+    const livre::Future _request;
+    std::atomic<size_t>& _suspended;
+};
+
+bool waitForSuspended(const std::atomic<size_t>& suspended, const size_t n)
+{
+    for (size_t i = 0; i < 10000 && suspended != n; ++i)
+        boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+    return suspended == n;
+}
+}
+
+BOOST_AUTO_TEST_CASE(testSuspendedFilters)
+{
+    std::vector<livre::Promise> requests;
+    std::vector<livre::PipeFilter> filters;
+    std::atomic<size_t> suspended(0);
+    for (size_t i = 0; i < nFilters; ++i)
+    {
+        requests.emplace_back(
+            livre::DataInfo("Request", livre::getType<uint32_t>()));
+        filters.push_back(livre::PipeFilterT<ReadFilter>(
+            "Reader", requests.back().getFuture(), suspended));
+        filters.back().getPromise("Input").set(uint32_t(i));
+    }
+
+    const test::DummyContext context;
+    livre::DependencyExecutor executor("Executor", nThreads, context);
+    for (livre::PipeFilter& filter : filters)
+        filter.schedule(executor);
+
+    // all the filters wait for their request, none holds a thread
+    BOOST_REQUIRE(waitForSuspended(suspended, nFilters));
+    for (const livre::PipeFilter& filter : filters)
+        BOOST_CHECK(!filter.getPostconditions().front().isReady());
+
+    for (size_t i = 0; i < nFilters; ++i)
+        requests[i].set(uint32_t(2 * i));
+
+    for (size_t i = 0; i < nFilters; ++i)
+    {
+        const livre::UniqueFutureMap futures(filters[i].getPostconditions());
+        BOOST_CHECK_EQUAL(futures.get<uint32_t>("Output"), 3 * i);
+    }
+    BOOST_CHECK_EQUAL(suspended, 0);
+}
+
+BOOST_AUTO_TEST_CASE(testSynchronousExecution)
+{
+    livre::Promise request(
+        livre::DataInfo("Request", livre::getType<uint32_t>()));
+    std::atomic<size_t> suspended(0);
+    livre::PipeFilterT<ReadFilter> filter("Reader", request.getFuture(),
+                                          suspended);
+    filter.getPromise("Input").set(uint32_t(1));
+
+    // a direct execution waits for the request on the calling thread
+    boost::thread io([&request, &suspended] {
+        waitForSuspended(suspended, 1);
+        request.set(uint32_t(2));
+    });
+    filter.execute();
+    io.join();
+
+    const livre::UniqueFutureMap futures(filter.getPostconditions());
+    BOOST_CHECK_EQUAL(futures.get<uint32_t>("Output"), 3);
+}
+
+BOOST_AUTO_TEST_CASE(testCanceledSuspension)
+{
+    livre::Promise request(
+        livre::DataInfo("Request", livre::getType<uint32_t>()));
+    std::atomic<size_t> suspended(0);
+    livre::PipeFilterT<ReadFilter> filter("Reader", request.getFuture(),
+                                          suspended);
+    filter.getPromise("Input").set(uint32_t(1));
+    livre::CancelToken token;
+    filter.setCancelToken(token);
+
+    const test::DummyContext context;
+    livre::DependencyExecutor executor("Executor", nThreads, context);
+    filter.schedule(executor);
+    BOOST_REQUIRE(waitForSuspended(suspended, 1));
+
+    // the suspended execution is not resumed, but its outputs are flushed
+    token.cancel();
+    request.set(uint32_t(2));
+    const livre::UniqueFutureMap futures(filter.getPostconditions());
+    futures.wait("Output");
+    BOOST_CHECK_THROW(futures.get<uint32_t>("Output"), std::runtime_error);
+    BOOST_CHECK_EQUAL(suspended, 1);
+
+    livre::Suspension suspension(token);
+    const livre::AsyncFilter::Step step = [](const livre::FutureMap&,
+                                             livre::PromiseMap&,
+                                             livre::Suspension&) {};
+    suspension.await({request.getFuture()}, step);
+    BOOST_CHECK(suspension.isSuspended());
+    BOOST_CHECK_THROW(suspension.await({request.getFuture()}, step),
+                      std::logic_error);
+}
@@ -0,0 +1,224 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define BOOST_TEST_MODULE DependencyExecutor
+
+#include "../core/render/DummyContext.h"
+
+#include <livre/core/pipeline/DependencyExecutor.h>
+#include <livre/core/pipeline/Filter.h>
+#include <livre/core/pipeline/FutureMap.h>
+#include <livre/core/pipeline/FuturePromise.h>
+#include <livre/core/pipeline/PipeFilter.h>
+#include <livre/core/pipeline/Pipeline.h>
+#include <livre/core/pipeline/PromiseMap.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+
+namespace
+{
+const size_t nThreads = 4;
+const size_t nRounds = 10;
+const size_t chainLength = 1000;
+const size_t fanWidth = 1000;
+
+/** Outputs the sum of its inputs plus one */
+class IncrementFilter : public livre::Filter
+{
+    void execute(const livre::FutureMap& input,
+                 livre::PromiseMap& output) const final
+    {
+        uint32_t sum = 1;
+        for (const uint32_t value : input.get<uint32_t>("Input"))
+            sum += value;
+        output.set("Output", sum);
+    }
+
+    livre::DataInfos getInputDataInfos() const final
+    {
+        return {{"Input", livre::getType<uint32_t>()}};
+    }
+
+    livre::DataInfos getOutputDataInfos() const final
+    {
+        return {{"Output", livre::getType<uint32_t>()}};
+    }
+};
+
+std::string getName(const std::string& prefix, const size_t index)
+{
+    std::stringstream name;
+    name << prefix << index;
+    return name.str();
+}
+
+/**
+ * Source -> chain of increments -> fan out of increments -> Sink, which yields
+ * ( chainLength + 2 ) * fanWidth + 1 in the sink. The filters are scheduled in
+ * the order of their names, so most consumers are scheduled before their
+ * producers.
+ */
+livre::Pipeline createPipeline()
+{
+    livre::Pipeline pipeline;
+    livre::PipeFilter previous = pipeline.add<IncrementFilter>("Source");
+    livre::PipeFilter sink = pipeline.add<IncrementFilter>("Sink");
+
+    for (size_t i = 0; i < chainLength; ++i)
+    {
+        livre::PipeFilter filter =
+            pipeline.add<IncrementFilter>(getName("Chain", i));
+        previous.connect("Output", filter, "Input");
+        previous = filter;
+    }
+
+    for (size_t i = 0; i < fanWidth; ++i)
+    {
+        livre::PipeFilter filter =
+            pipeline.add<IncrementFilter>(getName("Fan", i));
+        previous.connect("Output", filter, "Input");
+        filter.connect("Output", sink, "Input");
+    }
+    return pipeline;
+}
+
+livre::PipeFilter& getFilter(livre::Pipeline& pipeline, const std::string& name)
+{
+    return static_cast<livre::PipeFilter&>(pipeline.getExecutable(name));
+}
+
+/** Waits for a future and counts its living copies */
+class CountedExecutable : public livre::Executable
+{
+public:
+    explicit CountedExecutable(const livre::Future& future)
+        : _future(future)
+    {
+        ++instances;
+    }
+
+    CountedExecutable(const CountedExecutable& from)
+        : livre::Executable()
+        , _future(from._future)
+    {
+        ++instances;
+    }
+
+    ~CountedExecutable() { --instances; }
+    void execute() final {}
+    livre::Futures getPostconditions() const final { return {}; }
+    livre::Futures getPreconditions() const final { return {_future}; }
+    livre::ExecutablePtr clone() const final
+    {
+        return livre::ExecutablePtr(new CountedExecutable(*this));
+    }
+
+    static size_t instances;
+
+private:
+    const livre::Future _future;
+};
+
+size_t CountedExecutable::instances = 0;
+}
+
+BOOST_AUTO_TEST_CASE(testOnReady)
+{
+    livre::Promise promise(livre::DataInfo("Value", livre::getType<int>()));
+    const livre::Future future = promise.getFuture();
+
+    size_t calls = 0;
+    future.onReady([&calls] { ++calls; });
+    BOOST_CHECK_EQUAL(calls, 0);
+
+    promise.set(42);
+    BOOST_CHECK_EQUAL(calls, 1);
+
+    // Called immediately on ready futures
+    future.onReady([&calls] { ++calls; });
+    BOOST_CHECK_EQUAL(calls, 2);
+
+    // Futures of the reset promise wait for the new value
+    promise.reset();
+    const livre::Future resetFuture = promise.getFuture();
+    resetFuture.onReady([&calls] { ++calls; });
+    BOOST_CHECK_EQUAL(calls, 2);
+    promise.set(43);
+    BOOST_CHECK_EQUAL(calls, 3);
+}
+
+BOOST_AUTO_TEST_CASE(testManySmallFilters)
+{
+    const test::DummyContext context;
+    livre::DependencyExecutor executor("test", nThreads, context);
+
+    for (size_t i = 0; i < nRounds; ++i)
+    {
+        livre::Pipeline pipeline = createPipeline();
+
+        // The input is connected before and set after scheduling
+        livre::Promise input =
+            getFilter(pipeline, "Source").getPromise("Input");
+        pipeline.schedule(executor);
+        input.set(uint32_t(0));
+
+        const livre::UniqueFutureMap futures(
+            getFilter(pipeline, "Sink").getPostconditions());
+        BOOST_CHECK_EQUAL(futures.get<uint32_t>("Output"),
+                          (chainLength + 2) * fanWidth + 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(testDestroyWithPendingExecutables)
+{
+    livre::PipeFilterT<IncrementFilter> filter("Filter");
+    livre::Promise input = filter.getPromise("Input");
+    {
+        const test::DummyContext context;
+        livre::DependencyExecutor executor("test", nThreads, context);
+        filter.schedule(executor);
+    }
+
+    // The executor is gone, the filter is never executed
+    input.set(uint32_t(0));
+    BOOST_CHECK(!livre::FutureMap(filter.getPostconditions()).isReady());
+}
+
+BOOST_AUTO_TEST_CASE(testClearFreesPendingExecutables)
+{
+    const test::DummyContext context;
+    livre::DependencyExecutor executor("test", nThreads, context);
+
+    // The promise is never set, its future holds the scheduling callback
+    livre::Promise promise(livre::DataInfo("Value", livre::getType<int>()));
+    {
+        CountedExecutable executable(promise.getFuture());
+        executable.schedule(executor);
+        BOOST_CHECK_EQUAL(CountedExecutable::instances, 2);
+    }
+    BOOST_CHECK_EQUAL(CountedExecutable::instances, 1);
+
+    executor.clear();
+    BOOST_CHECK_EQUAL(CountedExecutable::instances, 0);
+
+    // The callback of the cleared executable does nothing
+    promise.set(42);
+    BOOST_CHECK_EQUAL(CountedExecutable::instances, 0);
+}
@@ -19,6 +19,10 @@
 
 #define BOOST_TEST_MODULE Pipeline
 
+#include "../core/render/DummyContext.h"
+
+#include <livre/core/pipeline/CancelToken.h>
+#include <livre/core/pipeline/DependencyExecutor.h>
 #include <livre/core/pipeline/Filter.h>
 #include <livre/core/pipeline/FutureMap.h>
 #include <livre/core/pipeline/FuturePromise.h>
@@ -27,9 +31,11 @@
 #include <livre/core/pipeline/PromiseMap.h>
 #include <livre/core/pipeline/SimpleExecutor.h>
 #include <livre/core/pipeline/Workers.h>
-#include <livre/core/render/GLContext.h>
 
 #include <boost/test/unit_test.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <atomic>
 
 namespace ut = boost::unit_test;
 
@@ -115,6 +121,101 @@ class ConvertFilter : public livre::Filter
     }
 };
 
+class CountingFilter : public livre::Filter
+{
+public:
+    explicit CountingFilter(size_t& iterations)
+        : _iterations(iterations)
+    {
+    }
+
+private:
+    void execute(const livre::FutureMap& input,
+                 livre::PromiseMap& output) const final
+    {
+        execute(input, output, livre::CancelToken());
+    }
+
+    void execute(const livre::FutureMap& input, livre::PromiseMap& output,
+                 const livre::CancelToken& token) const final
+    {
+        livre::CancelToken canceler = input.get<livre::CancelToken>("Token")[0];
+        for (size_t i = 0; i < 100; ++i)
+        {
+            if (token.isCanceled())
+                return;
+            if (++_iterations == 10)
+                canceler.cancel();
+        }
+        output.set("Iterations", uint32_t(_iterations));
+    }
+
+    livre::DataInfos getInputDataInfos() const final
+    {
+        return {{"Token", livre::getType<livre::CancelToken>()}};
+    }
+
+    livre::DataInfos getOutputDataInfos() const final
+    {
+        return {{"Iterations", livre::getType<uint32_t>()}};
+    }
+
+    size_t& _iterations;
+};
+
+/** Adds one to the sum of its inputs, and tracks the concurrent executions */
+class SumFilter : public livre::Filter
+{
+public:
+    explicit SumFilter(std::atomic<size_t>* running = nullptr,
+                       std::atomic<size_t>* maxRunning = nullptr)
+        : _running(running)
+        , _maxRunning(maxRunning)
+    {
+    }
+
+private:
+    void execute(const livre::FutureMap& input,
+                 livre::PromiseMap& output) const final
+    {
+        if (_running)
+        {
+            const size_t running = ++*_running;
+            size_t maxRunning = *_maxRunning;
+            while (running > maxRunning &&
+                   !_maxRunning->compare_exchange_weak(maxRunning, running))
+            {
+            }
+            boost::this_thread::sleep_for(boost::chrono::milliseconds(20));
+            --*_running;
+        }
+
+        uint32_t sum = 1;
+        for (const uint32_t value : input.get<uint32_t>("Input"))
+            sum += value;
+        output.set("Output", sum);
+    }
+
+    livre::DataInfos getInputDataInfos() const final
+    {
+        return {{"Input", livre::getType<uint32_t>()}};
+    }
+
+    livre::DataInfos getOutputDataInfos() const final
+    {
+        return {{"Output", livre::getType<uint32_t>()}};
+    }
+
+    std::atomic<size_t>* _running;
+    std::atomic<size_t>* _maxRunning;
+};
+
+uint32_t getOutput(const livre::PipeFilter& filter)
+{
+    const livre::UniqueFutureMap futures(filter.getPostconditions());
+    return futures.get<uint32_t>("Output");
+}
+
 bool check_error(const std::runtime_error&)
 {
     return true;
@@ -230,30 +331,12 @@ BOOST_AUTO_TEST_CASE(testSynchronousPipeline)
     BOOST_CHECK_EQUAL(outputData.thanksForAllTheFish, 222);
 }
 
-namespace
-{
-class DummyContext : public livre::GLContext
-{
-public:
-    DummyContext()
-        : livre::GLContext(nullptr)
-    {
-    }
-
-private:
-    livre::GLContextPtr clone() const final
-    {
-        return livre::GLContextPtr(new DummyContext);
-    }
-};
-}
-
 BOOST_AUTO_TEST_CASE(testWaitPipeline)
 {
     const uint32_t inputValue = 90;
     livre::Pipeline pipeline = createPipeline(inputValue, 1);
 
-    const DummyContext context;
+    const test::DummyContext context;
     livre::SimpleExecutor executor("test", 2, context);
 
     const livre::FutureMap pipelineFutures(pipeline.schedule(executor));
@@ -271,7 +354,7 @@ BOOST_AUTO_TEST_CASE(testAsynchronousPipeline)
     const uint32_t inputValue = 90;
     livre::Pipeline pipeline = createPipeline(inputValue, 1);
 
-    const DummyContext context;
+    const test::DummyContext context;
     livre::SimpleExecutor executor("test", 2, context);
 
     pipeline.schedule(executor);
@@ -327,3 +410,127 @@ BOOST_AUTO_TEST_CASE(testFutureMaps)
                       std::logic_error);
     const livre::FutureMap portFutures2(nonUniqueFutures);
 }
+
+BOOST_AUTO_TEST_CASE(testCancel)
+{
+    livre::Pipeline pipeline = createPipeline(90, 1);
+    livre::CancelToken token;
+    pipeline.setCancelToken(token);
+    token.cancel();
+
+    // canceled filters do not run, but their outputs are flushed
+    pipeline.execute();
+    const livre::Executable& pipeOutput = pipeline.getExecutable("Consumer");
+    const livre::UniqueFutureMap portFutures(pipeOutput.getPostconditions());
+    BOOST_CHECK(portFutures.isReady("TestOutputData"));
+    BOOST_CHECK_THROW(portFutures.get<OutputData>("TestOutputData"),
+                      std::runtime_error);
+
+    // the filters of a new frame get a new token
+    livre::Pipeline newPipeline = createPipeline(90, 1);
+    newPipeline.setCancelToken(livre::CancelToken());
+    newPipeline.execute();
+    const livre::UniqueFutureMap newFutures(
+        newPipeline.getExecutable("Consumer").getPostconditions());
+    BOOST_CHECK_EQUAL(
+        newFutures.get<OutputData>("TestOutputData").thanksForAllTheFish, 222);
+
+    // long running filters return early
+    size_t iterations = 0;
+    livre::PipeFilterT<CountingFilter> counter("Counter", iterations);
+    livre::CancelToken counterToken;
+    counter.setCancelToken(counterToken);
+    counter.getPromise("Token").set(counterToken);
+    counter.execute();
+    BOOST_CHECK_EQUAL(iterations, 10);
+    BOOST_CHECK(counter.getPostconditions().front().isReady());
+}
+
+BOOST_AUTO_TEST_CASE(testDiamondPipeline)
+{
+    // added in reverse order, the names sort the sink first
+    livre::Pipeline pipeline;
+    livre::PipeFilter sink = pipeline.add<SumFilter>("A");
+    livre::PipeFilter right = pipeline.add<SumFilter>("B");
+    livre::PipeFilter left = pipeline.add<SumFilter>("C");
+    livre::PipeFilter source = pipeline.add<SumFilter>("D");
+    source.connect("Output", left, "Input");
+    source.connect("Output", right, "Input");
+    left.connect("Output", sink, "Input");
+    right.connect("Output", sink, "Input");
+
+    // the input of the source is set while the pipeline waits for it
+    livre::Promise input = source.getPromise("Input");
+    boost::thread setter([&input] {
+        boost::this_thread::sleep_for(boost::chrono::milliseconds(10));
+        input.set(uint32_t(1));
+    });
+    pipeline.execute();
+    setter.join();
+
+    BOOST_CHECK_EQUAL(getOutput(source), 2);
+    BOOST_CHECK_EQUAL(getOutput(left), 3);
+    BOOST_CHECK_EQUAL(getOutput(right), 3);
+    BOOST_CHECK_EQUAL(getOutput(sink), 7);
+    BOOST_CHECK_EQUAL(pipeline.getPreconditions().size(), 1);
+
+    // the order is kept for later executions, and renewed for new
+    // connections; every execution reads the values of the current one
+    for (uint32_t value = 2; value < 5; ++value)
+    {
+        pipeline.reset();
+        input.set(value);
+        pipeline.execute();
+        BOOST_CHECK_EQUAL(getOutput(left), value + 2);
+        BOOST_CHECK_EQUAL(getOutput(right), value + 2);
+        BOOST_CHECK_EQUAL(getOutput(sink), 2 * value + 5);
+    }
+
+    livre::PipeFilter extra = pipeline.add<SumFilter>("E");
+    source.connect("Output", extra, "Input");
+    extra.connect("Output", sink, "Input");
+    for (uint32_t value = 2; value < 5; ++value)
+    {
+        pipeline.reset();
+        input.set(value);
+        pipeline.execute();
+        BOOST_CHECK_EQUAL(getOutput(sink), 3 * value + 7);
+    }
+
+    // a cycle has no order
+    sink.connect("Output", source, "Input");
+    BOOST_CHECK_THROW(pipeline.execute(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(testFanOutPipeline)
+{
+    const size_t nConsumers = 8;
+    std::atomic<size_t> running(0);
+    std::atomic<size_t> maxRunning(0);
+
+    livre::Pipeline pipeline;
+    livre::PipeFilter source = pipeline.add<SumFilter>("Source");
+    std::vector<livre::PipeFilter> consumers;
+    for (size_t i = 0; i < nConsumers; ++i)
+    {
+        consumers.push_back(pipeline.add<SumFilter>(
+            "Consumer" + std::to_string(i), &running, &maxRunning));
+        source.connect("Output", consumers.back(), "Input");
+    }
+    source.getPromise("Input").set(uint32_t(1));
+
+    pipeline.execute();
+    for (const livre::PipeFilter& consumer : consumers)
+        BOOST_CHECK_EQUAL(getOutput(consumer), 3);
+    BOOST_CHECK_EQUAL(maxRunning, 1);
+
+    // the consumers run in parallel on the executor
+    const test::DummyContext context;
+    livre::DependencyExecutor executor("Executor", 4, context);
+    pipeline.reset();
+    source.getPromise("Input").set(uint32_t(2));
+    pipeline.execute(executor);
+    for (const livre::PipeFilter& consumer : consumers)
+        BOOST_CHECK_EQUAL(getOutput(consumer), 4);
+    BOOST_CHECK_GT(maxRunning, 1);
+}
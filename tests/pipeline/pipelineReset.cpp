@@ -0,0 +1,108 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define BOOST_TEST_MODULE PipelineReset
+
+#include <livre/core/pipeline/Filter.h>
+#include <livre/core/pipeline/FutureMap.h>
+#include <livre/core/pipeline/FuturePromise.h>
+#include <livre/core/pipeline/PipeFilter.h>
+#include <livre/core/pipeline/Pipeline.h>
+#include <livre/core/pipeline/PromiseMap.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+const size_t nFrames = 100;
+const size_t nConsumers = 4;
+
+/** Outputs the sum of its inputs plus one */
+class IncrementFilter : public livre::Filter
+{
+    void execute(const livre::FutureMap& input,
+                 livre::PromiseMap& output) const final
+    {
+        uint32_t sum = 1;
+        for (const uint32_t value : input.get<uint32_t>("Input"))
+            sum += value;
+        output.set("Output", sum);
+    }
+
+    livre::DataInfos getInputDataInfos() const final
+    {
+        return {{"Input", livre::getType<uint32_t>()}};
+    }
+
+    livre::DataInfos getOutputDataInfos() const final
+    {
+        return {{"Output", livre::getType<uint32_t>()}};
+    }
+};
+
+/** Producer -> nConsumers -> Sink, similar to the render pipeline */
+struct Graph
+{
+    Graph()
+        : producer(pipeline.add<IncrementFilter>("Producer"))
+        , sink(pipeline.add<IncrementFilter>("Sink"))
+    {
+        for (size_t i = 0; i < nConsumers; ++i)
+        {
+            std::stringstream name;
+            name << "Consumer" << i;
+            livre::PipeFilter consumer =
+                pipeline.add<IncrementFilter>(name.str());
+            producer.connect("Output", consumer, "Input");
+            consumer.connect("Output", sink, "Input");
+        }
+    }
+
+    void setInput(const uint32_t input)
+    {
+        producer.getPromise("Input").set(input);
+    }
+
+    uint32_t execute()
+    {
+        pipeline.execute();
+        const livre::UniqueFutureMap futures(sink.getPostconditions());
+        return futures.get<uint32_t>("Output");
+    }
+
+    livre::Pipeline pipeline;
+    livre::PipeFilter producer;
+    livre::PipeFilter sink;
+};
+
+uint32_t getExpected(const uint32_t input)
+{
+    return (input + 2) * nConsumers + 1;
+}
+}
+
+BOOST_AUTO_TEST_CASE(testReusedGraph)
+{
+    Graph graph;
+    for (uint32_t i = 0; i < nFrames; ++i)
+    {
+        graph.pipeline.reset();
+        graph.setInput(i);
+        BOOST_CHECK_EQUAL(graph.execute(), getExpected(i));
+    }
+}
@@ -0,0 +1,225 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define BOOST_TEST_MODULE Tracer
+
+#include "../core/render/DummyContext.h"
+
+#include <livre/core/pipeline/DependencyExecutor.h>
+#include <livre/core/pipeline/Filter.h>
+#include <livre/core/pipeline/FutureMap.h>
+#include <livre/core/pipeline/PipeFilter.h>
+#include <livre/core/pipeline/Pipeline.h>
+#include <livre/core/pipeline/PromiseMap.h>
+#include <livre/core/pipeline/Tracer.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+class ForwardFilter : public livre::Filter
+{
+    void execute(const livre::FutureMap& input,
+                 livre::PromiseMap& output) const final
+    {
+        output.set("Output", input.get<uint32_t>("Input")[0] + 1);
+    }
+
+    livre::DataInfos getInputDataInfos() const final
+    {
+        return {{"Input", livre::getType<uint32_t>()}};
+    }
+
+    livre::DataInfos getOutputDataInfos() const final
+    {
+        return {{"Output", livre::getType<uint32_t>()}};
+    }
+};
+
+/** Runs a ForwardFilter inline, like a filter executing a pipeline */
+class NestingFilter : public livre::Filter
+{
+    void execute(const livre::FutureMap& input,
+                 livre::PromiseMap& output) const final
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        livre::PipeFilterT<ForwardFilter> inner("Inner");
+        inner.getPromise("Input").set(input.get<uint32_t>("Input")[0]);
+        inner.execute();
+        const livre::FutureMap futures(inner.getPostconditions());
+        output.set("Output", futures.get<uint32_t>("Output")[0]);
+    }
+
+    livre::DataInfos getInputDataInfos() const final
+    {
+        return {{"Input", livre::getType<uint32_t>()}};
+    }
+
+    livre::DataInfos getOutputDataInfos() const final
+    {
+        return {{"Output", livre::getType<uint32_t>()}};
+    }
+};
+
+size_t count(const std::string& string, const std::string& pattern)
+{
+    size_t n = 0;
+    for (size_t pos = string.find(pattern); pos != std::string::npos;
+         pos = string.find(pattern, pos + 1))
+    {
+        ++n;
+    }
+    return n;
+}
+
+/** @return the wait in us of the first event of a filter, if any */
+size_t getWait(const std::string& trace, const std::string& name)
+{
+    const size_t event =
+        trace.find("\"name\":\"" + name + "\",\"cat\":\"filter\"");
+    const size_t wait = trace.find("\"wait\":", event);
+    BOOST_REQUIRE_NE(event, std::string::npos);
+    BOOST_REQUIRE_NE(wait, std::string::npos);
+    return std::stoul(trace.substr(wait + 7));
+}
+
+std::string runFrame(const uint32_t frameId)
+{
+    livre::Tracer::setFrame(frameId);
+
+    livre::Pipeline pipeline;
+    livre::PipeFilter first = pipeline.add<ForwardFilter>("First");
+    livre::PipeFilter second = pipeline.add<ForwardFilter>("Second");
+    first.connect("Output", second, "Input");
+    first.getPromise("Input").set(uint32_t(0));
+    {
+        // the destruction waits until the filters are recorded
+        const test::DummyContext context;
+        livre::DependencyExecutor executor("Executor", 2, context);
+        pipeline.schedule(executor);
+
+        const livre::UniqueFutureMap futures(second.getPostconditions());
+        BOOST_CHECK_EQUAL(futures.get<uint32_t>("Output"), 2);
+    }
+
+    std::ostringstream os;
+    livre::Tracer::write(os);
+    return os.str();
+}
+}
+
+BOOST_AUTO_TEST_CASE(testTrace)
+{
+    livre::Tracer::setEnabled(false);
+    livre::Tracer::clear();
+    std::string trace = runFrame(1);
+    BOOST_CHECK_EQUAL(count(trace, "\"ph\":\"X\""), 0);
+
+    livre::Tracer::setEnabled(true);
+    trace = runFrame(2);
+    BOOST_CHECK_EQUAL(count(trace, "\"ph\":\"X\""), 2);
+    BOOST_CHECK_EQUAL(count(trace, "\"name\":\"First\",\"cat\":\"filter\""),
+                      1);
+    BOOST_CHECK_EQUAL(count(trace, "\"name\":\"Second\",\"cat\":\"filter\""),
+                      1);
+    BOOST_CHECK_EQUAL(count(trace, "\"args\":{\"frame\":2,\"wait\":"), 2);
+    BOOST_CHECK_EQUAL(trace.find("{\"traceEvents\":["), 0);
+    const std::string pid =
+        "\"pid\":" + std::to_string(livre::Tracer::getProcessId()) + ",";
+    BOOST_CHECK_EQUAL(count(trace, pid), count(trace, "\"pid\":"));
+
+    // synchronous executions are recorded without a wait
+    livre::PipeFilterT<ForwardFilter> filter("Sync");
+    filter.getPromise("Input").set(uint32_t(0));
+    filter.execute();
+    std::ostringstream os;
+    livre::Tracer::write(os);
+    BOOST_CHECK_EQUAL(count(os.str(), "\"ph\":\"X\""), 3);
+    BOOST_CHECK_GE(count(os.str(), "\"frame\":2,\"wait\":0"), 1);
+#ifdef __linux__
+    BOOST_CHECK_EQUAL(count(os.str(), "\"cpu\":"), 3);
+#endif
+
+    livre::Tracer::clear();
+    livre::Tracer::setEnabled(false);
+    os.str("");
+    livre::Tracer::write(os);
+    BOOST_CHECK_EQUAL(count(os.str(), "\"ph\":\"X\""), 0);
+}
+
+BOOST_AUTO_TEST_CASE(testWaitFromSubmission)
+{
+    // The wait starts once the preconditions are met, not at schedule time
+    livre::Tracer::clear();
+    livre::Tracer::setEnabled(true);
+
+    livre::PipeFilterT<ForwardFilter> filter("Delayed");
+    livre::Promise input = filter.getPromise("Input");
+    {
+        const test::DummyContext context;
+        livre::DependencyExecutor executor("Executor", 1, context);
+        filter.schedule(executor);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        input.set(uint32_t(0));
+
+        const livre::UniqueFutureMap futures(filter.getPostconditions());
+        BOOST_CHECK_EQUAL(futures.get<uint32_t>("Output"), 1);
+    }
+
+    std::ostringstream os;
+    livre::Tracer::write(os);
+    const std::string& trace = os.str();
+    const size_t wait = trace.find("\"wait\":");
+    BOOST_REQUIRE_NE(wait, std::string::npos);
+    BOOST_CHECK_LT(std::stoul(trace.substr(wait + 7)), 100000); // us
+
+    livre::Tracer::clear();
+    livre::Tracer::setEnabled(false);
+}
+
+BOOST_AUTO_TEST_CASE(testNestedScopes)
+{
+    // The filters run inline by a scheduled filter did not wait in the
+    // Workers, they are recorded without the wait of the outer one
+    livre::Tracer::clear();
+    livre::Tracer::setEnabled(true);
+
+    livre::PipeFilterT<NestingFilter> filter("Outer");
+    filter.getPromise("Input").set(uint32_t(0));
+    {
+        const test::DummyContext context;
+        livre::DependencyExecutor executor("Executor", 1, context);
+        filter.schedule(executor);
+
+        const livre::UniqueFutureMap futures(filter.getPostconditions());
+        BOOST_CHECK_EQUAL(futures.get<uint32_t>("Output"), 1);
+    }
+
+    std::ostringstream os;
+    livre::Tracer::write(os);
+    BOOST_CHECK_EQUAL(count(os.str(), "\"ph\":\"X\""), 2);
+    BOOST_CHECK_LT(getWait(os.str(), "Outer"), 100000); // us
+    BOOST_CHECK_EQUAL(getWait(os.str(), "Inner"), 0);
+
+    livre::Tracer::clear();
+    livre::Tracer::setEnabled(false);
+}
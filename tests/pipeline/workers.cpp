@@ -0,0 +1,231 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *
+ * This file is part of Livre <https://github.com/BlueBrain/Livre>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define BOOST_TEST_MODULE Workers
+
+#include "../core/render/DummyContext.h"
+
+#include <livre/core/pipeline/DependencyExecutor.h>
+#include <livre/core/pipeline/Executable.h>
+#include <livre/core/pipeline/FuturePromise.h>
+#include <livre/core/pipeline/Workers.h>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <lunchbox/thread.h>
+
+#include <atomic>
+#include <set>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace
+{
+const size_t nExecutables = 100;
+
+/** Calls a function, without pre- and postconditions */
+class FunctionExecutable : public livre::Executable
+{
+public:
+    explicit FunctionExecutable(const std::function<void()>& function)
+        : _function(function)
+    {
+    }
+
+    void execute() final { _function(); }
+    livre::Futures getPostconditions() const final { return {}; }
+    livre::Futures getPreconditions() const final { return {}; }
+    livre::ExecutablePtr clone() const final
+    {
+        return std::make_shared<FunctionExecutable>(_function);
+    }
+
+private:
+    const std::function<void()> _function;
+};
+
+livre::ExecutablePtr makeExecutable(const std::function<void()>& function)
+{
+    return std::make_shared<FunctionExecutable>(function);
+}
+
+livre::Promise makePromise(const std::string& name)
+{
+    return livre::Promise(livre::DataInfo(name, livre::getType<bool>()));
+}
+}
+
+BOOST_AUTO_TEST_CASE(testPriorities)
+{
+    const test::DummyContext context;
+    livre::Workers workers("test", 1, context);
+
+    // Block the only thread until everything is queued
+    livre::Promise started = makePromise("Started");
+    livre::Promise gate = makePromise("Gate");
+    const livre::Future gateFuture = gate.getFuture();
+    workers.schedule(makeExecutable([&] {
+        started.set(true);
+        gateFuture.wait();
+    }));
+    started.getFuture().wait();
+
+    std::vector<livre::WorkPriority> order;
+    livre::Promise done = makePromise("Done");
+    const livre::WorkPriority priorities[] = {livre::PRIORITY_BACKGROUND,
+                                              livre::PRIORITY_UPLOAD,
+                                              livre::PRIORITY_RENDER};
+    for (size_t i = 0; i < 3; ++i)
+    {
+        for (const livre::WorkPriority priority : priorities)
+        {
+            workers.schedule(makeExecutable([&order, &done, priority] {
+                                 order.push_back(priority);
+                                 if (order.size() == 9)
+                                     done.set(true);
+                             }),
+                             priority);
+        }
+    }
+
+    gate.set(true);
+    done.getFuture().wait();
+
+    BOOST_REQUIRE_EQUAL(order.size(), 9);
+    for (size_t i = 0; i < order.size(); ++i)
+        BOOST_CHECK_EQUAL(size_t(order[i]), i / 3);
+}
+
+BOOST_AUTO_TEST_CASE(testWorkStealing)
+{
+    const test::DummyContext context;
+    livre::Workers workers("test", 4, context);
+
+    boost::mutex mutex;
+    std::set<boost::thread::id> threads;
+    std::atomic<size_t> count(0);
+    livre::Promise done = makePromise("Done");
+
+    // All children are queued on the thread of the parent
+    workers.schedule(makeExecutable([&] {
+        for (size_t i = 0; i < nExecutables; ++i)
+        {
+            workers.schedule(makeExecutable([&] {
+                boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+                {
+                    livre::ScopedLock lock(mutex);
+                    threads.insert(boost::this_thread::get_id());
+                }
+                if (++count == nExecutables)
+                    done.set(true);
+            }));
+        }
+    }));
+
+    done.getFuture().wait();
+    BOOST_CHECK_EQUAL(count.load(), nExecutables);
+    BOOST_CHECK_GT(threads.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(testSharedWorkers)
+{
+    const test::DummyContext context;
+    livre::Workers workers("test", 2, context);
+    livre::DependencyExecutor render(workers, livre::PRIORITY_RENDER);
+    livre::DependencyExecutor background(workers, livre::PRIORITY_BACKGROUND);
+
+    std::atomic<size_t> count(0);
+    livre::Promise done = makePromise("Done");
+    for (size_t i = 0; i < nExecutables; ++i)
+    {
+        livre::Executor& executor = i % 2 ? render : background;
+        executor.schedule(makeExecutable([&] {
+            if (++count == nExecutables)
+                done.set(true);
+        }));
+    }
+
+    done.getFuture().wait();
+    BOOST_CHECK_EQUAL(count.load(), nExecutables);
+}
+
+BOOST_AUTO_TEST_CASE(testExecutorWaitsOnSharedWorkers)
+{
+    const test::DummyContext context;
+    livre::Workers workers("test", 1, context);
+
+    // The destruction of the executor waits for its executables in the
+    // Workers, which outlive it
+    std::atomic<bool> finished(false);
+    livre::Promise started = makePromise("Started");
+    {
+        livre::DependencyExecutor executor(workers, livre::PRIORITY_RENDER);
+        executor.schedule(makeExecutable([&] {
+            started.set(true);
+            boost::this_thread::sleep_for(boost::chrono::milliseconds(100));
+            finished = true;
+        }));
+        started.getFuture().wait();
+    }
+    BOOST_CHECK(finished);
+}
+
+BOOST_AUTO_TEST_CASE(testAffinities)
+{
+    const int32_t core = lunchbox::Thread::CORE;
+    const int32_t socket = lunchbox::Thread::SOCKET;
+    BOOST_CHECK(livre::Workers::parseAffinities("").empty());
+    BOOST_CHECK(livre::Workers::parseAffinities("socket:1") ==
+                livre::Int32s({socket + 1}));
+    BOOST_CHECK(livre::Workers::parseAffinities("cores:2-4,0") ==
+                livre::Int32s({core + 2, core + 3, core + 4, core}));
+    BOOST_CHECK_THROW(livre::Workers::parseAffinities("cores:"),
+                      std::runtime_error);
+    BOOST_CHECK_THROW(livre::Workers::parseAffinities("cores:4-2"),
+                      std::runtime_error);
+    BOOST_CHECK_THROW(livre::Workers::parseAffinities("socket:-1"),
+                      std::runtime_error);
+    BOOST_CHECK_THROW(livre::Workers::parseAffinities("gpu:0"),
+                      std::runtime_error);
+
+    // all the threads are bound to the first core
+    const test::DummyContext context;
+    livre::Workers workers("test", 2, context, {core});
+    std::atomic<size_t> count(0);
+    std::atomic<size_t> onFirstCore(0);
+    livre::Promise done = makePromise("Done");
+    for (size_t i = 0; i < nExecutables; ++i)
+    {
+        workers.schedule(makeExecutable([&count, &onFirstCore, done] {
+#ifdef __linux__
+            if (sched_getcpu() == 0)
+                ++onFirstCore;
+#else
+            ++onFirstCore;
+#endif
+            if (++count == nExecutables)
+                livre::Promise(done).set(true);
+        }));
+    }
+
+    done.getFuture().wait();
+    BOOST_CHECK_EQUAL(onFirstCore.load(), nExecutables);
+}